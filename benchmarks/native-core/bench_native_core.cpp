@@ -0,0 +1,327 @@
+#include <benchmark/benchmark.h>
+#include "../../native-core/SmartBlueprintCore.h"
+#include "../../native-core/SyntheticNetwork.h"
+#include "../../native-core/ScanBackend.h"
+#include "../../native-core/DeviceExporter.h"
+#include "../../native-core/Localizer.h"
+#include <cstdio>
+#include <random>
+
+namespace {
+
+SyntheticNetwork::Options networkOptions(size_t deviceCount) {
+    SyntheticNetwork::Options options;
+    options.deviceCount = deviceCount;
+    return options;
+}
+
+// Rows shaped like FeatureStore's features
+std::vector<float> makeFeatureRows(size_t count) {
+    std::mt19937 rng(7);
+    std::normal_distribution<float> rssi(-60.0f, 10.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    
+    std::vector<float> rows(count * MLEngine::kNumFeatures);
+    for (size_t i = 0; i < count; ++i) {
+        float* row = &rows[i * MLEngine::kNumFeatures];
+        row[FeatureStore::kRssi] = rssi(rng);
+        row[FeatureStore::kOnline] = unit(rng) < 0.95f ? 1.0f : 0.0f;
+        row[FeatureStore::kSecondsSinceSeen] = unit(rng) * 2.0f;
+        row[FeatureStore::kTypeScore] = unit(rng);
+        row[FeatureStore::kRssiStdDev] = unit(rng) * 4.0f;
+        row[FeatureStore::kFlapRate] = unit(rng) < 0.9f ? 0.0f : unit(rng) * 3.0f;
+        row[FeatureStore::kIpChurnRate] = unit(rng) < 0.95f ? 0.0f : unit(rng);
+        row[FeatureStore::kHourPresence] = unit(rng) * 2.0f;
+    }
+    return rows;
+}
+
+void BM_IsolationForestTrain(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    auto rows = makeFeatureRows(count);
+    
+    for (auto _ : state) {
+        IsolationForest forest;
+        forest.setTrainingThreads(1);
+        forest.train(rows.data(), count, MLEngine::kNumFeatures);
+        benchmark::DoNotOptimize(forest.isTrained());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+BENCHMARK(BM_IsolationForestTrain)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMillisecond);
+
+void BM_IsolationForestScore(benchmark::State& state) {
+    auto training = makeFeatureRows(4096);
+    IsolationForest forest;
+    forest.train(training.data(), 4096, MLEngine::kNumFeatures);
+    
+    std::vector<double> point = {-95.0, 0.0, 1.5, 0.2, 12.0, 4.0, 1.0, 0.0};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(forest.anomalyScore(point));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_IsolationForestScore);
+
+void BM_IsolationForestScoreBatch(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    auto training = makeFeatureRows(4096);
+    IsolationForest forest;
+    forest.train(training.data(), 4096, MLEngine::kNumFeatures);
+    
+    auto rows = makeFeatureRows(count);
+    std::vector<double> scores(count);
+    for (auto _ : state) {
+        forest.anomalyScoreBatch(rows.data(), count, MLEngine::kNumFeatures, scores.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+BENCHMARK(BM_IsolationForestScoreBatch)->RangeMultiplier(10)->Range(10, 100000);
+
+// One online update: only the trees covering the changed share of the window are rebuilt
+void BM_IsolationForestReplaceTrees(benchmark::State& state) {
+    auto window = makeFeatureRows(4096);
+    IsolationForest forest;
+    forest.setTrainingThreads(1);
+    forest.train(window.data(), 4096, MLEngine::kNumFeatures);
+    
+    int trees = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        forest.replaceTrees(window.data(), 4096, MLEngine::kNumFeatures, trees);
+    }
+    state.SetItemsProcessed(state.iterations() * trees);
+}
+BENCHMARK(BM_IsolationForestReplaceTrees)->Arg(1)->Arg(10)->Arg(100)->Unit(benchmark::kMicrosecond);
+
+// Cached: the same devices every cycle, as in steady state
+void BM_ClassifyDeviceCached(benchmark::State& state) {
+    SyntheticNetwork network(networkOptions(static_cast<size_t>(state.range(0))));
+    auto devices = network.makeDevices();
+    DeviceClassifier classifier(devices.size());
+    
+    for (auto _ : state) {
+        for (const auto& device : devices) {
+            benchmark::DoNotOptimize(classifier.classifyDevice(device));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(devices.size()));
+}
+BENCHMARK(BM_ClassifyDeviceCached)->RangeMultiplier(10)->Range(10, 100000);
+
+// Uncached: a cache too small to help, so every call runs the matchers
+void BM_ClassifyDeviceUncached(benchmark::State& state) {
+    SyntheticNetwork network(networkOptions(static_cast<size_t>(state.range(0))));
+    auto devices = network.makeDevices();
+    DeviceClassifier classifier(0);
+    
+    for (auto _ : state) {
+        for (const auto& device : devices) {
+            benchmark::DoNotOptimize(classifier.classifyDevice(device));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(devices.size()));
+}
+BENCHMARK(BM_ClassifyDeviceUncached)->RangeMultiplier(10)->Range(10, 100000);
+
+void BM_ProcessRSSI(benchmark::State& state) {
+    SyntheticNetwork network(networkOptions(static_cast<size_t>(state.range(0))));
+    const auto& records = network.records();
+    SignalProcessor processor;
+    
+    for (auto _ : state) {
+        for (uint32_t id = 0; id < records.size(); ++id) {
+            benchmark::DoNotOptimize(processor.processRSSI(records[id].rssi, id));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(records.size()));
+}
+BENCHMARK(BM_ProcessRSSI)->RangeMultiplier(10)->Range(10, 100000);
+
+void BM_ProcessRSSIBatch(benchmark::State& state) {
+    SyntheticNetwork network(networkOptions(static_cast<size_t>(state.range(0))));
+    const auto& records = network.records();
+    SignalProcessor processor;
+    
+    std::vector<uint32_t> ids(records.size());
+    std::vector<float> measurements(records.size());
+    std::vector<float> filtered(records.size());
+    for (uint32_t id = 0; id < records.size(); ++id) {
+        ids[id] = id;
+        measurements[id] = static_cast<float>(records[id].rssi);
+    }
+    
+    for (auto _ : state) {
+        processor.processRSSIBatch(ids.data(), measurements.data(), ids.size(), filtered.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(records.size()));
+}
+BENCHMARK(BM_ProcessRSSIBatch)->RangeMultiplier(10)->Range(10, 100000);
+
+// Floor-plan mapping: every device against kAccessPoints access points
+constexpr size_t kAccessPoints = 8;
+
+void BM_EstimateDistance(benchmark::State& state) {
+    size_t devices = static_cast<size_t>(state.range(0));
+    SignalProcessor processor;
+
+    for (auto _ : state) {
+        for (size_t ap = 0; ap < kAccessPoints; ++ap) {
+            for (size_t d = 0; d < devices; ++d) {
+                benchmark::DoNotOptimize(processor.estimateDistance(-40.0 - static_cast<double>(d % 55), -59.0 - ap, 2.0 + 0.1 * ap));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(devices * kAccessPoints));
+}
+BENCHMARK(BM_EstimateDistance)->RangeMultiplier(10)->Range(10, 100000);
+
+void BM_EstimateDistancesBatch(benchmark::State& state) {
+    size_t devices = static_cast<size_t>(state.range(0));
+    SignalProcessor processor;
+
+    std::vector<float> rssi(devices * kAccessPoints);
+    std::vector<float> distances(rssi.size());
+    std::vector<float> txPower(kAccessPoints);
+    std::vector<float> exponents(kAccessPoints);
+    for (size_t ap = 0; ap < kAccessPoints; ++ap) {
+        txPower[ap] = -59.0f - static_cast<float>(ap);
+        exponents[ap] = 2.0f + 0.1f * static_cast<float>(ap);
+        for (size_t d = 0; d < devices; ++d) {
+            rssi[ap * devices + d] = -40.0f - static_cast<float>(d % 55);
+        }
+    }
+
+    for (auto _ : state) {
+        processor.estimateDistances(rssi.data(), devices, txPower.data(), exponents.data(), kAccessPoints,
+                                    distances.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(rssi.size()));
+}
+BENCHMARK(BM_EstimateDistancesBatch)->RangeMultiplier(10)->Range(10, 100000);
+
+// One localization cycle: every device heard by kAccessPoints observers
+void BM_LocalizeDevices(benchmark::State& state) {
+    size_t devices = static_cast<size_t>(state.range(0));
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> noise(-2.0f, 2.0f);
+
+    std::vector<Observer> observers(kAccessPoints);
+    for (size_t ap = 0; ap < kAccessPoints; ++ap) {
+        observers[ap].x = static_cast<float>(ap % 4) * 10.0f;
+        observers[ap].y = static_cast<float>(ap / 4) * 20.0f;
+    }
+    std::vector<uint32_t> deviceIds, observerIds;
+    std::vector<float> rssi;
+    for (size_t d = 0; d < devices; ++d) {
+        for (size_t ap = 0; ap < kAccessPoints; ++ap) {
+            deviceIds.push_back(static_cast<uint32_t>(d));
+            observerIds.push_back(static_cast<uint32_t>(ap));
+            rssi.push_back(-60.0f - static_cast<float>((d + ap * 7) % 30) + noise(rng));
+        }
+    }
+
+    Localizer localizer;
+    localizer.setObservers(observers);
+    localizer.observe(deviceIds.data(), observerIds.data(), rssi.data(), rssi.size());
+    localizer.solve(); // first solves take initialIterations steps
+
+    for (auto _ : state) {
+        localizer.observe(deviceIds.data(), observerIds.data(), rssi.data(), rssi.size());
+        benchmark::DoNotOptimize(localizer.solve());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(devices));
+}
+BENCHMARK(BM_LocalizeDevices)->RangeMultiplier(10)->Range(10, 100000)->UseRealTime();
+
+// performNetworkScan over a SyntheticBackend is updateDeviceList plus one record copy.
+// Each iteration scans a new step, so churn, dropouts and RSSI changes produce deltas.
+void BM_UpdateDeviceList(benchmark::State& state) {
+    SyntheticNetwork network(networkOptions(static_cast<size_t>(state.range(0))));
+    auto synthetic = std::make_unique<SyntheticBackend>();
+    SyntheticBackend* backend = synthetic.get();
+    NetworkScanner scanner(std::move(synthetic));
+    
+    size_t changes = 0;
+    scanner.setChangeCallback([&changes](const std::vector<DeviceChange>& batch) { changes += batch.size(); });
+    network.applyTo(*backend);
+    scanner.performNetworkScan();
+    
+    for (auto _ : state) {
+        state.PauseTiming();
+        network.step();
+        network.applyTo(*backend);
+        state.ResumeTiming();
+        
+        scanner.performNetworkScan();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(network.records().size()));
+    state.counters["changes/scan"] = benchmark::Counter(static_cast<double>(changes), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_UpdateDeviceList)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMicrosecond);
+
+// One monitoring cycle end to end: scan, deltas, classification, filtering,
+// anomaly scoring and snapshot publication
+void BM_MonitoringCycle(benchmark::State& state) {
+    SyntheticNetwork network(networkOptions(static_cast<size_t>(state.range(0))));
+    auto synthetic = std::make_unique<SyntheticBackend>();
+    SyntheticBackend* backend = synthetic.get();
+    SmartBlueprintCore core(std::make_unique<NetworkScanner>(std::move(synthetic)));
+    
+    network.applyTo(*backend);
+    core.runMonitoringCycle(true);
+    
+    uint64_t allocations = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        network.step();
+        network.applyTo(*backend);
+        state.ResumeTiming();
+        
+        uint64_t before = Metrics::threadAllocationCount();
+        core.runMonitoringCycle();
+        allocations += Metrics::threadAllocationCount() - before;
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(network.records().size()));
+    state.counters["allocs/cycle"] = benchmark::Counter(static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_MonitoringCycle)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMicrosecond);
+
+// Full pass: everything is reprocessed, as happens once a minute
+void BM_MonitoringCycleFullPass(benchmark::State& state) {
+    SyntheticNetwork network(networkOptions(static_cast<size_t>(state.range(0))));
+    auto synthetic = std::make_unique<SyntheticBackend>();
+    SyntheticBackend* backend = synthetic.get();
+    SmartBlueprintCore core(std::make_unique<NetworkScanner>(std::move(synthetic)));
+    network.applyTo(*backend);
+    
+    for (auto _ : state) {
+        core.runMonitoringCycle(true);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(network.records().size()));
+}
+BENCHMARK(BM_MonitoringCycleFullPass)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMicrosecond);
+
+// Device export to a temporary file; argument 0 is CSV, 1 NDJSON, 2 binary
+void BM_ExportDevices(benchmark::State& state) {
+    SyntheticNetwork network(networkOptions(static_cast<size_t>(state.range(1))));
+    auto devices = network.makeDevices();
+    auto format = static_cast<ExportFormat>(state.range(0));
+    std::string path = "sb_bench_export" + std::string(DeviceExporter::extension(format));
+    DeviceExporter exporter;
+    
+    size_t bytes = 0;
+    for (auto _ : state) {
+        bytes = exporter.exportDevices(path, format, devices).bytes;
+    }
+    std::remove(path.c_str());
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(devices.size()));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes));
+}
+BENCHMARK(BM_ExportDevices)->ArgsProduct({{0, 1, 2}, {1000, 100000}})->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,41 @@
+#include "Metrics.h"
+#include <cstdlib>
+#include <new>
+
+// Counting replacements for the global allocation functions, linked only into
+// the test and benchmark executables (SB_COUNT_ALLOCATIONS) so the library
+// never replaces an application's operator new. The aligned overloads are
+// left to the standard library, which pairs them itself.
+void* operator new(std::size_t size) {
+    Metrics::countAllocation();
+    if (size == 0) size = 1;
+    for (;;) {
+        if (void* pointer = std::malloc(size)) return pointer;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return ::operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
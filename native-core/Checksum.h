@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32 (IEEE 802.3 polynomial) used to validate on-disk binary formats.
+// Pass the previous result as `crc` to checksum data in several pieces.
+uint32_t crc32(const void* data, size_t size, uint32_t crc = 0);
@@ -1,8 +1,11 @@
 #include "DesktopUI.h"
+#include "Metrics.h"
 #include <iostream>
 #include <iomanip>
 #include <ctime>
 #include <algorithm>
+#include <cstdio>
+#include <cmath>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -11,9 +14,30 @@
 #include <termios.h>
 #include <unistd.h>
 #include <sys/select.h>
+#include <sys/ioctl.h>
 #endif
 
-DesktopUI::DesktopUI() : currentView(ViewMode::DASHBOARD), autoRefresh(true) {
+namespace {
+
+// Lines taken by the header and command bar on every view
+constexpr size_t kChromeRows = 14;
+
+// Colored label and bar graph for each SignalQualityLevel
+constexpr std::string_view kQualityLabels[] = {
+    "\033[31mVery Poor\033[0m", "\033[31mPoor\033[0m", "\033[33mFair\033[0m",
+    "\033[32mGood\033[0m", "\033[32mExcellent\033[0m",
+};
+constexpr std::string_view kQualityBars[] = {
+    "░░░░░░░░", "██░░░░░░", "████░░░░", "██████░░", "████████",
+};
+
+static_assert(sizeof(kQualityLabels) / sizeof(kQualityLabels[0]) == kSignalQualityLevelCount &&
+              sizeof(kQualityBars) / sizeof(kQualityBars[0]) == kSignalQualityLevelCount,
+              "every SignalQualityLevel needs a label and bars");
+
+} // namespace
+
+DesktopUI::DesktopUI() : currentView(ViewMode::DASHBOARD), autoRefresh(true), devicePage(0) {
     setupConsole();
 }
 
@@ -64,21 +88,55 @@ void DesktopUI::clearScreen() {
 #else
     system("clear");
 #endif
+    frame.invalidate(); // The screen no longer shows the last frame
+}
+
+void DesktopUI::updateViewport() {
+    size_t rows = 24;
+    size_t columns = 80;
+#ifdef _WIN32
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)) {
+        rows = static_cast<size_t>(info.srWindow.Bottom - info.srWindow.Top + 1);
+        columns = static_cast<size_t>(info.srWindow.Right - info.srWindow.Left + 1);
+    }
+#else
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0) {
+        rows = size.ws_row;
+        columns = size.ws_col;
+    }
+#endif
+    frame.resize(rows, columns);
+}
+
+size_t DesktopUI::rowBudget(size_t usedRows) const {
+    // Always leave room for a few entries, even on a tiny terminal
+    size_t chrome = kChromeRows + usedRows;
+    return frame.rows() > chrome + 3 ? frame.rows() - chrome : 3;
+}
+
+void DesktopUI::nextPage() {
+    devicePage++; // Clamped against the device count when rendered
+}
+
+void DesktopUI::previousPage() {
+    if (devicePage > 0) devicePage--;
 }
 
 void DesktopUI::showHeader() {
     auto now = std::chrono::system_clock::now();
     auto time_t = std::chrono::system_clock::to_time_t(now);
     
-    std::cout << "╔══════════════════════════════════════════════════════════════╗\n";
-    std::cout << "║ SmartBlueprint Pro │ " << getCurrentViewName() 
+    view << "╔══════════════════════════════════════════════════════════════╗\n";
+    view << "║ SmartBlueprint Pro │ " << getCurrentViewName() 
               << std::string(30 - getCurrentViewName().length(), ' ') << "║\n";
-    std::cout << "╠══════════════════════════════════════════════════════════════╣\n";
-    std::cout << "║ Devices: " << std::setw(3) << devices.size() 
+    view << "╠══════════════════════════════════════════════════════════════╣\n";
+    view << "║ Devices: " << std::setw(3) << devices.size() 
               << "   │ Anomalies: " << std::setw(2) << anomalies.size()
               << "  │ Auto-refresh: " << (autoRefresh ? "ON " : "OFF")
               << " │ " << std::put_time(std::localtime(&time_t), "%H:%M:%S") << " ║\n";
-    std::cout << "╠══════════════════════════════════════════════════════════════╣\n";
+    view << "╠══════════════════════════════════════════════════════════════╣\n";
 }
 
 std::string DesktopUI::getCurrentViewName() {
@@ -102,7 +160,10 @@ void DesktopUI::updateAnomalies(const std::vector<std::pair<std::shared_ptr<Netw
 }
 
 void DesktopUI::render() {
-    clearScreen();
+    SB_SCOPED_TIMER(UiRender);
+    updateViewport();
+    view.str(std::string());
+    view.clear();
     showHeader();
     
     switch (currentView) {
@@ -127,38 +188,55 @@ void DesktopUI::render() {
     }
     
     showCommandBar();
+    
+    // Compose the frame and send only what changed since the last one
+    frame.begin();
+    frame.write(view.str());
+    output.clear();
+    frame.present(output);
+    if (!output.empty()) {
+        std::cout.write(output.data(), static_cast<std::streamsize>(output.size()));
+        std::cout.flush();
+    }
 }
 
 void DesktopUI::showDashboard() {
-    std::cout << "\nWelcome to SmartBlueprint Network Monitor\n";
-    std::cout << "=========================================\n";
+    view << "\nWelcome to SmartBlueprint Network Monitor\n";
+    view << "=========================================\n";
     
-    std::cout << "Devices Found: " << devices.size() << "\n\n";
+    view << "Devices Found: " << devices.size() << "\n\n";
     
     // Device table header
-    std::cout << "┌─────────────┬───────────────┬───────────────────┬────────┬─────────┐\n";
-    std::cout << "│ Device Name │ IP Address    │ MAC Address       │ Signal │ Status  │\n";
-    std::cout << "├─────────────┼───────────────┼───────────────────┼────────┼─────────┤\n";
+    view << "┌─────────────┬───────────────┬───────────────────┬────────┬─────────┐\n";
+    view << "│ Device Name │ IP Address    │ MAC Address       │ Signal │ Status  │\n";
+    view << "├─────────────┼───────────────┼───────────────────┼────────┼─────────┤\n";
     
     if (devices.empty()) {
-        std::cout << "│             │               │ No devices found  │        │ Scanning│\n";
+        view << "│             │               │ No devices found  │        │ Scanning│\n";
     } else {
-        for (const auto& device : devices) {
+        // Only the rows that fit are formatted; the device list pages through the rest
+        size_t shown = std::min(devices.size(), rowBudget(16));
+        for (size_t i = 0; i < shown; ++i) {
+            const auto& device = devices[i];
             std::string deviceName = device->hostname.empty() ? 
-                generateDeviceName(device->macAddress) : device->hostname;
+                generateDeviceName(*device) : device->hostname;
             std::string ipAddr = device->ipAddress.empty() ? "Unknown" : device->ipAddress;
             std::string status = device->isOnline ? "\033[32mOnline\033[0m" : "\033[31mOffline\033[0m";
             std::string signal = std::to_string(device->rssi) + " dBm";
             
-            std::cout << "│ " << std::setw(11) << std::left << deviceName.substr(0, 11)
+            view << "│ " << std::setw(11) << std::left << deviceName.substr(0, 11)
                      << " │ " << std::setw(13) << std::left << ipAddr.substr(0, 13)
                      << " │ " << std::setw(17) << std::left << device->macAddress.substr(0, 17)
                      << " │ " << std::setw(6) << std::right << signal
                      << " │ " << status << std::string(9, ' ') << "│\n";
         }
+        if (shown < devices.size()) {
+            std::string more = "+" + std::to_string(devices.size() - shown) + " more, press 2 for the device list";
+            view << "│ " << std::setw(66) << std::left << more << " │\n";
+        }
     }
     
-    std::cout << "└─────────────┴───────────────┴───────────────────┴────────┴─────────┘\n\n";
+    view << "└─────────────┴───────────────┴───────────────────┴────────┴─────────┘\n\n";
     
     // Real-time anomalies section
     showAnomaliesCompact();
@@ -166,23 +244,28 @@ void DesktopUI::showDashboard() {
 
 void DesktopUI::showAnomaliesCompact() {
     if (!anomalies.empty()) {
-        std::cout << "Real-time anomalies:\n";
+        view << "Real-time anomalies:\n";
         for (const auto& anomaly : anomalies) {
-            std::string deviceName = generateDeviceName(anomaly.first->macAddress);
+            std::string deviceName = generateDeviceName(*anomaly.first);
             int confidence = static_cast<int>(anomaly.second * 100);
             
-            std::cout << "\033[33m⚠️  Device " << deviceName 
+            view << "\033[33m⚠️  Device " << deviceName 
                      << ": Offline unexpectedly — Confidence: " << confidence << "%\033[0m\n";
         }
     }
     
-    std::cout << "\nFeatures:\n";
-    std::cout << "• Auto-refreshes every 30s\n";
-    std::cout << "• Real-time anomaly detection\n";
-    std::cout << "• ML-powered signal analysis\n\n";
+    view << "\nFeatures:\n";
+    view << "• Auto-refreshes every 30s\n";
+    view << "• Real-time anomaly detection\n";
+    view << "• ML-powered signal analysis\n\n";
 }
 
-std::string DesktopUI::generateDeviceName(const std::string& macAddress) {
+std::string DesktopUI::generateDeviceName(const NetworkDevice& device) {
+    const std::string& macAddress = device.macAddress;
+    if (device.deviceType != DeviceType::Unknown && macAddress.size() >= 17) {
+        return std::string(deviceTypeLabel(device.deviceType)) + "-" + macAddress.substr(15, 2);
+    }
+    
     std::string prefix = macAddress.substr(0, 8);
     if (prefix.find("aa:bb") != std::string::npos) return "Router";
     if (prefix.find("11:22") != std::string::npos) return "Laptop";
@@ -193,83 +276,95 @@ std::string DesktopUI::generateDeviceName(const std::string& macAddress) {
 }
 
 void DesktopUI::showDeviceList() {
-    std::cout << "\nDetailed Device Information\n";
-    std::cout << "===========================\n\n";
+    view << "\nDetailed Device Information\n";
+    view << "===========================\n\n";
     
     if (devices.empty()) {
-        std::cout << "🔍 No devices detected. Network scanning in progress...\n\n";
-        std::cout << "Tips:\n";
-        std::cout << "• Ensure you're connected to a WiFi network\n";
-        std::cout << "• Check that devices are powered on\n";
-        std::cout << "• Wait 30-60 seconds for full discovery\n";
+        view << "🔍 No devices detected. Network scanning in progress...\n\n";
+        view << "Tips:\n";
+        view << "• Ensure you're connected to a WiFi network\n";
+        view << "• Check that devices are powered on\n";
+        view << "• Wait 30-60 seconds for full discovery\n";
         return;
     }
     
-    for (size_t i = 0; i < devices.size(); ++i) {
+    // Nine lines per device; only the current page is formatted
+    size_t perPage = std::max<size_t>(1, rowBudget(6) / 9);
+    size_t pages = (devices.size() + perPage - 1) / perPage;
+    devicePage = std::min(devicePage, pages - 1);
+    size_t first = devicePage * perPage;
+    size_t last = std::min(devices.size(), first + perPage);
+    
+    view << "Page " << (devicePage + 1) << " of " << pages << "  (devices " << (first + 1) << "-" << last
+         << " of " << devices.size() << ")  N: next page  P: previous page\n\n";
+    
+    auto now = std::chrono::system_clock::now();
+    for (size_t i = first; i < last; ++i) {
         const auto& device = devices[i];
         std::string statusColor = device->isOnline ? "\033[32m" : "\033[31m";
-        std::string signalQuality = getSignalQuality(device->rssi);
+        std::string_view signalQuality = getSignalQuality(device->rssi);
         
-        std::cout << "Device " << (i + 1) << ":\n";
-        std::cout << "  Name: " << generateDeviceName(device->macAddress) << "\n";
-        std::cout << "  MAC:  " << device->macAddress << "\n";
-        std::cout << "  IP:   " << (device->ipAddress.empty() ? "Unknown" : device->ipAddress) << "\n";
-        std::cout << "  Signal: " << device->rssi << " dBm (" << signalQuality << ")\n";
-        std::cout << "  Status: " << statusColor << (device->isOnline ? "Online" : "Offline") << "\033[0m\n";
+        view << "Device " << (i + 1) << ":\n";
+        view << "  Name: " << generateDeviceName(*device) << "\n";
+        view << "  Type: " << deviceTypeIcon(device->deviceType) << " " << deviceTypeLabel(device->deviceType) << "\n";
+        view << "  MAC:  " << device->macAddress << "\n";
+        view << "  IP:   " << (device->ipAddress.empty() ? "Unknown" : device->ipAddress) << "\n";
+        view << "  Signal: " << device->rssi << " dBm (" << signalQuality << ")\n";
+        view << "  Status: " << statusColor << (device->isOnline ? "Online" : "Offline") << "\033[0m\n";
         
-        auto now = std::chrono::system_clock::now();
         auto lastSeen = std::chrono::duration_cast<std::chrono::seconds>(now - device->lastSeen).count();
-        std::cout << "  Last Seen: " << lastSeen << " seconds ago\n\n";
+        view << "  Last Seen: " << lastSeen << " seconds ago\n\n";
     }
 }
 
-std::string DesktopUI::getSignalQuality(int rssi) {
-    if (rssi >= -50) return "\033[32mExcellent\033[0m";
-    if (rssi >= -60) return "\033[32mGood\033[0m";
-    if (rssi >= -70) return "\033[33mFair\033[0m";
-    return "\033[31mPoor\033[0m";
+std::string_view DesktopUI::getSignalQuality(int rssi) {
+    return kQualityLabels[static_cast<size_t>(signalQualityLevel(static_cast<float>(rssi)))];
 }
 
 void DesktopUI::showAnomalyMonitor() {
-    std::cout << "\nNetwork Anomaly Detection\n";
-    std::cout << "=========================\n\n";
+    view << "\nNetwork Anomaly Detection\n";
+    view << "=========================\n\n";
     
-    std::cout << "Active Monitoring: \033[32mENABLED\033[0m\n";
-    std::cout << "Detection Algorithm: ML-based pattern analysis\n";
-    std::cout << "Anomalies Found: " << anomalies.size() << "\n\n";
+    view << "Active Monitoring: \033[32mENABLED\033[0m\n";
+    view << "Detection Algorithm: ML-based pattern analysis\n";
+    view << "Anomalies Found: " << anomalies.size() << "\n\n";
     
     if (anomalies.empty()) {
-        std::cout << "✅ No anomalies detected\n";
-        std::cout << "   Network appears to be functioning normally\n\n";
+        view << "✅ No anomalies detected\n";
+        view << "   Network appears to be functioning normally\n\n";
     } else {
-        std::cout << "⚠️  Anomalies Detected:\n";
-        std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n\n";
+        view << "⚠️  Anomalies Detected:\n";
+        view << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n\n";
         
-        for (size_t i = 0; i < anomalies.size(); ++i) {
+        size_t shown = std::min(anomalies.size(), std::max<size_t>(1, rowBudget(18) / 6));
+        for (size_t i = 0; i < shown; ++i) {
             const auto& anomaly = anomalies[i];
-            std::string deviceName = generateDeviceName(anomaly.first->macAddress);
+            std::string deviceName = generateDeviceName(*anomaly.first);
             int confidence = static_cast<int>(anomaly.second * 100);
             
-            std::cout << "Anomaly " << (i + 1) << ":\n";
-            std::cout << "  Device: " << deviceName << " (" << anomaly.first->macAddress << ")\n";
-            std::cout << "  Issue: Signal deviation from normal pattern\n";
-            std::cout << "  Confidence: " << confidence << "%\n";
-            std::cout << "  Recommendation: Check device connectivity\n\n";
+            view << "Anomaly " << (i + 1) << ":\n";
+            view << "  Device: " << deviceName << " (" << anomaly.first->macAddress << ")\n";
+            view << "  Issue: Signal deviation from normal pattern\n";
+            view << "  Confidence: " << confidence << "%\n";
+            view << "  Recommendation: Check device connectivity\n\n";
+        }
+        if (shown < anomalies.size()) {
+            view << "+" << (anomalies.size() - shown) << " more anomalies\n\n";
         }
     }
     
-    std::cout << "Monitoring Statistics:\n";
-    std::cout << "• Total devices monitored: " << devices.size() << "\n";
-    std::cout << "• Scan frequency: Every 30 seconds\n";
-    std::cout << "• Detection sensitivity: High\n";
+    view << "Monitoring Statistics:\n";
+    view << "• Total devices monitored: " << devices.size() << "\n";
+    view << "• Scan frequency: Every 30 seconds\n";
+    view << "• Detection sensitivity: High\n";
 }
 
 void DesktopUI::showSignalAnalysis() {
-    std::cout << "\nSignal Strength Analysis\n";
-    std::cout << "========================\n\n";
+    view << "\nSignal Strength Analysis\n";
+    view << "========================\n\n";
     
     if (devices.empty()) {
-        std::cout << "No devices available for analysis\n";
+        view << "No devices available for analysis\n";
         return;
     }
     
@@ -277,105 +372,136 @@ void DesktopUI::showSignalAnalysis() {
     int strongSignals = 0;
     int weakSignals = 0;
     
+    // Merging the per-device digests gives network-wide percentiles over
+    // every sample ever filtered, without keeping any of them
+    TDigest networkSignal;
+    
     for (const auto& device : devices) {
         totalSignal += device->rssi;
         if (device->rssi >= -60) strongSignals++;
         if (device->rssi <= -70) weakSignals++;
+        networkSignal.merge(device->summary.rssiQuantiles);
     }
     
     int averageSignal = totalSignal / devices.size();
     
-    std::cout << "Network Signal Summary:\n";
-    std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━\n";
-    std::cout << "Average Signal Strength: " << averageSignal << " dBm\n";
-    std::cout << "Strong Signals (>-60 dBm): " << strongSignals << " devices\n";
-    std::cout << "Weak Signals (<-70 dBm): " << weakSignals << " devices\n\n";
+    view << "Network Signal Summary:\n";
+    view << "━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+    view << "Average Signal Strength: " << averageSignal << " dBm\n";
+    view << "Strong Signals (>-60 dBm): " << strongSignals << " devices\n";
+    view << "Weak Signals (<-70 dBm): " << weakSignals << " devices\n";
+    if (networkSignal.count() > 0) {
+        view << "History p10/p50/p90: " << std::lround(networkSignal.quantile(0.1)) << " / "
+             << std::lround(networkSignal.quantile(0.5)) << " / " << std::lround(networkSignal.quantile(0.9)) << " dBm\n";
+    }
+    view << "\n";
     
-    std::cout << "Signal Quality Distribution:\n";
-    std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+    view << "Signal Quality Distribution:\n";
+    view << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
     
-    for (const auto& device : devices) {
-        std::string deviceName = generateDeviceName(device->macAddress);
-        std::string quality = getSignalQuality(device->rssi);
-        std::string bars = getSignalBars(device->rssi);
+    size_t shown = std::min(devices.size(), rowBudget(13));
+    for (size_t i = 0; i < shown; ++i) {
+        const auto& device = devices[i];
+        std::string deviceName = generateDeviceName(*device);
+        std::string_view quality = getSignalQuality(device->rssi);
+        std::string_view bars = getSignalBars(device->rssi);
         
-        std::cout << deviceName << std::string(12 - deviceName.length(), ' ') 
-                 << ": " << bars << " " << device->rssi << " dBm (" << quality << ")\n";
+        const DeviceSummary& summary = device->summary;
+        
+        view << deviceName << std::string(deviceName.length() < 12 ? 12 - deviceName.length() : 1, ' ') 
+                 << ": " << bars << " " << device->rssi << " dBm (" << quality << ")";
+        if (summary.rssi.count() > 1) {
+            char range[64];
+            std::snprintf(range, sizeof(range), "  p10-p90 %ld..%ld dBm, σ %.1f",
+                          std::lround(summary.rssiQuantiles.quantile(0.1)),
+                          std::lround(summary.rssiQuantiles.quantile(0.9)), summary.rssi.stdDev());
+            view << range;
+        }
+        long addresses = std::lround(summary.addresses.estimate());
+        if (addresses > 1) {
+            view << "  " << addresses << " IPs";
+        }
+        view << "\n";
+    }
+    if (shown < devices.size()) {
+        view << "+" << (devices.size() - shown) << " more devices\n";
     }
 }
 
-std::string DesktopUI::getSignalBars(int rssi) {
-    if (rssi >= -50) return "████████";
-    if (rssi >= -60) return "██████░░";
-    if (rssi >= -70) return "████░░░░";
-    return "██░░░░░░";
+std::string_view DesktopUI::getSignalBars(int rssi) {
+    return kQualityBars[static_cast<size_t>(signalQualityLevel(static_cast<float>(rssi)))];
 }
 
 void DesktopUI::showSettings() {
-    std::cout << "\nApplication Settings\n";
-    std::cout << "===================\n\n";
-    
-    std::cout << "Current Configuration:\n";
-    std::cout << "━━━━━━━━━━━━━━━━━━━━━━━\n";
-    std::cout << "Auto-refresh: " << (autoRefresh ? "\033[32mEnabled\033[0m" : "\033[31mDisabled\033[0m") << "\n";
-    std::cout << "Scan interval: 30 seconds\n";
-    std::cout << "Display mode: " << getCurrentViewName() << "\n";
-    std::cout << "Anomaly detection: \033[32mEnabled\033[0m\n\n";
-    
-    std::cout << "Available Actions:\n";
-    std::cout << "━━━━━━━━━━━━━━━━━━\n";
-    std::cout << "A: Toggle auto-refresh\n";
-    std::cout << "D: Reset to dashboard view\n";
-    std::cout << "C: Clear device history\n";
-    std::cout << "E: Export device data\n";
+    view << "\nApplication Settings\n";
+    view << "===================\n\n";
+    
+    view << "Current Configuration:\n";
+    view << "━━━━━━━━━━━━━━━━━━━━━━━\n";
+    view << "Auto-refresh: " << (autoRefresh ? "\033[32mEnabled\033[0m" : "\033[31mDisabled\033[0m") << "\n";
+    view << "Scan interval: 30 seconds\n";
+    view << "Display mode: " << getCurrentViewName() << "\n";
+    view << "Anomaly detection: \033[32mEnabled\033[0m\n\n";
+    
+    view << "Available Actions:\n";
+    view << "━━━━━━━━━━━━━━━━━━\n";
+    view << "A: Toggle auto-refresh\n";
+    view << "D: Reset to dashboard view\n";
+    view << "C: Clear device history\n";
+    view << "E: Export device data (CSV)\n";
+    view << "J: Export device data (NDJSON)\n";
+    view << "B: Export device data (binary)\n";
 }
 
 void DesktopUI::showHelp() {
-    std::cout << "\nSmartBlueprint Pro - Help Guide\n";
-    std::cout << "===============================\n\n";
-    
-    std::cout << "🔧 Application Overview:\n";
-    std::cout << "SmartBlueprint Pro monitors your local network in real-time,\n";
-    std::cout << "detecting smart home devices and analyzing their connectivity.\n\n";
-    
-    std::cout << "⌨️  Keyboard Commands:\n";
-    std::cout << "━━━━━━━━━━━━━━━━━━━━━\n";
-    std::cout << "R - Refresh device list manually\n";
-    std::cout << "S - Trigger immediate network scan\n";
-    std::cout << "Q - Quit application\n";
-    std::cout << "1 - Switch to Dashboard view\n";
-    std::cout << "2 - Switch to Device List view\n";
-    std::cout << "3 - Switch to Anomaly Monitor\n";
-    std::cout << "4 - Switch to Signal Analysis\n";
-    std::cout << "5 - Switch to Settings\n";
-    std::cout << "H - Show this help screen\n\n";
-    
-    std::cout << "📊 Features:\n";
-    std::cout << "━━━━━━━━━━━━\n";
-    std::cout << "• Real-time device discovery\n";
-    std::cout << "• Signal strength monitoring\n";
-    std::cout << "• ML-powered anomaly detection\n";
-    std::cout << "• Cross-platform compatibility\n";
-    std::cout << "• No cloud dependencies\n\n";
-    
-    std::cout << "❓ Troubleshooting:\n";
-    std::cout << "━━━━━━━━━━━━━━━━━━\n";
-    std::cout << "• If no devices appear, wait 60 seconds for full scan\n";
-    std::cout << "• Ensure network adapter is active\n";
-    std::cout << "• Run with administrator privileges for best results\n";
-    std::cout << "• Check firewall settings if scanning fails\n";
+    view << "\nSmartBlueprint Pro - Help Guide\n";
+    view << "===============================\n\n";
+    
+    view << "🔧 Application Overview:\n";
+    view << "SmartBlueprint Pro monitors your local network in real-time,\n";
+    view << "detecting smart home devices and analyzing their connectivity.\n\n";
+    
+    view << "⌨️  Keyboard Commands:\n";
+    view << "━━━━━━━━━━━━━━━━━━━━━\n";
+    view << "R - Refresh device list manually\n";
+    view << "N / P - Next / previous page of the device list\n";
+    view << "S - Trigger immediate network scan\n";
+    view << "Q - Quit application\n";
+    view << "1 - Switch to Dashboard view\n";
+    view << "2 - Switch to Device List view\n";
+    view << "3 - Switch to Anomaly Monitor\n";
+    view << "4 - Switch to Signal Analysis\n";
+    view << "5 - Switch to Settings\n";
+    view << "H - Show this help screen\n\n";
+    
+    view << "📊 Features:\n";
+    view << "━━━━━━━━━━━━\n";
+    view << "• Real-time device discovery\n";
+    view << "• Signal strength monitoring\n";
+    view << "• ML-powered anomaly detection\n";
+    view << "• Cross-platform compatibility\n";
+    view << "• No cloud dependencies\n\n";
+    
+    view << "❓ Troubleshooting:\n";
+    view << "━━━━━━━━━━━━━━━━━━\n";
+    view << "• If no devices appear, wait 60 seconds for full scan\n";
+    view << "• Ensure network adapter is active\n";
+    view << "• Run with administrator privileges for best results\n";
+    view << "• Check firewall settings if scanning fails\n";
 }
 
 void DesktopUI::showCommandBar() {
-    std::cout << "╠══════════════════════════════════════════════════════════════╣\n";
-    std::cout << "║ [ R ] Refresh List     [ S ] Scan Now     [ Q ] Quit        ║\n";
-    std::cout << "║                                                              ║\n";
-    std::cout << "║ Keyboard shortcuts to control the app:                      ║\n";
-    std::cout << "║ R: Refresh the list manually                                ║\n";
-    std::cout << "║ S: Trigger an immediate scan                                ║\n";
-    std::cout << "║ Q: Quit the application                                     ║\n";
-    std::cout << "║ 1: Dashboard  2: Device List  3: Anomalies  4: Settings    ║\n";
-    std::cout << "╚══════════════════════════════════════════════════════════════╝\n";
+    view << "╠══════════════════════════════════════════════════════════════╣\n";
+    view << "║ [ R ] Refresh List     [ S ] Scan Now     [ Q ] Quit        ║\n";
+    // Status line, e.g. export progress
+    std::string status = statusMessage.substr(0, 60);
+    view << "║ " << status << std::string(61 - status.size(), ' ') << "║\n";
+    view << "║ Keyboard shortcuts to control the app:                      ║\n";
+    view << "║ R: Refresh the list manually                                ║\n";
+    view << "║ S: Trigger an immediate scan                                ║\n";
+    view << "║ Q: Quit the application                                     ║\n";
+    view << "║ 1: Dashboard  2: Device List  3: Anomalies  4: Settings    ║\n";
+    view << "╚══════════════════════════════════════════════════════════════╝\n";
 }
 
 char DesktopUI::getKeyPress() {
@@ -408,6 +534,10 @@ void DesktopUI::setView(ViewMode view) {
     currentView = view;
 }
 
+void DesktopUI::setStatusMessage(const std::string& message) {
+    statusMessage = message;
+}
+
 void DesktopUI::toggleAutoRefresh() {
     autoRefresh = !autoRefresh;
 }
\ No newline at end of file
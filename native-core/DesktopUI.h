@@ -1,10 +1,14 @@
 #pragma once
 
 #include "NetworkScanner.h"
+#include "SignalQuality.h"
+#include "TerminalFrame.h"
 #include <vector>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <chrono>
+#include <sstream>
 
 enum class ViewMode {
     DASHBOARD,
@@ -27,10 +31,16 @@ public:
     char getKeyPress();
     void setView(ViewMode view);
     void toggleAutoRefresh();
+    void nextPage();
+    void previousPage();
+    // One line shown above the keyboard shortcuts
+    void setStatusMessage(const std::string& message);
     
     ViewMode getCurrentView() const { return currentView; }
     bool isAutoRefreshEnabled() const { return autoRefresh; }
     
+    void clearScreen();
+    
 private:
     ViewMode currentView;
     bool autoRefresh;
@@ -38,9 +48,18 @@ private:
     std::vector<std::shared_ptr<NetworkDevice>> devices;
     std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>> anomalies;
     
+    // Views print into `view`; render() lays it out in the frame and writes
+    // only the difference from the previous frame
+    TerminalFrame frame;
+    std::ostringstream view;
+    std::string output;
+    size_t devicePage;
+    std::string statusMessage;
+    
     void setupConsole();
     void restoreConsole();
-    void clearScreen();
+    void updateViewport();
+    size_t rowBudget(size_t usedRows) const;
     void showHeader();
     std::string getCurrentViewName();
     
@@ -53,7 +72,9 @@ private:
     void showCommandBar();
     void showAnomaliesCompact();
     
-    std::string generateDeviceName(const std::string& macAddress);
-    std::string getSignalQuality(int rssi);
-    std::string getSignalBars(int rssi);
+    // Type label plus the last MAC octet once the device is classified
+    std::string generateDeviceName(const NetworkDevice& device);
+    // Views into constant tables indexed by SignalQualityLevel
+    std::string_view getSignalQuality(int rssi);
+    std::string_view getSignalBars(int rssi);
 };
\ No newline at end of file
@@ -1,276 +1,488 @@
 #include "DeviceClassifier.h"
+#include "Metrics.h"
 #include <algorithm>
 #include <cctype>
+#include <fstream>
+#include <iostream>
+#include <iterator>
 
-DeviceClassifier::DeviceClassifier() {
+namespace {
+
+struct BuiltinVendor {
+    uint32_t oui;
+    const char* name;
+};
+
+const BuiltinVendor kBuiltinVendors[] = {
+    // Major network equipment vendors
+    {0x00000c, "Cisco"},
+    {0x000142, "Cisco"},
+    {0x000196, "Cisco"},
+    {0x000f66, "Cisco"},
+    {0x001b0d, "Cisco"},
+
+    // Apple devices
+    {0x000393, "Apple"},
+    {0x000a95, "Apple"},
+    {0x000d93, "Apple"},
+    {0x0016cb, "Apple"},
+    {0x0017f2, "Apple"},
+    {0x0019e3, "Apple"},
+    {0x001b63, "Apple"},
+    {0x001cb3, "Apple"},
+    {0x001ec2, "Apple"},
+    {0x0021e9, "Apple"},
+    {0x002241, "Apple"},
+    {0x002312, "Apple"},
+    {0x0023df, "Apple"},
+    {0x002500, "Apple"},
+    {0x00254b, "Apple"},
+    {0x0025bc, "Apple"},
+    {0x002608, "Apple"},
+    {0x00264a, "Apple"},
+    {0x0026b0, "Apple"},
+    {0x0026bb, "Apple"},
+
+    // Samsung
+    {0x0012fb, "Samsung"},
+    {0x001377, "Samsung"},
+    {0x001599, "Samsung"},
+    {0x001632, "Samsung"},
+    {0x0017c9, "Samsung"},
+    {0x001a8a, "Samsung"},
+    {0x001d25, "Samsung"},
+    {0x001e7d, "Samsung"},
+    {0x002119, "Samsung"},
+    {0x002339, "Samsung"},
+
+    // HP
+    {0x0001e6, "HP"},
+    {0x0002a5, "HP"},
+    {0x0004ea, "HP"},
+    {0x0008c7, "HP"},
+    {0x000bcd, "HP"},
+    {0x000e7f, "HP"},
+    {0x0010e3, "HP"},
+    {0x00110a, "HP"},
+    {0x001279, "HP"},
+    {0x001321, "HP"},
+    {0x001438, "HP"},
+    {0x0014c2, "HP"},
+    {0x001560, "HP"},
+    {0x001635, "HP"},
+    {0x001708, "HP"},
+    {0x0017a4, "HP"},
+    {0x0018fe, "HP"},
+    {0x0019bb, "HP"},
+    {0x001a4b, "HP"},
+    {0x001b78, "HP"},
+    {0x001cc4, "HP"},
+    {0x001e0b, "HP"},
+    {0x001f29, "HP"},
+
+    // Intel
+    {0x0002b3, "Intel"},
+    {0x000347, "Intel"},
+    {0x000423, "Intel"},
+    {0x0007e9, "Intel"},
+    {0x000cf1, "Intel"},
+    {0x000e0c, "Intel"},
+    {0x0012f0, "Intel"},
+    {0x001302, "Intel"},
+    {0x001320, "Intel"},
+    {0x0013ce, "Intel"},
+    {0x0013e8, "Intel"},
+    {0x001517, "Intel"},
+    {0x001676, "Intel"},
+    {0x0016ea, "Intel"},
+    {0x0018de, "Intel"},
+    {0x0019d1, "Intel"},
+    {0x001b21, "Intel"},
+    {0x001cbf, "Intel"},
+    {0x001de0, "Intel"},
+    {0x001e64, "Intel"},
+    {0x001f3a, "Intel"},
+
+    // D-Link
+    {0x00055d, "D-Link"},
+    {0x00077d, "D-Link"},
+    {0x000d88, "D-Link"},
+    {0x000f3d, "D-Link"},
+    {0x001195, "D-Link"},
+    {0x001346, "D-Link"},
+    {0x0015e9, "D-Link"},
+    {0x00179a, "D-Link"},
+    {0x0018e7, "D-Link"},
+    {0x00195b, "D-Link"},
+    {0x001b11, "D-Link"},
+    {0x001cf0, "D-Link"},
+    {0x001e58, "D-Link"},
+    {0x001f1f, "D-Link"},
+
+    // TP-Link
+    {0x001d0f, "TP-Link"},
+    {0x002127, "TP-Link"},
+    {0x0022b0, "TP-Link"},
+    {0x0023cd, "TP-Link"},
+    {0x0024a5, "TP-Link"},
+    {0x002586, "TP-Link"},
+    {0x00265a, "TP-Link"},
+    {0x002719, "TP-Link"},
+
+    // Netgear
+    {0x00095b, "Netgear"},
+    {0x000fb5, "Netgear"},
+    {0x00146c, "Netgear"},
+    {0x00184d, "Netgear"},
+    {0x001b2f, "Netgear"},
+    {0x001e2a, "Netgear"},
+    {0x00223f, "Netgear"},
+    {0x0024b2, "Netgear"},
+    {0x0026f2, "Netgear"},
+
+    // Linksys
+    {0x000625, "Linksys"},
+    {0x000c41, "Linksys"},
+    {0x000e08, "Linksys"},
+    {0x001217, "Linksys"},
+    {0x001310, "Linksys"},
+    {0x0014bf, "Linksys"},
+    {0x0016b6, "Linksys"},
+    {0x001839, "Linksys"},
+    {0x0018f8, "Linksys"},
+    {0x001a70, "Linksys"},
+    {0x001c10, "Linksys"},
+    {0x001d7e, "Linksys"},
+    {0x0020a6, "Linksys"},
+    {0x002129, "Linksys"},
+    {0x00226b, "Linksys"},
+    {0x002369, "Linksys"},
+    {0x00259c, "Linksys"},
+};
+
+struct TypeRule {
+    std::string_view pattern;
+    DeviceType type;
+};
+
+// Built-in rules; loadPatternRules() adds to and overrides them
+constexpr TypeRule kHostnameRules[] = {
+    {"router", DeviceType::Router},
+    {"gateway", DeviceType::Router},
+    {"ap", DeviceType::AccessPoint},
+    {"printer", DeviceType::Printer},
+    {"print", DeviceType::Printer},
+    {"hp", DeviceType::Printer},
+    {"canon", DeviceType::Printer},
+    {"epson", DeviceType::Printer},
+    {"brother", DeviceType::Printer},
+    {"tv", DeviceType::SmartTv},
+    {"samsung", DeviceType::SmartTv},
+    {"lg", DeviceType::SmartTv},
+    {"sony", DeviceType::SmartTv},
+    {"roku", DeviceType::StreamingDevice},
+    {"chromecast", DeviceType::StreamingDevice},
+    {"appletv", DeviceType::StreamingDevice},
+    {"xbox", DeviceType::GamingConsole},
+    {"playstation", DeviceType::GamingConsole},
+    {"ps4", DeviceType::GamingConsole},
+    {"ps5", DeviceType::GamingConsole},
+    {"nintendo", DeviceType::GamingConsole},
+    {"laptop", DeviceType::Laptop},
+    {"desktop", DeviceType::Desktop},
+    {"phone", DeviceType::Smartphone},
+    {"iphone", DeviceType::Smartphone},
+    {"android", DeviceType::Smartphone},
+    {"tablet", DeviceType::Tablet},
+    {"ipad", DeviceType::Tablet},
+    {"echo", DeviceType::SmartSpeaker},
+    {"alexa", DeviceType::SmartSpeaker},
+    {"homepod", DeviceType::SmartSpeaker},
+    {"google home", DeviceType::SmartSpeaker},
+    {"nest", DeviceType::SmartHome},
+    {"ring", DeviceType::SecurityCamera},
+    {"camera", DeviceType::SecurityCamera},
+    {"doorbell", DeviceType::SmartDoorbell},
+    {"thermostat", DeviceType::SmartThermostat},
+    {"light", DeviceType::SmartLight},
+    {"bulb", DeviceType::SmartLight},
+    {"switch", DeviceType::SmartSwitch},
+    {"plug", DeviceType::SmartPlug},
+    {"outlet", DeviceType::SmartPlug},
+};
+
+constexpr TypeRule kVendorRules[] = {
+    {"apple", DeviceType::Smartphone},
+    {"samsung", DeviceType::Smartphone},
+    {"hp", DeviceType::Printer},
+    {"canon", DeviceType::Printer},
+    {"epson", DeviceType::Printer},
+    {"brother", DeviceType::Printer},
+    {"cisco", DeviceType::Router},
+    {"netgear", DeviceType::Router},
+    {"linksys", DeviceType::Router},
+    {"d-link", DeviceType::Router},
+    {"tp-link", DeviceType::Router},
+    {"intel", DeviceType::Laptop},
+};
+
+struct OuiTypeRule {
+    uint32_t oui;
+    DeviceType type;
+};
+
+constexpr OuiTypeRule kOuiRules[] = {
+    {0x000393, DeviceType::Smartphone}, // Apple
+    {0x000a95, DeviceType::Smartphone}, // Apple
+    {0x0012fb, DeviceType::Smartphone}, // Samsung
+    {0x0001e6, DeviceType::Printer}, // HP
+    {0x0004ea, DeviceType::Printer}, // HP
+    {0x00000c, DeviceType::Router}, // Cisco
+    {0x00055d, DeviceType::Router}, // D-Link
+    {0x001d0f, DeviceType::Router}, // TP-Link
+    {0x00095b, DeviceType::Router}, // Netgear
+    {0x000625, DeviceType::Router}, // Linksys
+};
+
+uint64_t hashHostname(const std::string& hostname) {
+    // FNV-1a over the case-folded name; matching is case-insensitive anyway
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : hostname) {
+        hash ^= static_cast<unsigned char>(std::tolower(c));
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+DeviceClassifier::DeviceClassifier(size_t cacheCapacity) : cacheCapacity(cacheCapacity), cacheGeneration(0) {
     initializeVendorDatabase();
-    initializeDevicePatterns();
 }
 
-std::string DeviceClassifier::classifyDevice(const std::shared_ptr<NetworkDevice>& device) {
-    std::string vendor = identifyVendor(device->macAddress);
-    std::string hostname = device->hostname;
-    
-    // Convert to lowercase for pattern matching
-    std::transform(hostname.begin(), hostname.end(), hostname.begin(), ::tolower);
-    std::transform(vendor.begin(), vendor.end(), vendor.begin(), ::tolower);
-    
-    // Check hostname patterns first
-    for (const auto& pattern : devicePatterns) {
-        if (hostname.find(pattern.first) != std::string::npos) {
-            return pattern.second;
-        }
+void DeviceClassifier::ensureRules() {
+    // Building and compiling the rule tables waits for the first
+    // classification, so constructing a classifier costs nothing at startup
+    std::call_once(rulesReady, [this] {
+        initializeDevicePatterns();
+        compilePatterns();
+    });
+}
+
+DeviceType DeviceClassifier::classifyDevice(const std::shared_ptr<NetworkDevice>& device) {
+    MacAddress mac = device->mac;
+    if (mac.isZero()) {
+        MacAddress::parse(device->macAddress, mac);
     }
+    CacheKey key{mac.toUint64(), hashHostname(device->hostname)};
+    uint64_t generation;
     
-    // Check vendor patterns
-    for (const auto& pattern : vendorPatterns) {
-        if (vendor.find(pattern.first) != std::string::npos) {
-            return pattern.second;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = cacheIndex.find(key);
+        if (it != cacheIndex.end()) {
+            cacheOrder.splice(cacheOrder.begin(), cacheOrder, it->second);
+            cacheStats.hits++;
+            SB_COUNT(CacheHits, 1);
+            return it->second->second;
         }
+        cacheStats.misses++;
+        SB_COUNT(CacheMisses, 1);
+        generation = cacheGeneration;
     }
     
-    // Check MAC address patterns
-    std::string macPrefix = device->macAddress.substr(0, 8);
-    std::transform(macPrefix.begin(), macPrefix.end(), macPrefix.begin(), ::tolower);
+    ensureRules();
+    DeviceType deviceType = classifyUncached(*device);
     
-    auto it = macToDeviceType.find(macPrefix);
-    if (it != macToDeviceType.end()) {
-        return it->second;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (cacheCapacity == 0 || generation != cacheGeneration || cacheIndex.count(key)) {
+        return deviceType;
     }
-    
-    return "unknown";
+    if (cacheIndex.size() >= cacheCapacity) {
+        // Reuse the evicted entry's list and map nodes, so a working set
+        // larger than the cache doesn't allocate on every miss
+        cacheOrder.splice(cacheOrder.begin(), cacheOrder, std::prev(cacheOrder.end()));
+        auto node = cacheIndex.extract(cacheOrder.front().first);
+        cacheOrder.front().first = key;
+        cacheOrder.front().second = deviceType;
+        node.key() = key;
+        cacheIndex.insert(std::move(node));
+        cacheStats.evictions++;
+        return deviceType;
+    }
+    cacheOrder.emplace_front(key, deviceType);
+    cacheIndex[key] = cacheOrder.begin();
+    return deviceType;
 }
 
-std::string DeviceClassifier::identifyVendor(const std::string& macAddress) {
-    if (macAddress.length() < 8) return "Unknown";
+DeviceType DeviceClassifier::classifyUncached(const NetworkDevice& device) const {
+    MacAddress mac = device.mac;
+    if (mac.isZero()) {
+        MacAddress::parse(device.macAddress, mac);
+    }
     
-    std::string prefix = macAddress.substr(0, 8);
-    std::transform(prefix.begin(), prefix.end(), prefix.begin(), ::tolower);
+    // Hostname rules take precedence over vendor rules; matching is case-insensitive
+    int rule = hostnameMatcher.match(device.hostname);
+    if (rule != PatternMatcher::kNoMatch) {
+        return hostnameTypes[rule];
+    }
+    
+    rule = vendorMatcher.match(identifyVendor(mac));
+    if (rule != PatternMatcher::kNoMatch) {
+        return vendorTypes[rule];
+    }
     
-    auto it = ouiDatabase.find(prefix);
-    if (it != ouiDatabase.end()) {
+    // Check MAC address patterns
+    auto it = macToDeviceType.find(mac.oui());
+    if (it != macToDeviceType.end()) {
         return it->second;
     }
     
-    return "Unknown";
+    return DeviceType::Unknown;
 }
 
-void DeviceClassifier::initializeVendorDatabase() {
-    // Major network equipment vendors
-    ouiDatabase["00:00:0c"] = "Cisco";
-    ouiDatabase["00:01:42"] = "Cisco";
-    ouiDatabase["00:01:96"] = "Cisco";
-    ouiDatabase["00:0f:66"] = "Cisco";
-    ouiDatabase["00:1b:0d"] = "Cisco";
-    
-    // Apple devices
-    ouiDatabase["00:03:93"] = "Apple";
-    ouiDatabase["00:0a:95"] = "Apple";
-    ouiDatabase["00:0d:93"] = "Apple";
-    ouiDatabase["00:16:cb"] = "Apple";
-    ouiDatabase["00:17:f2"] = "Apple";
-    ouiDatabase["00:19:e3"] = "Apple";
-    ouiDatabase["00:1b:63"] = "Apple";
-    ouiDatabase["00:1c:b3"] = "Apple";
-    ouiDatabase["00:1e:c2"] = "Apple";
-    ouiDatabase["00:21:e9"] = "Apple";
-    ouiDatabase["00:22:41"] = "Apple";
-    ouiDatabase["00:23:12"] = "Apple";
-    ouiDatabase["00:23:df"] = "Apple";
-    ouiDatabase["00:25:00"] = "Apple";
-    ouiDatabase["00:25:4b"] = "Apple";
-    ouiDatabase["00:25:bc"] = "Apple";
-    ouiDatabase["00:26:08"] = "Apple";
-    ouiDatabase["00:26:4a"] = "Apple";
-    ouiDatabase["00:26:b0"] = "Apple";
-    ouiDatabase["00:26:bb"] = "Apple";
+std::string_view DeviceClassifier::identifyVendor(const std::string& macAddress) const {
+    MacAddress mac;
+    if (!MacAddress::parse(macAddress, mac)) return "Unknown";
     
-    // Samsung
-    ouiDatabase["00:12:fb"] = "Samsung";
-    ouiDatabase["00:13:77"] = "Samsung";
-    ouiDatabase["00:15:99"] = "Samsung";
-    ouiDatabase["00:16:32"] = "Samsung";
-    ouiDatabase["00:17:c9"] = "Samsung";
-    ouiDatabase["00:1a:8a"] = "Samsung";
-    ouiDatabase["00:1d:25"] = "Samsung";
-    ouiDatabase["00:1e:7d"] = "Samsung";
-    ouiDatabase["00:21:19"] = "Samsung";
-    ouiDatabase["00:23:39"] = "Samsung";
-    
-    // HP
-    ouiDatabase["00:01:e6"] = "HP";
-    ouiDatabase["00:02:a5"] = "HP";
-    ouiDatabase["00:04:ea"] = "HP";
-    ouiDatabase["00:08:c7"] = "HP";
-    ouiDatabase["00:0b:cd"] = "HP";
-    ouiDatabase["00:0e:7f"] = "HP";
-    ouiDatabase["00:10:e3"] = "HP";
-    ouiDatabase["00:11:0a"] = "HP";
-    ouiDatabase["00:12:79"] = "HP";
-    ouiDatabase["00:13:21"] = "HP";
-    ouiDatabase["00:14:38"] = "HP";
-    ouiDatabase["00:14:c2"] = "HP";
-    ouiDatabase["00:15:60"] = "HP";
-    ouiDatabase["00:16:35"] = "HP";
-    ouiDatabase["00:17:08"] = "HP";
-    ouiDatabase["00:17:a4"] = "HP";
-    ouiDatabase["00:18:fe"] = "HP";
-    ouiDatabase["00:19:bb"] = "HP";
-    ouiDatabase["00:1a:4b"] = "HP";
-    ouiDatabase["00:1b:78"] = "HP";
-    ouiDatabase["00:1c:c4"] = "HP";
-    ouiDatabase["00:1e:0b"] = "HP";
-    ouiDatabase["00:1f:29"] = "HP";
-    
-    // Intel
-    ouiDatabase["00:02:b3"] = "Intel";
-    ouiDatabase["00:03:47"] = "Intel";
-    ouiDatabase["00:04:23"] = "Intel";
-    ouiDatabase["00:07:e9"] = "Intel";
-    ouiDatabase["00:0c:f1"] = "Intel";
-    ouiDatabase["00:0e:0c"] = "Intel";
-    ouiDatabase["00:12:f0"] = "Intel";
-    ouiDatabase["00:13:02"] = "Intel";
-    ouiDatabase["00:13:20"] = "Intel";
-    ouiDatabase["00:13:ce"] = "Intel";
-    ouiDatabase["00:13:e8"] = "Intel";
-    ouiDatabase["00:15:17"] = "Intel";
-    ouiDatabase["00:16:76"] = "Intel";
-    ouiDatabase["00:16:ea"] = "Intel";
-    ouiDatabase["00:18:de"] = "Intel";
-    ouiDatabase["00:19:d1"] = "Intel";
-    ouiDatabase["00:1b:21"] = "Intel";
-    ouiDatabase["00:1c:bf"] = "Intel";
-    ouiDatabase["00:1d:e0"] = "Intel";
-    ouiDatabase["00:1e:64"] = "Intel";
-    ouiDatabase["00:1f:3a"] = "Intel";
-    
-    // D-Link
-    ouiDatabase["00:05:5d"] = "D-Link";
-    ouiDatabase["00:07:7d"] = "D-Link";
-    ouiDatabase["00:0d:88"] = "D-Link";
-    ouiDatabase["00:0f:3d"] = "D-Link";
-    ouiDatabase["00:11:95"] = "D-Link";
-    ouiDatabase["00:13:46"] = "D-Link";
-    ouiDatabase["00:15:e9"] = "D-Link";
-    ouiDatabase["00:17:9a"] = "D-Link";
-    ouiDatabase["00:18:e7"] = "D-Link";
-    ouiDatabase["00:19:5b"] = "D-Link";
-    ouiDatabase["00:1b:11"] = "D-Link";
-    ouiDatabase["00:1c:f0"] = "D-Link";
-    ouiDatabase["00:1e:58"] = "D-Link";
-    ouiDatabase["00:1f:1f"] = "D-Link";
-    
-    // TP-Link
-    ouiDatabase["00:1d:0f"] = "TP-Link";
-    ouiDatabase["00:21:27"] = "TP-Link";
-    ouiDatabase["00:22:b0"] = "TP-Link";
-    ouiDatabase["00:23:cd"] = "TP-Link";
-    ouiDatabase["00:24:a5"] = "TP-Link";
-    ouiDatabase["00:25:86"] = "TP-Link";
-    ouiDatabase["00:26:5a"] = "TP-Link";
-    ouiDatabase["00:27:19"] = "TP-Link";
-    
-    // Netgear
-    ouiDatabase["00:09:5b"] = "Netgear";
-    ouiDatabase["00:0f:b5"] = "Netgear";
-    ouiDatabase["00:14:6c"] = "Netgear";
-    ouiDatabase["00:18:4d"] = "Netgear";
-    ouiDatabase["00:1b:2f"] = "Netgear";
-    ouiDatabase["00:1e:2a"] = "Netgear";
-    ouiDatabase["00:22:3f"] = "Netgear";
-    ouiDatabase["00:24:b2"] = "Netgear";
-    ouiDatabase["00:26:f2"] = "Netgear";
-    
-    // Linksys
-    ouiDatabase["00:06:25"] = "Linksys";
-    ouiDatabase["00:0c:41"] = "Linksys";
-    ouiDatabase["00:0e:08"] = "Linksys";
-    ouiDatabase["00:12:17"] = "Linksys";
-    ouiDatabase["00:13:10"] = "Linksys";
-    ouiDatabase["00:14:bf"] = "Linksys";
-    ouiDatabase["00:16:b6"] = "Linksys";
-    ouiDatabase["00:18:39"] = "Linksys";
-    ouiDatabase["00:18:f8"] = "Linksys";
-    ouiDatabase["00:1a:70"] = "Linksys";
-    ouiDatabase["00:1c:10"] = "Linksys";
-    ouiDatabase["00:1d:7e"] = "Linksys";
-    ouiDatabase["00:20:a6"] = "Linksys";
-    ouiDatabase["00:21:29"] = "Linksys";
-    ouiDatabase["00:22:6b"] = "Linksys";
-    ouiDatabase["00:23:69"] = "Linksys";
-    ouiDatabase["00:25:9c"] = "Linksys";
+    return identifyVendor(mac);
+}
+
+std::string_view DeviceClassifier::identifyVendor(MacAddress mac) const {
+    std::string_view vendor = vendorDatabase.lookup(mac);
+    return vendor.empty() ? std::string_view("Unknown") : vendor;
+}
+
+void DeviceClassifier::initializeVendorDatabase() {
+    // Built-in defaults; loadVendorDatabase() adds the full IEEE registry on top
+    for (const auto& vendor : kBuiltinVendors) {
+        vendorDatabase.addEntry(OuiDatabase::MA_L, vendor.oui, vendor.name);
+    }
+    vendorDatabase.finalize();
+}
+
+bool DeviceClassifier::loadVendorDatabase(const std::string& path) {
+    // Prebuilt binary indexes map directly; anything else is parsed as an IEEE registry file
+    bool loaded = vendorDatabase.loadIndex(path) || vendorDatabase.loadIeeeRegistry(path) > 0;
+    clearCache();
+    return loaded;
 }
 
 void DeviceClassifier::initializeDevicePatterns() {
-    // Hostname patterns
-    devicePatterns["router"] = "router";
-    devicePatterns["gateway"] = "router";
-    devicePatterns["ap"] = "access_point";
-    devicePatterns["printer"] = "printer";
-    devicePatterns["print"] = "printer";
-    devicePatterns["hp"] = "printer";
-    devicePatterns["canon"] = "printer";
-    devicePatterns["epson"] = "printer";
-    devicePatterns["brother"] = "printer";
-    devicePatterns["tv"] = "smart_tv";
-    devicePatterns["samsung"] = "smart_tv";
-    devicePatterns["lg"] = "smart_tv";
-    devicePatterns["sony"] = "smart_tv";
-    devicePatterns["roku"] = "streaming_device";
-    devicePatterns["chromecast"] = "streaming_device";
-    devicePatterns["appletv"] = "streaming_device";
-    devicePatterns["xbox"] = "gaming_console";
-    devicePatterns["playstation"] = "gaming_console";
-    devicePatterns["ps4"] = "gaming_console";
-    devicePatterns["ps5"] = "gaming_console";
-    devicePatterns["nintendo"] = "gaming_console";
-    devicePatterns["switch"] = "gaming_console";
-    devicePatterns["laptop"] = "laptop";
-    devicePatterns["desktop"] = "desktop";
-    devicePatterns["phone"] = "smartphone";
-    devicePatterns["iphone"] = "smartphone";
-    devicePatterns["android"] = "smartphone";
-    devicePatterns["tablet"] = "tablet";
-    devicePatterns["ipad"] = "tablet";
-    devicePatterns["echo"] = "smart_speaker";
-    devicePatterns["alexa"] = "smart_speaker";
-    devicePatterns["homepod"] = "smart_speaker";
-    devicePatterns["google home"] = "smart_speaker";
-    devicePatterns["nest"] = "smart_home";
-    devicePatterns["ring"] = "security_camera";
-    devicePatterns["camera"] = "security_camera";
-    devicePatterns["doorbell"] = "smart_doorbell";
-    devicePatterns["thermostat"] = "smart_thermostat";
-    devicePatterns["light"] = "smart_light";
-    devicePatterns["bulb"] = "smart_light";
-    devicePatterns["switch"] = "smart_switch";
-    devicePatterns["plug"] = "smart_plug";
-    devicePatterns["outlet"] = "smart_plug";
+    for (const auto& rule : kHostnameRules) {
+        devicePatterns[std::string(rule.pattern)] = rule.type;
+    }
+    for (const auto& rule : kVendorRules) {
+        vendorPatterns[std::string(rule.pattern)] = rule.type;
+    }
+    for (const auto& rule : kOuiRules) {
+        macToDeviceType[rule.oui] = rule.type;
+    }
+}
+
+const std::map<std::string, DeviceType>& DeviceClassifier::getHostnamePatterns() {
+    ensureRules();
+    return devicePatterns;
+}
+
+const std::map<std::string, DeviceType>& DeviceClassifier::getVendorPatterns() {
+    ensureRules();
+    return vendorPatterns;
+}
+
+void DeviceClassifier::compilePatterns() {
+    // Priority is the rank in map order, matching the original first-match-wins scan
+    // Rule indices from addPattern() index the type vectors
+    hostnameMatcher.clear();
+    hostnameTypes.clear();
+    uint32_t priority = 0;
+    for (const auto& pattern : devicePatterns) {
+        hostnameMatcher.addPattern(pattern.first, deviceTypeName(pattern.second), priority++);
+        hostnameTypes.push_back(pattern.second);
+    }
+    hostnameMatcher.compile();
     
-    // Vendor patterns
-    vendorPatterns["apple"] = "smartphone";
-    vendorPatterns["samsung"] = "smartphone";
-    vendorPatterns["hp"] = "printer";
-    vendorPatterns["canon"] = "printer";
-    vendorPatterns["epson"] = "printer";
-    vendorPatterns["brother"] = "printer";
-    vendorPatterns["cisco"] = "router";
-    vendorPatterns["netgear"] = "router";
-    vendorPatterns["linksys"] = "router";
-    vendorPatterns["d-link"] = "router";
-    vendorPatterns["tp-link"] = "router";
-    vendorPatterns["intel"] = "laptop";
+    vendorMatcher.clear();
+    vendorTypes.clear();
+    priority = 0;
+    for (const auto& pattern : vendorPatterns) {
+        vendorMatcher.addPattern(pattern.first, deviceTypeName(pattern.second), priority++);
+        vendorTypes.push_back(pattern.second);
+    }
+    vendorMatcher.compile();
+}
+
+int DeviceClassifier::loadPatternRules(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return -1;
+    }
     
-    // MAC address prefix patterns
-    macToDeviceType["00:03:93"] = "smartphone"; // Apple
-    macToDeviceType["00:0a:95"] = "smartphone"; // Apple
-    macToDeviceType["00:12:fb"] = "smartphone"; // Samsung
-    macToDeviceType["00:01:e6"] = "printer"; // HP
-    macToDeviceType["00:04:ea"] = "printer"; // HP
-    macToDeviceType["00:00:0c"] = "router"; // Cisco
-    macToDeviceType["00:05:5d"] = "router"; // D-Link
-    macToDeviceType["00:1d:0f"] = "router"; // TP-Link
-    macToDeviceType["00:09:5b"] = "router"; // Netgear
-    macToDeviceType["00:06:25"] = "router"; // Linksys
-}
\ No newline at end of file
+    // Loaded rules override the built-in ones, so those must be in place first
+    ensureRules();
+
+    int loaded = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        line.erase(std::find(line.begin(), line.end(), '#'), line.end());
+        
+        size_t first = line.find(',');
+        size_t second = first == std::string::npos ? first : line.find(',', first + 1);
+        if (second == std::string::npos) continue;
+        
+        auto trim = [](std::string text) {
+            size_t begin = text.find_first_not_of(" \t\r");
+            size_t end = text.find_last_not_of(" \t\r");
+            return begin == std::string::npos ? std::string() : text.substr(begin, end - begin + 1);
+        };
+        std::string kind = trim(line.substr(0, first));
+        std::string pattern = trim(line.substr(first + 1, second - first - 1));
+        std::string typeName = trim(line.substr(second + 1));
+        if (pattern.empty() || typeName.empty()) continue;
+
+        DeviceType type;
+        if (!parseDeviceType(typeName, type)) {
+            std::cerr << "Skipping rule with unknown device type: " << typeName << std::endl;
+            continue;
+        }
+        
+        std::transform(pattern.begin(), pattern.end(), pattern.begin(), ::tolower);
+        if (kind == "hostname") {
+            devicePatterns[pattern] = type;
+        } else if (kind == "vendor") {
+            vendorPatterns[pattern] = type;
+        } else {
+            continue;
+        }
+        loaded++;
+    }
+    
+    compilePatterns();
+    clearCache();
+    return loaded;
+}
+
+DeviceClassifier::CacheStats DeviceClassifier::getCacheStats() const {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    CacheStats stats = cacheStats;
+    stats.entries = cacheIndex.size();
+    stats.capacity = cacheCapacity;
+    return stats;
+}
+
+void DeviceClassifier::setCacheCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cacheCapacity = capacity;
+    while (cacheIndex.size() > cacheCapacity) {
+        cacheIndex.erase(cacheOrder.back().first);
+        cacheOrder.pop_back();
+        cacheStats.evictions++;
+    }
+}
+
+void DeviceClassifier::clearCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cacheIndex.clear();
+    cacheOrder.clear();
+    cacheGeneration++;
+}
@@ -1,23 +1,97 @@
 #pragma once
 
 #include "NetworkScanner.h"
+#include "OuiDatabase.h"
+#include "PatternMatcher.h"
 #include <string>
+#include <string_view>
 #include <map>
+#include <unordered_map>
+#include <cstdint>
 #include <memory>
+#include <list>
+#include <mutex>
+#include <vector>
 
 class DeviceClassifier {
 public:
-    DeviceClassifier();
+    struct CacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t entries = 0;
+        size_t capacity = 0;
+    };
     
-    std::string classifyDevice(const std::shared_ptr<NetworkDevice>& device);
-    std::string identifyVendor(const std::string& macAddress);
+    explicit DeviceClassifier(size_t cacheCapacity = 4096);
+    
+    // Results are cached per (MAC, hostname) until the rules or vendor table change
+    DeviceType classifyDevice(const std::shared_ptr<NetworkDevice>& device);
+    
+    // Returned views point into the vendor table and never allocate
+    std::string_view identifyVendor(const std::string& macAddress) const;
+    std::string_view identifyVendor(MacAddress mac) const;
+    
+    // Loads a prebuilt binary OUI index (mmapped) or an IEEE registry file
+    // (oui.txt, oui.csv, mam.csv, oui36.csv)
+    bool loadVendorDatabase(const std::string& path);
+    const OuiDatabase& getVendorDatabase() const { return vendorDatabase; }
+    
+    // Adds or overrides rules from a text file of "hostname,<pattern>,<type>"
+    // and "vendor,<pattern>,<type>" lines ('#' starts a comment), where type
+    // is a DeviceType name; rules naming other types are skipped.
+    // Returns the number of rules read, or -1 if the file can't be opened.
+    int loadPatternRules(const std::string& path);
+    
+    // Current hostname and vendor rules by lowercase pattern; on overlapping
+    // matches the rule earliest in map order wins
+    const std::map<std::string, DeviceType>& getHostnamePatterns();
+    const std::map<std::string, DeviceType>& getVendorPatterns();
+    
+    CacheStats getCacheStats() const;
+    void setCacheCapacity(size_t capacity);
+    void clearCache();
     
 private:
-    std::map<std::string, std::string> ouiDatabase;
-    std::map<std::string, std::string> devicePatterns;
-    std::map<std::string, std::string> vendorPatterns;
-    std::map<std::string, std::string> macToDeviceType;
+    struct CacheKey {
+        uint64_t mac;
+        uint64_t hostnameHash;
+        bool operator==(const CacheKey& other) const {
+            return mac == other.mac && hostnameHash == other.hostnameHash;
+        }
+    };
+    struct CacheKeyHash {
+        size_t operator()(const CacheKey& key) const noexcept {
+            return static_cast<size_t>((key.mac * 0x9E3779B97F4A7C15ull) ^ key.hostnameHash);
+        }
+    };
+    using CacheList = std::list<std::pair<CacheKey, DeviceType>>;
+    
+    // LRU cache: most recently used entries at the front of the list
+    mutable std::mutex cacheMutex;
+    CacheList cacheOrder;
+    std::unordered_map<CacheKey, CacheList::iterator, CacheKeyHash> cacheIndex;
+    size_t cacheCapacity;
+    CacheStats cacheStats;
+    // Bumped by clearCache(); a result computed before a reload isn't cached after it
+    uint64_t cacheGeneration;
+    
+    OuiDatabase vendorDatabase;
+    std::map<std::string, DeviceType> devicePatterns;
+    std::map<std::string, DeviceType> vendorPatterns;
+    std::unordered_map<uint32_t, DeviceType> macToDeviceType;
+    
+    // Built on first use by ensureRules(); compiled from the pattern maps,
+    // with rule priority following map order
+    std::once_flag rulesReady;
+    PatternMatcher hostnameMatcher;
+    PatternMatcher vendorMatcher;
+    std::vector<DeviceType> hostnameTypes; // by matcher rule index
+    std::vector<DeviceType> vendorTypes;
     
     void initializeVendorDatabase();
+    void ensureRules();
     void initializeDevicePatterns();
+    void compilePatterns();
+    DeviceType classifyUncached(const NetworkDevice& device) const;
 };
\ No newline at end of file
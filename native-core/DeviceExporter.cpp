@@ -0,0 +1,482 @@
+#include "DeviceExporter.h"
+#include "Checksum.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+namespace {
+
+constexpr char kFileMagic[8] = {'S', 'B', 'E', 'X', 'P', 'R', 'T', '\0'};
+constexpr char kTrailerMagic[4] = {'S', 'B', 'E', 'N'};
+constexpr uint32_t kFormatVersion = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+constexpr uint32_t kContentDevices = 0;
+constexpr uint32_t kContentHistory = 1;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t content;
+    uint32_t reserved;
+};
+
+struct GroupHeader {
+    uint32_t rows;
+    uint32_t columns;
+    uint64_t key;
+};
+
+struct ColumnHeader {
+    uint32_t id;
+    uint32_t type;
+    uint64_t bytes; // excluding padding
+};
+
+struct Trailer {
+    char magic[4];
+    uint32_t groups;
+    uint64_t rows;
+    uint32_t checksum;
+    uint32_t reserved;
+};
+
+// A file written through a caller-owned buffer in large chunks
+class BufferedOutput {
+public:
+    BufferedOutput(std::vector<char>& buffer, bool checksummed)
+        : buffer(buffer), file(nullptr), used(0), total(0), checksum(0), checksummed(checksummed), failed(false) {}
+
+    ~BufferedOutput() {
+        if (file) std::fclose(file);
+    }
+
+    bool open(const std::string& path) {
+        file = std::fopen(path.c_str(), "wb");
+        return file != nullptr;
+    }
+
+    bool close() {
+        flush();
+        if (file && std::fclose(file) != 0) failed = true;
+        file = nullptr;
+        return !failed;
+    }
+
+    char* reserve(size_t bytes) {
+        if (used + bytes > buffer.size()) {
+            flush();
+            if (bytes > buffer.size()) buffer.resize(bytes);
+        }
+        return buffer.data() + used;
+    }
+
+    void append(const void* data, size_t bytes) {
+        std::memcpy(reserve(bytes), data, bytes);
+        used += bytes;
+    }
+
+    void append(std::string_view text) { append(text.data(), text.size()); }
+
+    void put(char c) {
+        *reserve(1) = c;
+        used++;
+    }
+
+    template <typename T>
+    void integer(T value) {
+        char* out = reserve(24);
+        auto result = std::to_chars(out, out + 24, value);
+        used += static_cast<size_t>(result.ptr - out);
+    }
+
+    void mac(MacAddress address) {
+        address.format(reserve(MacAddress::kStringLength + 1));
+        used += MacAddress::kStringLength;
+    }
+
+    void flush() {
+        if (used == 0) return;
+        if (checksummed) checksum = crc32(buffer.data(), used, checksum);
+        if (!file || std::fwrite(buffer.data(), 1, used, file) != used) failed = true;
+        total += used;
+        used = 0;
+    }
+
+    uint64_t size() const { return total + used; }
+
+    uint32_t crc() {
+        flush();
+        return checksum;
+    }
+
+private:
+    std::vector<char>& buffer;
+    std::FILE* file;
+    size_t used;
+    uint64_t total;
+    uint32_t checksum;
+    bool checksummed;
+    bool failed;
+};
+
+void csvField(BufferedOutput& out, std::string_view text) {
+    if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out.append(text);
+        return;
+    }
+    out.put('"');
+    for (char c : text) {
+        if (c == '"') out.put('"');
+        out.put(c);
+    }
+    out.put('"');
+}
+
+void jsonString(BufferedOutput& out, std::string_view text) {
+    static const char kHex[] = "0123456789abcdef";
+    out.put('"');
+    for (char c : text) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out.put('\\');
+            out.put(c);
+        } else if (byte < 0x20) {
+            char escape[6] = {'\\', 'u', '0', '0', kHex[byte >> 4], kHex[byte & 0xF]};
+            out.append(escape, sizeof(escape));
+        } else {
+            out.put(c);
+        }
+    }
+    out.put('"');
+}
+
+int64_t unixSeconds(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+}
+
+void pad(BufferedOutput& out, uint64_t bytes) {
+    static const char kZeros[8] = {};
+    out.append(kZeros, static_cast<size_t>((8 - bytes % 8) % 8));
+}
+
+template <typename T, typename F>
+void fixedColumn(BufferedOutput& out, uint32_t id, uint32_t type, size_t rows, F value) {
+    ColumnHeader header = {id, type, static_cast<uint64_t>(rows) * sizeof(T)};
+    out.append(&header, sizeof(header));
+    for (size_t i = 0; i < rows; ++i) {
+        T v = value(i);
+        out.append(&v, sizeof(v));
+    }
+    pad(out, header.bytes);
+}
+
+template <typename F>
+void stringColumn(BufferedOutput& out, uint32_t id, size_t rows, F value) {
+    uint64_t textBytes = 0;
+    for (size_t i = 0; i < rows; ++i) {
+        textBytes += value(i).size();
+    }
+
+    ColumnHeader header = {id, DeviceExporter::kTypeString, (rows + 1) * sizeof(uint32_t) + textBytes};
+    out.append(&header, sizeof(header));
+    uint32_t offset = 0;
+    out.append(&offset, sizeof(offset));
+    for (size_t i = 0; i < rows; ++i) {
+        offset += static_cast<uint32_t>(value(i).size());
+        out.append(&offset, sizeof(offset));
+    }
+    for (size_t i = 0; i < rows; ++i) {
+        out.append(value(i));
+    }
+    pad(out, header.bytes);
+}
+
+void writeFileHeader(BufferedOutput& out, uint32_t content) {
+    FileHeader header = {};
+    std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+    header.version = kFormatVersion;
+    header.byteOrder = kByteOrderMark;
+    header.content = content;
+    out.append(&header, sizeof(header));
+}
+
+void writeTrailer(BufferedOutput& out, uint32_t groups, uint64_t rows) {
+    Trailer trailer = {};
+    std::memcpy(trailer.magic, kTrailerMagic, sizeof(kTrailerMagic));
+    trailer.groups = groups;
+    trailer.rows = rows;
+    trailer.checksum = out.crc();
+    out.append(&trailer, sizeof(trailer));
+}
+
+// Closes the output and moves it into place, filling in the result
+void finish(BufferedOutput& out, const std::string& tempPath, ExportResult& result,
+            std::chrono::steady_clock::time_point started) {
+    result.bytes = static_cast<size_t>(out.size());
+    if (!out.close()) {
+        result.error = "write failed";
+    } else {
+        // Readers see either the previous export or the complete new one
+        if (replaceFile(tempPath, result.path)) {
+            result.ok = true;
+        } else {
+            result.error = "cannot rename " + tempPath;
+        }
+    }
+    if (!result.ok) {
+        std::remove(tempPath.c_str());
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+}
+
+} // namespace
+
+DeviceExporter::DeviceExporter() : progress(0), running(false), hasResult(false) {
+}
+
+DeviceExporter::~DeviceExporter() {
+    job.wait();
+}
+
+const char* DeviceExporter::extension(ExportFormat format) {
+    switch (format) {
+        case ExportFormat::Csv: return ".csv";
+        case ExportFormat::NdJson: return ".ndjson";
+        case ExportFormat::Binary: return ".sbx";
+    }
+    return "";
+}
+
+ExportResult DeviceExporter::exportDevices(const std::string& path, ExportFormat format,
+                                           const std::vector<std::shared_ptr<NetworkDevice>>& devices) {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    auto started = std::chrono::steady_clock::now();
+    buffer.resize(kBufferSize);
+    progress.store(0, std::memory_order_relaxed);
+
+    ExportResult result;
+    result.path = path;
+    std::string tempPath = path + ".tmp";
+    BufferedOutput out(buffer, format == ExportFormat::Binary);
+    if (!out.open(tempPath)) {
+        result.error = "cannot open " + tempPath;
+        return result;
+    }
+
+    char mac[MacAddress::kStringLength + 1];
+    if (format == ExportFormat::Csv) {
+        out.append("Device Name,MAC Address,IP Address,Signal Strength,Status,Device Type,Vendor,Last Seen\n");
+        for (const auto& device : devices) {
+            device->mac.format(mac);
+            if (device->hostname.empty()) {
+                out.append("Device-");
+                out.append(mac + 15, 2);
+            } else {
+                csvField(out, device->hostname);
+            }
+            out.put(',');
+            out.append(mac, MacAddress::kStringLength);
+            out.put(',');
+            csvField(out, device->ipAddress.empty() ? std::string_view("Unknown") : std::string_view(device->ipAddress));
+            out.put(',');
+            out.integer(device->rssi);
+            out.append(" dBm,");
+            out.append(device->isOnline ? std::string_view("Online,") : std::string_view("Offline,"));
+            csvField(out, deviceTypeName(device->deviceType));
+            out.put(',');
+            csvField(out, device->vendor);
+            out.put(',');
+            out.integer(unixSeconds(device->lastSeen));
+            out.put('\n');
+            progress.fetch_add(1, std::memory_order_relaxed);
+        }
+        result.rows = devices.size();
+    } else if (format == ExportFormat::NdJson) {
+        for (const auto& device : devices) {
+            out.append("{\"mac\":\"");
+            out.mac(device->mac);
+            out.append("\",\"ip\":");
+            jsonString(out, device->ipAddress);
+            out.append(",\"hostname\":");
+            jsonString(out, device->hostname);
+            out.append(",\"vendor\":");
+            jsonString(out, device->vendor);
+            out.append(",\"type\":");
+            jsonString(out, deviceTypeName(device->deviceType));
+            out.append(",\"rssi\":");
+            out.integer(device->rssi);
+            out.append(device->isOnline ? std::string_view(",\"online\":true") : std::string_view(",\"online\":false"));
+            out.append(",\"lastSeen\":");
+            out.integer(unixSeconds(device->lastSeen));
+            out.append("}\n");
+            progress.fetch_add(1, std::memory_order_relaxed);
+        }
+        result.rows = devices.size();
+    } else {
+        writeFileHeader(out, kContentDevices);
+        uint32_t groups = 0;
+        for (size_t base = 0; base < devices.size(); base += kRowsPerGroup) {
+            const std::shared_ptr<NetworkDevice>* group = devices.data() + base;
+            size_t rows = std::min(kRowsPerGroup, devices.size() - base);
+
+            GroupHeader header = {static_cast<uint32_t>(rows), 8, 0};
+            out.append(&header, sizeof(header));
+            fixedColumn<uint64_t>(out, kColumnMac, kTypeUint64, rows, [&](size_t i) { return group[i]->mac.toUint64(); });
+            stringColumn(out, kColumnIp, rows, [&](size_t i) -> std::string_view { return group[i]->ipAddress; });
+            stringColumn(out, kColumnHostname, rows, [&](size_t i) -> std::string_view { return group[i]->hostname; });
+            stringColumn(out, kColumnVendor, rows, [&](size_t i) -> std::string_view { return group[i]->vendor; });
+            stringColumn(out, kColumnDeviceType, rows, [&](size_t i) { return deviceTypeName(group[i]->deviceType); });
+            fixedColumn<int32_t>(out, kColumnRssi, kTypeInt32, rows, [&](size_t i) { return static_cast<int32_t>(group[i]->rssi); });
+            fixedColumn<uint8_t>(out, kColumnOnline, kTypeUint8, rows, [&](size_t i) { return static_cast<uint8_t>(group[i]->isOnline); });
+            fixedColumn<int64_t>(out, kColumnLastSeen, kTypeInt64, rows, [&](size_t i) { return unixSeconds(group[i]->lastSeen); });
+
+            groups++;
+            progress.fetch_add(rows, std::memory_order_relaxed);
+        }
+        result.rows = devices.size();
+        writeTrailer(out, groups, result.rows);
+    }
+
+    finish(out, tempPath, result, started);
+    return result;
+}
+
+ExportResult DeviceExporter::exportHistory(const std::string& path, ExportFormat format, const SignalHistoryStore& store,
+                                           const std::vector<MacAddress>& macs, int64_t since) {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    auto started = std::chrono::steady_clock::now();
+    buffer.resize(kBufferSize);
+    progress.store(0, std::memory_order_relaxed);
+
+    ExportResult result;
+    result.path = path;
+    std::string tempPath = path + ".tmp";
+    BufferedOutput out(buffer, format == ExportFormat::Binary);
+    if (!out.open(tempPath)) {
+        result.error = "cannot open " + tempPath;
+        return result;
+    }
+
+    using Sample = SignalHistoryStore::Sample;
+    if (format == ExportFormat::Csv) {
+        out.append("MAC Address,Timestamp,RSSI,Online\n");
+        char mac[MacAddress::kStringLength + 1];
+        for (MacAddress address : macs) {
+            address.format(mac);
+            store.forEachSample(address, since, [&](const Sample& sample) {
+                out.append(mac, MacAddress::kStringLength);
+                out.put(',');
+                out.integer(sample.timestamp);
+                out.put(',');
+                out.integer(static_cast<int>(sample.rssi));
+                out.append((sample.flags & SignalHistoryStore::kSampleOnline) ? std::string_view(",1\n") : std::string_view(",0\n"));
+                result.rows++;
+            });
+            progress.store(result.rows, std::memory_order_relaxed);
+        }
+    } else if (format == ExportFormat::NdJson) {
+        // Every line of a device starts the same way, so its prefix is formatted once
+        constexpr std::string_view kOpen = "{\"mac\":\"";
+        constexpr std::string_view kTimestamp = "\",\"timestamp\":";
+        char prefix[kOpen.size() + MacAddress::kStringLength + kTimestamp.size() + 1];
+        size_t length = sizeof(prefix) - 1;
+        std::memcpy(prefix, kOpen.data(), kOpen.size());
+        for (MacAddress address : macs) {
+            address.format(prefix + kOpen.size());
+            std::memcpy(prefix + kOpen.size() + MacAddress::kStringLength, kTimestamp.data(), kTimestamp.size());
+            store.forEachSample(address, since, [&](const Sample& sample) {
+                out.append(prefix, length);
+                out.integer(sample.timestamp);
+                out.append(",\"rssi\":");
+                out.integer(static_cast<int>(sample.rssi));
+                out.append((sample.flags & SignalHistoryStore::kSampleOnline) ? std::string_view(",\"online\":true}\n")
+                                                                               : std::string_view(",\"online\":false}\n"));
+                result.rows++;
+            });
+            progress.store(result.rows, std::memory_order_relaxed);
+        }
+    } else {
+        // One row group per device; the columns are gathered in reused scratch arrays
+        writeFileHeader(out, kContentHistory);
+        std::vector<int64_t> timestamps;
+        std::vector<int8_t> rssi;
+        std::vector<uint8_t> flags;
+        uint32_t groups = 0;
+        for (MacAddress address : macs) {
+            timestamps.clear();
+            rssi.clear();
+            flags.clear();
+            store.forEachSample(address, since, [&](const Sample& sample) {
+                timestamps.push_back(sample.timestamp);
+                rssi.push_back(sample.rssi);
+                flags.push_back(sample.flags);
+            });
+            if (timestamps.empty()) continue;
+
+            size_t rows = timestamps.size();
+            GroupHeader header = {static_cast<uint32_t>(rows), 3, address.toUint64()};
+            out.append(&header, sizeof(header));
+            fixedColumn<int64_t>(out, kColumnTimestamp, kTypeInt64, rows, [&](size_t i) { return timestamps[i]; });
+            fixedColumn<int8_t>(out, kColumnRssi, kTypeInt8, rows, [&](size_t i) { return rssi[i]; });
+            fixedColumn<uint8_t>(out, kColumnFlags, kTypeUint8, rows, [&](size_t i) { return flags[i]; });
+
+            groups++;
+            result.rows += rows;
+            progress.store(result.rows, std::memory_order_relaxed);
+        }
+        writeTrailer(out, groups, result.rows);
+    }
+
+    finish(out, tempPath, result, started);
+    return result;
+}
+
+bool DeviceExporter::startDeviceExport(const std::string& path, ExportFormat format,
+                                       std::vector<std::shared_ptr<NetworkDevice>> devices) {
+    if (!claimWorker()) return false;
+
+    auto task = [this, path, format, devices = std::move(devices)]() {
+        publish(exportDevices(path, format, devices));
+    };
+    job = TaskScheduler::shared().submit(TaskPriority::Background, std::move(task));
+    return true;
+}
+
+bool DeviceExporter::startHistoryExport(const std::string& path, ExportFormat format, const SignalHistoryStore& store,
+                                        std::vector<MacAddress> macs, int64_t since) {
+    if (!claimWorker()) return false;
+
+    auto task = [this, path, format, &store, macs = std::move(macs), since]() {
+        publish(exportHistory(path, format, store, macs, since));
+    };
+    job = TaskScheduler::shared().submit(TaskPriority::Background, std::move(task));
+    return true;
+}
+
+bool DeviceExporter::claimWorker() {
+    if (running.exchange(true)) return false;
+    job.wait(); // The previous export has already published its result
+    return true;
+}
+
+void DeviceExporter::publish(ExportResult result) {
+    std::lock_guard<std::mutex> lock(resultMutex);
+    finished = std::move(result);
+    hasResult = true;
+    running.store(false);
+}
+
+bool DeviceExporter::takeResult(ExportResult& result) {
+    std::lock_guard<std::mutex> lock(resultMutex);
+    if (!hasResult) return false;
+
+    result = std::move(finished);
+    hasResult = false;
+    return true;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "NetworkScanner.h"
+#include "SignalHistoryStore.h"
+#include "TaskScheduler.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class ExportFormat {
+    Csv,
+    NdJson,  // one JSON object per line
+    Binary   // columnar, see DeviceExporter
+};
+
+struct ExportResult {
+    bool ok = false;
+    std::string path;
+    size_t rows = 0;
+    size_t bytes = 0;
+    double seconds = 0.0;
+    std::string error;
+};
+
+// Writes device snapshots and RSSI history to files. Rows are formatted with
+// std::to_chars straight into one reusable 1 MiB buffer that is flushed with
+// large writes so exports cost no per-row allocations. Output goes to
+// "<path>.tmp" and is renamed into place once complete.
+//
+// The binary format is a sequence of row groups, each holding one column
+// after another so readers can map or skip columns:
+//
+//   file header   "SBEXPRT\0", version, byte-order mark, content (0 devices, 1 history)
+//   row group     rows, columns, key (the MAC for a history group, else 0)
+//     column      id, type, byte length, then the values padded to 8 bytes;
+//                 strings are rows + 1 uint32 offsets followed by the bytes
+//   trailer       "SBEN", group count, row count, CRC-32 of everything before it
+//
+// All integers are little-endian as written by the host; readers check the
+// byte-order mark.
+class DeviceExporter {
+public:
+    enum ColumnId : uint32_t {
+        kColumnMac = 1,
+        kColumnIp,
+        kColumnHostname,
+        kColumnVendor,
+        kColumnDeviceType,
+        kColumnRssi,
+        kColumnOnline,
+        kColumnLastSeen,  // seconds since the Unix epoch
+        kColumnTimestamp, // seconds since the Unix epoch
+        kColumnFlags      // SignalHistoryStore::SampleFlags
+    };
+
+    enum ColumnType : uint32_t {
+        kTypeUint8 = 1,
+        kTypeInt8,
+        kTypeInt32,
+        kTypeInt64,
+        kTypeUint64,
+        kTypeString
+    };
+
+    DeviceExporter();
+    ~DeviceExporter();
+
+    DeviceExporter(const DeviceExporter&) = delete;
+    DeviceExporter& operator=(const DeviceExporter&) = delete;
+
+    // Synchronous exports; they wait for a background export to finish first
+    ExportResult exportDevices(const std::string& path, ExportFormat format,
+                               const std::vector<std::shared_ptr<NetworkDevice>>& devices);
+    // Streams each device's samples at or after since from the store,
+    // decoding in place without copying the history
+    ExportResult exportHistory(const std::string& path, ExportFormat format, const SignalHistoryStore& store,
+                               const std::vector<MacAddress>& macs, int64_t since);
+
+    // The same as a Background task. The devices must not be modified
+    // while the export runs (snapshot copies are fine) and the store must
+    // outlive it. Returns false while another export is running.
+    bool startDeviceExport(const std::string& path, ExportFormat format,
+                           std::vector<std::shared_ptr<NetworkDevice>> devices);
+    bool startHistoryExport(const std::string& path, ExportFormat format, const SignalHistoryStore& store,
+                            std::vector<MacAddress> macs, int64_t since);
+
+    bool isRunning() const { return running.load(); }
+    // Rows written by the current or last export, for progress display
+    size_t rowsWritten() const { return progress.load(std::memory_order_relaxed); }
+    // Hands out the result of a finished background export once
+    bool takeResult(ExportResult& result);
+
+    static const char* extension(ExportFormat format);
+
+private:
+    static constexpr size_t kBufferSize = 1 << 20;
+    static constexpr size_t kRowsPerGroup = 65536;
+
+    std::mutex jobMutex; // held for the whole of each export
+    std::vector<char> buffer;
+    std::atomic<size_t> progress;
+
+    TaskHandle job;
+    std::atomic<bool> running;
+    std::mutex resultMutex;
+    ExportResult finished;
+    bool hasResult;
+
+    bool claimWorker();
+    void publish(ExportResult result);
+};
@@ -0,0 +1,137 @@
+#include "DeviceStateFile.h"
+#include "Checksum.h"
+#include "MappedFile.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+namespace {
+
+constexpr char kStateMagic[8] = {'S', 'B', 'S', 'T', 'A', 'T', 'E', '\0'};
+constexpr uint32_t kStateVersion = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+struct StateHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t recordSize; // rejects records from a different layout
+    uint32_t recordCount;
+    uint64_t poolSize;
+    uint32_t checksum; // CRC-32 over records and pool
+    uint32_t reserved;
+};
+
+struct StateRecord {
+    uint64_t mac;
+    int64_t lastSeen; // seconds since the Unix epoch
+    int32_t rssi;
+    uint8_t deviceType;
+    uint8_t reserved[3];
+    uint32_t ipOffset, ipLength;
+    uint32_t hostnameOffset, hostnameLength;
+    uint32_t vendorOffset, vendorLength;
+    DeviceSummary summary;
+};
+
+static_assert(std::is_trivially_copyable<DeviceSummary>::value, "DeviceSummary is stored as raw bytes");
+
+void appendString(std::string& pool, const std::string& value, uint32_t& offset, uint32_t& length) {
+    offset = static_cast<uint32_t>(pool.size());
+    length = static_cast<uint32_t>(value.size());
+    pool += value;
+}
+
+bool readString(const char* pool, uint64_t poolSize, uint32_t offset, uint32_t length, std::string& value) {
+    if (static_cast<uint64_t>(offset) + length > poolSize) return false;
+    value.assign(pool + offset, length);
+    return true;
+}
+
+} // namespace
+
+bool DeviceStateFile::save(const std::string& path, const std::vector<std::shared_ptr<NetworkDevice>>& devices) {
+    std::vector<StateRecord> records(devices.size()); // value-initialized, so reserved bytes are zero
+    std::string pool;
+    for (size_t i = 0; i < devices.size(); ++i) {
+        const NetworkDevice& device = *devices[i];
+        StateRecord& record = records[i];
+        record.mac = device.mac.toUint64();
+        record.lastSeen = std::chrono::duration_cast<std::chrono::seconds>(device.lastSeen.time_since_epoch()).count();
+        record.rssi = device.rssi;
+        record.deviceType = static_cast<uint8_t>(device.deviceType);
+        appendString(pool, device.ipAddress, record.ipOffset, record.ipLength);
+        appendString(pool, device.hostname, record.hostnameOffset, record.hostnameLength);
+        appendString(pool, device.vendor, record.vendorOffset, record.vendorLength);
+        record.summary = device.summary;
+    }
+
+    StateHeader header = {};
+    std::memcpy(header.magic, kStateMagic, sizeof(kStateMagic));
+    header.version = kStateVersion;
+    header.byteOrder = kByteOrderMark;
+    header.recordSize = sizeof(StateRecord);
+    header.recordCount = static_cast<uint32_t>(records.size());
+    header.poolSize = pool.size();
+    header.checksum = crc32(pool.data(), pool.size(), crc32(records.data(), records.size() * sizeof(StateRecord)));
+
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(StateRecord));
+        file.write(pool.data(), static_cast<std::streamsize>(pool.size()));
+        if (!file) return false;
+    }
+
+    // A starting monitor maps either the previous table or this one
+    return replaceFile(tempPath, path);
+}
+
+bool DeviceStateFile::load(const std::string& path, std::vector<NetworkDevice>& devices) {
+    devices.clear();
+
+    MappedFile file;
+    if (!file.open(path) || file.size() < sizeof(StateHeader)) return false;
+
+    StateHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, kStateMagic, sizeof(kStateMagic)) != 0 || header.version != kStateVersion ||
+        header.byteOrder != kByteOrderMark || header.recordSize != sizeof(StateRecord)) {
+        return false;
+    }
+
+    uint64_t recordBytes = static_cast<uint64_t>(header.recordCount) * sizeof(StateRecord);
+    if (file.size() != sizeof(StateHeader) + recordBytes + header.poolSize) return false;
+
+    const uint8_t* body = file.data() + sizeof(StateHeader);
+    if (crc32(body, file.size() - sizeof(StateHeader)) != header.checksum) return false;
+
+    const char* pool = reinterpret_cast<const char*>(body + recordBytes);
+    devices.resize(header.recordCount);
+    for (uint32_t i = 0; i < header.recordCount; ++i) {
+        // Records are copied out, so the mapping needs no particular alignment
+        StateRecord record;
+        std::memcpy(&record, body + i * sizeof(StateRecord), sizeof(record));
+
+        NetworkDevice& device = devices[i];
+        device.mac = MacAddress(record.mac);
+        device.macAddress = device.mac.toString();
+        device.rssi = record.rssi;
+        device.isOnline = false;
+        device.deviceType = record.deviceType < kDeviceTypeCount ? static_cast<DeviceType>(record.deviceType)
+                                                                 : DeviceType::Unknown;
+        device.lastSeen = std::chrono::system_clock::time_point(std::chrono::seconds(record.lastSeen));
+        device.summary = record.summary;
+        if (!readString(pool, header.poolSize, record.ipOffset, record.ipLength, device.ipAddress) ||
+            !readString(pool, header.poolSize, record.hostnameOffset, record.hostnameLength, device.hostname) ||
+            !readString(pool, header.poolSize, record.vendorOffset, record.vendorLength, device.vendor)) {
+            devices.clear();
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "NetworkScanner.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Last-known device table, saved on shutdown and periodically so that a
+// restarted monitor can show the previous devices before its first scan
+// completes. The file is a header, one fixed-size record per device
+// (including its DeviceSummary) and a pool of the address, hostname and
+// vendor strings, checked with a CRC-32 and read through one mmap.
+//
+// Records are written in the host's layout; a file from another build or
+// platform fails the header checks and is ignored.
+class DeviceStateFile {
+public:
+    // Written to "<path>.tmp" and renamed into place
+    static bool save(const std::string& path, const std::vector<std::shared_ptr<NetworkDevice>>& devices);
+    // Replaces the contents of devices; false if the file is missing or invalid
+    static bool load(const std::string& path, std::vector<NetworkDevice>& devices);
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// What a device is, as decided by DeviceClassifier. Everything that reacts
+// to the type (anomaly features, UI, exports) reads one row of kDeviceTypes
+// instead of comparing strings.
+enum class DeviceType : uint8_t {
+    Unknown,
+    Router,
+    AccessPoint,
+    Printer,
+    SmartTv,
+    StreamingDevice,
+    GamingConsole,
+    Laptop,
+    Desktop,
+    Smartphone,
+    Tablet,
+    SmartSpeaker,
+    SmartHome,
+    SecurityCamera,
+    SmartDoorbell,
+    SmartThermostat,
+    SmartLight,
+    SmartSwitch,
+    SmartPlug,
+    Count
+};
+
+struct DeviceTypeInfo {
+    DeviceType type;
+    std::string_view name;  // stable identifier used in rule files, exports and IPC
+    std::string_view label; // shown in the UI
+    std::string_view icon;
+    float score;            // reliability feature for anomaly scoring; infrastructure scores high
+};
+
+// The single definition of every type, in enum order
+inline constexpr DeviceTypeInfo kDeviceTypes[] = {
+    {DeviceType::Unknown, "unknown", "Unknown", "❓", 0.3f},
+    {DeviceType::Router, "router", "Router", "📡", 0.9f},
+    {DeviceType::AccessPoint, "access_point", "Access point", "📶", 0.3f},
+    {DeviceType::Printer, "printer", "Printer", "🖨", 0.7f},
+    {DeviceType::SmartTv, "smart_tv", "Smart TV", "📺", 0.8f},
+    {DeviceType::StreamingDevice, "streaming_device", "Streaming device", "🎬", 0.3f},
+    {DeviceType::GamingConsole, "gaming_console", "Game console", "🎮", 0.3f},
+    {DeviceType::Laptop, "laptop", "Laptop", "💻", 0.6f},
+    {DeviceType::Desktop, "desktop", "Desktop", "🖥", 0.3f},
+    {DeviceType::Smartphone, "smartphone", "Phone", "📱", 0.5f},
+    {DeviceType::Tablet, "tablet", "Tablet", "📱", 0.3f},
+    {DeviceType::SmartSpeaker, "smart_speaker", "Smart speaker", "🔊", 0.3f},
+    {DeviceType::SmartHome, "smart_home", "Smart home hub", "🏠", 0.3f},
+    {DeviceType::SecurityCamera, "security_camera", "Camera", "📷", 0.3f},
+    {DeviceType::SmartDoorbell, "smart_doorbell", "Doorbell", "🔔", 0.3f},
+    {DeviceType::SmartThermostat, "smart_thermostat", "Thermostat", "🌡", 0.3f},
+    {DeviceType::SmartLight, "smart_light", "Light", "💡", 0.3f},
+    {DeviceType::SmartSwitch, "smart_switch", "Switch", "🎚", 0.3f},
+    {DeviceType::SmartPlug, "smart_plug", "Plug", "🔌", 0.3f},
+};
+
+inline constexpr size_t kDeviceTypeCount = static_cast<size_t>(DeviceType::Count);
+
+namespace device_type_detail {
+
+constexpr bool tableInEnumOrder() {
+    for (size_t i = 0; i < kDeviceTypeCount; ++i) {
+        if (static_cast<size_t>(kDeviceTypes[i].type) != i) return false;
+    }
+    return true;
+}
+
+} // namespace device_type_detail
+
+static_assert(sizeof(kDeviceTypes) / sizeof(kDeviceTypes[0]) == kDeviceTypeCount, "every DeviceType needs a row");
+static_assert(device_type_detail::tableInEnumOrder(), "kDeviceTypes rows must follow enum order");
+
+constexpr const DeviceTypeInfo& deviceTypeInfo(DeviceType type) {
+    size_t index = static_cast<size_t>(type);
+    return kDeviceTypes[index < kDeviceTypeCount ? index : 0];
+}
+
+constexpr std::string_view deviceTypeName(DeviceType type) { return deviceTypeInfo(type).name; }
+constexpr std::string_view deviceTypeLabel(DeviceType type) { return deviceTypeInfo(type).label; }
+constexpr std::string_view deviceTypeIcon(DeviceType type) { return deviceTypeInfo(type).icon; }
+constexpr float deviceTypeScore(DeviceType type) { return deviceTypeInfo(type).score; }
+
+// Looks a type up by name; false (and Unknown) if there is no such type
+constexpr bool parseDeviceType(std::string_view name, DeviceType& type) {
+    for (const auto& info : kDeviceTypes) {
+        if (info.name == name) {
+            type = info.type;
+            return true;
+        }
+    }
+    type = DeviceType::Unknown;
+    return false;
+}
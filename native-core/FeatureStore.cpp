@@ -0,0 +1,171 @@
+#include "FeatureStore.h"
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+FeatureStore::FeatureStore(double halfLifeSeconds) : halfLife(std::max(1.0, halfLifeSeconds)) {
+}
+
+void FeatureStore::ensure(uint32_t deviceId) {
+    if (deviceId < observations.size()) return;
+
+    size_t size = deviceId + 1;
+    observations.resize(size, 0);
+    rssiMean.resize(size, 0.0f);
+    rssiM2.resize(size, 0.0f);
+    lastUpdate.resize(size, 0.0);
+    flapRate.resize(size, 0.0f);
+    ipChurnRate.resize(size, 0.0f);
+    ipHash.resize(size, 0);
+    lastOnline.resize(size, 0);
+    presenceTotal.resize(size, 0.0f);
+    presence.resize(size * kHours, 0.0f);
+}
+
+void FeatureStore::reset(uint32_t deviceId) {
+    if (deviceId >= observations.size()) return;
+
+    observations[deviceId] = 0;
+    rssiMean[deviceId] = 0.0f;
+    rssiM2[deviceId] = 0.0f;
+    lastUpdate[deviceId] = 0.0;
+    flapRate[deviceId] = 0.0f;
+    ipChurnRate[deviceId] = 0.0f;
+    ipHash[deviceId] = 0;
+    lastOnline[deviceId] = 0;
+    presenceTotal[deviceId] = 0.0f;
+    std::fill_n(&presence[deviceId * kHours], kHours, 0.0f);
+}
+
+void FeatureStore::clear() {
+    observations.clear();
+    rssiMean.clear();
+    rssiM2.clear();
+    lastUpdate.clear();
+    flapRate.clear();
+    ipChurnRate.clear();
+    ipHash.clear();
+    lastOnline.clear();
+    presenceTotal.clear();
+    presence.clear();
+}
+
+float FeatureStore::decayFactor(double elapsedSeconds) const {
+    if (elapsedSeconds <= 0.0) return 1.0f;
+    return static_cast<float>(std::exp2(-elapsedSeconds / halfLife));
+}
+
+void FeatureStore::observe(const std::shared_ptr<NetworkDevice>* devices, size_t count,
+                           std::chrono::system_clock::time_point now, float* rows) {
+    double nowSeconds = toSeconds(now);
+    size_t hour = localHour(now);
+
+    for (size_t i = 0; i < count; ++i) {
+        const NetworkDevice& device = *devices[i];
+        uint32_t id = device.deviceId;
+        ensure(id);
+
+        float rssi = static_cast<float>(device.rssi);
+        uint8_t online = device.isOnline ? 1 : 0;
+        uint32_t address = hashAddress(device.ipAddress);
+
+        if (observations[id] == 0) {
+            observations[id] = 1;
+            rssiMean[id] = rssi;
+            rssiM2[id] = 0.0f;
+            ipHash[id] = address;
+        } else {
+            float decay = decayFactor(nowSeconds - lastUpdate[id]);
+            flapRate[id] = flapRate[id] * decay + (online != lastOnline[id] ? 1.0f : 0.0f);
+            bool addressChanged = address != 0 && ipHash[id] != 0 && address != ipHash[id];
+            ipChurnRate[id] = ipChurnRate[id] * decay + (addressChanged ? 1.0f : 0.0f);
+            if (address != 0) ipHash[id] = address;
+
+            // Welford's update with the count capped at the window: once full,
+            // M2 is first scaled down so older readings fade out
+            uint32_t n = observations[id];
+            if (n >= kVarianceWindow) {
+                rssiM2[id] *= static_cast<float>(kVarianceWindow - 1) / kVarianceWindow;
+                n = kVarianceWindow;
+            } else {
+                n = ++observations[id];
+            }
+            float delta = rssi - rssiMean[id];
+            rssiMean[id] += delta / static_cast<float>(n);
+            rssiM2[id] += delta * (rssi - rssiMean[id]);
+        }
+
+        lastOnline[id] = online;
+        lastUpdate[id] = nowSeconds;
+
+        if (online) {
+            float* bins = &presence[id * kHours];
+            bins[hour] += 1.0f;
+            presenceTotal[id] += 1.0f;
+            if (presenceTotal[id] > 4096.0f) {
+                // Halve occasionally so the profile follows habits that change
+                for (size_t h = 0; h < kHours; ++h) bins[h] *= 0.5f;
+                presenceTotal[id] *= 0.5f;
+            }
+        }
+
+        writeRow(device, nowSeconds, hour, rows + i * kNumFeatures);
+    }
+}
+
+void FeatureStore::extract(const NetworkDevice& device, std::chrono::system_clock::time_point now, float* row) const {
+    writeRow(device, toSeconds(now), localHour(now), row);
+}
+
+void FeatureStore::writeRow(const NetworkDevice& device, double nowSeconds, size_t hour, float* row) const {
+    uint32_t id = device.deviceId;
+
+    row[kRssi] = static_cast<float>(device.rssi);
+    row[kOnline] = device.isOnline ? 1.0f : 0.0f;
+    row[kSecondsSinceSeen] = static_cast<float>(std::floor(nowSeconds - toSeconds(device.lastSeen)));
+    row[kTypeScore] = typeScore(device.deviceType);
+
+    if (id >= observations.size() || observations[id] == 0) {
+        row[kRssiStdDev] = 0.0f;
+        row[kFlapRate] = 0.0f;
+        row[kIpChurnRate] = 0.0f;
+        row[kHourPresence] = 1.0f;
+        return;
+    }
+
+    uint32_t n = std::min(observations[id], kVarianceWindow);
+    row[kRssiStdDev] = n > 1 ? std::sqrt(std::max(0.0f, rssiM2[id]) / static_cast<float>(n - 1)) : 0.0f;
+
+    float decay = decayFactor(nowSeconds - lastUpdate[id]);
+    row[kFlapRate] = flapRate[id] * decay;
+    row[kIpChurnRate] = ipChurnRate[id] * decay;
+
+    // Until a day's worth of sightings exists every hour counts as average
+    float total = presenceTotal[id];
+    row[kHourPresence] = total >= kHours ? presence[id * kHours + hour] * kHours / total : 1.0f;
+}
+
+double FeatureStore::toSeconds(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration<double>(time.time_since_epoch()).count();
+}
+
+size_t FeatureStore::localHour(std::chrono::system_clock::time_point time) {
+    std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+    std::tm local = {};
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    return static_cast<size_t>(std::min(23, std::max(0, local.tm_hour)));
+}
+
+uint32_t FeatureStore::hashAddress(const std::string& address) {
+    if (address.empty()) return 0;
+
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (char c : address) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash ? hash : 1;
+}
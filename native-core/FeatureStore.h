@@ -0,0 +1,76 @@
+#pragma once
+
+#include "NetworkScanner.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Rolling per-device statistics for anomaly detection, kept as
+// structure-of-arrays indexed by the scanner's dense device ID. Every
+// observation updates a device in O(1) and writes one row of a dense float
+// matrix that the batched forest scores directly; no per-device objects are
+// allocated, so adding a feature only adds a column.
+class FeatureStore {
+public:
+    enum Feature : size_t {
+        kRssi,
+        kOnline,
+        kSecondsSinceSeen,
+        kTypeScore,
+        kRssiStdDev,    // Welford over roughly the last kVarianceWindow readings
+        kFlapRate,      // online/offline transitions, exponentially decayed
+        kIpChurnRate,   // address changes, exponentially decayed
+        kHourPresence,  // how usual this hour of day is for the device; 1 is average, 0 never seen
+        kNumFeatures
+    };
+
+    static constexpr uint32_t kVarianceWindow = 64;
+    // Bump whenever a feature changes meaning, scale or position; stored
+    // with model snapshots so stale models are rejected
+    static constexpr uint32_t kLayoutVersion = 1;
+
+    // Event rates decay with the given half-life, so a rate is roughly the
+    // number of events within the last half-life
+    explicit FeatureStore(double halfLifeSeconds = 3600.0);
+
+    // Folds each device's current state into its statistics, then writes its
+    // feature row (kNumFeatures floats) into rows
+    void observe(const std::shared_ptr<NetworkDevice>* devices, size_t count,
+                 std::chrono::system_clock::time_point now, float* rows);
+
+    // Writes a device's feature row from the current statistics without updating them
+    void extract(const NetworkDevice& device, std::chrono::system_clock::time_point now, float* row) const;
+
+    void reset(uint32_t deviceId);
+    void clear();
+    size_t size() const { return observations.size(); }
+
+    static float typeScore(DeviceType deviceType) { return deviceTypeScore(deviceType); }
+
+private:
+    static constexpr size_t kHours = 24;
+
+    double halfLife;
+
+    // One entry per device ID
+    std::vector<uint32_t> observations;
+    std::vector<float> rssiMean;
+    std::vector<float> rssiM2;
+    std::vector<double> lastUpdate; // seconds since the epoch
+    std::vector<float> flapRate;
+    std::vector<float> ipChurnRate;
+    std::vector<uint32_t> ipHash;
+    std::vector<uint8_t> lastOnline;
+    std::vector<float> presenceTotal;
+    std::vector<float> presence; // kHours per device
+
+    void ensure(uint32_t deviceId);
+    float decayFactor(double elapsedSeconds) const;
+    void writeRow(const NetworkDevice& device, double nowSeconds, size_t hour, float* row) const;
+    static double toSeconds(std::chrono::system_clock::time_point time);
+    static size_t localHour(std::chrono::system_clock::time_point time);
+    static uint32_t hashAddress(const std::string& address);
+};
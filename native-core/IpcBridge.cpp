@@ -0,0 +1,612 @@
+#include "IpcBridge.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <string_view>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char kMagic[8] = {'S', 'B', 'I', 'P', 'C', '\0', '\0', '\0'};
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+// Attempts before readSnapshot() gives up on a table the writer keeps busy
+constexpr int kSnapshotAttempts = 64;
+
+// Requests longer than this close the connection
+constexpr size_t kMaxRequestLength = 4096;
+
+std::string regionPath(const std::string& name) {
+#ifdef _WIN32
+    return "Local\\" + name;
+#else
+    return "/" + name;
+#endif
+}
+
+#ifndef _WIN32
+// True when the region at path carries the header of a writer that is
+// still running. Regions without a complete header count as abandoned.
+bool hasLiveWriter(const std::string& path, uint32_t& pid) {
+    int fd = shm_open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+
+    bool alive = false;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(IpcHeader)) {
+        void* view = mmap(nullptr, sizeof(IpcHeader), PROT_READ, MAP_SHARED, fd, 0);
+        if (view != MAP_FAILED) {
+            const auto* existing = static_cast<const IpcHeader*>(view);
+            if (std::memcmp(existing->magic, kMagic, sizeof(kMagic)) == 0) {
+                pid = existing->writerPid;
+                // EPERM means the process exists but belongs to another user
+                alive = pid != 0 && (kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM);
+            }
+            munmap(view, sizeof(IpcHeader));
+        }
+    }
+    ::close(fd);
+    return alive;
+}
+#endif
+
+template <size_t N>
+void copyField(char (&field)[N], std::string_view value) {
+    size_t length = std::min(value.size(), N - 1);
+    std::memcpy(field, value.data(), length);
+    std::memset(field + length, 0, N - length);
+}
+
+int64_t toEpochMs(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+void unmapRegion(void*& region, size_t& regionSize, void*& mappingHandle) {
+#ifdef _WIN32
+    if (region) UnmapViewOfFile(region);
+    if (mappingHandle) CloseHandle(mappingHandle);
+#else
+    if (region) munmap(region, regionSize);
+#endif
+    region = nullptr;
+    regionSize = 0;
+    mappingHandle = nullptr;
+}
+
+// Splits complete lines out of pending and appends one response line per request
+bool handleRequests(std::string& pending, const IpcControlServer::Handler& handler, std::string& responses) {
+    size_t start = 0;
+    size_t end;
+    while ((end = pending.find('\n', start)) != std::string::npos) {
+        std::string_view request(pending.data() + start, end - start);
+        if (!request.empty() && request.back() == '\r') request.remove_suffix(1);
+        if (!request.empty()) {
+            responses += handler(request);
+            responses += '\n';
+        }
+        start = end + 1;
+    }
+    pending.erase(0, start);
+    return pending.size() <= kMaxRequestLength;
+}
+
+} // namespace
+
+IpcPublisher::IpcPublisher()
+    : region(nullptr), regionSize(0), mappingHandle(nullptr), header(nullptr), table(nullptr), ring(nullptr) {
+}
+
+IpcPublisher::~IpcPublisher() {
+    close();
+}
+
+bool IpcPublisher::open(const std::string& name, const Options& options) {
+    close();
+    if (name.empty() || options.deviceSlots == 0 || options.ringSlots == 0 || options.ringSlots > (1u << 30)) {
+        return false;
+    }
+
+    uint32_t ringSlots = 1;
+    while (ringSlots < options.ringSlots) ringSlots <<= 1;
+    size_t tableOffset = sizeof(IpcHeader);
+    size_t ringOffset = tableOffset + static_cast<size_t>(options.deviceSlots) * sizeof(IpcDeviceRecord);
+    size_t size = ringOffset + static_cast<size_t>(ringSlots) * sizeof(IpcDeltaRecord);
+    std::string path = regionPath(name);
+
+#ifdef _WIN32
+    // A fresh mapping is zero-filled; an existing one belongs to a live writer
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                        static_cast<DWORD>(size & 0xFFFFFFFFu), path.c_str());
+    if (!mapping) {
+        std::cerr << "Failed to create shared memory " << path << std::endl;
+        return false;
+    }
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        std::cerr << "Shared memory " << path << " is already in use" << std::endl;
+        CloseHandle(mapping);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!view) {
+        std::cerr << "Failed to map shared memory " << path << std::endl;
+        CloseHandle(mapping);
+        return false;
+    }
+    mappingHandle = mapping;
+    uint32_t pid = static_cast<uint32_t>(GetCurrentProcessId());
+#else
+    // Like a Windows mapping, a region whose writer is alive stays theirs;
+    // one left behind by a writer that did not shut down cleanly is replaced
+    uint32_t owner = 0;
+    if (hasLiveWriter(path, owner)) {
+        std::cerr << "Shared memory " << path << " is already in use by process " << owner << std::endl;
+        return false;
+    }
+    shm_unlink(path.c_str());
+    int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to create shared memory " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        std::cerr << "Failed to size shared memory " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        shm_unlink(path.c_str());
+        return false;
+    }
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        std::cerr << "Failed to map shared memory " << path << ": " << std::strerror(errno) << std::endl;
+        shm_unlink(path.c_str());
+        return false;
+    }
+    uint32_t pid = static_cast<uint32_t>(getpid());
+#endif
+
+    region = view;
+    regionSize = size;
+    regionName = name;
+
+    auto* base = static_cast<unsigned char*>(region);
+    ring = reinterpret_cast<IpcDeltaRecord*>(base + ringOffset);
+    for (uint32_t i = 0; i < ringSlots; ++i) {
+        new (ring + i) IpcDeltaRecord();
+    }
+    table = reinterpret_cast<IpcDeviceRecord*>(base + tableOffset);
+
+    // The header goes last so a reader never sees a valid magic over an unset layout
+    IpcHeader* layout = new (region) IpcHeader();
+    layout->layoutVersion = kIpcLayoutVersion;
+    layout->byteOrder = kByteOrderMark;
+    layout->headerSize = sizeof(IpcHeader);
+    layout->recordSize = sizeof(IpcDeviceRecord);
+    layout->deltaRecordSize = sizeof(IpcDeltaRecord);
+    layout->deviceSlots = options.deviceSlots;
+    layout->ringSlots = ringSlots;
+    layout->writerPid = pid;
+    layout->tableOffset = tableOffset;
+    layout->ringOffset = ringOffset;
+    layout->publishedAtMs = toEpochMs(std::chrono::system_clock::now());
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(layout->magic, kMagic, sizeof(kMagic));
+    header = layout;
+
+    scores.assign(options.deviceSlots, std::numeric_limits<float>::quiet_NaN());
+    return true;
+}
+
+void IpcPublisher::close() {
+    if (!region) return;
+
+    unmapRegion(region, regionSize, mappingHandle);
+#ifndef _WIN32
+    shm_unlink(regionPath(regionName).c_str());
+#endif
+    header = nullptr;
+    table = nullptr;
+    ring = nullptr;
+    regionName.clear();
+    scores.clear();
+}
+
+void IpcPublisher::publish(const std::vector<std::shared_ptr<NetworkDevice>>& changed,
+                           const std::vector<uint32_t>& removed,
+                           const std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>>& anomalies,
+                           uint64_t version) {
+    if (!header) return;
+
+    uint32_t slots = header->deviceSlots;
+    for (const auto& anomaly : anomalies) {
+        uint32_t id = anomaly.first->deviceId;
+        if (id < slots) scores[id] = static_cast<float>(anomaly.second);
+    }
+
+    uint64_t sequence = header->tableSequence.load(std::memory_order_relaxed);
+    header->tableSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // Removals first, so a device that left and came back in one batch ends up present
+    for (uint32_t id : removed) {
+        if (id >= slots) continue;
+        IpcDeviceRecord& record = table[id];
+        if (!(record.flags & kIpcPresent)) continue;
+
+        header->deviceCount--;
+        if (record.flags & kIpcAnomalous) header->anomalyCount--;
+        record.flags = 0;
+        record.anomalyScore = 0.0f;
+        appendDelta(kIpcRemoved, record);
+        std::memset(&record, 0, sizeof(record));
+    }
+
+    uint32_t dropped = 0;
+    for (const auto& device : changed) {
+        uint32_t id = device->deviceId;
+        if (id >= slots) {
+            dropped++;
+            continue;
+        }
+
+        IpcDeviceRecord& record = table[id];
+        bool wasPresent = record.flags & kIpcPresent;
+        bool wasAnomalous = record.flags & kIpcAnomalous;
+        float score = scores[id];
+        bool anomalous = !std::isnan(score);
+
+        record.mac = device->mac.toUint64();
+        record.lastSeenMs = toEpochMs(device->lastSeen);
+        record.deviceId = id;
+        record.flags = kIpcPresent | (device->isOnline ? uint32_t(kIpcOnline) : 0u) | (anomalous ? uint32_t(kIpcAnomalous) : 0u);
+        record.rssi = device->rssi;
+        record.anomalyScore = anomalous ? score : 0.0f;
+        copyField(record.ipAddress, device->ipAddress);
+        copyField(record.hostname, device->hostname);
+        copyField(record.deviceType, deviceTypeName(device->deviceType));
+        copyField(record.vendor, device->vendor);
+
+        if (!wasPresent) header->deviceCount++;
+        header->anomalyCount += static_cast<uint32_t>(anomalous) - static_cast<uint32_t>(wasAnomalous);
+        header->slotsUsed = std::max(header->slotsUsed, id + 1);
+        appendDelta(wasPresent ? kIpcUpdated : kIpcAdded, record);
+    }
+
+    header->snapshotVersion = version;
+    header->publishedAtMs = toEpochMs(std::chrono::system_clock::now());
+    header->droppedDevices = dropped;
+    header->tableSequence.store(sequence + 2, std::memory_order_release);
+
+    for (const auto& anomaly : anomalies) {
+        uint32_t id = anomaly.first->deviceId;
+        if (id < slots) scores[id] = std::numeric_limits<float>::quiet_NaN();
+    }
+}
+
+void IpcPublisher::appendDelta(IpcChangeType type, const IpcDeviceRecord& record) {
+    uint64_t index = header->deltaCount.load(std::memory_order_relaxed);
+    IpcDeltaRecord& slot = ring[index & (header->ringSlots - 1)];
+
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.changeType = type;
+    slot.device = record;
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+    header->deltaCount.store(index + 1, std::memory_order_release);
+}
+
+IpcReader::IpcReader()
+    : region(nullptr), regionSize(0), mappingHandle(nullptr), header(nullptr), table(nullptr), ring(nullptr) {
+}
+
+IpcReader::~IpcReader() {
+    close();
+}
+
+bool IpcReader::open(const std::string& name) {
+    close();
+    std::string path = regionPath(name);
+
+#ifdef _WIN32
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, path.c_str());
+    if (!mapping) return false;
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info;
+    if (!view || VirtualQuery(view, &info, sizeof(info)) == 0) {
+        if (view) UnmapViewOfFile(view);
+        CloseHandle(mapping);
+        return false;
+    }
+    mappingHandle = mapping;
+    size_t size = info.RegionSize;
+#else
+    int fd = shm_open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(IpcHeader)) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* view = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) return false;
+#endif
+
+    region = view;
+    regionSize = size;
+
+    const auto* layout = static_cast<const IpcHeader*>(region);
+    const auto* base = static_cast<const unsigned char*>(region);
+    bool valid = size >= sizeof(IpcHeader) && std::memcmp(layout->magic, kMagic, sizeof(kMagic)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    valid = valid && layout->layoutVersion == kIpcLayoutVersion && layout->byteOrder == kByteOrderMark &&
+            layout->headerSize == sizeof(IpcHeader) && layout->recordSize == sizeof(IpcDeviceRecord) &&
+            layout->deltaRecordSize == sizeof(IpcDeltaRecord) && layout->ringSlots != 0 &&
+            (layout->ringSlots & (layout->ringSlots - 1)) == 0 &&
+            layout->tableOffset + static_cast<uint64_t>(layout->deviceSlots) * sizeof(IpcDeviceRecord) <= size &&
+            layout->ringOffset + static_cast<uint64_t>(layout->ringSlots) * sizeof(IpcDeltaRecord) <= size;
+    if (!valid) {
+        close();
+        return false;
+    }
+
+    header = layout;
+    table = reinterpret_cast<const IpcDeviceRecord*>(base + layout->tableOffset);
+    ring = reinterpret_cast<const IpcDeltaRecord*>(base + layout->ringOffset);
+    return true;
+}
+
+void IpcReader::close() {
+    unmapRegion(region, regionSize, mappingHandle);
+    header = nullptr;
+    table = nullptr;
+    ring = nullptr;
+}
+
+bool IpcReader::readSnapshot(std::vector<IpcDeviceRecord>& devices, uint64_t& version, uint64_t& deltaCursor) const {
+    if (!header) return false;
+
+    for (int attempt = 0; attempt < kSnapshotAttempts; ++attempt) {
+        uint64_t before = header->tableSequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Changes are appended inside the table's write section, so the
+        // count read here matches the table exactly
+        uint64_t cursor = header->deltaCount.load(std::memory_order_relaxed);
+        uint64_t snapshotVersion = header->snapshotVersion;
+        uint32_t used = std::min(header->slotsUsed, header->deviceSlots);
+        devices.clear();
+        for (uint32_t id = 0; id < used; ++id) {
+            if (table[id].flags & kIpcPresent) devices.push_back(table[id]);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->tableSequence.load(std::memory_order_relaxed) == before) {
+            version = snapshotVersion;
+            deltaCursor = cursor;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IpcReader::readDeltas(uint64_t& cursor, std::vector<std::pair<IpcChangeType, IpcDeviceRecord>>& changes) const {
+    if (!header) return false;
+
+    uint64_t head = header->deltaCount.load(std::memory_order_acquire);
+    if (head - cursor > header->ringSlots) {
+        cursor = head;
+        return false;
+    }
+
+    for (uint64_t index = cursor; index < head; ++index) {
+        const IpcDeltaRecord& slot = ring[index & (header->ringSlots - 1)];
+        uint64_t expected = 2 * index + 2;
+        if (slot.sequence.load(std::memory_order_acquire) != expected) {
+            cursor = header->deltaCount.load(std::memory_order_acquire);
+            return false;
+        }
+        auto type = static_cast<IpcChangeType>(slot.changeType);
+        IpcDeviceRecord record = slot.device;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != expected) {
+            cursor = header->deltaCount.load(std::memory_order_acquire);
+            return false;
+        }
+        changes.emplace_back(type, record);
+    }
+    cursor = head;
+    return true;
+}
+
+IpcControlServer::IpcControlServer() : running(false), listener(-1) {
+}
+
+IpcControlServer::~IpcControlServer() {
+    stop();
+}
+
+std::string IpcControlServer::defaultPath(const std::string& name) {
+#ifdef _WIN32
+    return "\\\\.\\pipe\\" + name;
+#else
+    return "/tmp/" + name + ".sock";
+#endif
+}
+
+bool IpcControlServer::start(const std::string& path, Handler requestHandler) {
+    if (running.exchange(true)) return false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+    endpoint = path;
+    handler = std::move(requestHandler);
+
+#ifndef _WIN32
+    sockaddr_un address{};
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Control socket path is too long: " << path << std::endl;
+        running = false;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        running = false;
+        return false;
+    }
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 8) != 0) {
+        std::cerr << "Failed to open control socket " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        running = false;
+        return false;
+    }
+    listener = fd;
+#endif
+
+    thread = std::thread(&IpcControlServer::serve, this);
+    return true;
+}
+
+void IpcControlServer::stop() {
+    if (!running.exchange(false)) {
+        if (thread.joinable()) thread.join();
+        return;
+    }
+
+#ifdef _WIN32
+    // Wake the thread from ConnectNamedPipe or a blocking read
+    CancelSynchronousIo(thread.native_handle());
+    HANDLE wake = CreateFileA(endpoint.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (wake != INVALID_HANDLE_VALUE) CloseHandle(wake);
+#endif
+    if (thread.joinable()) {
+        thread.join();
+    }
+#ifndef _WIN32
+    ::close(static_cast<int>(listener));
+    listener = -1;
+    unlink(endpoint.c_str());
+#endif
+}
+
+#ifdef _WIN32
+
+void IpcControlServer::serve() {
+    // One client at a time; requests are short and answered immediately
+    while (running.load()) {
+        HANDLE pipe = CreateNamedPipeA(endpoint.c_str(), PIPE_ACCESS_DUPLEX,
+                                       PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT, PIPE_UNLIMITED_INSTANCES,
+                                       4096, 4096, 0, nullptr);
+        if (pipe == INVALID_HANDLE_VALUE) {
+            std::cerr << "Failed to create control pipe " << endpoint << std::endl;
+            break;
+        }
+
+        bool connected = ConnectNamedPipe(pipe, nullptr) || GetLastError() == ERROR_PIPE_CONNECTED;
+        std::string pending;
+        std::string responses;
+        char buffer[1024];
+        DWORD received = 0;
+        while (connected && running.load() && ReadFile(pipe, buffer, sizeof(buffer), &received, nullptr) &&
+               received > 0) {
+            pending.append(buffer, received);
+            responses.clear();
+            bool keep = handleRequests(pending, handler, responses);
+            DWORD written = 0;
+            if (!responses.empty() &&
+                !WriteFile(pipe, responses.data(), static_cast<DWORD>(responses.size()), &written, nullptr)) {
+                break;
+            }
+            if (!keep) break;
+        }
+
+        DisconnectNamedPipe(pipe);
+        CloseHandle(pipe);
+    }
+}
+
+#else
+
+void IpcControlServer::serve() {
+#ifdef MSG_NOSIGNAL
+    const int sendFlags = MSG_NOSIGNAL;
+#else
+    const int sendFlags = 0;
+#endif
+
+    std::vector<pollfd> fds = {{static_cast<int>(listener), POLLIN, 0}};
+    std::vector<std::string> pending = {std::string()}; // parallel to fds
+    std::string responses;
+    char buffer[1024];
+
+    while (running.load()) {
+        // Short timeout so stop() is noticed without a wake-up pipe
+        if (poll(fds.data(), fds.size(), 100) <= 0) continue;
+
+        if (fds[0].revents & POLLIN) {
+            int client = accept(fds[0].fd, nullptr, nullptr);
+            if (client >= 0) {
+#ifdef SO_NOSIGPIPE
+                int on = 1;
+                setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+                fds.push_back({client, POLLIN, 0});
+                pending.emplace_back();
+            }
+        }
+
+        for (size_t i = fds.size() - 1; i > 0; --i) {
+            if (!fds[i].revents) continue;
+
+            bool keep = false;
+            ssize_t received = recv(fds[i].fd, buffer, sizeof(buffer), 0);
+            if (received > 0) {
+                pending[i].append(buffer, static_cast<size_t>(received));
+                responses.clear();
+                keep = handleRequests(pending[i], handler, responses);
+                size_t sent = 0;
+                while (keep && sent < responses.size()) {
+                    ssize_t n = send(fds[i].fd, responses.data() + sent, responses.size() - sent, sendFlags);
+                    if (n <= 0) keep = false;
+                    else sent += static_cast<size_t>(n);
+                }
+            }
+            if (!keep) {
+                ::close(fds[i].fd);
+                fds.erase(fds.begin() + static_cast<std::ptrdiff_t>(i));
+                pending.erase(pending.begin() + static_cast<std::ptrdiff_t>(i));
+            }
+        }
+    }
+
+    for (size_t i = 1; i < fds.size(); ++i) {
+        ::close(fds[i].fd);
+    }
+}
+
+#endif
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "NetworkScanner.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Fixed-layout shared memory through which other local processes (the Node
+// server, the Python services) read the core's devices without scanning or
+// parsing anything themselves. The region is named "/<name>" on POSIX
+// (shm_open) and "Local\<name>" on Windows (a named file mapping):
+//
+//   IpcHeader                      layout description, counters, seqlocks
+//   IpcDeviceRecord[deviceSlots]   device table indexed by deviceId
+//   IpcDeltaRecord[ringSlots]      ring of the most recent changes
+//
+// Device table: guarded by header.tableSequence, a seqlock that is odd while
+// the writer updates records. Readers read the sequence, copy the records
+// they need, read it again and retry if it was odd or has moved. Slots
+// without kIpcPresent are empty; only the first slotsUsed can be occupied.
+//
+// Delta ring: change number n (counting from 0) lives in slot n % ringSlots,
+// whose sequence is 2n + 1 while it is written and 2n + 2 once complete.
+// header.deltaCount is the number of changes written so far. A reader more
+// than ringSlots behind has missed changes and re-reads the table.
+//
+// Integers are little-endian as written by the host; readers check the
+// byte-order mark and the sizes in the header before using the region.
+constexpr uint32_t kIpcLayoutVersion = 1;
+
+enum IpcRecordFlags : uint32_t {
+    kIpcPresent = 1 << 0,
+    kIpcOnline = 1 << 1,
+    kIpcAnomalous = 1 << 2
+};
+
+enum IpcChangeType : uint32_t {
+    kIpcAdded = 1,
+    kIpcUpdated = 2,
+    kIpcRemoved = 3
+};
+
+// Strings are NUL-terminated and truncated to fit
+struct IpcDeviceRecord {
+    uint64_t mac;        // MacAddress::toUint64()
+    int64_t lastSeenMs;  // milliseconds since the Unix epoch
+    uint32_t deviceId;
+    uint32_t flags;      // IpcRecordFlags
+    int32_t rssi;
+    float anomalyScore;  // set with kIpcAnomalous
+    char ipAddress[40];
+    char hostname[40];
+    char deviceType[16];
+    char vendor[32];
+};
+
+struct IpcDeltaRecord {
+    std::atomic<uint64_t> sequence;
+    uint32_t changeType; // IpcChangeType
+    uint32_t reserved;
+    IpcDeviceRecord device; // the record as written to the table; flags are 0 when removed
+};
+
+struct IpcHeader {
+    char magic[8]; // "SBIPC\0\0\0"
+    uint32_t layoutVersion;
+    uint32_t byteOrder; // 0x01020304
+    uint32_t headerSize;
+    uint32_t recordSize;
+    uint32_t deltaRecordSize;
+    uint32_t deviceSlots;
+    uint32_t ringSlots;
+    uint32_t writerPid;
+    uint64_t tableOffset;
+    uint64_t ringOffset;
+    uint64_t reserved0;
+
+    // Written under tableSequence
+    alignas(64) std::atomic<uint64_t> tableSequence;
+    uint64_t snapshotVersion; // DeviceSnapshot::version of the table contents
+    int64_t publishedAtMs;
+    uint32_t deviceCount;
+    uint32_t anomalyCount;
+    uint32_t slotsUsed;
+    uint32_t droppedDevices; // devices whose ID does not fit the table
+
+    alignas(64) std::atomic<uint64_t> deltaCount;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared counters must be lock-free");
+static_assert(sizeof(IpcDeviceRecord) == 160, "IpcDeviceRecord layout changed");
+static_assert(sizeof(IpcDeltaRecord) == 176, "IpcDeltaRecord layout changed");
+static_assert(sizeof(IpcHeader) == 192, "IpcHeader layout changed");
+
+// Owns the region and writes every monitoring cycle into it
+class IpcPublisher {
+public:
+    struct Options {
+        uint32_t deviceSlots = 16384;
+        uint32_t ringSlots = 4096; // rounded up to a power of two
+    };
+
+    IpcPublisher();
+    ~IpcPublisher();
+
+    IpcPublisher(const IpcPublisher&) = delete;
+    IpcPublisher& operator=(const IpcPublisher&) = delete;
+
+    // Creates the region, replacing a stale one of the same name
+    bool open(const std::string& name) { return open(name, Options()); }
+    bool open(const std::string& name, const Options& options);
+    // Unmaps and removes the region; mapped readers keep their last view
+    void close();
+    bool isOpen() const { return header != nullptr; }
+    const std::string& name() const { return regionName; }
+
+    // Writes the devices processed this cycle and removes the given IDs.
+    // anomalies holds the current anomalies; only those of changed devices
+    // are looked at, as the others are already in the table.
+    void publish(const std::vector<std::shared_ptr<NetworkDevice>>& changed, const std::vector<uint32_t>& removed,
+                 const std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>>& anomalies,
+                 uint64_t snapshotVersion);
+
+    uint32_t deviceCount() const { return header ? header->deviceCount : 0; }
+    uint32_t anomalyCount() const { return header ? header->anomalyCount : 0; }
+    uint64_t snapshotVersion() const { return header ? header->snapshotVersion : 0; }
+
+private:
+    std::string regionName;
+    void* region;
+    size_t regionSize;
+    void* mappingHandle; // Windows file mapping
+    IpcHeader* header;
+    IpcDeviceRecord* table;
+    IpcDeltaRecord* ring;
+
+    std::vector<float> scores; // per deviceId, NaN unless anomalous this cycle
+
+    void appendDelta(IpcChangeType type, const IpcDeviceRecord& record);
+};
+
+// Read-only view of a publisher's region, for tests and C++ consumers;
+// other languages map the region and follow the same protocol
+class IpcReader {
+public:
+    IpcReader();
+    ~IpcReader();
+
+    IpcReader(const IpcReader&) = delete;
+    IpcReader& operator=(const IpcReader&) = delete;
+
+    bool open(const std::string& name);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+    const IpcHeader* layout() const { return header; }
+
+    // Copies the present devices as of one consistent point. deltaCursor is
+    // set to resume readDeltas() from exactly that point. Returns false if
+    // the writer kept the table busy for every attempt.
+    bool readSnapshot(std::vector<IpcDeviceRecord>& devices, uint64_t& version, uint64_t& deltaCursor) const;
+    // Appends the changes after cursor and advances it. Returns false when
+    // changes were overwritten before they could be read; the cursor then
+    // skips to the newest change and the caller should re-read the snapshot.
+    bool readDeltas(uint64_t& cursor, std::vector<std::pair<IpcChangeType, IpcDeviceRecord>>& changes) const;
+
+private:
+    void* region;
+    size_t regionSize;
+    void* mappingHandle;
+    const IpcHeader* header;
+    const IpcDeviceRecord* table;
+    const IpcDeltaRecord* ring;
+};
+
+// Line-based control channel on a Unix domain socket, or a named pipe on
+// Windows. Each request line is answered with exactly one response line by
+// the handler, which runs on the server's thread.
+class IpcControlServer {
+public:
+    using Handler = std::function<std::string(std::string_view request)>;
+
+    IpcControlServer();
+    ~IpcControlServer();
+
+    IpcControlServer(const IpcControlServer&) = delete;
+    IpcControlServer& operator=(const IpcControlServer&) = delete;
+
+    bool start(const std::string& path, Handler handler);
+    void stop();
+    bool isRunning() const { return running.load(); }
+    const std::string& path() const { return endpoint; }
+
+    // "/tmp/<name>.sock", or "\\.\pipe\<name>" on Windows
+    static std::string defaultPath(const std::string& name);
+
+private:
+    std::string endpoint;
+    Handler handler;
+    std::thread thread;
+    std::atomic<bool> running;
+    intptr_t listener; // socket descriptor; unused on Windows
+
+    void serve();
+};
@@ -0,0 +1,212 @@
+#include "Localizer.h"
+#include "Metrics.h"
+#include "SignalKernels.h"
+#include "TaskScheduler.h"
+#include <cmath>
+#include <limits>
+
+Localizer::Localizer() : Localizer(Options()) {
+}
+
+Localizer::Localizer(const Options& options) : options(options), solveCount(0) {
+}
+
+void Localizer::setObservers(const std::vector<Observer>& newObservers) {
+    observers = newObservers;
+    txPower.resize(observers.size());
+    pathLossExponent.resize(observers.size());
+    for (size_t i = 0; i < observers.size(); ++i) {
+        txPower[i] = observers[i].txPower;
+        pathLossExponent[i] = observers[i].pathLossExponent;
+    }
+
+    filters = KalmanFilterBank();
+    observedAt.clear();
+    distances.clear();
+    pendingReadings.clear();
+    positions.clear();
+    solved.clear();
+    solveCount = 0;
+}
+
+void Localizer::ensureDevice(uint32_t deviceId) {
+    while (positions.size() <= deviceId) {
+        size_t pairs = kBlockDevices * observers.size();
+        for (size_t i = 0; i < pairs; ++i) {
+            filters.addFilter();
+        }
+        observedAt.resize(observedAt.size() + pairs, 0);
+        distances.resize(distances.size() + pairs, -1.0f);
+        pendingReadings.resize(pendingReadings.size() + pairs, std::numeric_limits<float>::quiet_NaN());
+        positions.resize(positions.size() + kBlockDevices);
+        solved.resize(solved.size() + kBlockDevices, 0);
+    }
+}
+
+void Localizer::observe(const uint32_t* deviceIds, const uint32_t* observerIds, const float* rssi, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (observerIds[i] < observers.size()) ensureDevice(deviceIds[i]);
+    }
+
+    // Only the pairs read in this call are updated, once each with their last reading
+    touchedPairs.clear();
+    for (size_t i = 0; i < count; ++i) {
+        if (observerIds[i] >= observers.size()) continue;
+        uint32_t index = static_cast<uint32_t>(pairIndex(deviceIds[i], observerIds[i]));
+        if (std::isnan(pendingReadings[index])) touchedPairs.push_back(index);
+        pendingReadings[index] = rssi[i];
+        observedAt[index] = solveCount + 1; // usable from the next solve on
+    }
+    touchedReadings.resize(touchedPairs.size());
+    for (size_t i = 0; i < touchedPairs.size(); ++i) {
+        touchedReadings[i] = pendingReadings[touchedPairs[i]];
+        pendingReadings[touchedPairs[i]] = std::numeric_limits<float>::quiet_NaN();
+    }
+    filters.updateIndexed(touchedPairs.data(), touchedReadings.data(), touchedPairs.size(), nullptr);
+}
+
+size_t Localizer::solve() {
+    SB_SCOPED_TIMER(Localization);
+    solveCount++;
+
+    size_t blocks = positions.size() / kBlockDevices;
+    if (blocks == 0) return 0;
+
+    blockMoved.assign(blocks, 0);
+    if (blocks == 1) {
+        blockMoved[0] = static_cast<uint32_t>(solveBlock(0));
+    } else {
+        TaskScheduler::shared().parallelFor(TaskPriority::Pipeline, blocks, [this](size_t block) {
+            blockMoved[block] = static_cast<uint32_t>(solveBlock(block));
+        });
+    }
+
+    size_t moved = 0;
+    for (uint32_t count : blockMoved) moved += count;
+    return moved;
+}
+
+size_t Localizer::solveBlock(size_t block) {
+    // The block's filtered RSSI is already one row per observer
+    size_t offset = block * observers.size() * kBlockDevices;
+    SignalKernels::estimateDistances(filters.estimateData() + offset, kBlockDevices, txPower.data(),
+                                     pathLossExponent.data(), observers.size(), distances.data() + offset);
+
+    size_t moved = 0;
+    for (size_t lane = 0; lane < kBlockDevices; ++lane) {
+        size_t deviceId = block * kBlockDevices + lane;
+        DevicePosition position = positions[deviceId];
+        if (solveDevice(block, lane, position, !solved[deviceId])) {
+            position.solvedAt = solveCount;
+            positions[deviceId] = position;
+            solved[deviceId] = 1;
+            moved++;
+        }
+    }
+    return moved;
+}
+
+bool Localizer::solveDevice(size_t block, size_t lane, DevicePosition& position, bool first) const {
+    const size_t base = block * observers.size() * kBlockDevices + lane;
+
+    // Range error grows with distance, so each reading is weighted by 1/d^2
+    auto reading = [&](size_t observer, float& distance, float& weight) {
+        size_t index = base + observer * kBlockDevices;
+        distance = distances[index];
+        weight = distance > 0.0f ? 1.0f / (distance * distance) : 0.0f;
+        return observedAt[index] != 0 && solveCount - observedAt[index] < options.maxObservationAge &&
+               distance > 0.0f;
+    };
+
+    size_t used = 0;
+    float weightSum = 0.0f, centroidX = 0.0f, centroidY = 0.0f;
+    for (size_t a = 0; a < observers.size(); ++a) {
+        float distance, weight;
+        if (!reading(a, distance, weight)) continue;
+        used++;
+        weightSum += weight;
+        centroidX += weight * observers[a].x;
+        centroidY += weight * observers[a].y;
+    }
+    if (used < options.minObservers || used == 0) return false;
+
+    float x = position.x, y = position.y;
+    unsigned iterations = options.iterations;
+    if (first) {
+        x = centroidX / weightSum;
+        y = centroidY / weightSum;
+        iterations = options.initialIterations;
+    }
+
+    for (unsigned step = 0; step < iterations; ++step) {
+        // Normal equations J^T W J s = -J^T W r of the range residuals
+        float h11 = 0.0f, h12 = 0.0f, h22 = 0.0f, g1 = 0.0f, g2 = 0.0f;
+        for (size_t a = 0; a < observers.size(); ++a) {
+            float distance, weight;
+            if (!reading(a, distance, weight)) continue;
+            float dx = x - observers[a].x;
+            float dy = y - observers[a].y;
+            float range = std::sqrt(dx * dx + dy * dy);
+            if (range < 1e-3f) continue; // no gradient on top of the observer
+            float jx = dx / range, jy = dy / range;
+            float residual = range - distance;
+            h11 += weight * jx * jx;
+            h12 += weight * jx * jy;
+            h22 += weight * jy * jy;
+            g1 += weight * jx * residual;
+            g2 += weight * jy * residual;
+        }
+
+        // A little Levenberg damping keeps the step finite for nearly collinear observers
+        float damping = 1e-3f * (h11 + h22) + 1e-12f;
+        h11 += damping;
+        h22 += damping;
+        float det = h11 * h22 - h12 * h12;
+        if (!(det > 0.0f)) break;
+
+        float stepX = -(h22 * g1 - h12 * g2) / det;
+        float stepY = -(h11 * g2 - h12 * g1) / det;
+        float length = std::sqrt(stepX * stepX + stepY * stepY);
+        if (length > options.maxStep) {
+            stepX *= options.maxStep / length;
+            stepY *= options.maxStep / length;
+        }
+        x += stepX;
+        y += stepY;
+    }
+
+    float squaredError = 0.0f;
+    for (size_t a = 0; a < observers.size(); ++a) {
+        float distance, weight;
+        if (!reading(a, distance, weight)) continue;
+        float dx = x - observers[a].x;
+        float dy = y - observers[a].y;
+        float residual = std::sqrt(dx * dx + dy * dy) - distance;
+        squaredError += residual * residual;
+    }
+
+    position.x = x;
+    position.y = y;
+    position.residual = std::sqrt(squaredError / static_cast<float>(used));
+    position.observers = static_cast<uint8_t>(used < 255 ? used : 255);
+    return true;
+}
+
+void Localizer::forgetDevice(uint32_t deviceId) {
+    if (deviceId >= positions.size()) return;
+
+    for (size_t observer = 0; observer < observers.size(); ++observer) {
+        size_t index = pairIndex(deviceId, observer);
+        filters.reset(static_cast<uint32_t>(index));
+        observedAt[index] = 0;
+        distances[index] = -1.0f;
+    }
+    positions[deviceId] = DevicePosition();
+    solved[deviceId] = 0;
+}
+
+bool Localizer::position(uint32_t deviceId, DevicePosition& result) const {
+    if (deviceId >= positions.size() || !solved[deviceId]) return false;
+    result = positions[deviceId];
+    return true;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "SignalProcessor.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A fixed receiver that reports RSSI for the devices it hears: an access
+// point, or another scanner, at a known position on the floor plan
+struct Observer {
+    float x = 0.0f; // metres
+    float y = 0.0f;
+    float txPower = -59.0f;          // dBm at the reference distance
+    float pathLossExponent = 2.0f;
+};
+
+struct DevicePosition {
+    float x = 0.0f;
+    float y = 0.0f;
+    float residual = 0.0f;  // RMS range error at the new position, metres
+    uint8_t observers = 0;  // fresh observations the solve used
+    uint32_t solvedAt = 0;  // solve() call that last moved it
+};
+
+// Incremental 2D trilateration from multi-observer RSSI.
+//
+// Every (device, observer) pair has its own Kalman filter. State is kept in
+// blocks of kBlockDevices devices; inside a block each observer's filters
+// form one contiguous row, so a block's filtered RSSI is converted to
+// distances with the batch SignalKernels kernel without any gathering, and
+// growing to more devices only appends blocks.
+//
+// solve() takes one weighted Gauss-Newton step per device from its previous
+// position (new devices start at the weighted centroid of their observers
+// and take initialIterations steps), with the blocks spread over the shared
+// TaskScheduler. Per device that is a few dozen flops per observer, so
+// thousands of devices fit easily in one monitoring cycle.
+//
+// Not synchronized: observe(), solve() and the readers belong to one thread
+// at a time, like SignalProcessor.
+class Localizer {
+public:
+    static constexpr size_t kBlockDevices = 128;
+
+    struct Options {
+        size_t minObservers = 3;          // fewer leave the position ambiguous
+        uint32_t maxObservationAge = 3;   // solve() calls a reading stays usable
+        unsigned iterations = 1;          // Gauss-Newton steps per solve for known devices
+        unsigned initialIterations = 8;   // steps for a device's first solve
+        float maxStep = 5.0f;             // metres one step may move a device
+    };
+
+    Localizer();
+    explicit Localizer(const Options& options);
+
+    // Replaces the observers; every device's filters and position are
+    // cleared, since both are tied to the observer layout
+    void setObservers(const std::vector<Observer>& observers);
+    size_t observerCount() const { return observers.size(); }
+
+    // Feeds count readings, reading i being what observer observerIds[i]
+    // heard from device deviceIds[i]. Device IDs are dense, such as the
+    // scanner's interned IDs. Readings for unknown observers are ignored;
+    // for a pair repeated in one call only the last reading counts.
+    void observe(const uint32_t* deviceIds, const uint32_t* observerIds, const float* rssi, size_t count);
+
+    // Updates every device with at least minObservers fresh readings and
+    // returns how many moved
+    size_t solve();
+
+    // Clears one device's filters and position, e.g. once the scanner has
+    // removed it and may hand its ID to another device
+    void forgetDevice(uint32_t deviceId);
+
+    // False until the device has been solved once
+    bool position(uint32_t deviceId, DevicePosition& result) const;
+    size_t deviceCapacity() const { return positions.size(); }
+
+private:
+    Options options;
+    std::vector<Observer> observers;
+    std::vector<float> txPower;           // per observer, for the distance kernel
+    std::vector<float> pathLossExponent;
+
+    // Per (device, observer) pair, in block layout (see pairIndex())
+    KalmanFilterBank filters;
+    std::vector<uint32_t> observedAt;     // solve count when last observed; 0 never
+    std::vector<float> distances;         // scratch for solve()
+    std::vector<float> pendingReadings;   // NaN except during observe()
+    std::vector<uint32_t> touchedPairs;   // scratch for observe()
+    std::vector<float> touchedReadings;
+
+    // Per device
+    std::vector<DevicePosition> positions;
+    std::vector<uint8_t> solved;
+    std::vector<uint32_t> blockMoved;     // per block, filled by solve()
+    uint32_t solveCount;
+
+    size_t pairIndex(uint32_t deviceId, size_t observer) const {
+        size_t block = deviceId / kBlockDevices;
+        return (block * observers.size() + observer) * kBlockDevices + deviceId % kBlockDevices;
+    }
+
+    void ensureDevice(uint32_t deviceId);
+    size_t solveBlock(size_t block);
+    // Weighted Gauss-Newton update of one device; false without enough readings
+    bool solveDevice(size_t block, size_t lane, DevicePosition& position, bool first) const;
+};
@@ -3,189 +3,647 @@
 #include <numeric>
 #include <cmath>
 #include <random>
+#include <thread>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include "Checksum.h"
 
-MLEngine::MLEngine() : isolationForest(100, 256, 42) {
-    // Initialize with default parameters
+namespace {
+
+constexpr char kSnapshotMagic[8] = {'S', 'B', 'F', 'O', 'R', 'S', 'T', '\0'};
+constexpr uint32_t kSnapshotVersion = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t featureLayout;
+    uint32_t featureCount;
+    uint32_t treeCount;
+    uint32_t nodeCount;
+    int32_t subsampleSize;
+    int32_t randomSeed;
+    uint32_t treesBuilt;
+    uint32_t nextReplacement;
+    double normalizer;
+    uint32_t checksum; // CRC-32 over tree roots, tree sizes and nodes
+    uint32_t reserved;
+};
+
+// Nodes are mapped in place, so their layout is part of the file format
+static_assert(sizeof(IsolationNode) == 16, "IsolationNode layout changed; bump kSnapshotVersion");
+static_assert(sizeof(SnapshotHeader) % alignof(IsolationNode) == 0, "Snapshot sections must stay aligned");
+
+} // namespace
+
+MLEngine::MLEngine()
+    : isolationForest(std::make_shared<IsolationForest>(kForestTrees, kForestSubsample, kForestSeed)),
+      onlineLearning(false), windowRows(0), windowNext(0), retraining(false), retrainCount(0) {
 }
 
-std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>> 
+MLEngine::~MLEngine() {
+    retrainTask.wait();
+}
+
+std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>>
 MLEngine::detectAnomalies(const std::vector<std::shared_ptr<NetworkDevice>>& devices) {
     std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>> anomalies;
+    detectAnomalies(devices, anomalies);
+    return anomalies;
+}
+
+void MLEngine::detectAnomalies(const std::vector<std::shared_ptr<NetworkDevice>>& devices,
+                               std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>>& anomalies) {
+    installPendingModel();
+    if (devices.empty()) return;
+    
+    // Build one dense feature matrix and score every device in a single pass
+    featureMatrix.resize(devices.size() * kNumFeatures);
+    scores.resize(devices.size());
+    featureStore.observe(devices.data(), devices.size(), std::chrono::system_clock::now(), featureMatrix.data());
+    
+    size_t chunks = (devices.size() + kScoreChunkRows - 1) / kScoreChunkRows;
+    if (chunks == 1) {
+        isolationForest->anomalyScoreBatch(featureMatrix.data(), devices.size(), kNumFeatures, scores.data());
+    } else {
+        const IsolationForest& forest = *isolationForest;
+        TaskScheduler::shared().parallelFor(TaskPriority::Pipeline, chunks, [&](size_t chunk) {
+            size_t begin = chunk * kScoreChunkRows;
+            size_t count = std::min(kScoreChunkRows, devices.size() - begin);
+            forest.anomalyScoreBatch(&featureMatrix[begin * kNumFeatures], count, kNumFeatures, &scores[begin]);
+        });
+    }
     
-    for (const auto& device : devices) {
-        double anomalyScore = calculateAnomalyScore(device);
-        if (anomalyScore > 0.6) { // Threshold for anomaly detection
-            anomalies.push_back({device, anomalyScore});
+    for (size_t i = 0; i < devices.size(); ++i) {
+        if (scores[i] > 0.6) { // Threshold for anomaly detection
+            anomalies.push_back({devices[i], scores[i]});
         }
     }
     
-    return anomalies;
+    // Learn only after scoring, so a burst of odd readings is still reported once
+    if (onlineLearning) {
+        learn(featureMatrix.data(), devices.size());
+    }
 }
 
-double MLEngine::calculateAnomalyScore(const std::shared_ptr<NetworkDevice>& device) {
-    // Create feature vector for isolation forest
-    std::vector<double> features = {
-        static_cast<double>(device->rssi),
-        device->isOnline ? 1.0 : 0.0,
-        getTimeSinceLastSeen(device),
-        getDeviceTypeScore(device->deviceType)
-    };
+void MLEngine::enableOnlineLearning(const OnlineOptions& options) {
+    onlineOptions = options;
+    onlineOptions.windowSize = std::max<size_t>(1, options.windowSize);
+    window.assign(onlineOptions.windowSize * kNumFeatures, 0.0f);
+    windowRows = 0;
+    windowNext = 0;
+    onlineLearning = true;
+}
+
+void MLEngine::disableOnlineLearning() {
+    onlineLearning = false;
+    window.clear();
+    window.shrink_to_fit();
+    windowRows = 0;
+    windowNext = 0;
+}
+
+void MLEngine::learn(const float* rows, size_t n) {
+    // Overwrite the oldest rows; the window is unordered, trees subsample it at random
+    size_t capacity = onlineOptions.windowSize;
+    for (size_t i = 0; i < n; ++i) {
+        std::copy(rows + i * kNumFeatures, rows + (i + 1) * kNumFeatures, &window[windowNext * kNumFeatures]);
+        windowNext = (windowNext + 1) % capacity;
+    }
+    windowRows = std::min(capacity, windowRows + n);
+    
+    if (!isolationForest->isTrained()) {
+        if (windowRows >= onlineOptions.minRowsToTrain) {
+            isolationForest->train(window.data(), windowRows, kNumFeatures);
+            isolationForest->reserveForReplacements(onlineOptions.maxTreesPerUpdate);
+        }
+        return;
+    }
     
-    return isolationForest.anomalyScore(features);
+    // Replace trees in proportion to how much of the window is new, so a
+    // full window's worth of changes rebuilds the whole forest
+    double share = static_cast<double>(std::min(n, capacity)) / static_cast<double>(capacity);
+    int trees = static_cast<int>(std::ceil(share * static_cast<double>(isolationForest->treeCount())));
+    trees = std::max(1, std::min(trees, onlineOptions.maxTreesPerUpdate));
+    isolationForest->replaceTrees(window.data(), windowRows, kNumFeatures, trees);
 }
 
-double MLEngine::getTimeSinceLastSeen(const std::shared_ptr<NetworkDevice>& device) {
-    auto now = std::chrono::system_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - device->lastSeen);
-    return static_cast<double>(duration.count());
+bool MLEngine::trainModelAsync(const std::vector<std::shared_ptr<NetworkDevice>>& historicalData) {
+    if (retraining.load() || historicalData.empty()) return false;
+    
+    return startRetrain(extractRows(historicalData), historicalData.size());
 }
 
-double MLEngine::getDeviceTypeScore(const std::string& deviceType) {
-    // Score based on device type reliability
-    if (deviceType == "router") return 0.9;
-    if (deviceType == "printer") return 0.7;
-    if (deviceType == "smart_tv") return 0.8;
-    if (deviceType == "laptop") return 0.6;
-    if (deviceType == "phone") return 0.5;
-    return 0.3; // Unknown devices
+bool MLEngine::retrainFromWindowAsync() {
+    if (retraining.load() || windowRows < onlineOptions.minRowsToTrain) return false;
+    
+    std::vector<float> rows(window.begin(), window.begin() + windowRows * kNumFeatures);
+    return startRetrain(std::move(rows), windowRows);
 }
 
-void MLEngine::trainModel(const std::vector<std::shared_ptr<NetworkDevice>>& historicalData) {
-    std::vector<std::vector<double>> trainingData;
+bool MLEngine::startRetrain(std::vector<float> rows, size_t n) {
+    if (retraining.exchange(true)) return false;
     
-    for (const auto& device : historicalData) {
-        std::vector<double> features = {
-            static_cast<double>(device->rssi),
-            device->isOnline ? 1.0 : 0.0,
-            getTimeSinceLastSeen(device),
-            getDeviceTypeScore(device->deviceType)
-        };
-        trainingData.push_back(features);
+    // Tree building fans out at Training priority, so it only uses workers
+    // the monitoring pipeline leaves idle
+    int seed = kForestSeed + ++retrainCount;
+    retrainTask = TaskScheduler::shared().submit(TaskPriority::Training, [this, rows = std::move(rows), n, seed]() {
+        auto model = std::make_shared<IsolationForest>(kForestTrees, kForestSubsample, seed);
+        model->train(rows.data(), n, kNumFeatures);
+        model->reserveForReplacements(onlineOptions.maxTreesPerUpdate);
+        
+        std::atomic_store(&pendingModel, std::move(model));
+        retraining.store(false);
+    });
+    return true;
+}
+
+bool MLEngine::saveModel(const std::string& path) const {
+    return isolationForest->saveSnapshot(path, FeatureStore::kLayoutVersion);
+}
+
+bool MLEngine::loadModel(const std::string& path) {
+    auto model = std::make_shared<IsolationForest>(kForestTrees, kForestSubsample, kForestSeed);
+    if (!model->loadSnapshot(path, FeatureStore::kLayoutVersion) || model->numFeatures() != kNumFeatures) {
+        return false;
     }
+    isolationForest = std::move(model);
+    return true;
+}
+
+void MLEngine::installPendingModel() {
+    if (!std::atomic_load(&pendingModel)) return;
     
-    isolationForest.train(trainingData);
+    auto model = std::atomic_exchange(&pendingModel, std::shared_ptr<IsolationForest>());
+    if (model) {
+        isolationForest = std::move(model);
+    }
+}
+
+std::vector<float> MLEngine::extractRows(const std::vector<std::shared_ptr<NetworkDevice>>& devices) const {
+    auto now = std::chrono::system_clock::now();
+    std::vector<float> rows(devices.size() * kNumFeatures);
+    for (size_t i = 0; i < devices.size(); ++i) {
+        featureStore.extract(*devices[i], now, &rows[i * kNumFeatures]);
+    }
+    return rows;
+}
+
+void MLEngine::resetDevice(uint32_t deviceId) {
+    featureStore.reset(deviceId);
+}
+
+void MLEngine::trainModel(const std::vector<std::shared_ptr<NetworkDevice>>& historicalData) {
+    std::vector<float> trainingData = extractRows(historicalData);
+    isolationForest->train(trainingData.data(), historicalData.size(), kNumFeatures);
 }
 
 // Isolation Forest Implementation
 IsolationForest::IsolationForest(int numTrees, int subsampleSize, int randomSeed)
-    : numTrees(numTrees), subsampleSize(subsampleSize), generator(randomSeed) {
+    : numTrees(numTrees), subsampleSize(subsampleSize), randomSeed(randomSeed), trainingThreads(0),
+      featureCount(0), normalizer(calculateC(subsampleSize)), nodeData(nullptr), nodeDataCount(0),
+      rootData(nullptr), sizeData(nullptr), rootCount(0), nextReplacement(0), treesBuilt(0) {
 }
 
 void IsolationForest::train(const std::vector<std::vector<double>>& data) {
-    trees.clear();
-    trees.reserve(numTrees);
+    if (data.empty()) {
+        train(nullptr, 0, 0);
+        return;
+    }
+    
+    size_t numFeatures = data[0].size();
+    std::vector<float> rows(data.size() * numFeatures);
+    for (size_t i = 0; i < data.size(); ++i) {
+        std::copy(data[i].begin(), data[i].begin() + numFeatures, rows.begin() + i * numFeatures);
+    }
     
-    for (int i = 0; i < numTrees; ++i) {
-        // Create subsample
-        auto subsample = createSubsample(data);
+    train(rows.data(), data.size(), numFeatures);
+}
+
+void IsolationForest::train(const float* rows, size_t n, size_t numFeatures) {
+    nodes.clear();
+    treeRoots.clear();
+    treeSizes.clear();
+    mapping.close();
+    bindOwnedStorage();
+    nextReplacement = 0;
+    if (n == 0 || numFeatures == 0 || numTrees <= 0) return;
+    
+    featureCount = numFeatures;
+    int sampleSize = static_cast<int>(std::min<size_t>(std::max(subsampleSize, 1), n));
+    int maxDepth = static_cast<int>(std::log2(sampleSize));
+    
+    // A tree cut off at maxDepth never has more than 2^(maxDepth+1) - 1 nodes,
+    // so each tree gets a fixed slot and workers never allocate or contend.
+    uint32_t slotSize = (2u << maxDepth) - 1;
+    nodes.resize(static_cast<size_t>(numTrees) * slotSize);
+    treeRoots.resize(numTrees);
+    std::vector<uint32_t> nodeCounts(numTrees);
+    
+    TaskScheduler& scheduler = TaskScheduler::shared();
+    unsigned threads = trainingThreads ? trainingThreads : scheduler.workerCount();
+    threads = std::max(1u, std::min(threads, static_cast<unsigned>(numTrees)));
+    
+    std::atomic<int> nextTree(0);
+    auto worker = [&]() {
+        std::vector<uint32_t> indices(sampleSize);
+        TreeBuilder builder;
+        builder.rows = rows;
+        builder.numFeatures = numFeatures;
+        builder.indices = indices.data();
+        builder.nodes = nodes.data();
+        
+        for (int tree = nextTree++; tree < numTrees; tree = nextTree++) {
+            builder.rng.seed(treeSeed(randomSeed, tree));
+            builder.nodeBase = static_cast<uint32_t>(tree) * slotSize;
+            builder.nodeCount = 0;
+            
+            buildTree(builder, n, sampleSize);
+            nodeCounts[tree] = builder.nodeCount;
+        }
+    };
+    
+    if (threads == 1) {
+        worker();
+    } else {
+        // Each slot pulls trees until none are left, however many actually start
+        scheduler.parallelFor(TaskPriority::Training, threads, [&](size_t) { worker(); }, threads);
+    }
+    
+    // Compact the per-tree slots into one contiguous array, rebasing child indices
+    uint32_t offset = 0;
+    for (int tree = 0; tree < numTrees; ++tree) {
+        uint32_t slotBase = static_cast<uint32_t>(tree) * slotSize;
+        uint32_t shift = slotBase - offset;
         
-        // Build tree
-        auto tree = buildTree(subsample, 0, static_cast<int>(std::log2(subsample.size())));
-        trees.push_back(tree);
+        for (uint32_t i = 0; i < nodeCounts[tree]; ++i) {
+            IsolationNode node = nodes[slotBase + i];
+            if (!node.isLeaf()) {
+                node.left -= shift;
+                node.right -= shift;
+            }
+            nodes[offset + i] = node;
+        }
+        
+        treeRoots[tree] = offset;
+        offset += nodeCounts[tree];
     }
+    
+    nodes.resize(offset);
+    nodes.shrink_to_fit();
+    treeSizes = std::move(nodeCounts);
+    treesBuilt = static_cast<uint32_t>(numTrees);
+    bindOwnedStorage();
 }
 
-double IsolationForest::anomalyScore(const std::vector<double>& point) {
-    if (trees.empty()) return 0.5; // Default score if not trained
+void IsolationForest::replaceTrees(const float* rows, size_t n, size_t numFeatures, int count) {
+    if (!isTrained() || numFeatures != featureCount) {
+        train(rows, n, numFeatures);
+        return;
+    }
+    if (n == 0 || count <= 0) return;
+    if (isMapped()) {
+        detachMapping();
+    }
+    
+    count = std::min(count, static_cast<int>(treeRoots.size()));
+    int sampleSize = static_cast<int>(std::min<size_t>(std::max(subsampleSize, 1), n));
+    uint32_t slotSize = (2u << static_cast<int>(std::log2(sampleSize))) - 1;
+    replacementIndices.resize(sampleSize);
     
-    double totalPathLength = 0.0;
+    TreeBuilder builder;
+    builder.rows = rows;
+    builder.numFeatures = numFeatures;
+    builder.indices = replacementIndices.data();
     
-    for (const auto& tree : trees) {
-        totalPathLength += getPathLength(tree, point, 0);
+    for (int i = 0; i < count; ++i) {
+        int tree = nextReplacement;
+        nextReplacement = (nextReplacement + 1) % static_cast<int>(treeRoots.size());
+        
+        // New trees go at the end of the node array; the old nodes become
+        // garbage until the next compaction
+        uint32_t base = static_cast<uint32_t>(nodes.size());
+        nodes.resize(base + slotSize);
+        builder.nodes = nodes.data();
+        builder.nodeBase = base;
+        builder.nodeCount = 0;
+        builder.rng.seed(treeSeed(randomSeed, static_cast<int>(treesBuilt++)));
+        
+        buildTree(builder, n, sampleSize);
+        nodes.resize(base + builder.nodeCount);
+        treeRoots[tree] = base;
+        treeSizes[tree] = builder.nodeCount;
     }
     
-    double avgPathLength = totalPathLength / trees.size();
-    double c = calculateC(subsampleSize);
+    size_t liveNodes = std::accumulate(treeSizes.begin(), treeSizes.end(), size_t(0));
+    if (nodes.size() > 2 * liveNodes) {
+        compactNodes();
+    }
+    bindOwnedStorage();
+}
+
+void IsolationForest::reserveForReplacements(int treesPerUpdate) {
+    if (!isTrained() || isMapped()) return;
     
-    // Anomaly score formula: 2^(-avgPathLength/c)
-    return std::pow(2.0, -avgPathLength / c);
+    // replaceTrees() compacts once the array passes twice the live nodes, so
+    // it peaks just above that; the margin absorbs trees growing a little
+    int sampleSize = std::max(subsampleSize, 1);
+    size_t slotSize = (2u << static_cast<int>(std::log2(sampleSize))) - 1;
+    size_t liveNodes = std::accumulate(treeSizes.begin(), treeSizes.end(), size_t(0));
+    size_t capacity = 2 * (liveNodes + static_cast<size_t>(std::max(treesPerUpdate, 1)) * slotSize);
+    nodes.reserve(capacity);
+    spareNodes.reserve(capacity);
+    bindOwnedStorage();
 }
 
-std::vector<std::vector<double>> IsolationForest::createSubsample(const std::vector<std::vector<double>>& data) {
-    std::vector<std::vector<double>> subsample;
-    std::uniform_int_distribution<> dist(0, static_cast<int>(data.size() - 1));
+void IsolationForest::compactNodes() {
+    // Repack the trees in order so scoring walks one dense array again
+    std::vector<IsolationNode>& packed = spareNodes;
+    packed.clear();
+    packed.reserve(std::accumulate(treeSizes.begin(), treeSizes.end(), size_t(0)));
     
-    int sampleSize = std::min(subsampleSize, static_cast<int>(data.size()));
+    for (size_t tree = 0; tree < treeRoots.size(); ++tree) {
+        uint32_t root = treeRoots[tree];
+        uint32_t offset = static_cast<uint32_t>(packed.size());
+        for (uint32_t i = 0; i < treeSizes[tree]; ++i) {
+            IsolationNode node = nodes[root + i];
+            if (!node.isLeaf()) {
+                node.left = node.left - root + offset;
+                node.right = node.right - root + offset;
+            }
+            packed.push_back(node);
+        }
+        treeRoots[tree] = offset;
+    }
     
+    nodes.swap(packed);
+}
+
+void IsolationForest::bindOwnedStorage() {
+    nodeData = nodes.data();
+    nodeDataCount = nodes.size();
+    rootData = treeRoots.data();
+    sizeData = treeSizes.data();
+    rootCount = treeRoots.size();
+}
+
+void IsolationForest::detachMapping() {
+    nodes.assign(nodeData, nodeData + nodeDataCount);
+    treeRoots.assign(rootData, rootData + rootCount);
+    treeSizes.assign(sizeData, sizeData + rootCount);
+    mapping.close();
+    bindOwnedStorage();
+}
+
+bool IsolationForest::saveSnapshot(const std::string& path, uint32_t featureLayout) const {
+    if (!isTrained()) return false;
+    
+    // Trees are written back to back, so nodes left behind by replacements are dropped
+    std::vector<uint32_t> roots(rootCount);
+    std::vector<IsolationNode> packed;
+    packed.reserve(nodeDataCount);
+    for (size_t tree = 0; tree < rootCount; ++tree) {
+        uint32_t root = rootData[tree];
+        uint32_t offset = static_cast<uint32_t>(packed.size());
+        for (uint32_t i = 0; i < sizeData[tree]; ++i) {
+            IsolationNode node = nodeData[root + i];
+            if (!node.isLeaf()) {
+                node.left = node.left - root + offset;
+                node.right = node.right - root + offset;
+            }
+            packed.push_back(node);
+        }
+        roots[tree] = offset;
+    }
+    
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+    header.version = kSnapshotVersion;
+    header.byteOrder = kByteOrderMark;
+    header.featureLayout = featureLayout;
+    header.featureCount = static_cast<uint32_t>(featureCount);
+    header.treeCount = static_cast<uint32_t>(rootCount);
+    header.nodeCount = static_cast<uint32_t>(packed.size());
+    header.subsampleSize = subsampleSize;
+    header.randomSeed = randomSeed;
+    header.treesBuilt = treesBuilt;
+    header.nextReplacement = static_cast<uint32_t>(nextReplacement);
+    header.normalizer = normalizer;
+    
+    uint32_t checksum = crc32(roots.data(), rootCount * sizeof(uint32_t));
+    checksum = crc32(sizeData, rootCount * sizeof(uint32_t), checksum);
+    header.checksum = crc32(packed.data(), packed.size() * sizeof(IsolationNode), checksum);
+    
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(roots.data()), rootCount * sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(sizeData), rootCount * sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(packed.data()), packed.size() * sizeof(IsolationNode));
+        if (!file) return false;
+    }
+    
+    // A concurrent loader maps either the previous snapshot or this one
+    return replaceFile(tempPath, path);
+}
+
+bool IsolationForest::loadSnapshot(const std::string& path, uint32_t featureLayout) {
+    MappedFile file;
+    if (!file.open(path) || file.size() < sizeof(SnapshotHeader)) return false;
+    
+    SnapshotHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 ||
+        header.version != kSnapshotVersion || header.byteOrder != kByteOrderMark ||
+        header.featureLayout != featureLayout || header.featureCount == 0 || header.treeCount == 0 ||
+        !std::isfinite(header.normalizer)) {
+        return false;
+    }
+    
+    uint64_t expected = sizeof(SnapshotHeader) + 2 * static_cast<uint64_t>(header.treeCount) * sizeof(uint32_t) +
+                        static_cast<uint64_t>(header.nodeCount) * sizeof(IsolationNode);
+    if (file.size() != expected) return false;
+    
+    const uint8_t* cursor = file.data() + sizeof(SnapshotHeader);
+    const uint32_t* roots = reinterpret_cast<const uint32_t*>(cursor);
+    const uint32_t* sizes = roots + header.treeCount;
+    const IsolationNode* mappedNodes = reinterpret_cast<const IsolationNode*>(sizes + header.treeCount);
+    if (crc32(cursor, file.size() - sizeof(SnapshotHeader)) != header.checksum) return false;
+    
+    // Scoring trusts the structure, so check that every walk stays inside its
+    // tree and terminates: children always come after their parent
+    for (uint32_t tree = 0; tree < header.treeCount; ++tree) {
+        uint64_t end = static_cast<uint64_t>(roots[tree]) + sizes[tree];
+        if (sizes[tree] == 0 || end > header.nodeCount) return false;
+        
+        for (uint32_t i = roots[tree]; i < end; ++i) {
+            const IsolationNode& node = mappedNodes[i];
+            if (node.isLeaf()) continue;
+            if (node.splitFeature >= header.featureCount || node.left <= i || node.right <= i ||
+                node.left >= end || node.right >= end) {
+                return false;
+            }
+        }
+    }
+    
+    nodes.clear();
+    treeRoots.clear();
+    treeSizes.clear();
+    mapping.swap(file);
+    file.close();
+    
+    nodeData = mappedNodes;
+    nodeDataCount = header.nodeCount;
+    rootData = roots;
+    sizeData = sizes;
+    rootCount = header.treeCount;
+    
+    numTrees = static_cast<int>(header.treeCount);
+    subsampleSize = header.subsampleSize;
+    randomSeed = header.randomSeed;
+    featureCount = header.featureCount;
+    normalizer = header.normalizer;
+    treesBuilt = header.treesBuilt;
+    nextReplacement = static_cast<int>(header.nextReplacement % header.treeCount);
+    return true;
+}
+
+double IsolationForest::anomalyScore(const std::vector<double>& point) const {
+    if (!isTrained()) return 0.5; // Default score if not trained
+    
+    std::vector<float> row(point.begin(), point.end());
+    row.resize(std::max(row.size(), featureCount), 0.0f);
+    
+    double score;
+    anomalyScoreBatch(row.data(), 1, row.size(), &score);
+    return score;
+}
+
+void IsolationForest::anomalyScoreBatch(const float* rows, size_t n, size_t stride, double* out) const {
+    if (!isTrained()) {
+        std::fill(out, out + n, 0.5); // Default score if not trained
+        return;
+    }
+    
+    // Walk every tree over a block of rows before moving to the next tree so
+    // each tree's nodes stay hot in cache while the block is scored.
+    constexpr size_t kBlock = 64;
+    float pathLengths[kBlock];
+    double c = normalizer > 0.0 ? normalizer : 1.0;
+    double scale = 1.0 / (static_cast<double>(rootCount) * c);
+    
+    for (size_t base = 0; base < n; base += kBlock) {
+        size_t count = std::min(kBlock, n - base);
+        const float* block = rows + base * stride;
+        std::fill(pathLengths, pathLengths + count, 0.0f);
+        
+        for (size_t tree = 0; tree < rootCount; ++tree) {
+            uint32_t root = rootData[tree];
+            for (size_t r = 0; r < count; ++r) {
+                pathLengths[r] += getPathLength(root, block + r * stride);
+            }
+        }
+        
+        // Anomaly score formula: 2^(-avgPathLength/c)
+        for (size_t r = 0; r < count; ++r) {
+            out[base + r] = std::exp2(-pathLengths[r] * scale);
+        }
+    }
+}
+
+void IsolationForest::buildTree(TreeBuilder& builder, size_t numRows, int sampleSize) {
+    // Subsample with replacement into the index array; splits then partition
+    // this array in place instead of copying rows.
+    std::uniform_int_distribution<uint32_t> dist(0, static_cast<uint32_t>(numRows - 1));
     for (int i = 0; i < sampleSize; ++i) {
-        int index = dist(generator);
-        subsample.push_back(data[index]);
+        builder.indices[i] = dist(builder.rng);
     }
     
-    return subsample;
+    buildNode(builder, 0, static_cast<uint32_t>(sampleSize), 0, static_cast<int>(std::log2(sampleSize)));
 }
 
-std::shared_ptr<IsolationTree> IsolationForest::buildTree(const std::vector<std::vector<double>>& data, 
-                                                          int depth, int maxDepth) {
-    auto node = std::make_shared<IsolationTree>();
+uint32_t IsolationForest::buildNode(TreeBuilder& builder, uint32_t begin, uint32_t end, int depth, int maxDepth) {
+    uint32_t size = end - begin;
     
     // Terminal conditions
-    if (data.size() <= 1 || depth >= maxDepth) {
-        node->isLeaf = true;
-        node->size = static_cast<int>(data.size());
-        return node;
+    if (size <= 1 || depth >= maxDepth) {
+        return addLeaf(builder, size, depth);
     }
     
     // Random feature selection
-    int numFeatures = static_cast<int>(data[0].size());
-    std::uniform_int_distribution<> featureDist(0, numFeatures - 1);
-    int splitFeature = featureDist(generator);
+    std::uniform_int_distribution<uint32_t> featureDist(0, static_cast<uint32_t>(builder.numFeatures - 1));
+    uint32_t splitFeature = featureDist(builder.rng);
     
     // Find min/max for selected feature
-    double minVal = std::numeric_limits<double>::max();
-    double maxVal = std::numeric_limits<double>::lowest();
+    const float* rows = builder.rows;
+    size_t stride = builder.numFeatures;
+    float minVal = std::numeric_limits<float>::max();
+    float maxVal = std::numeric_limits<float>::lowest();
     
-    for (const auto& point : data) {
-        minVal = std::min(minVal, point[splitFeature]);
-        maxVal = std::max(maxVal, point[splitFeature]);
+    for (uint32_t i = begin; i < end; ++i) {
+        float value = rows[builder.indices[i] * stride + splitFeature];
+        minVal = std::min(minVal, value);
+        maxVal = std::max(maxVal, value);
     }
     
     if (minVal >= maxVal) {
         // Cannot split
-        node->isLeaf = true;
-        node->size = static_cast<int>(data.size());
-        return node;
+        return addLeaf(builder, size, depth);
     }
     
     // Random split point
-    std::uniform_real_distribution<> splitDist(minVal, maxVal);
-    double splitValue = splitDist(generator);
-    
-    node->isLeaf = false;
-    node->splitFeature = splitFeature;
-    node->splitValue = splitValue;
-    
-    // Split data
-    std::vector<std::vector<double>> leftData, rightData;
-    for (const auto& point : data) {
-        if (point[splitFeature] < splitValue) {
-            leftData.push_back(point);
-        } else {
-            rightData.push_back(point);
-        }
-    }
+    std::uniform_real_distribution<double> splitDist(minVal, maxVal);
+    float splitValue = static_cast<float>(splitDist(builder.rng));
+    
+    uint32_t index = builder.nodeBase + builder.nodeCount++;
+    builder.nodes[index] = {splitValue, splitFeature, 0, 0};
+    
+    // Partition the index range in place
+    uint32_t* first = builder.indices + begin;
+    uint32_t* middle = std::partition(first, builder.indices + end, [&](uint32_t row) {
+        return rows[row * stride + splitFeature] < splitValue;
+    });
+    uint32_t mid = begin + static_cast<uint32_t>(middle - first);
     
     // Recursively build subtrees
-    node->left = buildTree(leftData, depth + 1, maxDepth);
-    node->right = buildTree(rightData, depth + 1, maxDepth);
+    uint32_t left = buildNode(builder, begin, mid, depth + 1, maxDepth);
+    uint32_t right = buildNode(builder, mid, end, depth + 1, maxDepth);
+    builder.nodes[index].left = left;
+    builder.nodes[index].right = right;
     
-    return node;
+    return index;
 }
 
-double IsolationForest::getPathLength(const std::shared_ptr<IsolationTree>& tree, 
-                                     const std::vector<double>& point, int depth) {
-    if (tree->isLeaf) {
-        return depth + calculateC(tree->size);
-    }
-    
-    if (point[tree->splitFeature] < tree->splitValue) {
-        return getPathLength(tree->left, point, depth + 1);
-    } else {
-        return getPathLength(tree->right, point, depth + 1);
+uint32_t IsolationForest::addLeaf(TreeBuilder& builder, uint32_t size, int depth) {
+    uint32_t index = builder.nodeBase + builder.nodeCount++;
+    float pathLength = static_cast<float>(depth + calculateC(static_cast<int>(size)));
+    builder.nodes[index] = {pathLength, IsolationNode::kLeaf, 0, 0};
+    return index;
+}
+
+uint32_t IsolationForest::treeSeed(int randomSeed, int tree) {
+    // SplitMix64 over (seed, tree) gives well-separated per-tree streams
+    uint64_t z = (static_cast<uint64_t>(static_cast<uint32_t>(randomSeed)) << 32) + static_cast<uint32_t>(tree);
+    z += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return static_cast<uint32_t>(z ^ (z >> 31));
+}
+
+float IsolationForest::getPathLength(uint32_t root, const float* point) const {
+    const IsolationNode* node = &nodeData[root];
+    while (!node->isLeaf()) {
+        node = &nodeData[point[node->splitFeature] < node->splitValue ? node->left : node->right];
     }
+    return node->splitValue;
 }
 
 double IsolationForest::calculateC(int n) {
     if (n <= 1) return 0.0;
     return 2.0 * (std::log(n - 1) + 0.5772156649) - (2.0 * (n - 1) / n);
-}
\ No newline at end of file
+}
@@ -1,20 +1,31 @@
 #pragma once
 
 #include "NetworkScanner.h"
+#include "FeatureStore.h"
+#include "MappedFile.h"
+#include "TaskScheduler.h"
 #include <vector>
 #include <memory>
 #include <random>
 #include <limits>
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <thread>
+#include <string>
 
-struct IsolationTree {
-    bool isLeaf;
-    int splitFeature;
-    double splitValue;
-    int size;
-    std::shared_ptr<IsolationTree> left;
-    std::shared_ptr<IsolationTree> right;
-    
-    IsolationTree() : isLeaf(false), splitFeature(-1), splitValue(0.0), size(0) {}
+// Flat isolation tree node. All trees of a forest live in one contiguous
+// array and children are addressed by 32-bit index into that array.
+// Leaves store their precomputed path length (depth + c(size)) in splitValue.
+struct IsolationNode {
+    static constexpr uint32_t kLeaf = 0xFFFFFFFFu;
+    
+    float splitValue;
+    uint32_t splitFeature;
+    uint32_t left;
+    uint32_t right;
+    
+    bool isLeaf() const { return splitFeature == kLeaf; }
 };
 
 class IsolationForest {
@@ -22,33 +33,173 @@ public:
     IsolationForest(int numTrees = 100, int subsampleSize = 256, int randomSeed = 42);
     
     void train(const std::vector<std::vector<double>>& data);
-    double anomalyScore(const std::vector<double>& point);
+    // Trains on a dense row-major matrix of n rows with numFeatures floats each.
+    void train(const float* rows, size_t n, size_t numFeatures);
+    double anomalyScore(const std::vector<double>& point) const;
+    
+    // Sliding-window update: rebuilds the `count` oldest trees from n rows
+    // (e.g. a window of recent observations) and keeps the rest. The cost
+    // depends only on count and the subsample size, not on the history.
+    // Trains from scratch when untrained or the feature count changes.
+    void replaceTrees(const float* rows, size_t n, size_t numFeatures, int count);
+    // Sizes the node buffers for replaceTrees() calls of up to treesPerUpdate
+    // trees, so sliding-window updates stop reallocating them
+    void reserveForReplacements(int treesPerUpdate);
+    
+    // Scores n rows of `numFeatures()` floats each; consecutive rows are
+    // `stride` floats apart. Writes one score per row into out.
+    void anomalyScoreBatch(const float* rows, size_t n, size_t stride, double* out) const;
+    
+    // Most threads used to build trees, on the shared TaskScheduler; 0 uses
+    // every worker and 1 builds on the calling thread. Every tree draws from its
+    // own RNG stream derived from randomSeed, so the trained forest is the same
+    // for any thread count.
+    void setTrainingThreads(unsigned threads) { trainingThreads = threads; }
+    
+    // Flat snapshot of the trained trees: a versioned header, then the tree
+    // roots, tree sizes and nodes exactly as scoring reads them, all covered
+    // by a CRC. featureLayout identifies how the rows were built and must
+    // match on load.
+    bool saveSnapshot(const std::string& path, uint32_t featureLayout) const;
+    // Maps the snapshot and scores straight from the mapping, so a loaded
+    // forest is usable at once. The first replaceTrees() copies it to memory.
+    // A file that fails validation leaves the current forest untouched.
+    bool loadSnapshot(const std::string& path, uint32_t featureLayout);
+    bool isMapped() const { return mapping.isOpen(); }
     
+    bool isTrained() const { return rootCount != 0; }
+    size_t treeCount() const { return rootCount; }
+    size_t numFeatures() const { return featureCount; }
+
 private:
+    struct TreeBuilder {
+        std::mt19937 rng;
+        const float* rows;
+        size_t numFeatures;
+        uint32_t* indices;
+        IsolationNode* nodes;
+        uint32_t nodeBase;
+        uint32_t nodeCount;
+    };
+    
     int numTrees;
     int subsampleSize;
-    std::mt19937 generator;
-    std::vector<std::shared_ptr<IsolationTree>> trees;
+    int randomSeed;
+    unsigned trainingThreads;
+    
+    // Owned storage; empty while scoring from a mapped snapshot
+    std::vector<IsolationNode> nodes;
+    std::vector<uint32_t> treeRoots;
+    std::vector<uint32_t> treeSizes;
+    size_t featureCount;
+    double normalizer;
+    
+    // Views used for scoring, pointing at either the vectors or the mapping
+    MappedFile mapping;
+    const IsolationNode* nodeData;
+    size_t nodeDataCount;
+    const uint32_t* rootData;
+    const uint32_t* sizeData;
+    size_t rootCount;
+    
+    // Sliding-window state: replacements cycle through the trees oldest
+    // first, and every new tree draws a fresh RNG stream
+    int nextReplacement;
+    uint32_t treesBuilt;
+    std::vector<uint32_t> replacementIndices;
+    // Compaction repacks into this and swaps it with nodes, so the two
+    // buffers trade places instead of being reallocated
+    std::vector<IsolationNode> spareNodes;
     
-    std::vector<std::vector<double>> createSubsample(const std::vector<std::vector<double>>& data);
-    std::shared_ptr<IsolationTree> buildTree(const std::vector<std::vector<double>>& data, int depth, int maxDepth);
-    double getPathLength(const std::shared_ptr<IsolationTree>& tree, const std::vector<double>& point, int depth);
-    double calculateC(int n);
+    void buildTree(TreeBuilder& builder, size_t numRows, int sampleSize);
+    uint32_t buildNode(TreeBuilder& builder, uint32_t begin, uint32_t end, int depth, int maxDepth);
+    uint32_t addLeaf(TreeBuilder& builder, uint32_t size, int depth);
+    void compactNodes();
+    void bindOwnedStorage();
+    void detachMapping();
+    static uint32_t treeSeed(int randomSeed, int tree);
+    float getPathLength(uint32_t root, const float* point) const;
+    static double calculateC(int n);
 };
 
 class MLEngine {
 public:
+    static constexpr size_t kNumFeatures = FeatureStore::kNumFeatures;
+    
+    struct OnlineOptions {
+        size_t windowSize = 4096;    // recent feature rows the trees are rebuilt from
+        size_t minRowsToTrain = 64;  // the first forest is built once this many rows were seen
+        int maxTreesPerUpdate = 10;
+    };
+    
     MLEngine();
+    ~MLEngine();
     
-    std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>> 
+    // Scores the devices, folding each observation into its rolling
+    // statistics first. With online learning enabled their features are
+    // then added to the window and a share of the trees proportional to the
+    // batch size is rebuilt, so the model follows the network as it changes.
+    std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>>
     detectAnomalies(const std::vector<std::shared_ptr<NetworkDevice>>& devices);
+    // The same, appending to a caller-owned buffer so a steady stream of
+    // cycles doesn't allocate
+    void detectAnomalies(const std::vector<std::shared_ptr<NetworkDevice>>& devices,
+                         std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>>& anomalies);
     
     void trainModel(const std::vector<std::shared_ptr<NetworkDevice>>& historicalData);
     
+    // Forgets a device's rolling statistics once it has left the network,
+    // since the scanner may hand its ID to another device
+    void resetDevice(uint32_t deviceId);
+    
+    void enableOnlineLearning(const OnlineOptions& options);
+    void enableOnlineLearning() { enableOnlineLearning(OnlineOptions()); }
+    void disableOnlineLearning();
+    bool isOnlineLearningEnabled() const { return onlineLearning; }
+    
+    // Full retrains as a Training task. The new forest replaces the
+    // current one at the start of the next detectAnomalies() call, so scoring
+    // never sees a half-built model. Return false while a retrain is running.
+    bool trainModelAsync(const std::vector<std::shared_ptr<NetworkDevice>>& historicalData);
+    bool retrainFromWindowAsync();
+    bool isRetraining() const { return retraining.load(); }
+    
+    bool isTrained() const { return isolationForest->isTrained(); }
+    
+    // Model snapshots (see IsolationForest::saveSnapshot) tagged with the
+    // feature layout, so a freshly started engine scores straight away and
+    // a model trained elsewhere can be deployed as a file. Loading replaces
+    // the current forest and fails on snapshots from another layout.
+    bool saveModel(const std::string& path) const;
+    bool loadModel(const std::string& path);
+
 private:
-    IsolationForest isolationForest;
+    static constexpr int kForestTrees = 100;
+    static constexpr int kForestSubsample = 256;
+    static constexpr int kForestSeed = 42;
+    // Bigger batches are scored in chunks of this many rows across workers
+    static constexpr size_t kScoreChunkRows = 4096;
+    
+    std::shared_ptr<IsolationForest> isolationForest;
+    FeatureStore featureStore;
+    std::vector<float> featureMatrix;
+    std::vector<double> scores;
+    
+    // Online learning: a ring of recent feature rows
+    bool onlineLearning;
+    OnlineOptions onlineOptions;
+    std::vector<float> window;
+    size_t windowRows;
+    size_t windowNext;
     
-    double calculateAnomalyScore(const std::shared_ptr<NetworkDevice>& device);
-    double getTimeSinceLastSeen(const std::shared_ptr<NetworkDevice>& device);
-    double getDeviceTypeScore(const std::string& deviceType);
-};
\ No newline at end of file
+    // Background retraining; the finished model waits in pendingModel
+    TaskHandle retrainTask;
+    std::atomic<bool> retraining;
+    std::shared_ptr<IsolationForest> pendingModel; // atomic_load/atomic_exchange only
+    int retrainCount;
+    
+    void installPendingModel();
+    bool startRetrain(std::vector<float> rows, size_t n);
+    void learn(const float* rows, size_t n);
+    std::vector<float> extractRows(const std::vector<std::shared_ptr<NetworkDevice>>& devices) const;
+};
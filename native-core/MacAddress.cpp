@@ -0,0 +1,146 @@
+#include "MacAddress.h"
+
+namespace {
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+MacAddress MacAddress::fromBytes(const uint8_t* bytes) {
+    uint64_t packed = 0;
+    for (int i = 0; i < 6; ++i) {
+        packed = (packed << 8) | bytes[i];
+    }
+    return MacAddress(packed);
+}
+
+bool MacAddress::parse(std::string_view text, MacAddress& out) {
+    uint64_t packed = 0;
+    uint32_t group = 0;
+    size_t groupLength = 0;
+    size_t octets = 0;
+    char separator = 0;
+
+    // Flushes one separated group: an octet of 1-2 digits, or 4 digits in dotted form
+    auto flush = [&]() {
+        if (separator == '.') {
+            if (groupLength != 4) return false;
+            packed = (packed << 16) | group;
+            octets += 2;
+        } else {
+            if (groupLength == 0 || groupLength > 2) return false;
+            packed = (packed << 8) | group;
+            octets += 1;
+        }
+        group = 0;
+        groupLength = 0;
+        return true;
+    };
+
+    for (char c : text) {
+        int nibble = hexValue(c);
+        if (nibble >= 0) {
+            if (++groupLength > 12) return false;
+            group = (group << 4) | static_cast<uint32_t>(nibble);
+            packed = separator == 0 ? (packed << 4) | static_cast<uint64_t>(nibble) : packed;
+            continue;
+        }
+
+        if (c != ':' && c != '-' && c != '.') return false;
+        if (separator == 0) {
+            // First separator: restart so the digits seen so far form the first group
+            if (groupLength > 4) return false;
+            separator = c;
+            packed = 0;
+        }
+        if (c != separator || !flush()) return false;
+    }
+
+    if (separator == 0) {
+        if (groupLength != 12) return false;
+    } else if (!flush() || octets != 6) {
+        return false;
+    }
+
+    out = MacAddress(packed);
+    return true;
+}
+
+void MacAddress::format(char* out) const {
+    static const char kHex[] = "0123456789abcdef";
+    for (int i = 0; i < 6; ++i) {
+        unsigned octet = static_cast<unsigned>((value >> (40 - 8 * i)) & 0xFF);
+        out[i * 3] = kHex[octet >> 4];
+        out[i * 3 + 1] = kHex[octet & 0xF];
+        out[i * 3 + 2] = ':';
+    }
+    out[kStringLength] = '\0';
+}
+
+std::string MacAddress::toString() const {
+    char buffer[kStringLength + 1];
+    format(buffer);
+    return std::string(buffer, kStringLength);
+}
+
+void MacAddress::toBytes(uint8_t* bytes) const {
+    for (int i = 0; i < 6; ++i) {
+        bytes[i] = static_cast<uint8_t>(value >> (40 - 8 * i));
+    }
+}
+
+uint32_t DeviceIdTable::intern(MacAddress mac) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Known addresses are the common case; emplace would build a node first
+    auto it = ids.find(mac);
+    if (it != ids.end()) return it->second;
+
+    if (!freeIds.empty()) {
+        uint32_t id = freeIds.back();
+        freeIds.pop_back();
+        ids.emplace(mac, id);
+        macs[id] = mac;
+        return id;
+    }
+
+    uint32_t id = static_cast<uint32_t>(macs.size());
+    ids.emplace(mac, id);
+    macs.push_back(mac);
+    return id;
+}
+
+void DeviceIdTable::release(uint32_t deviceId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (deviceId >= macs.size() || macs[deviceId].isZero()) return;
+
+    ids.erase(macs[deviceId]);
+    macs[deviceId] = MacAddress();
+    releasedIds.push_back(deviceId);
+}
+
+void DeviceIdTable::reclaimReleased() {
+    std::lock_guard<std::mutex> lock(mutex);
+    freeIds.insert(freeIds.end(), releasedIds.begin(), releasedIds.end());
+    releasedIds.clear();
+}
+
+uint32_t DeviceIdTable::find(MacAddress mac) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = ids.find(mac);
+    return it != ids.end() ? it->second : kInvalidId;
+}
+
+MacAddress DeviceIdTable::macAddress(uint32_t deviceId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return deviceId < macs.size() ? macs[deviceId] : MacAddress();
+}
+
+size_t DeviceIdTable::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return macs.size();
+}
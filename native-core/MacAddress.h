@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <functional>
+
+// 48-bit MAC address packed into a uint64 (first octet in bits 40..47).
+class MacAddress {
+public:
+    static constexpr size_t kStringLength = 17; // "aa:bb:cc:dd:ee:ff"
+
+    constexpr MacAddress() : value(0) {}
+    constexpr explicit MacAddress(uint64_t packed) : value(packed & 0xFFFFFFFFFFFFull) {}
+
+    static MacAddress fromBytes(const uint8_t* bytes);
+
+    // Accepts six hex octets separated by ':' or '-', Cisco-style dotted
+    // groups ("aabb.ccdd.eeff") or twelve bare hex digits, in any case.
+    static bool parse(std::string_view text, MacAddress& out);
+
+    // Writes the lowercase colon-separated form plus a terminating NUL
+    // into a buffer of at least kStringLength + 1 bytes.
+    void format(char* out) const;
+    std::string toString() const;
+
+    void toBytes(uint8_t* bytes) const;
+
+    constexpr uint64_t toUint64() const { return value; }
+    constexpr uint32_t oui() const { return static_cast<uint32_t>(value >> 24); }
+    constexpr bool isZero() const { return value == 0; }
+    constexpr bool isMulticast() const { return (value >> 40) & 0x01; }
+    constexpr bool isLocallyAdministered() const { return (value >> 40) & 0x02; }
+
+    constexpr bool operator==(const MacAddress& other) const { return value == other.value; }
+    constexpr bool operator!=(const MacAddress& other) const { return value != other.value; }
+    constexpr bool operator<(const MacAddress& other) const { return value < other.value; }
+
+private:
+    uint64_t value;
+};
+
+namespace std {
+template <>
+struct hash<MacAddress> {
+    size_t operator()(const MacAddress& mac) const noexcept {
+        // Fibonacci hashing spreads the vendor-heavy high bits across buckets
+        return static_cast<size_t>((mac.toUint64() * 0x9E3779B97F4A7C15ull) >> 16);
+    }
+};
+}
+
+// Interns MAC addresses into dense 32-bit device IDs (0, 1, 2, ...) so
+// per-device state can live in flat arrays indexed by ID. IDs of removed
+// devices are handed out again, so with randomized MACs the arrays grow with
+// the most devices tracked at once rather than with every MAC ever seen.
+class DeviceIdTable {
+public:
+    static constexpr uint32_t kInvalidId = 0xFFFFFFFFu;
+
+    uint32_t intern(MacAddress mac);
+    uint32_t find(MacAddress mac) const;
+    MacAddress macAddress(uint32_t deviceId) const; // zero for a released ID
+    // One past the highest ID handed out, i.e. the size per-ID arrays need
+    size_t size() const;
+
+    // Forgets a removed device's MAC at once; a returning device is interned
+    // afresh. The ID itself is reused only after the next reclaimReleased(),
+    // which gives consumers time to see the removal and reset their per-ID state.
+    void release(uint32_t deviceId);
+    void reclaimReleased();
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_map<MacAddress, uint32_t> ids;
+    std::vector<MacAddress> macs;
+    std::vector<uint32_t> releasedIds;
+    std::vector<uint32_t> freeIds;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Memory mapping of a whole file (mmap / MapViewOfFile), read-only unless
+// opened with openWritable().
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    // Maps the file read-write, creating it if needed and resizing it to size
+    // bytes (new space reads as zeros). Writes go straight to the page cache.
+    bool openWritable(const std::string& path, size_t size);
+    // Schedules dirty pages for writing back to disk
+    bool flush();
+    void close();
+    void swap(MappedFile& other);
+
+    bool isOpen() const { return mappedData != nullptr; }
+    const uint8_t* data() const { return static_cast<const uint8_t*>(mappedData); }
+    uint8_t* mutableData() { return writable ? static_cast<uint8_t*>(mappedData) : nullptr; }
+    size_t size() const { return mappedSize; }
+
+private:
+    void* mappedData;
+    size_t mappedSize;
+    bool writable;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+// Renames source over target in one step (rename() on POSIX,
+// MoveFileEx(MOVEFILE_REPLACE_EXISTING) on Windows), so readers find either
+// the old file or the new one, never neither. On failure target is untouched.
+bool replaceFile(const std::string& source, const std::string& target);
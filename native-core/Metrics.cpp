@@ -0,0 +1,366 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+const char* const kStageNames[kMetricStageCount] = {
+    "scan", "update_device_list", "classification", "signal_processing",
+    "anomaly_scoring", "localization", "cycle", "ui_render",
+};
+
+const char* const kCounterNames[kMetricCounterCount] = {
+    "cycles", "devices_processed", "cache_hits", "cache_misses",
+    "allocations", "scan_errors", "cycle_errors",
+};
+
+unsigned highestBit(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#endif
+}
+
+// One thread's metrics. Only the owning thread writes; readers load relaxed.
+struct ThreadMetrics {
+    std::atomic<uint64_t> buckets[kMetricStageCount][LatencyHistogram::kBucketCount];
+    std::atomic<uint64_t> counts[kMetricStageCount];
+    std::atomic<uint64_t> sums[kMetricStageCount];
+    std::atomic<uint64_t> mins[kMetricStageCount];
+    std::atomic<uint64_t> maxs[kMetricStageCount];
+    std::atomic<uint64_t> counters[kMetricCounterCount];
+
+    ThreadMetrics() { clear(); }
+
+    void clear() {
+        for (size_t s = 0; s < kMetricStageCount; ++s) {
+            for (auto& bucket : buckets[s]) bucket.store(0, std::memory_order_relaxed);
+            counts[s].store(0, std::memory_order_relaxed);
+            sums[s].store(0, std::memory_order_relaxed);
+            mins[s].store(UINT64_MAX, std::memory_order_relaxed);
+            maxs[s].store(0, std::memory_order_relaxed);
+        }
+        for (auto& counter : counters) counter.store(0, std::memory_order_relaxed);
+    }
+};
+
+inline void bump(std::atomic<uint64_t>& slot, uint64_t amount) {
+    slot.store(slot.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadMetrics*> threads;
+
+    // Totals of threads that have exited
+    std::array<LatencyHistogram, kMetricStageCount> retiredHistograms;
+    std::array<uint64_t, kMetricCounterCount> retiredCounters{};
+};
+
+Registry& registry() {
+    // Never destroyed: threads may still exit after static destructors have run
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+void foldInto(const ThreadMetrics& metrics, std::array<LatencyHistogram, kMetricStageCount>& histograms,
+              std::array<uint64_t, kMetricCounterCount>& counters);
+
+struct ThreadSlot {
+    ThreadMetrics* metrics;
+
+    ThreadSlot() : metrics(new ThreadMetrics()) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.threads.push_back(metrics);
+    }
+
+    ~ThreadSlot() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        foldInto(*metrics, r.retiredHistograms, r.retiredCounters);
+        r.threads.erase(std::remove(r.threads.begin(), r.threads.end(), metrics), r.threads.end());
+        delete metrics;
+    }
+};
+
+ThreadMetrics& localMetrics() {
+    thread_local ThreadSlot slot;
+    return *slot.metrics;
+}
+
+#if SB_ENABLE_METRICS
+thread_local uint64_t allocationCount = 0;
+#endif
+
+} // namespace
+
+const char* metricStageName(MetricStage stage) {
+    size_t index = static_cast<size_t>(stage);
+    return index < kMetricStageCount ? kStageNames[index] : "unknown";
+}
+
+const char* metricCounterName(MetricCounter counter) {
+    size_t index = static_cast<size_t>(counter);
+    return index < kMetricCounterCount ? kCounterNames[index] : "unknown";
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t value) {
+    if (value < kSubBuckets) return static_cast<size_t>(value);
+
+    unsigned exponent = highestBit(value);
+    if (exponent > kMaxExponent) return kBucketCount - 1;
+
+    size_t subBucket = static_cast<size_t>(value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+    return (exponent - kSubBucketBits + 1) * kSubBuckets + subBucket;
+}
+
+uint64_t LatencyHistogram::bucketLowerBound(size_t index) {
+    if (index < kSubBuckets) return index;
+
+    unsigned exponent = static_cast<unsigned>(index / kSubBuckets) + kSubBucketBits - 1;
+    uint64_t subBucket = index % kSubBuckets;
+    return (kSubBuckets + subBucket) << (exponent - kSubBucketBits);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < kSubBuckets) return index;
+    if (index + 1 >= kBucketCount) return UINT64_MAX;
+    return bucketLowerBound(index + 1) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    buckets[bucketIndex(value)]++;
+    totalCount++;
+    totalSum += value;
+    minValue = std::min(minValue, value);
+    maxValue = std::max(maxValue, value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    merge(other.buckets.data(), other.totalCount, other.totalSum, other.minValue, other.maxValue);
+}
+
+void LatencyHistogram::merge(const uint64_t* bucketCounts, uint64_t count, uint64_t sum, uint64_t min, uint64_t max) {
+    if (count == 0) return;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        buckets[i] += bucketCounts[i];
+    }
+    totalCount += count;
+    totalSum += sum;
+    minValue = std::min(minValue, min);
+    maxValue = std::max(maxValue, max);
+}
+
+void LatencyHistogram::reset() {
+    *this = LatencyHistogram();
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    if (totalCount == 0) return 0;
+
+    q = std::min(1.0, std::max(0.0, q));
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(totalCount))));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(bucketUpperBound(i), maxValue);
+        }
+    }
+    return maxValue;
+}
+
+namespace {
+
+void foldInto(const ThreadMetrics& metrics, std::array<LatencyHistogram, kMetricStageCount>& histograms,
+              std::array<uint64_t, kMetricCounterCount>& counters) {
+    uint64_t bucketCounts[LatencyHistogram::kBucketCount];
+    for (size_t s = 0; s < kMetricStageCount; ++s) {
+        uint64_t count = metrics.counts[s].load(std::memory_order_relaxed);
+        if (count == 0) continue;
+
+        for (size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+            bucketCounts[i] = metrics.buckets[s][i].load(std::memory_order_relaxed);
+        }
+        histograms[s].merge(bucketCounts, count, metrics.sums[s].load(std::memory_order_relaxed),
+                            metrics.mins[s].load(std::memory_order_relaxed),
+                            metrics.maxs[s].load(std::memory_order_relaxed));
+    }
+    for (size_t c = 0; c < kMetricCounterCount; ++c) {
+        counters[c] += metrics.counters[c].load(std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+void Metrics::recordDuration(MetricStage stage, uint64_t nanoseconds) {
+    ThreadMetrics& metrics = localMetrics();
+    size_t s = static_cast<size_t>(stage);
+
+    bump(metrics.buckets[s][LatencyHistogram::bucketIndex(nanoseconds)], 1);
+    bump(metrics.counts[s], 1);
+    bump(metrics.sums[s], nanoseconds);
+    if (nanoseconds < metrics.mins[s].load(std::memory_order_relaxed)) {
+        metrics.mins[s].store(nanoseconds, std::memory_order_relaxed);
+    }
+    if (nanoseconds > metrics.maxs[s].load(std::memory_order_relaxed)) {
+        metrics.maxs[s].store(nanoseconds, std::memory_order_relaxed);
+    }
+}
+
+void Metrics::add(MetricCounter counter, uint64_t amount) {
+    bump(localMetrics().counters[static_cast<size_t>(counter)], amount);
+}
+
+MetricsSnapshot Metrics::snapshot() {
+    MetricsSnapshot result;
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        result.histograms = r.retiredHistograms;
+        result.counters = r.retiredCounters;
+        for (const ThreadMetrics* metrics : r.threads) {
+            foldInto(*metrics, result.histograms, result.counters);
+        }
+    }
+
+    for (size_t s = 0; s < kMetricStageCount; ++s) {
+        const LatencyHistogram& histogram = result.histograms[s];
+        StageMetrics& stage = result.stages[s];
+        stage.count = histogram.count();
+        stage.totalNs = histogram.sum();
+        stage.minNs = histogram.min();
+        stage.maxNs = histogram.max();
+        stage.p50Ns = histogram.percentile(0.5);
+        stage.p90Ns = histogram.percentile(0.9);
+        stage.p99Ns = histogram.percentile(0.99);
+        stage.p999Ns = histogram.percentile(0.999);
+    }
+    return result;
+}
+
+void Metrics::reset() {
+    // Meant for tests and benchmarks; a thread recording at the same moment may keep one sample
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (auto& histogram : r.retiredHistograms) histogram.reset();
+    r.retiredCounters.fill(0);
+    for (ThreadMetrics* metrics : r.threads) {
+        metrics->clear();
+    }
+}
+
+void Metrics::countAllocation() {
+#if SB_ENABLE_METRICS
+    ++allocationCount;
+#endif
+}
+
+uint64_t Metrics::threadAllocationCount() {
+#if SB_ENABLE_METRICS
+    return allocationCount;
+#else
+    return 0;
+#endif
+}
+
+namespace {
+
+void appendNumber(std::string& out, double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    out += buffer;
+}
+
+void appendNumber(std::string& out, uint64_t value) {
+    char buffer[24];
+    std::snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(value));
+    out += buffer;
+}
+
+} // namespace
+
+std::string formatMetricsPrometheus(const MetricsSnapshot& metrics) {
+    std::string out;
+    out.reserve(4096);
+
+    out += "# HELP smartblueprint_stage_duration_seconds Time spent in each processing stage.\n";
+    out += "# TYPE smartblueprint_stage_duration_seconds summary\n";
+    const std::pair<const char*, double> quantiles[] = {{"0.5", 0.5}, {"0.9", 0.9}, {"0.99", 0.99}, {"0.999", 0.999}};
+    for (size_t s = 0; s < kMetricStageCount; ++s) {
+        const StageMetrics& stage = metrics.stages[s];
+        const uint64_t values[] = {stage.p50Ns, stage.p90Ns, stage.p99Ns, stage.p999Ns};
+        std::string label = std::string("stage=\"") + kStageNames[s] + "\"";
+
+        for (size_t q = 0; q < 4; ++q) {
+            out += "smartblueprint_stage_duration_seconds{" + label + ",quantile=\"" + quantiles[q].first + "\"} ";
+            appendNumber(out, static_cast<double>(values[q]) * 1e-9);
+            out += '\n';
+        }
+        out += "smartblueprint_stage_duration_seconds_sum{" + label + "} ";
+        appendNumber(out, static_cast<double>(stage.totalNs) * 1e-9);
+        out += "\nsmartblueprint_stage_duration_seconds_count{" + label + "} ";
+        appendNumber(out, stage.count);
+        out += '\n';
+    }
+
+    for (size_t c = 0; c < kMetricCounterCount; ++c) {
+        std::string name = std::string("smartblueprint_") + kCounterNames[c] + "_total";
+        out += "# TYPE " + name + " counter\n" + name + ' ';
+        appendNumber(out, metrics.counters[c]);
+        out += '\n';
+    }
+    return out;
+}
+
+std::string formatMetricsJson(const MetricsSnapshot& metrics) {
+    std::string out;
+    out.reserve(2048);
+
+    out += "{\"stages\":{";
+    for (size_t s = 0; s < kMetricStageCount; ++s) {
+        const StageMetrics& stage = metrics.stages[s];
+        if (s > 0) out += ',';
+        out += std::string("\"") + kStageNames[s] + "\":{\"count\":";
+        appendNumber(out, stage.count);
+        out += ",\"total_ns\":";
+        appendNumber(out, stage.totalNs);
+        out += ",\"min_ns\":";
+        appendNumber(out, stage.minNs);
+        out += ",\"max_ns\":";
+        appendNumber(out, stage.maxNs);
+        out += ",\"mean_ns\":";
+        appendNumber(out, stage.meanNs());
+        out += ",\"p50_ns\":";
+        appendNumber(out, stage.p50Ns);
+        out += ",\"p90_ns\":";
+        appendNumber(out, stage.p90Ns);
+        out += ",\"p99_ns\":";
+        appendNumber(out, stage.p99Ns);
+        out += ",\"p999_ns\":";
+        appendNumber(out, stage.p999Ns);
+        out += '}';
+    }
+
+    out += "},\"counters\":{";
+    for (size_t c = 0; c < kMetricCounterCount; ++c) {
+        if (c > 0) out += ',';
+        out += std::string("\"") + kCounterNames[c] + "\":";
+        appendNumber(out, metrics.counters[c]);
+    }
+    out += "}}";
+    return out;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Built with -DSB_ENABLE_METRICS=0 the macros below expand to nothing and the
+// hot paths carry no instrumentation at all.
+#ifndef SB_ENABLE_METRICS
+#define SB_ENABLE_METRICS 1
+#endif
+
+enum class MetricStage : uint8_t {
+    Scan,             // backend table reads and active sweeps
+    UpdateDeviceList, // merging scan records into the device list
+    Classification,
+    SignalProcessing,
+    AnomalyScoring,
+    Localization,     // Localizer::solve()
+    Cycle,            // one monitoring cycle, end to end
+    UiRender,
+    Count
+};
+
+enum class MetricCounter : uint8_t {
+    Cycles,
+    DevicesProcessed,
+    CacheHits,
+    CacheMisses,
+    Allocations, // heap allocations made on the monitoring thread during cycles
+    ScanErrors,
+    CycleErrors,
+    Count
+};
+
+constexpr size_t kMetricStageCount = static_cast<size_t>(MetricStage::Count);
+constexpr size_t kMetricCounterCount = static_cast<size_t>(MetricCounter::Count);
+
+const char* metricStageName(MetricStage stage);
+const char* metricCounterName(MetricCounter counter);
+
+// Log-linear (HDR-style) histogram of nanosecond durations. Values below 16
+// are exact; above that every power of two is split into 16 buckets, so a
+// reported percentile is within 1/16 (6.25%) of the true value. Durations up
+// to 2^40 ns (about 18 minutes) are resolved, longer ones land in the top bucket.
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBucketBits = 4;
+    static constexpr unsigned kSubBuckets = 1u << kSubBucketBits;
+    static constexpr unsigned kMaxExponent = 40;
+    static constexpr size_t kBucketCount = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketLowerBound(size_t index);
+    static uint64_t bucketUpperBound(size_t index);
+
+    void record(uint64_t value);
+    void merge(const LatencyHistogram& other);
+    // Adds samples counted elsewhere: kBucketCount bucket counts plus their totals
+    void merge(const uint64_t* bucketCounts, uint64_t count, uint64_t sum, uint64_t min, uint64_t max);
+    void reset();
+
+    // Upper bound of the bucket holding the q-quantile (0..1), clamped to max()
+    uint64_t percentile(double q) const;
+
+    uint64_t count() const { return totalCount; }
+    uint64_t sum() const { return totalSum; }
+    uint64_t min() const { return totalCount ? minValue : 0; }
+    uint64_t max() const { return maxValue; }
+    uint64_t bucketCount(size_t index) const { return buckets[index]; }
+
+private:
+    std::array<uint64_t, kBucketCount> buckets{};
+    uint64_t totalCount = 0;
+    uint64_t totalSum = 0;
+    uint64_t minValue = UINT64_MAX;
+    uint64_t maxValue = 0;
+};
+
+struct StageMetrics {
+    uint64_t count = 0;
+    uint64_t totalNs = 0;
+    uint64_t minNs = 0;
+    uint64_t maxNs = 0;
+    uint64_t p50Ns = 0;
+    uint64_t p90Ns = 0;
+    uint64_t p99Ns = 0;
+    uint64_t p999Ns = 0;
+
+    double meanNs() const { return count ? static_cast<double>(totalNs) / static_cast<double>(count) : 0.0; }
+};
+
+struct MetricsSnapshot {
+    std::array<StageMetrics, kMetricStageCount> stages{};
+    std::array<uint64_t, kMetricCounterCount> counters{};
+    std::array<LatencyHistogram, kMetricStageCount> histograms;
+
+    const StageMetrics& stage(MetricStage s) const { return stages[static_cast<size_t>(s)]; }
+    uint64_t counter(MetricCounter c) const { return counters[static_cast<size_t>(c)]; }
+};
+
+// Process-wide metrics. Every thread records into its own histograms and
+// counters with plain relaxed stores (each slot has a single writer), so the
+// hot path takes no locks and does no atomic read-modify-writes. snapshot()
+// sums all live threads plus those that have exited.
+class Metrics {
+public:
+    static void recordDuration(MetricStage stage, uint64_t nanoseconds);
+    static void add(MetricCounter counter, uint64_t amount = 1);
+
+    static MetricsSnapshot snapshot();
+    static void reset();
+
+    // Heap allocations made by the calling thread so far; always 0 unless the
+    // executable links the allocation hooks (AllocationCounter.cpp), which
+    // call countAllocation()
+    static void countAllocation();
+    static uint64_t threadAllocationCount();
+};
+
+std::string formatMetricsPrometheus(const MetricsSnapshot& metrics);
+std::string formatMetricsJson(const MetricsSnapshot& metrics);
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(MetricStage stage) : stage(stage), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        Metrics::recordDuration(stage, static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    MetricStage stage;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define SB_METRICS_CONCAT_INNER(a, b) a##b
+#define SB_METRICS_CONCAT(a, b) SB_METRICS_CONCAT_INNER(a, b)
+
+#if SB_ENABLE_METRICS
+#define SB_SCOPED_TIMER(stage) ScopedTimer SB_METRICS_CONCAT(sbScopedTimer, __LINE__)(MetricStage::stage)
+#define SB_COUNT(counter, amount) Metrics::add(MetricCounter::counter, (amount))
+#else
+#define SB_SCOPED_TIMER(stage) ((void)0)
+#define SB_COUNT(counter, amount) ((void)sizeof(amount))
+#endif
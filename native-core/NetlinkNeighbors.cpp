@@ -0,0 +1,197 @@
+#include "NetlinkNeighbors.h"
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+
+#include <arpa/inet.h>
+#include <linux/neighbour.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+constexpr size_t kReceiveBufferSize = 64 * 1024;
+
+int openNetlinkSocket(uint32_t groups) {
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) return -1;
+    
+    sockaddr_nl local{};
+    local.nl_family = AF_NETLINK;
+    local.nl_groups = groups;
+    if (bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace
+
+bool NeighborEntry::isReachable() const {
+    if (removed) return false;
+    return (state & (NUD_REACHABLE | NUD_STALE | NUD_DELAY | NUD_PROBE | NUD_PERMANENT)) != 0;
+}
+
+void NeighborEntry::formatAddress(char* out) const {
+    if (!inet_ntop(family, address, out, INET6_ADDRSTRLEN)) {
+        out[0] = '\0';
+    }
+}
+
+NetlinkNeighbors::NetlinkNeighbors()
+    : dumpSocket(-1), eventSocket(-1), sequence(0), receiveBuffer(kReceiveBufferSize) {}
+
+NetlinkNeighbors::~NetlinkNeighbors() {
+    if (dumpSocket >= 0) close(dumpSocket);
+    if (eventSocket >= 0) close(eventSocket);
+}
+
+bool NetlinkNeighbors::openDumpSocket() {
+    if (dumpSocket >= 0) return true;
+    
+    dumpSocket = openNetlinkSocket(0);
+    if (dumpSocket < 0) {
+        std::cerr << "Failed to open netlink socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    
+    // A dump normally completes immediately; never block the scanner on a lost reply
+    timeval timeout{2, 0};
+    setsockopt(dumpSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return true;
+}
+
+bool NetlinkNeighbors::subscribe() {
+    if (eventSocket >= 0) return true;
+    
+    eventSocket = openNetlinkSocket(RTMGRP_NEIGH);
+    if (eventSocket < 0) {
+        std::cerr << "Failed to subscribe to neighbour events: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool NetlinkNeighbors::dump(std::vector<NeighborEntry>& entries) {
+    entries.clear();
+    if (!openDumpSocket()) return false;
+    
+    struct {
+        nlmsghdr header;
+        ndmsg message;
+    } request{};
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(ndmsg));
+    request.header.nlmsg_type = RTM_GETNEIGH;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.header.nlmsg_seq = ++sequence;
+    request.message.ndm_family = AF_UNSPEC;
+    
+    sockaddr_nl kernel{};
+    kernel.nl_family = AF_NETLINK;
+    if (sendto(dumpSocket, &request, request.header.nlmsg_len, 0,
+               reinterpret_cast<sockaddr*>(&kernel), sizeof(kernel)) < 0) {
+        std::cerr << "RTM_GETNEIGH request failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    
+    bool done = false;
+    while (!done) {
+        ssize_t length = recv(dumpSocket, receiveBuffer.data(), receiveBuffer.size(), 0);
+        if (length < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Netlink receive failed: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        if (!parseMessages(receiveBuffer.data(), static_cast<size_t>(length), request.header.nlmsg_seq, entries, done)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool NetlinkNeighbors::waitForEvents(int timeoutMs, std::vector<NeighborEntry>& events) {
+    if (eventSocket < 0) return true;
+    
+    pollfd descriptor{eventSocket, POLLIN, 0};
+    int ready = poll(&descriptor, 1, timeoutMs);
+    if (ready <= 0) return true;
+    
+    // Drain everything that queued up while we were busy
+    for (;;) {
+        ssize_t length = recv(eventSocket, receiveBuffer.data(), receiveBuffer.size(), MSG_DONTWAIT);
+        if (length < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+            // ENOBUFS: the kernel dropped notifications, the caller must resynchronise
+            return false;
+        }
+        bool done = false;
+        parseMessages(receiveBuffer.data(), static_cast<size_t>(length), 0, events, done);
+    }
+}
+
+bool NetlinkNeighbors::parseMessages(const char* data, size_t length, uint32_t expectedSequence,
+                                     std::vector<NeighborEntry>& out, bool& done) {
+    int remaining = static_cast<int>(length);
+    for (auto* header = reinterpret_cast<const nlmsghdr*>(data);
+         NLMSG_OK(header, remaining); header = NLMSG_NEXT(header, remaining)) {
+        if (expectedSequence != 0 && header->nlmsg_seq != expectedSequence) {
+            continue; // Reply to an older, abandoned request
+        }
+        if (header->nlmsg_type == NLMSG_DONE) {
+            done = true;
+            return true;
+        }
+        if (header->nlmsg_type == NLMSG_ERROR) {
+            if (header->nlmsg_len < NLMSG_LENGTH(sizeof(nlmsgerr))) return false;
+            auto* error = static_cast<const nlmsgerr*>(NLMSG_DATA(header));
+            done = true;
+            if (error->error == 0) return true;
+            std::cerr << "Netlink error: " << std::strerror(-error->error) << std::endl;
+            return false;
+        }
+        if (header->nlmsg_type != RTM_NEWNEIGH && header->nlmsg_type != RTM_DELNEIGH) {
+            continue;
+        }
+        if (header->nlmsg_len < NLMSG_LENGTH(sizeof(ndmsg))) continue; // truncated
+        
+        auto* message = static_cast<const ndmsg*>(NLMSG_DATA(header));
+        if (message->ndm_family != AF_INET && message->ndm_family != AF_INET6) continue;
+        
+        NeighborEntry entry{};
+        entry.family = message->ndm_family;
+        entry.interfaceIndex = message->ndm_ifindex;
+        entry.state = message->ndm_state;
+        entry.removed = header->nlmsg_type == RTM_DELNEIGH || (message->ndm_state & NUD_FAILED);
+        
+        bool hasAddress = false;
+        bool hasMac = false;
+        int attributeLength = static_cast<int>(header->nlmsg_len - NLMSG_LENGTH(sizeof(ndmsg)));
+        for (auto* attribute = reinterpret_cast<const rtattr*>(
+                 reinterpret_cast<const char*>(message) + NLMSG_ALIGN(sizeof(ndmsg)));
+             RTA_OK(attribute, attributeLength); attribute = RTA_NEXT(attribute, attributeLength)) {
+            size_t payload = RTA_PAYLOAD(attribute);
+            if (attribute->rta_type == NDA_DST && payload <= sizeof(entry.address)) {
+                std::memcpy(entry.address, RTA_DATA(attribute), payload);
+                hasAddress = true;
+            } else if (attribute->rta_type == NDA_LLADDR && payload == 6) {
+                entry.mac = MacAddress::fromBytes(static_cast<const uint8_t*>(RTA_DATA(attribute)));
+                hasMac = true;
+            }
+        }
+        
+        // Incomplete entries have no hardware address yet; removals still carry it
+        if (hasAddress && hasMac && !entry.mac.isZero()) {
+            out.push_back(entry);
+        }
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "MacAddress.h"
+#include <cstdint>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+
+// One entry of the kernel neighbour (ARP / NDP) table
+struct NeighborEntry {
+    MacAddress mac;
+    uint8_t family;      // AF_INET or AF_INET6
+    uint8_t address[16]; // network byte order; the first 4 bytes for IPv4
+    int interfaceIndex;
+    uint16_t state;      // NUD_* flags
+    bool removed;        // RTM_DELNEIGH, or the kernel gave up resolving the entry
+
+    bool isReachable() const;
+    // Writes the textual IP address into a buffer of at least 46 bytes
+    void formatAddress(char* out) const;
+};
+
+// Reads the Linux neighbour table over rtnetlink. A dump socket answers
+// RTM_GETNEIGH requests and an optional second socket subscribed to
+// RTMGRP_NEIGH delivers RTM_NEWNEIGH / RTM_DELNEIGH changes as they happen.
+// Both share one receive buffer, so steady-state operation does not allocate.
+class NetlinkNeighbors {
+public:
+    NetlinkNeighbors();
+    ~NetlinkNeighbors();
+
+    NetlinkNeighbors(const NetlinkNeighbors&) = delete;
+    NetlinkNeighbors& operator=(const NetlinkNeighbors&) = delete;
+
+    // Replaces `entries` with the current contents of the neighbour table
+    bool dump(std::vector<NeighborEntry>& entries);
+
+    bool subscribe();
+    bool isSubscribed() const { return eventSocket >= 0; }
+
+    // Waits up to timeoutMs for notifications and appends them to `events`.
+    // Returns false if the subscription overflowed and a full dump is needed.
+    bool waitForEvents(int timeoutMs, std::vector<NeighborEntry>& events);
+
+    // Parses one datagram of rtnetlink messages (4-byte aligned) into out and
+    // sets `done` when NLMSG_DONE or an error ends a dump. Messages with
+    // another sequence number are skipped unless expectedSequence is 0.
+    // Returns false on an NLMSG_ERROR reply.
+    static bool parseMessages(const char* data, size_t length, uint32_t expectedSequence,
+                              std::vector<NeighborEntry>& out, bool& done);
+
+private:
+    int dumpSocket;
+    int eventSocket;
+    uint32_t sequence;
+    std::vector<char> receiveBuffer;
+
+    bool openDumpSocket();
+};
+
+#endif
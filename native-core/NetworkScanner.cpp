@@ -1,27 +1,48 @@
 #include "NetworkScanner.h"
+#include "Metrics.h"
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <cstring>
 
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
-#include <iphlpapi.h>
 #pragma comment(lib, "ws2_32.lib")
-#pragma comment(lib, "iphlpapi.lib")
-#elif __APPLE__
-#include <SystemConfiguration/SystemConfiguration.h>
-#include <CoreWLAN/CoreWLAN.h>
-#else
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <ifaddrs.h>
-#include <unistd.h>
 #endif
 
-NetworkScanner::NetworkScanner() : isScanning(false) {
+namespace {
+
+std::shared_ptr<SlabPool>& devicePool() {
+    // Blocks hold the device plus allocate_shared's counts and allocator
+    static std::shared_ptr<SlabPool> pool = std::make_shared<SlabPool>(sizeof(NetworkDevice) + 64, 256);
+    return pool;
+}
+
+} // namespace
+
+std::shared_ptr<NetworkDevice> allocateDevice() {
+    return std::allocate_shared<NetworkDevice>(SlabAllocator<NetworkDevice>(devicePool()));
+}
+
+std::shared_ptr<NetworkDevice> allocateDevice(const NetworkDevice& source) {
+    return std::allocate_shared<NetworkDevice>(SlabAllocator<NetworkDevice>(devicePool()), source);
+}
+
+const SlabPool& deviceRecordPool() {
+    return *devicePool();
+}
+
+NetworkScanner::NetworkScanner() : NetworkScanner(createPlatformBackend()) {
+}
+
+NetworkScanner::NetworkScanner(std::unique_ptr<ScanBackend> backend)
+    : isScanning(false), activeDiscovery(false), scanRequested(false), scansCompleted(0) {
     initializePlatform();
+    if (backend) {
+        backends.push_back(std::move(backend));
+    }
 }
 
 NetworkScanner::~NetworkScanner() {
@@ -29,6 +50,11 @@ NetworkScanner::~NetworkScanner() {
     cleanupPlatform();
 }
 
+void NetworkScanner::addBackend(std::unique_ptr<ScanBackend> backend) {
+    std::lock_guard<std::mutex> lock(scanMutex);
+    backends.push_back(std::move(backend));
+}
+
 void NetworkScanner::initializePlatform() {
 #ifdef _WIN32
     WSADATA wsaData;
@@ -45,162 +71,329 @@ void NetworkScanner::cleanupPlatform() {
 }
 
 void NetworkScanner::startScanning() {
-    if (isScanning) return;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        if (isScanning.exchange(true)) return;
+        scanRequested = false;
+    }
+    
+    bool events;
+    {
+        std::lock_guard<std::mutex> lock(scanMutex);
+        events = hasEventBackend();
+    }
     
-    isScanning = true;
-    scanningThread = std::thread(&NetworkScanner::scanLoop, this);
+    scanThread = std::thread(&NetworkScanner::scanLoop, this);
+    if (events) {
+        eventTask = TaskScheduler::shared().schedulePeriodic(TaskPriority::Pipeline, kEventPollInterval,
+                                                             [this] { pollEvents(); }, kEventPollInterval);
+    }
 }
 
 void NetworkScanner::stopScanning() {
-    isScanning = false;
-    if (scanningThread.joinable()) {
-        scanningThread.join();
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        isScanning = false;
+    }
+    wakeScanThread.notify_all();
+    eventTask.cancel();
+    eventTask.wait();
+    if (scanThread.joinable()) {
+        scanThread.join();
     }
 }
 
 void NetworkScanner::scanLoop() {
+    // A sweep probes whole subnets and a backend may wait on the OS, so
+    // scans run here rather than holding a scheduler worker for seconds
+    std::unique_lock<std::mutex> lock(wakeMutex);
     while (isScanning) {
-        try {
-            performNetworkScan();
-            std::this_thread::sleep_for(std::chrono::seconds(30));
-        } catch (const std::exception& e) {
-            std::cerr << "Scan error: " << e.what() << std::endl;
-            std::this_thread::sleep_for(std::chrono::seconds(5));
+        scanRequested = false;
+        lock.unlock();
+        scanOnce();
+        lock.lock();
+        wakeScanThread.wait_for(lock, kScanInterval, [this] { return !isScanning || scanRequested; });
+    }
+}
+
+void NetworkScanner::requestScan() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        scanRequested = true;
+    }
+    wakeScanThread.notify_one();
+}
+
+void NetworkScanner::scanOnce() {
+    try {
+        performNetworkScan();
+    } catch (const std::exception& e) {
+        std::cerr << "Scan error: " << e.what() << std::endl;
+    }
+}
+
+bool NetworkScanner::hasEventBackend() const {
+    for (const auto& backend : backends) {
+        if (backend->supportsEvents()) return true;
+    }
+    return false;
+}
+
+void NetworkScanner::pollEvents() {
+    // Changes pushed by an event backend are applied as they arrive; the
+    // periodic full scan only resynchronises
+    bool inSync = true;
+    {
+        std::unique_lock<std::mutex> lock(scanMutex, std::try_to_lock);
+        if (!lock.owns_lock()) return; // A full scan is running and sees the same changes
+        
+        eventRecords.clear();
+        for (const auto& backend : backends) {
+            if (backend->supportsEvents() && !backend->waitForEvents(0, eventRecords)) {
+                inSync = false;
+            }
         }
+        if (!eventRecords.empty()) {
+            applyEvents(eventRecords);
+        }
+    }
+    if (!inSync) {
+        requestScan(); // Events were dropped, rescan now
     }
 }
 
 std::vector<std::shared_ptr<NetworkDevice>> NetworkScanner::getCurrentDevices() {
-    std::lock_guard<std::mutex> lock(devicesMutex);
     std::vector<std::shared_ptr<NetworkDevice>> result;
+    getCurrentDevices(result);
+    return result;
+}
+
+void NetworkScanner::getCurrentDevices(std::vector<std::shared_ptr<NetworkDevice>>& devices) {
+    std::lock_guard<std::mutex> lock(devicesMutex);
+    devices.clear();
+    devices.reserve(discoveredDevices.size());
     
-    for (const auto& pair : discoveredDevices) {
-        result.push_back(pair.second);
+    for (const auto& device : discoveredDevices) {
+        if (device) {
+            devices.push_back(allocateDevice(*device));
+        }
     }
-    
-    return result;
+}
+
+void NetworkScanner::currentDeviceIds(std::vector<uint32_t>& ids) {
+    std::lock_guard<std::mutex> lock(devicesMutex);
+    ids.clear();
+    for (size_t id = 0; id < discoveredDevices.size(); ++id) {
+        if (discoveredDevices[id]) {
+            ids.push_back(static_cast<uint32_t>(id));
+        }
+    }
+}
+
+size_t NetworkScanner::copyDevices(const uint32_t* ids, size_t count,
+                                   std::vector<std::shared_ptr<NetworkDevice>>& records) {
+    std::lock_guard<std::mutex> lock(devicesMutex);
+    size_t copied = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t id = ids[i];
+        if (id >= discoveredDevices.size() || !discoveredDevices[id]) continue;
+        if (id >= records.size()) {
+            records.resize(id + 1);
+        }
+        
+        const NetworkDevice& source = *discoveredDevices[id];
+        auto& record = records[id];
+        if (!record) {
+            record = allocateDevice();
+        }
+        // assign() keeps the record's string capacity from earlier copies
+        record->mac = source.mac;
+        record->deviceId = source.deviceId;
+        record->macAddress.assign(source.macAddress);
+        record->ipAddress.assign(source.ipAddress);
+        record->hostname.assign(source.hostname);
+        record->rssi = source.rssi;
+        record->isOnline = source.isOnline;
+        record->lastSeen = source.lastSeen;
+        copied++;
+    }
+    return copied;
+}
+
+void NetworkScanner::setActiveDiscovery(bool enabled, const SubnetSweeper::Options& options) {
+    std::lock_guard<std::mutex> lock(sweeperMutex);
+    sweeper = SubnetSweeper(options);
+    activeDiscovery = enabled;
 }
 
 void NetworkScanner::performNetworkScan() {
-    std::vector<std::shared_ptr<NetworkDevice>> newDevices;
-    
-#ifdef _WIN32
-    newDevices = scanWindowsNetwork();
-#elif __APPLE__
-    newDevices = scanMacOSNetwork();
-#else
-    newDevices = scanLinuxNetwork();
-#endif
+    std::unique_lock<std::mutex> lock(scanMutex, std::defer_lock);
+    {
+        SB_SCOPED_TIMER(Scan);
+        if (activeDiscovery) {
+            // Replies are not used directly: probing makes the OS resolve each
+            // live host, so the table reads below pick them up with their MACs
+            std::lock_guard<std::mutex> sweepLock(sweeperMutex);
+            sweeper.sweep(SubnetSweeper::enumerateSubnets());
+        }
+        
+        lock.lock();
+        
+        // Each backend appends to the same buffer, which keeps its capacity between scans
+        scanRecords.clear();
+        for (const auto& backend : backends) {
+            if (!backend->scan(scanRecords)) {
+                SB_COUNT(ScanErrors, 1);
+                std::cerr << "Scan backend " << backend->name() << " failed" << std::endl;
+            }
+        }
+    }
     
-    updateDeviceList(newDevices);
+    updateDeviceList(scanRecords);
 }
 
-#ifdef _WIN32
-std::vector<std::shared_ptr<NetworkDevice>> NetworkScanner::scanWindowsNetwork() {
-    std::vector<std::shared_ptr<NetworkDevice>> devices;
-    
-    // Get ARP table
-    PMIB_IPNETTABLE pIpNetTable;
-    DWORD dwSize = 0;
-    
-    if (GetIpNetTable(NULL, &dwSize, FALSE) == ERROR_INSUFFICIENT_BUFFER) {
-        pIpNetTable = (MIB_IPNETTABLE*)malloc(dwSize);
+void NetworkScanner::updateDeviceList(const std::vector<ScanRecord>& records) {
+    SB_SCOPED_TIMER(UpdateDeviceList);
+    {
+        std::lock_guard<std::mutex> lock(devicesMutex);
+        // IDs removed by the previous scan have been published by now
+        deviceIds.reclaimReleased();
+        seenInScan.assign(discoveredDevices.size(), 0);
         
-        if (GetIpNetTable(pIpNetTable, &dwSize, FALSE) == NO_ERROR) {
-            for (DWORD i = 0; i < pIpNetTable->dwNumEntries; i++) {
-                MIB_IPNETROW& row = pIpNetTable->table[i];
-                
-                if (row.dwType == MIB_IPNET_TYPE_DYNAMIC || row.dwType == MIB_IPNET_TYPE_STATIC) {
-                    auto device = std::make_shared<NetworkDevice>();
-                    
-                    // IP Address
-                    struct in_addr addr;
-                    addr.s_addr = row.dwAddr;
-                    device->ipAddress = inet_ntoa(addr);
-                    
-                    // MAC Address
-                    char macStr[18];
-                    sprintf_s(macStr, sizeof(macStr), "%02x:%02x:%02x:%02x:%02x:%02x",
-                        row.bPhysAddr[0], row.bPhysAddr[1], row.bPhysAddr[2],
-                        row.bPhysAddr[3], row.bPhysAddr[4], row.bPhysAddr[5]);
-                    device->macAddress = macStr;
-                    
-                    device->isOnline = true;
-                    device->rssi = -50; // Simulated signal strength
-                    device->lastSeen = std::chrono::system_clock::now();
-                    
-                    devices.push_back(device);
-                }
+        // Update or add devices
+        auto now = std::chrono::system_clock::now();
+        for (const auto& record : records) {
+            if (record.mac.isZero() || record.removed) continue;
+            
+            uint32_t id = mergeRecord(record, now);
+            if (id >= seenInScan.size()) {
+                seenInScan.resize(id + 1, 0);
             }
+            seenInScan[id] = 1;
         }
         
-        free(pIpNetTable);
+        // Mark devices missing from this scan offline, and remove devices not seen for too long
+        for (size_t id = 0; id < discoveredDevices.size(); ++id) {
+            auto& device = discoveredDevices[id];
+            if (!device || seenInScan[id]) continue;
+            
+            auto timeSinceLastSeen = std::chrono::duration_cast<std::chrono::minutes>(
+                now - device->lastSeen).count();
+            
+            if (timeSinceLastSeen > 10) { // Remove after 10 minutes
+                recordChange(DeviceChangeType::Removed, static_cast<uint32_t>(id));
+                device.reset();
+                deviceIds.release(static_cast<uint32_t>(id));
+            } else if (device->isOnline) {
+                device->isOnline = false;
+                recordChange(DeviceChangeType::Updated, static_cast<uint32_t>(id));
+            }
+        }
+        scansCompleted.fetch_add(1, std::memory_order_release);
     }
     
-    return devices;
+    publishChanges();
 }
-#endif
 
-#ifdef __APPLE__
-std::vector<std::shared_ptr<NetworkDevice>> NetworkScanner::scanMacOSNetwork() {
-    std::vector<std::shared_ptr<NetworkDevice>> devices;
-    
-    // Placeholder for macOS-specific network scanning
-    // Would use CoreWLAN and System Configuration frameworks
+void NetworkScanner::applyEvents(const std::vector<ScanRecord>& records) {
+    {
+        std::lock_guard<std::mutex> lock(devicesMutex);
+        
+        auto now = std::chrono::system_clock::now();
+        for (const auto& record : records) {
+            if (record.mac.isZero()) continue;
+            
+            if (!record.removed) {
+                mergeRecord(record, now);
+                continue;
+            }
+            
+            // Keep the device until it ages out, but mark it offline
+            uint32_t id = deviceIds.find(record.mac);
+            if (id < discoveredDevices.size() && discoveredDevices[id] && discoveredDevices[id]->isOnline) {
+                discoveredDevices[id]->isOnline = false;
+                recordChange(DeviceChangeType::Updated, id);
+            }
+        }
+    }
     
-    return devices;
+    publishChanges();
 }
-#endif
 
-#ifndef _WIN32
-#ifndef __APPLE__
-std::vector<std::shared_ptr<NetworkDevice>> NetworkScanner::scanLinuxNetwork() {
-    std::vector<std::shared_ptr<NetworkDevice>> devices;
-    
-    // Placeholder for Linux-specific network scanning
-    // Would use /proc/net/arp and other system interfaces
-    
-    return devices;
+void NetworkScanner::restoreDevices(const std::vector<NetworkDevice>& devices) {
+    std::lock_guard<std::mutex> lock(devicesMutex);
+    for (const auto& restored : devices) {
+        if (restored.mac.isZero()) continue;
+
+        uint32_t id = deviceIds.intern(restored.mac);
+        if (id >= discoveredDevices.size()) {
+            discoveredDevices.resize(id + 1);
+        }
+        if (discoveredDevices[id]) continue;
+
+        auto device = allocateDevice(restored);
+        device->deviceId = id;
+        device->isOnline = false;
+        discoveredDevices[id] = std::move(device);
+    }
 }
-#endif
-#endif
 
-void NetworkScanner::updateDeviceList(const std::vector<std::shared_ptr<NetworkDevice>>& newDevices) {
-    std::lock_guard<std::mutex> lock(devicesMutex);
+uint32_t NetworkScanner::mergeRecord(const ScanRecord& record, std::chrono::system_clock::time_point now) {
+    uint32_t id = deviceIds.intern(record.mac);
+    if (id >= discoveredDevices.size()) {
+        discoveredDevices.resize(id + 1);
+    }
     
-    // Mark all existing devices as potentially offline
-    for (auto& pair : discoveredDevices) {
-        pair.second->isOnline = false;
+    auto& device = discoveredDevices[id];
+    bool added = !device;
+    if (added) {
+        device = allocateDevice();
+        device->mac = record.mac;
+        device->deviceId = id;
+        device->macAddress = record.mac.toString();
     }
     
-    // Update or add new devices
-    for (const auto& newDevice : newDevices) {
-        std::string key = newDevice->macAddress;
-        
-        auto it = discoveredDevices.find(key);
-        if (it != discoveredDevices.end()) {
-            // Update existing device
-            it->second->ipAddress = newDevice->ipAddress;
-            it->second->isOnline = true;
-            it->second->rssi = newDevice->rssi;
-            it->second->lastSeen = newDevice->lastSeen;
-        } else {
-            // Add new device
-            discoveredDevices[key] = newDevice;
-        }
+    bool changed = added || !device->isOnline || device->rssi != record.rssi;
+    
+    // Records without an address (e.g. Wi-Fi scans) keep the known one, and an
+    // IPv6 neighbour entry never replaces a known IPv4 address
+    bool isIpv6 = std::strchr(record.ipAddress, ':') != nullptr;
+    bool hasIpv4 = !device->ipAddress.empty() && device->ipAddress.find(':') == std::string::npos;
+    if (record.ipAddress[0] != '\0' && !(isIpv6 && hasIpv4) && device->ipAddress != record.ipAddress) {
+        device->ipAddress = record.ipAddress;
+        changed = true;
     }
     
-    // Remove devices not seen for too long
-    auto now = std::chrono::system_clock::now();
-    auto it = discoveredDevices.begin();
-    while (it != discoveredDevices.end()) {
-        auto timeSinceLastSeen = std::chrono::duration_cast<std::chrono::minutes>(
-            now - it->second->lastSeen).count();
-        
-        if (timeSinceLastSeen > 10) { // Remove after 10 minutes
-            it = discoveredDevices.erase(it);
-        } else {
-            ++it;
-        }
+    device->isOnline = true;
+    device->rssi = record.rssi;
+    device->lastSeen = now;
+    
+    if (changed) {
+        recordChange(added ? DeviceChangeType::Added : DeviceChangeType::Updated, id);
     }
-}
\ No newline at end of file
+    return id;
+}
+
+void NetworkScanner::setChangeCallback(ChangeCallback callback) {
+    std::lock_guard<std::mutex> lock(callbackMutex);
+    changeCallback = std::move(callback);
+}
+
+void NetworkScanner::recordChange(DeviceChangeType type, uint32_t deviceId) {
+    pendingChanges.push_back({type, deviceId});
+}
+
+void NetworkScanner::publishChanges() {
+    // callbackMutex serialises publishers and guards deliveredChanges
+    std::lock_guard<std::mutex> callbackLock(callbackMutex);
+    {
+        std::lock_guard<std::mutex> lock(devicesMutex);
+        deliveredChanges.swap(pendingChanges);
+        pendingChanges.clear();
+    }
+    
+    if (!deliveredChanges.empty() && changeCallback) {
+        changeCallback(deliveredChanges);
+    }
+    deliveredChanges.clear();
+}
@@ -1,52 +1,160 @@
 #pragma once
 
+#include "DeviceType.h"
+#include "MacAddress.h"
+#include "ScanBackend.h"
+#include "SubnetSweeper.h"
+#include "SlabPool.h"
+#include "StreamingSummary.h"
+#include "TaskScheduler.h"
 #include <vector>
 #include <memory>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
 #include <map>
 #include <string>
 #include <chrono>
+#include <cstdint>
 
 struct NetworkDevice {
+    MacAddress mac;
+    uint32_t deviceId; // dense ID interned by NetworkScanner, indexes per-device arrays
     std::string macAddress;
     std::string ipAddress;
     std::string hostname;
     int rssi;
     bool isOnline;
+    DeviceType deviceType;
     std::chrono::system_clock::time_point lastSeen;
-    std::string deviceType;
     std::string vendor;
+    // Signal and address statistics since the device was first seen, one
+    // sample per reading the scanner reported as new or changed
+    DeviceSummary summary;
     
-    NetworkDevice() : rssi(-100), isOnline(false), lastSeen(std::chrono::system_clock::now()) {}
+    NetworkDevice() : deviceId(DeviceIdTable::kInvalidId), rssi(-100), isOnline(false), deviceType(DeviceType::Unknown),
+                      lastSeen(std::chrono::system_clock::now()) {}
+};
+
+// Device records, and the control blocks of their shared_ptrs, come from one
+// slab pool shared by the scanner and snapshot copies, so devices leaving
+// the network make room for new ones without touching the heap
+std::shared_ptr<NetworkDevice> allocateDevice();
+std::shared_ptr<NetworkDevice> allocateDevice(const NetworkDevice& source);
+const SlabPool& deviceRecordPool();
+
+enum class DeviceChangeType {
+    Added,
+    Updated, // address, online state or signal changed
+    Removed // the ID may be handed to another device from the next full scan on
+};
+
+struct DeviceChange {
+    DeviceChangeType type;
+    uint32_t deviceId; // read the device itself with copyDevices()
 };
 
 class NetworkScanner {
 public:
+    // Invoked from whichever thread scanned, with each batch of changes, after the
+    // device list has been updated and without any scanner lock held
+    using ChangeCallback = std::function<void(const std::vector<DeviceChange>&)>;
+    
+    // Uses the native backend for this platform
     NetworkScanner();
+    // Uses only the given backend; more can be added with addBackend()
+    explicit NetworkScanner(std::unique_ptr<ScanBackend> backend);
     ~NetworkScanner();
     
+    // Every scan runs all backends in order; call before startScanning()
+    void addBackend(std::unique_ptr<ScanBackend> backend);
+    
+    // Scans periodically on a thread of its own, since the sweep and the
+    // backends block, and polls every event backend in between as a task on
+    // the shared TaskScheduler
     void startScanning();
     void stopScanning();
+    // Copies of the current devices, taken under the device lock; the
+    // scanner's own records change with every scan and event
     std::vector<std::shared_ptr<NetworkDevice>> getCurrentDevices();
+    // Replaces the contents of devices, reusing its capacity
+    void getCurrentDevices(std::vector<std::shared_ptr<NetworkDevice>>& devices);
+    // IDs of the devices currently in the table, in ID order
+    void currentDeviceIds(std::vector<uint32_t>& ids);
+    // Copies what the scanner maintains (identity, address, raw RSSI, online
+    // state, last seen) of each listed device into records[id], allocating
+    // missing records and growing records as needed. Type, vendor and summary
+    // are left alone, so callers can keep their own there. IDs no longer in
+    // the table are skipped; returns how many devices were copied.
+    size_t copyDevices(const uint32_t* ids, size_t count, std::vector<std::shared_ptr<NetworkDevice>>& records);
     void performNetworkScan();
     
+    const DeviceIdTable& getDeviceIds() const { return deviceIds; }
+    
+    // Seeds the device table with devices from a previous run, all offline
+    // and without reporting changes. The first scan brings back those still
+    // present and ages out the rest as usual. Call before startScanning().
+    void restoreDevices(const std::vector<NetworkDevice>& devices);
+    // Full scans finished so far; 0 while restored devices are unconfirmed
+    uint64_t completedScanCount() const { return scansCompleted.load(std::memory_order_acquire); }
+    
+    // Set before startScanning(); pass nullptr to stop receiving changes
+    void setChangeCallback(ChangeCallback callback);
+    
+    // When enabled, every scan first probes all hosts of the local subnets so
+    // hosts that haven't talked recently appear in the neighbour table
+    void setActiveDiscovery(bool enabled, const SubnetSweeper::Options& options = SubnetSweeper::Options());
+    
 private:
-    bool isScanning;
-    std::thread scanningThread;
+    std::atomic<bool> isScanning;
+    std::atomic<bool> activeDiscovery;
+    std::mutex sweeperMutex;
+    SubnetSweeper sweeper;
+    TaskHandle eventTask;
+    
+    // Full scans; woken early when an event backend has lost events
+    std::thread scanThread;
+    std::mutex wakeMutex;
+    std::condition_variable wakeScanThread;
+    bool scanRequested; // guarded by wakeMutex
+    
+    static constexpr std::chrono::seconds kScanInterval{30};
+    static constexpr std::chrono::milliseconds kEventPollInterval{250};
+    
+    // Backends and the record buffers they append to
+    std::mutex scanMutex;
+    std::vector<std::unique_ptr<ScanBackend>> backends;
+    std::vector<ScanRecord> scanRecords;
+    std::vector<ScanRecord> eventRecords;
+    
     std::mutex devicesMutex;
-    std::map<std::string, std::shared_ptr<NetworkDevice>> discoveredDevices;
+    DeviceIdTable deviceIds;
+    std::vector<std::shared_ptr<NetworkDevice>> discoveredDevices; // indexed by deviceId, null when absent
+    std::vector<uint8_t> seenInScan; // indexed by deviceId, scratch for updateDeviceList
+    std::atomic<uint64_t> scansCompleted;
+    
+    std::mutex callbackMutex;
+    ChangeCallback changeCallback;
+    std::vector<DeviceChange> pendingChanges; // guarded by devicesMutex
+    std::vector<DeviceChange> deliveredChanges;
     
     void initializePlatform();
     void cleanupPlatform();
+    void scanOnce();
     void scanLoop();
-    void updateDeviceList(const std::vector<std::shared_ptr<NetworkDevice>>& newDevices);
-    
-#ifdef _WIN32
-    std::vector<std::shared_ptr<NetworkDevice>> scanWindowsNetwork();
-#elif __APPLE__
-    std::vector<std::shared_ptr<NetworkDevice>> scanMacOSNetwork();
-#else
-    std::vector<std::shared_ptr<NetworkDevice>> scanLinuxNetwork();
-#endif
+    void requestScan();
+    void pollEvents();
+    bool hasEventBackend() const;
+    
+    // Full scan results: devices missing from `records` go offline and eventually age out
+    void updateDeviceList(const std::vector<ScanRecord>& records);
+    // Incremental results: only the listed devices change
+    void applyEvents(const std::vector<ScanRecord>& records);
+    // Creates or updates one device and returns its ID; caller holds devicesMutex
+    uint32_t mergeRecord(const ScanRecord& record, std::chrono::system_clock::time_point now);
+    
+    void recordChange(DeviceChangeType type, uint32_t deviceId);
+    void publishChanges();
 };
\ No newline at end of file
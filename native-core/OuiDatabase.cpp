@@ -0,0 +1,318 @@
+#include "OuiDatabase.h"
+#include "Checksum.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+constexpr char kIndexMagic[8] = {'S', 'B', 'O', 'U', 'I', 'D', 'X', '\0'};
+constexpr uint32_t kIndexVersion = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t counts[OuiDatabase::BLOCK_SIZES];
+    uint32_t poolSize;
+    uint32_t checksum; // CRC-32 over entries and name pool
+    uint32_t reserved;
+};
+
+std::string_view trim(std::string_view text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string_view::npos) return {};
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+// Reads hex digits, skipping '-' and ':' separators; returns digit count or -1
+int parseHexPrefix(std::string_view text, uint64_t& value) {
+    value = 0;
+    int digits = 0;
+    for (char c : text) {
+        if (c == '-' || c == ':') continue;
+        int nibble;
+        if (c >= '0' && c <= '9') nibble = c - '0';
+        else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') nibble = c - 'A' + 10;
+        else return -1;
+        if (++digits > 12) return -1;
+        value = (value << 4) | static_cast<uint64_t>(nibble);
+    }
+    return digits;
+}
+
+// Splits off the next CSV field, honouring double-quoted fields
+std::string_view nextCsvField(std::string_view& line) {
+    std::string_view field;
+    if (!line.empty() && line.front() == '"') {
+        size_t close = line.find('"', 1);
+        while (close != std::string_view::npos && close + 1 < line.size() && line[close + 1] == '"') {
+            close = line.find('"', close + 2); // escaped quote
+        }
+        if (close == std::string_view::npos) {
+            field = line.substr(1);
+            line = {};
+            return field;
+        }
+        field = line.substr(1, close - 1);
+        line.remove_prefix(std::min(line.size(), close + 2));
+        return field;
+    }
+
+    size_t comma = line.find(',');
+    field = line.substr(0, comma);
+    line = comma == std::string_view::npos ? std::string_view() : line.substr(comma + 1);
+    return field;
+}
+
+} // namespace
+
+constexpr unsigned OuiDatabase::kPrefixBits[BLOCK_SIZES];
+
+OuiDatabase::OuiDatabase() {
+    bindOwnedStorage();
+}
+
+void OuiDatabase::addEntry(BlockSize block, uint64_t prefix, std::string_view vendor) {
+    if (mapping.isOpen()) {
+        detachMapping();
+    }
+
+    vendor = trim(vendor);
+    if (vendor.empty()) return;
+
+    uint32_t nameOffset = internName(vendor);
+    entries[block].push_back({prefix, nameOffset, static_cast<uint32_t>(vendor.size())});
+}
+
+uint32_t OuiDatabase::internName(std::string_view vendor) {
+    auto it = nameOffsets.find(std::string(vendor));
+    if (it != nameOffsets.end()) return it->second;
+
+    uint32_t offset = static_cast<uint32_t>(namePool.size());
+    namePool.append(vendor.data(), vendor.size());
+    nameOffsets.emplace(std::string(vendor), offset);
+    return offset;
+}
+
+void OuiDatabase::finalize() {
+    for (auto& table : entries) {
+        // Later additions win, so registry data overrides built-in defaults
+        std::stable_sort(table.begin(), table.end(), [](const Entry& a, const Entry& b) {
+            return a.prefix < b.prefix;
+        });
+
+        size_t out = 0;
+        for (size_t i = 0; i < table.size(); ++i) {
+            if (i + 1 < table.size() && table[i + 1].prefix == table[i].prefix) continue;
+            table[out++] = table[i];
+        }
+        table.resize(out);
+    }
+
+    bindOwnedStorage();
+}
+
+void OuiDatabase::bindOwnedStorage() {
+    for (int block = 0; block < BLOCK_SIZES; ++block) {
+        tables[block] = entries[block].data();
+        counts[block] = entries[block].size();
+    }
+    pool = namePool.data();
+    poolSize = namePool.size();
+}
+
+void OuiDatabase::detachMapping() {
+    // Copy the mapped index into owned storage so it can be extended
+    for (int block = 0; block < BLOCK_SIZES; ++block) {
+        entries[block].assign(tables[block], tables[block] + counts[block]);
+    }
+    namePool.assign(pool, poolSize);
+
+    nameOffsets.clear();
+    for (const auto& table : entries) {
+        for (const Entry& entry : table) {
+            nameOffsets.emplace(namePool.substr(entry.nameOffset, entry.nameLength), entry.nameOffset);
+        }
+    }
+
+    mapping.close();
+    bindOwnedStorage();
+}
+
+void OuiDatabase::clear() {
+    for (auto& table : entries) table.clear();
+    namePool.clear();
+    nameOffsets.clear();
+    mapping.close();
+    bindOwnedStorage();
+}
+
+int OuiDatabase::loadIeeeRegistry(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) return -1;
+
+    std::string line;
+    int parsed = 0;
+    while (std::getline(file, line)) {
+        if (parseRegistryLine(line)) ++parsed;
+    }
+
+    finalize();
+    return parsed;
+}
+
+bool OuiDatabase::parseRegistryLine(std::string_view line) {
+    // oui.txt: "00-00-0C   (hex)\t\tCisco Systems, Inc"
+    size_t hexTag = line.find("(hex)");
+    if (hexTag != std::string_view::npos) {
+        uint64_t prefix;
+        if (parseHexPrefix(trim(line.substr(0, hexTag)), prefix) != 6) return false;
+        addEntry(MA_L, prefix, line.substr(hexTag + 5));
+        return true;
+    }
+
+    // CSV exports: "MA-L,00000C,Cisco Systems, Inc,<address>"
+    std::string_view rest = line;
+    std::string_view registry = nextCsvField(rest);
+    std::string_view assignment = nextCsvField(rest);
+    std::string_view organization = nextCsvField(rest);
+
+    BlockSize block;
+    int expectedDigits;
+    if (registry == "MA-L") {
+        block = MA_L;
+        expectedDigits = 6;
+    } else if (registry == "MA-M") {
+        block = MA_M;
+        expectedDigits = 7;
+    } else if (registry == "MA-S" || registry == "IAB") {
+        block = MA_S;
+        expectedDigits = 9;
+    } else {
+        return false; // Header line, CID or unrelated registry
+    }
+
+    uint64_t prefix;
+    if (parseHexPrefix(assignment, prefix) != expectedDigits) return false;
+
+    // A quoted field still holds its escaped quotes as pairs
+    std::string unescaped;
+    if (organization.find("\"\"") != std::string_view::npos) {
+        for (size_t i = 0; i < organization.size(); ++i) {
+            unescaped += organization[i];
+            if (organization[i] == '"' && i + 1 < organization.size() && organization[i + 1] == '"') ++i;
+        }
+        organization = unescaped;
+    }
+    addEntry(block, prefix, organization);
+    return true;
+}
+
+bool OuiDatabase::saveIndex(const std::string& path) const {
+    IndexHeader header = {};
+    std::memcpy(header.magic, kIndexMagic, sizeof(kIndexMagic));
+    header.version = kIndexVersion;
+    header.byteOrder = kByteOrderMark;
+    header.poolSize = static_cast<uint32_t>(poolSize);
+
+    uint32_t checksum = 0;
+    for (int block = 0; block < BLOCK_SIZES; ++block) {
+        header.counts[block] = static_cast<uint32_t>(counts[block]);
+        checksum = crc32(tables[block], counts[block] * sizeof(Entry), checksum);
+    }
+    header.checksum = crc32(pool, poolSize, checksum);
+
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (int block = 0; block < BLOCK_SIZES; ++block) {
+            file.write(reinterpret_cast<const char*>(tables[block]), counts[block] * sizeof(Entry));
+        }
+        file.write(pool, poolSize);
+        if (!file) return false;
+    }
+
+    // A concurrent loader maps either the previous index or this one
+    return replaceFile(tempPath, path);
+}
+
+bool OuiDatabase::loadIndex(const std::string& path) {
+    MappedFile file;
+    if (!file.open(path) || file.size() < sizeof(IndexHeader)) return false;
+
+    IndexHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, kIndexMagic, sizeof(kIndexMagic)) != 0 ||
+        header.version != kIndexVersion || header.byteOrder != kByteOrderMark) {
+        return false;
+    }
+
+    size_t expected = sizeof(IndexHeader) + header.poolSize;
+    for (uint32_t count : header.counts) {
+        expected += static_cast<size_t>(count) * sizeof(Entry);
+    }
+    if (file.size() != expected) return false;
+
+    // Validate before switching over so a bad file leaves the current table intact
+    const uint8_t* cursor = file.data() + sizeof(IndexHeader);
+    const Entry* mappedTables[BLOCK_SIZES];
+    uint32_t checksum = 0;
+    for (int block = 0; block < BLOCK_SIZES; ++block) {
+        mappedTables[block] = reinterpret_cast<const Entry*>(cursor);
+        size_t bytes = static_cast<size_t>(header.counts[block]) * sizeof(Entry);
+        checksum = crc32(cursor, bytes, checksum);
+        cursor += bytes;
+    }
+    if (crc32(cursor, header.poolSize, checksum) != header.checksum) return false;
+
+    // lookup() binary-searches each table and slices names out of the pool
+    for (int block = 0; block < BLOCK_SIZES; ++block) {
+        const Entry* table = mappedTables[block];
+        for (uint32_t i = 0; i < header.counts[block]; ++i) {
+            if (static_cast<uint64_t>(table[i].nameOffset) + table[i].nameLength > header.poolSize) return false;
+            if (table[i].prefix >> kPrefixBits[block] != 0) return false;
+            if (i > 0 && table[i - 1].prefix >= table[i].prefix) return false;
+        }
+    }
+
+    clear();
+    mapping.swap(file);
+    for (int block = 0; block < BLOCK_SIZES; ++block) {
+        tables[block] = mappedTables[block];
+        counts[block] = header.counts[block];
+    }
+    pool = reinterpret_cast<const char*>(cursor);
+    poolSize = header.poolSize;
+    return true;
+}
+
+std::string_view OuiDatabase::lookup(MacAddress mac) const {
+    uint64_t address = mac.toUint64();
+
+    // Most specific block first: MA-S, then MA-M, then MA-L
+    for (int block = BLOCK_SIZES - 1; block >= 0; --block) {
+        const Entry* begin = tables[block];
+        const Entry* end = begin + counts[block];
+        uint64_t key = address >> (48 - kPrefixBits[block]);
+
+        const Entry* it = std::lower_bound(begin, end, key, [](const Entry& entry, uint64_t value) {
+            return entry.prefix < value;
+        });
+        if (it != end && it->prefix == key) {
+            return std::string_view(pool + it->nameOffset, it->nameLength);
+        }
+    }
+
+    return {};
+}
+
+size_t OuiDatabase::size() const {
+    return counts[MA_L] + counts[MA_M] + counts[MA_S];
+}
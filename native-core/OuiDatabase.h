@@ -0,0 +1,69 @@
+#pragma once
+
+#include "MacAddress.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+
+// Vendor lookup table for IEEE MAC address assignments. MA-L (24-bit OUI),
+// MA-M (28-bit) and MA-S (36-bit) blocks are kept in separate sorted arrays
+// keyed by the prefix integer, with every vendor name stored once in a
+// shared string pool. Lookups are a binary search and never allocate.
+//
+// The table can be built from the IEEE registry files (oui.txt or the
+// oui.csv / mam.csv / oui36.csv exports) and saved as a flat binary index
+// that later loads with a single mmap.
+class OuiDatabase {
+public:
+    enum BlockSize { MA_L = 0, MA_M = 1, MA_S = 2, BLOCK_SIZES = 3 };
+
+    struct Entry {
+        uint64_t prefix; // right-aligned top bits of the MAC
+        uint32_t nameOffset;
+        uint32_t nameLength;
+    };
+
+    OuiDatabase();
+
+    // Builder interface; call finalize() once all entries are added
+    void addEntry(BlockSize block, uint64_t prefix, std::string_view vendor);
+    void finalize();
+
+    // Parses an IEEE registry file and merges it into the table.
+    // Returns the number of assignments read, or -1 if the file can't be opened.
+    int loadIeeeRegistry(const std::string& path);
+
+    bool saveIndex(const std::string& path) const;
+    bool loadIndex(const std::string& path);
+
+    // Longest-prefix match; returns an empty view for unknown vendors.
+    // The view stays valid until the table is modified or reloaded.
+    std::string_view lookup(MacAddress mac) const;
+
+    size_t size() const;
+    bool isMapped() const { return mapping.isOpen(); }
+    void clear();
+
+private:
+    static constexpr unsigned kPrefixBits[BLOCK_SIZES] = {24, 28, 36};
+
+    // Owned storage while building; empty when serving from a mapped index
+    std::vector<Entry> entries[BLOCK_SIZES];
+    std::string namePool;
+    std::unordered_map<std::string, uint32_t> nameOffsets;
+    MappedFile mapping;
+
+    // Views used by lookup(), pointing at either the vectors or the mapping
+    const Entry* tables[BLOCK_SIZES];
+    size_t counts[BLOCK_SIZES];
+    const char* pool;
+    size_t poolSize;
+
+    uint32_t internName(std::string_view vendor);
+    void bindOwnedStorage();
+    void detachMapping();
+    bool parseRegistryLine(std::string_view line);
+};
@@ -0,0 +1,99 @@
+#include "PatternMatcher.h"
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+int PatternMatcher::addPattern(std::string_view pattern, std::string_view result, uint32_t priority) {
+    rules.push_back({std::string(pattern), std::string(result), priority});
+    return static_cast<int>(rules.size() - 1);
+}
+
+void PatternMatcher::clear() {
+    rules.clear();
+    transitions.clear();
+    outputs.clear();
+    std::fill(std::begin(byteClass), std::end(byteClass), 0);
+    alphabetSize = 1;
+}
+
+bool PatternMatcher::better(uint32_t a, uint32_t b) const {
+    if (a == kNoRule) return false;
+    if (b == kNoRule) return true;
+    if (rules[a].priority != rules[b].priority) return rules[a].priority < rules[b].priority;
+    return a < b;
+}
+
+void PatternMatcher::compile() {
+    // Assign one alphabet class per distinct (case-folded) pattern byte
+    std::fill(std::begin(byteClass), std::end(byteClass), 0);
+    alphabetSize = 1;
+    for (const auto& rule : rules) {
+        for (unsigned char c : rule.pattern) {
+            unsigned char lower = static_cast<unsigned char>(std::tolower(c));
+            if (byteClass[lower] == 0) {
+                byteClass[lower] = static_cast<uint8_t>(alphabetSize++);
+                byteClass[std::toupper(lower)] = byteClass[lower];
+            }
+        }
+    }
+    
+    // Build the trie; 0 in a transition slot means "no edge" until failure links are filled in
+    transitions.assign(alphabetSize, 0);
+    outputs.assign(1, kNoRule);
+    for (size_t r = 0; r < rules.size(); ++r) {
+        uint32_t state = 0;
+        for (unsigned char c : rules[r].pattern) {
+            uint32_t& next = transitions[state * alphabetSize + byteClass[c]];
+            if (next == 0) {
+                next = static_cast<uint32_t>(outputs.size());
+                outputs.push_back(kNoRule);
+                transitions.resize(transitions.size() + alphabetSize, 0);
+            }
+            state = transitions[state * alphabetSize + byteClass[c]];
+        }
+        if (better(static_cast<uint32_t>(r), outputs[state])) {
+            outputs[state] = static_cast<uint32_t>(r);
+        }
+    }
+    
+    // Breadth-first pass turns the trie into a DFA: missing edges follow the
+    // failure link, and each state inherits the best output of its suffix state
+    std::vector<uint32_t> failure(outputs.size(), 0);
+    std::vector<uint32_t> queue;
+    queue.reserve(outputs.size());
+    for (uint32_t cls = 0; cls < alphabetSize; ++cls) {
+        uint32_t child = transitions[cls];
+        if (child != 0) queue.push_back(child);
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        uint32_t state = queue[head];
+        uint32_t fail = failure[state];
+        if (better(outputs[fail], outputs[state])) {
+            outputs[state] = outputs[fail];
+        }
+        for (uint32_t cls = 0; cls < alphabetSize; ++cls) {
+            uint32_t& next = transitions[state * alphabetSize + cls];
+            uint32_t fallback = transitions[fail * alphabetSize + cls];
+            if (next != 0) {
+                failure[next] = fallback;
+                queue.push_back(next);
+            } else {
+                next = fallback;
+            }
+        }
+    }
+}
+
+int PatternMatcher::match(std::string_view text) const {
+    if (outputs.empty()) return kNoMatch;
+    
+    uint32_t state = 0;
+    uint32_t best = outputs[0];
+    for (unsigned char c : text) {
+        state = transitions[state * alphabetSize + byteClass[c]];
+        if (better(outputs[state], best)) {
+            best = outputs[state];
+        }
+    }
+    return best == kNoRule ? kNoMatch : static_cast<int>(best);
+}
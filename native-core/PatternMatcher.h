@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Case-insensitive multi-pattern substring matcher (Aho-Corasick).
+// Patterns are compiled into a dense DFA over a compressed alphabet, so
+// matching is one table lookup per input byte regardless of rule count.
+// When several patterns occur in the text, the one with the lowest
+// priority value wins, which keeps rule precedence deterministic.
+class PatternMatcher {
+public:
+    static constexpr int kNoMatch = -1;
+
+    // Returns the rule index passed to match() callers via result()
+    int addPattern(std::string_view pattern, std::string_view result, uint32_t priority);
+    void compile();
+    void clear();
+
+    // Index of the best matching rule in `text`, or kNoMatch
+    int match(std::string_view text) const;
+    const std::string& result(int rule) const { return rules[rule].result; }
+
+    size_t size() const { return rules.size(); }
+    size_t stateCount() const { return outputs.size(); }
+
+private:
+    static constexpr uint32_t kNoRule = 0xFFFFFFFFu;
+
+    struct Rule {
+        std::string pattern;
+        std::string result;
+        uint32_t priority;
+    };
+
+    std::vector<Rule> rules;
+
+    // Byte -> alphabet class; class 0 collects every byte not used by any pattern
+    uint8_t byteClass[256] = {};
+    uint32_t alphabetSize = 1;
+
+    // transitions[state * alphabetSize + class], outputs[state] = best rule ending here
+    std::vector<uint32_t> transitions;
+    std::vector<uint32_t> outputs;
+
+    bool better(uint32_t a, uint32_t b) const;
+};
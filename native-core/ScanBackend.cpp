@@ -0,0 +1,210 @@
+#include "ScanBackend.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <iphlpapi.h>
+#pragma comment(lib, "iphlpapi.lib")
+#elif __APPLE__
+#include <CoreWLAN/CoreWLAN.h>
+#else
+#include <sys/socket.h>
+#endif
+
+void ScanRecord::setAddress(const std::string& address) {
+    size_t length = std::min(address.size(), kAddressLength - 1);
+    std::memcpy(ipAddress, address.data(), length);
+    ipAddress[length] = '\0';
+}
+
+bool ScanRecord::ipv4Address(uint32_t& address) const {
+    uint32_t value = 0;
+    int octets = 0;
+    const char* p = ipAddress;
+    while (octets < 4) {
+        if (*p < '0' || *p > '9') return false;
+        uint32_t octet = 0;
+        for (int digits = 0; *p >= '0' && *p <= '9'; ++p) {
+            if (++digits > 3) return false;
+            octet = octet * 10 + static_cast<uint32_t>(*p - '0');
+        }
+        if (octet > 255) return false;
+        value = (value << 8) | octet;
+        if (++octets < 4 && *p++ != '.') return false;
+    }
+    if (*p != '\0') return false;
+
+    address = value;
+    return true;
+}
+
+bool ScanBackend::waitForEvents(int timeoutMs, std::vector<ScanRecord>&) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+    return true;
+}
+
+std::unique_ptr<ScanBackend> createPlatformBackend() {
+#ifdef _WIN32
+    return std::make_unique<WindowsIpHelperBackend>();
+#elif __APPLE__
+    return std::make_unique<MacOSCoreWlanBackend>();
+#else
+    return std::make_unique<LinuxNetlinkBackend>();
+#endif
+}
+
+#ifdef _WIN32
+bool WindowsIpHelperBackend::scan(std::vector<ScanRecord>& records) {
+    // The table buffer is kept between scans and only grows
+    ULONG size = static_cast<ULONG>(tableBuffer.size());
+    DWORD result = ERROR_INSUFFICIENT_BUFFER;
+    for (int attempt = 0; attempt < 3 && result == ERROR_INSUFFICIENT_BUFFER; ++attempt) {
+        if (size > tableBuffer.size()) {
+            tableBuffer.resize(size);
+        }
+        auto* table = tableBuffer.empty() ? nullptr : reinterpret_cast<MIB_IPNETTABLE*>(tableBuffer.data());
+        result = GetIpNetTable(table, &size, FALSE);
+    }
+    if (result != NO_ERROR) {
+        return result == ERROR_NO_DATA;
+    }
+
+    auto* table = reinterpret_cast<MIB_IPNETTABLE*>(tableBuffer.data());
+    for (DWORD i = 0; i < table->dwNumEntries; i++) {
+        const MIB_IPNETROW& row = table->table[i];
+        if (row.dwType != MIB_IPNET_TYPE_DYNAMIC && row.dwType != MIB_IPNET_TYPE_STATIC) continue;
+        if (row.dwPhysAddrLen != 6) continue;
+
+        ScanRecord record;
+        record.mac = MacAddress::fromBytes(row.bPhysAddr);
+        if (record.mac.isZero() || record.mac.isMulticast()) continue;
+
+        struct in_addr addr;
+        addr.s_addr = row.dwAddr;
+        inet_ntop(AF_INET, &addr, record.ipAddress, sizeof(record.ipAddress));
+        record.rssi = -50; // Simulated signal strength
+
+        records.push_back(record);
+    }
+
+    return true;
+}
+#endif
+
+#ifdef __APPLE__
+bool MacOSCoreWlanBackend::scan(std::vector<ScanRecord>& records) {
+    @autoreleasepool {
+        CWWiFiClient* wifiClient = [CWWiFiClient sharedWiFiClient];
+        CWInterface* interface = [wifiClient interface];
+        if (!interface) return false;
+
+        NSError* error = nil;
+        NSSet<CWNetwork*>* networks = [interface scanForNetworksWithName:nil error:&error];
+        if (!networks) return false;
+
+        for (CWNetwork* network in networks) {
+            NSString* bssid = [network bssid];
+            if (!bssid) continue; // BSSIDs are hidden without location permission
+
+            ScanRecord record;
+            if (!MacAddress::parse([bssid UTF8String], record.mac)) continue;
+            record.rssi = static_cast<int>([network rssiValue]);
+
+            records.push_back(record);
+        }
+    }
+
+    return true;
+}
+#endif
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+bool LinuxNetlinkBackend::scan(std::vector<ScanRecord>& records) {
+    if (!neighbors.dump(entries)) {
+        return false;
+    }
+
+    // IPv6 entries first so a device's IPv4 address wins when the scanner merges records
+    std::stable_partition(entries.begin(), entries.end(),
+                          [](const NeighborEntry& entry) { return entry.family == AF_INET6; });
+    appendRecords(records, false);
+    return true;
+}
+
+bool LinuxNetlinkBackend::waitForEvents(int timeoutMs, std::vector<ScanRecord>& records) {
+    if (!neighbors.subscribe()) {
+        return ScanBackend::waitForEvents(timeoutMs, records);
+    }
+
+    entries.clear();
+    bool inSync = neighbors.waitForEvents(timeoutMs, entries);
+    appendRecords(records, true);
+    return inSync;
+}
+
+void LinuxNetlinkBackend::appendRecords(std::vector<ScanRecord>& records, bool includeRemoved) {
+    for (const auto& entry : entries) {
+        if (entry.mac.isMulticast()) continue;
+
+        bool reachable = entry.isReachable();
+        if (!reachable && !includeRemoved) continue;
+
+        ScanRecord record;
+        record.mac = entry.mac;
+        entry.formatAddress(record.ipAddress);
+        record.rssi = -50; // Simulated signal strength
+        record.removed = !reachable;
+
+        records.push_back(record);
+    }
+}
+#endif
+
+SubnetFilterBackend::SubnetFilterBackend(std::unique_ptr<ScanBackend> innerBackend, uint32_t subnet,
+                                         uint32_t prefixLength)
+    : inner(std::move(innerBackend)),
+      mask(prefixLength == 0 ? 0 : ~0u << (32 - std::min(prefixLength, 32u))) {
+    network = subnet & mask;
+}
+
+bool SubnetFilterBackend::scan(std::vector<ScanRecord>& records) {
+    staging.clear();
+    bool ok = inner->scan(staging);
+    appendMatching(records);
+    return ok;
+}
+
+bool SubnetFilterBackend::waitForEvents(int timeoutMs, std::vector<ScanRecord>& records) {
+    staging.clear();
+    bool inSync = inner->waitForEvents(timeoutMs, staging);
+    appendMatching(records);
+    return inSync;
+}
+
+bool SubnetFilterBackend::contains(const ScanRecord& record) const {
+    uint32_t address;
+    return record.ipv4Address(address) && (address & mask) == network;
+}
+
+void SubnetFilterBackend::appendMatching(std::vector<ScanRecord>& records) const {
+    for (const auto& record : staging) {
+        if (contains(record)) {
+            records.push_back(record);
+        }
+    }
+}
+
+bool SyntheticBackend::scan(std::vector<ScanRecord>& out) {
+    std::lock_guard<std::mutex> lock(recordsMutex);
+    out.insert(out.end(), records.begin(), records.end());
+    return true;
+}
+
+void SyntheticBackend::setRecords(std::vector<ScanRecord> newRecords) {
+    std::lock_guard<std::mutex> lock(recordsMutex);
+    records = std::move(newRecords);
+}
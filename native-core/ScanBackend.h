@@ -0,0 +1,123 @@
+#pragma once
+
+#include "MacAddress.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include "NetlinkNeighbors.h"
+#endif
+
+// One observation of a device by a scan backend. Fixed-size so a scan
+// appends into a reused buffer without touching the heap.
+struct ScanRecord {
+    static constexpr size_t kAddressLength = 46; // INET6_ADDRSTRLEN
+
+    MacAddress mac;
+    char ipAddress[kAddressLength]; // empty when the backend doesn't know it
+    int rssi;
+    bool removed; // event backends only: the device left the network
+
+    ScanRecord() : ipAddress{}, rssi(-100), removed(false) {}
+    void setAddress(const std::string& address);
+    // Dotted-quad address in host byte order; false for IPv6 or no address
+    bool ipv4Address(uint32_t& address) const;
+};
+
+// A source of devices. NetworkScanner drives one or more backends; each scan
+// appends records to the buffer it is given and never clears it.
+class ScanBackend {
+public:
+    virtual ~ScanBackend() = default;
+
+    virtual const char* name() const = 0;
+
+    // Appends the backend's current view of the network. Returns false on failure.
+    virtual bool scan(std::vector<ScanRecord>& records) = 0;
+
+    // Backends that can push changes report them between full scans
+    virtual bool supportsEvents() const { return false; }
+
+    // Waits up to timeoutMs and appends change records. Returns false when
+    // events were lost and the scanner should run a full scan.
+    virtual bool waitForEvents(int timeoutMs, std::vector<ScanRecord>& records);
+};
+
+// The native backend for the platform we were built for
+std::unique_ptr<ScanBackend> createPlatformBackend();
+
+#ifdef _WIN32
+// ARP cache through the IP Helper API (GetIpNetTable)
+class WindowsIpHelperBackend : public ScanBackend {
+public:
+    const char* name() const override { return "windows-iphlpapi"; }
+    bool scan(std::vector<ScanRecord>& records) override;
+
+private:
+    std::vector<unsigned char> tableBuffer;
+};
+#elif __APPLE__
+// Nearby access points from a CoreWLAN scan (BSSID and RSSI)
+class MacOSCoreWlanBackend : public ScanBackend {
+public:
+    const char* name() const override { return "macos-corewlan"; }
+    bool scan(std::vector<ScanRecord>& records) override;
+};
+#else
+// Kernel neighbour table over rtnetlink, with change notifications
+class LinuxNetlinkBackend : public ScanBackend {
+public:
+    const char* name() const override { return "linux-netlink"; }
+    bool scan(std::vector<ScanRecord>& records) override;
+    bool supportsEvents() const override { return true; }
+    bool waitForEvents(int timeoutMs, std::vector<ScanRecord>& records) override;
+
+private:
+    NetlinkNeighbors neighbors;
+    std::vector<NeighborEntry> entries;
+
+    void appendRecords(std::vector<ScanRecord>& records, bool includeRemoved);
+};
+#endif
+
+// Passes on only the records of another backend whose IPv4 address lies in
+// one subnet, so several scanners can split a network between them. Records
+// without an IPv4 address are dropped.
+class SubnetFilterBackend : public ScanBackend {
+public:
+    // network in host byte order; prefix length 0 passes every IPv4 record
+    SubnetFilterBackend(std::unique_ptr<ScanBackend> inner, uint32_t network, uint32_t prefixLength);
+
+    const char* name() const override { return inner->name(); }
+    bool scan(std::vector<ScanRecord>& records) override;
+    bool supportsEvents() const override { return inner->supportsEvents(); }
+    bool waitForEvents(int timeoutMs, std::vector<ScanRecord>& records) override;
+
+    bool contains(const ScanRecord& record) const;
+
+private:
+    std::unique_ptr<ScanBackend> inner;
+    uint32_t network;
+    uint32_t mask;
+    std::vector<ScanRecord> staging; // inner's records before filtering, reused
+
+    void appendMatching(std::vector<ScanRecord>& records) const;
+};
+
+// Serves a fixed, caller-supplied device list. Used by tests and benchmarks
+// to drive the real scanner without touching the network.
+class SyntheticBackend : public ScanBackend {
+public:
+    const char* name() const override { return "synthetic"; }
+    bool scan(std::vector<ScanRecord>& records) override;
+
+    // Thread-safe; takes effect on the next scan
+    void setRecords(std::vector<ScanRecord> newRecords);
+
+private:
+    std::mutex recordsMutex;
+    std::vector<ScanRecord> records;
+};
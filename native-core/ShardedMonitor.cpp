@@ -0,0 +1,114 @@
+#include "ShardedMonitor.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+
+ShardedMonitor::~ShardedMonitor() {
+    stopMonitoring();
+}
+
+size_t ShardedMonitor::addShard(const std::string& name, std::unique_ptr<NetworkScanner> scanner) {
+    shards.push_back({name, std::make_unique<SmartBlueprintCore>(std::move(scanner))});
+    return shards.size() - 1;
+}
+
+size_t ShardedMonitor::addSubnetShard(const SubnetSweeper::Subnet& subnet) {
+    std::string name = SubnetSweeper::formatAddress(subnet.network) + "/" + std::to_string(subnet.prefixLength);
+    if (!subnet.interfaceName.empty()) {
+        name = subnet.interfaceName + " " + name;
+    }
+    auto backend = std::make_unique<SubnetFilterBackend>(createPlatformBackend(), subnet.network, subnet.prefixLength);
+    return addShard(name, std::make_unique<NetworkScanner>(std::move(backend)));
+}
+
+size_t ShardedMonitor::addLocalSubnetShards() {
+    auto subnets = SubnetSweeper::enumerateSubnets();
+    for (const auto& subnet : subnets) {
+        addSubnetShard(subnet);
+    }
+    return subnets.size();
+}
+
+void ShardedMonitor::startMonitoring() {
+    // Each core schedules its own cycles, so shards never wait for each other
+    for (auto& shard : shards) {
+        shard.core->startMonitoring();
+    }
+}
+
+void ShardedMonitor::stopMonitoring() {
+    for (auto& shard : shards) {
+        shard.core->stopMonitoring();
+    }
+}
+
+bool ShardedMonitor::isMonitoring() const {
+    return std::any_of(shards.begin(), shards.end(), [](const Shard& shard) { return shard.core->isMonitoring(); });
+}
+
+void ShardedMonitor::performScan() {
+    TaskScheduler::shared().parallelFor(TaskPriority::Pipeline, shards.size(),
+                                        [this](size_t i) { shards[i].core->performScan(); });
+}
+
+void ShardedMonitor::runMonitoringCycle(bool fullPass) {
+    TaskScheduler::shared().parallelFor(TaskPriority::Interactive, shards.size(),
+                                        [this, fullPass](size_t i) { shards[i].core->runMonitoringCycle(fullPass); });
+}
+
+std::shared_ptr<const ShardedSnapshot> ShardedMonitor::getSnapshot() const {
+    std::lock_guard<std::mutex> lock(mergeMutex);
+
+    shardSnapshots.clear();
+    bool changed = !merged || merged->shardVersions.size() != shards.size();
+    for (size_t i = 0; i < shards.size(); ++i) {
+        shardSnapshots.push_back(shards[i].core->getSnapshot());
+        changed = changed || merged->shardVersions[i] != shardSnapshots[i]->version;
+    }
+    if (!changed) {
+        shardSnapshots.clear();
+        return merged;
+    }
+
+    auto next = std::make_shared<ShardedSnapshot>();
+    size_t deviceCount = 0;
+    size_t anomalyCount = 0;
+    for (const auto& snapshot : shardSnapshots) {
+        deviceCount += snapshot->devices.size();
+        anomalyCount += snapshot->anomalies.size();
+    }
+    next->devices.reserve(deviceCount);
+    next->deviceShards.reserve(deviceCount);
+    next->anomalies.reserve(anomalyCount);
+    next->shardVersions.reserve(shardSnapshots.size());
+
+    for (size_t i = 0; i < shardSnapshots.size(); ++i) {
+        const DeviceSnapshot& snapshot = *shardSnapshots[i];
+        next->version += snapshot.version;
+        next->publishedAt = std::max(next->publishedAt, snapshot.publishedAt);
+        next->devices.insert(next->devices.end(), snapshot.devices.begin(), snapshot.devices.end());
+        next->deviceShards.insert(next->deviceShards.end(), snapshot.devices.size(), static_cast<uint32_t>(i));
+        next->anomalies.insert(next->anomalies.end(), snapshot.anomalies.begin(), snapshot.anomalies.end());
+        next->shardVersions.push_back(snapshot.version);
+    }
+
+    // Drop our references so the shards can recycle their snapshots
+    shardSnapshots.clear();
+    merged = std::move(next);
+    return merged;
+}
+
+uint64_t ShardedMonitor::getSnapshotVersion() const {
+    uint64_t version = 0;
+    for (const auto& shard : shards) {
+        version += shard.core->getSnapshotVersion();
+    }
+    return version;
+}
+
+std::vector<std::shared_ptr<NetworkDevice>> ShardedMonitor::getCurrentDevices() const {
+    return getSnapshot()->devices;
+}
+
+std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>> ShardedMonitor::detectAnomalies() const {
+    return getSnapshot()->anomalies;
+}
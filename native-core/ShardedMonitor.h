@@ -0,0 +1,73 @@
+#pragma once
+
+#include "SmartBlueprintCore.h"
+#include "SubnetSweeper.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// A merged view over every shard. devices and anomalies are the shards'
+// lists back to back, in shard order; deviceShards[i] is the shard that
+// owns devices[i]. Device IDs are only unique within a shard.
+struct ShardedSnapshot : DeviceSnapshot {
+    std::vector<uint32_t> deviceShards;
+    std::vector<uint64_t> shardVersions; // each shard's snapshot version when merged
+};
+
+// Monitors several networks (VLANs, interfaces, subnets) from one process.
+// Each shard is a complete SmartBlueprintCore with its own scanner, device
+// table, Kalman bank, anomaly forest and locks, so a large busy network
+// never delays cycles or scoring on a small one. All shards run on the
+// shared TaskScheduler; cross-shard queries read a merged snapshot that is
+// rebuilt only when some shard has published since the last merge.
+class ShardedMonitor {
+public:
+    ShardedMonitor() = default;
+    ~ShardedMonitor();
+
+    ShardedMonitor(const ShardedMonitor&) = delete;
+    ShardedMonitor& operator=(const ShardedMonitor&) = delete;
+
+    // Shards are added before startMonitoring(); each returns its index
+    size_t addShard(const std::string& name, std::unique_ptr<NetworkScanner> scanner);
+    // The platform backend, restricted to the hosts of one subnet
+    size_t addSubnetShard(const SubnetSweeper::Subnet& subnet);
+    // One subnet shard per interface subnet that is up; returns how many were added
+    size_t addLocalSubnetShards();
+
+    size_t shardCount() const { return shards.size(); }
+    const std::string& shardName(size_t index) const { return shards[index].name; }
+    // For per-shard setup (models, signal history, IPC) and queries
+    SmartBlueprintCore& shard(size_t index) { return *shards[index].core; }
+
+    void startMonitoring();
+    void stopMonitoring();
+    bool isMonitoring() const;
+
+    // Scans, or runs one cycle on, every shard in parallel on the shared
+    // scheduler and returns when all are done. runMonitoringCycle() is not
+    // for use while monitoring is running.
+    void performScan();
+    void runMonitoringCycle(bool fullPass = false);
+
+    std::shared_ptr<const ShardedSnapshot> getSnapshot() const;
+    // Sum of the shards' versions; changes whenever any shard publishes
+    uint64_t getSnapshotVersion() const;
+    std::vector<std::shared_ptr<NetworkDevice>> getCurrentDevices() const;
+    std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>> detectAnomalies() const;
+
+private:
+    struct Shard {
+        std::string name;
+        std::unique_ptr<SmartBlueprintCore> core;
+    };
+
+    std::vector<Shard> shards;
+
+    // Only merging takes this; shards publish without it
+    mutable std::mutex mergeMutex;
+    mutable std::shared_ptr<const ShardedSnapshot> merged;
+    mutable std::vector<std::shared_ptr<const DeviceSnapshot>> shardSnapshots; // scratch for merging
+};
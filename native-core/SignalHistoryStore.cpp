@@ -0,0 +1,492 @@
+#include "SignalHistoryStore.h"
+#include "Checksum.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const char kStoreMagic[4] = {'S', 'B', 'T', 'S'};
+constexpr uint32_t kStoreVersion = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+constexpr size_t kBlockSize = 256;
+constexpr uint16_t kNoRun = 0xFFFF;
+
+// Sample token layout. A byte with the top bit set repeats the previous
+// sample (same time delta, RSSI and flags) 1..127 times. Otherwise:
+//   bit 6     a new time delta follows as a varint
+//   bit 5     a new flags byte follows
+//   bits 0-4  zigzag RSSI delta in -15..15, or 31 when a raw int8 RSSI follows
+constexpr uint8_t kRunToken = 0x80;
+constexpr uint8_t kMaxRun = 0x7F;
+constexpr uint8_t kNewDelta = 0x40;
+constexpr uint8_t kNewFlags = 0x20;
+constexpr uint8_t kRssiMask = 0x1F;
+constexpr uint8_t kRawRssi = 0x1F;
+
+size_t writeVarint(uint8_t* out, uint32_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = static_cast<uint8_t>(value);
+    return length;
+}
+
+bool readVarint(const uint8_t*& cursor, const uint8_t* end, uint32_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 35 && cursor < end; shift += 7) {
+        uint8_t byte = *cursor++;
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+struct SignalHistoryStore::FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t deviceSlots;
+    uint32_t blocksPerDevice;
+    uint32_t blockSize;
+    uint32_t reserved;
+    uint32_t checksum; // of the fields above
+};
+
+struct SignalHistoryStore::SlotHeader {
+    uint64_t mac; // 0 for a free slot
+    int64_t lastTimestamp;
+    uint64_t totalSamples;
+    uint32_t headBlock; // block currently being appended to
+    uint32_t nextSequence;
+};
+
+struct SignalHistoryStore::BlockHeader {
+    int64_t firstTimestamp;
+    int64_t lastTimestamp;
+    uint32_t lastDelta;
+    uint32_t sequence;
+    uint16_t sampleCount; // 0 for an unused block
+    uint16_t usedBytes;
+    uint16_t runOffset;   // payload offset of a run token that can still grow
+    int8_t firstRssi;
+    uint8_t firstFlags;
+    int8_t lastRssi;
+    uint8_t lastFlags;
+    uint8_t reserved[6];
+};
+
+namespace {
+
+constexpr size_t kPayloadSize = kBlockSize - 40;
+
+size_t storeSize(uint32_t deviceSlots, uint32_t blocksPerDevice, size_t headerSize, size_t slotSize) {
+    return headerSize + static_cast<size_t>(deviceSlots) * slotSize +
+           static_cast<size_t>(deviceSlots) * blocksPerDevice * kBlockSize;
+}
+
+} // namespace
+
+SignalHistoryStore::SignalHistoryStore() : header(nullptr), slots(nullptr), blocks(nullptr) {
+    static_assert(sizeof(BlockHeader) == kBlockSize - kPayloadSize, "Block header layout changed");
+    static_assert(sizeof(SlotHeader) % 8 == 0 && sizeof(FileHeader) % 8 == 0, "Headers must keep 8-byte alignment");
+}
+
+SignalHistoryStore::~SignalHistoryStore() {
+    close();
+}
+
+bool SignalHistoryStore::open(const std::string& path, const Options& options) {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    closeMapping();
+    return initialise(path, options);
+}
+
+bool SignalHistoryStore::initialise(const std::string& path, const Options& options) {
+    uint32_t deviceSlots = std::max<uint32_t>(1, options.deviceSlots);
+    uint32_t blocksPerDevice = std::max<uint32_t>(2, options.blocksPerDevice);
+    bool reuse = false;
+    bool existed = false;
+
+    {
+        // An existing store keeps its layout, whatever the options say
+        MappedFile existing;
+        if (existing.open(path)) {
+            existed = true;
+            FileHeader stored;
+            if (existing.size() >= sizeof(FileHeader)) {
+                std::memcpy(&stored, existing.data(), sizeof(stored));
+                reuse = std::memcmp(stored.magic, kStoreMagic, sizeof(kStoreMagic)) == 0 &&
+                        stored.version == kStoreVersion && stored.byteOrder == kByteOrderMark &&
+                        stored.blockSize == kBlockSize && stored.deviceSlots > 0 && stored.blocksPerDevice > 1 &&
+                        stored.checksum == crc32(&stored, offsetof(FileHeader, checksum)) &&
+                        existing.size() == storeSize(stored.deviceSlots, stored.blocksPerDevice,
+                                                     sizeof(FileHeader), sizeof(SlotHeader));
+            }
+            if (reuse) {
+                deviceSlots = stored.deviceSlots;
+                blocksPerDevice = stored.blocksPerDevice;
+            }
+        }
+    }
+    if (existed && !reuse) {
+        std::cerr << "Signal history " << path << " is unreadable, starting a new one" << std::endl;
+    }
+
+    size_t size = storeSize(deviceSlots, blocksPerDevice, sizeof(FileHeader), sizeof(SlotHeader));
+    if (!mapping.openWritable(path, size)) {
+        std::cerr << "Failed to map signal history " << path << std::endl;
+        return false;
+    }
+
+    uint8_t* base = mapping.mutableData();
+    header = reinterpret_cast<FileHeader*>(base);
+    slots = reinterpret_cast<SlotHeader*>(base + sizeof(FileHeader));
+    blocks = base + sizeof(FileHeader) + static_cast<size_t>(deviceSlots) * sizeof(SlotHeader);
+
+    if (!reuse) {
+        std::memset(base, 0, size);
+        std::memcpy(header->magic, kStoreMagic, sizeof(kStoreMagic));
+        header->version = kStoreVersion;
+        header->byteOrder = kByteOrderMark;
+        header->deviceSlots = deviceSlots;
+        header->blocksPerDevice = blocksPerDevice;
+        header->blockSize = kBlockSize;
+        header->checksum = crc32(header, offsetof(FileHeader, checksum));
+    }
+
+    // The header checksum doesn't cover slots or blocks, so a torn write or a
+    // damaged file could still point the ring past its end; such a device
+    // loses its history rather than taking the store down
+    slotIndex.reserve(deviceSlots);
+    size_t discarded = 0;
+    for (uint32_t slot = 0; slot < deviceSlots; ++slot) {
+        if (slots[slot].mac == 0) continue;
+        if (!slotIsIntact(slot) || slotIndex.count(slots[slot].mac)) {
+            std::memset(&slots[slot], 0, sizeof(SlotHeader));
+            std::memset(blockAt(slot, 0), 0, static_cast<size_t>(blocksPerDevice) * kBlockSize);
+            discarded++;
+            continue;
+        }
+        slotIndex[slots[slot].mac] = slot;
+    }
+    if (discarded > 0) {
+        std::cerr << "Signal history " << path << ": discarded " << discarded << " damaged device histories"
+                  << std::endl;
+    }
+    return true;
+}
+
+bool SignalHistoryStore::slotIsIntact(uint32_t slot) const {
+    if (slots[slot].headBlock >= header->blocksPerDevice) return false;
+    for (uint32_t block = 0; block < header->blocksPerDevice; ++block) {
+        const BlockHeader* blockHeader = blockAt(slot, block);
+        if (blockHeader->sampleCount == 0) continue;
+        if (blockHeader->usedBytes > kPayloadSize) return false;
+        if (blockHeader->runOffset != kNoRun && blockHeader->runOffset >= blockHeader->usedBytes) return false;
+    }
+    return true;
+}
+
+void SignalHistoryStore::close() {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    closeMapping();
+}
+
+void SignalHistoryStore::closeMapping() {
+    if (!header) return;
+
+    mapping.flush();
+    mapping.close();
+    header = nullptr;
+    slots = nullptr;
+    blocks = nullptr;
+    slotIndex.clear();
+}
+
+bool SignalHistoryStore::flush() {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    return header && mapping.flush();
+}
+
+SignalHistoryStore::BlockHeader* SignalHistoryStore::blockAt(uint32_t slot, uint32_t block) const {
+    size_t index = static_cast<size_t>(slot) * header->blocksPerDevice + block;
+    return reinterpret_cast<BlockHeader*>(blocks + index * kBlockSize);
+}
+
+uint8_t* SignalHistoryStore::payloadOf(BlockHeader* block) const {
+    return reinterpret_cast<uint8_t*>(block) + sizeof(BlockHeader);
+}
+
+uint32_t SignalHistoryStore::slotFor(MacAddress mac) {
+    auto it = slotIndex.find(mac.toUint64());
+    if (it != slotIndex.end()) return it->second;
+
+    // Take a free slot, or recycle the one that has been quiet the longest
+    uint32_t chosen = 0;
+    bool found = false;
+    for (uint32_t slot = 0; slot < header->deviceSlots; ++slot) {
+        if (slots[slot].mac == 0) {
+            chosen = slot;
+            found = true;
+            break;
+        }
+        if (slots[slot].lastTimestamp < slots[chosen].lastTimestamp) {
+            chosen = slot;
+        }
+    }
+    if (!found) {
+        slotIndex.erase(slots[chosen].mac);
+        std::memset(blockAt(chosen, 0), 0, static_cast<size_t>(header->blocksPerDevice) * kBlockSize);
+    }
+
+    SlotHeader& slot = slots[chosen];
+    std::memset(&slot, 0, sizeof(slot));
+    slot.mac = mac.toUint64();
+    slotIndex[slot.mac] = chosen;
+    return chosen;
+}
+
+void SignalHistoryStore::startBlock(BlockHeader* block, uint32_t slot, int64_t timestamp, int8_t rssi, uint8_t flags) {
+    std::memset(block, 0, sizeof(BlockHeader));
+    block->firstTimestamp = timestamp;
+    block->lastTimestamp = timestamp;
+    block->sequence = ++slots[slot].nextSequence;
+    block->sampleCount = 1;
+    block->runOffset = kNoRun;
+    block->firstRssi = rssi;
+    block->firstFlags = flags;
+    block->lastRssi = rssi;
+    block->lastFlags = flags;
+}
+
+bool SignalHistoryStore::append(MacAddress mac, int64_t timestamp, int rssi, uint8_t flags) {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    if (!header || mac.isZero()) return false;
+
+    int8_t value = static_cast<int8_t>(std::min(127, std::max(-128, rssi)));
+    uint32_t slotId = slotFor(mac);
+    SlotHeader& slot = slots[slotId];
+    BlockHeader* block = blockAt(slotId, slot.headBlock);
+
+    bool stored = false;
+    if (block->sampleCount > 0 && block->sampleCount < UINT16_MAX) {
+        int64_t elapsed = std::max<int64_t>(0, timestamp - block->lastTimestamp);
+        bool fitsDelta = elapsed <= static_cast<int64_t>(UINT32_MAX);
+        uint32_t delta = static_cast<uint32_t>(elapsed);
+        uint8_t* payload = payloadOf(block);
+
+        if (!fitsDelta) {
+            // Gap too long to encode; start a fresh block
+        } else if (delta == block->lastDelta && value == block->lastRssi && flags == block->lastFlags) {
+            if (block->runOffset != kNoRun && (payload[block->runOffset] & kMaxRun) < kMaxRun) {
+                payload[block->runOffset]++;
+                stored = true;
+            } else if (block->usedBytes < kPayloadSize) {
+                block->runOffset = block->usedBytes;
+                payload[block->usedBytes++] = kRunToken | 1;
+                stored = true;
+            }
+        } else {
+            uint8_t encoded[8];
+            size_t length = 1;
+            uint8_t token = 0;
+            if (delta != block->lastDelta) {
+                token |= kNewDelta;
+                length += writeVarint(encoded + length, delta);
+            }
+            if (flags != block->lastFlags) {
+                token |= kNewFlags;
+                encoded[length++] = flags;
+            }
+            int change = value - block->lastRssi;
+            if (change >= -15 && change <= 15) {
+                token |= static_cast<uint8_t>((change << 1) ^ (change >> 31));
+            } else {
+                token |= kRawRssi;
+                encoded[length++] = static_cast<uint8_t>(value);
+            }
+            encoded[0] = token;
+
+            if (block->usedBytes + length <= kPayloadSize) {
+                std::memcpy(payload + block->usedBytes, encoded, length);
+                block->usedBytes = static_cast<uint16_t>(block->usedBytes + length);
+                block->runOffset = kNoRun;
+                stored = true;
+            }
+        }
+
+        if (stored) {
+            block->lastTimestamp += delta;
+            block->lastDelta = delta;
+            block->lastRssi = value;
+            block->lastFlags = flags;
+            block->sampleCount++;
+        }
+    }
+
+    if (!stored) {
+        // Move on to the next block in the ring, overwriting the oldest one
+        if (block->sampleCount > 0) {
+            slot.headBlock = (slot.headBlock + 1) % header->blocksPerDevice;
+            block = blockAt(slotId, slot.headBlock);
+        }
+        startBlock(block, slotId, std::max(timestamp, slot.lastTimestamp), value, flags);
+    }
+
+    slot.lastTimestamp = block->lastTimestamp;
+    slot.totalSamples++;
+    return true;
+}
+
+SignalHistoryStore::Cursor SignalHistoryStore::makeCursor(MacAddress mac, int64_t since) const {
+    Cursor cursor;
+    if (!header) return cursor;
+
+    auto it = slotIndex.find(mac.toUint64());
+    if (it == slotIndex.end()) return cursor;
+
+    cursor.store = this;
+    cursor.slot = it->second;
+    cursor.block = (slots[it->second].headBlock + 1) % header->blocksPerDevice; // oldest
+    cursor.blocksLeft = header->blocksPerDevice;
+    cursor.since = since;
+    return cursor;
+}
+
+bool SignalHistoryStore::Cursor::enterBlock() {
+    while (blocksLeft > 0) {
+        BlockHeader* blockHeader = store->blockAt(slot, block);
+        block = (block + 1) % store->header->blocksPerDevice;
+        blocksLeft--;
+        if (blockHeader->sampleCount == 0 || blockHeader->lastTimestamp < since) continue;
+
+        cursor = store->payloadOf(blockHeader);
+        end = cursor + std::min<size_t>(blockHeader->usedBytes, kPayloadSize);
+        firstPending = true;
+        runLeft = 0;
+        lastDelta = 0;
+        current.timestamp = blockHeader->firstTimestamp;
+        current.rssi = blockHeader->firstRssi;
+        current.flags = blockHeader->firstFlags;
+        return true;
+    }
+    return false;
+}
+
+bool SignalHistoryStore::Cursor::decodeNext() {
+    if (firstPending) {
+        firstPending = false;
+        return true;
+    }
+    if (runLeft > 0) {
+        runLeft--;
+        current.timestamp += lastDelta;
+        return true;
+    }
+    if (cursor >= end) return false;
+
+    uint8_t token = *cursor++;
+    if (token & kRunToken) {
+        runLeft = (token & kMaxRun) - 1u;
+        current.timestamp += lastDelta;
+        return true;
+    }
+    if ((token & kNewDelta) && !readVarint(cursor, end, lastDelta)) return false;
+    if (token & kNewFlags) {
+        if (cursor >= end) return false;
+        current.flags = *cursor++;
+    }
+    uint8_t zigzag = token & kRssiMask;
+    if (zigzag == kRawRssi) {
+        if (cursor >= end) return false;
+        current.rssi = static_cast<int8_t>(*cursor++);
+    } else {
+        int change = static_cast<int>(zigzag >> 1) ^ -static_cast<int>(zigzag & 1);
+        current.rssi = static_cast<int8_t>(current.rssi + change);
+    }
+    current.timestamp += lastDelta;
+    return true;
+}
+
+bool SignalHistoryStore::Cursor::next(Sample& sample) {
+    while (store) {
+        if (cursor && decodeNext()) {
+            if (current.timestamp < since) continue;
+            sample = current;
+            return true;
+        }
+        cursor = nullptr;
+        if (!enterBlock()) {
+            store = nullptr;
+        }
+    }
+    return false;
+}
+
+size_t SignalHistoryStore::sampleCount(MacAddress mac) const {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    if (!header) return 0;
+
+    auto it = slotIndex.find(mac.toUint64());
+    if (it == slotIndex.end()) return 0;
+
+    size_t count = 0;
+    for (uint32_t block = 0; block < header->blocksPerDevice; ++block) {
+        count += blockAt(it->second, block)->sampleCount;
+    }
+    return count;
+}
+
+size_t SignalHistoryStore::readSamples(MacAddress mac, float* rssi, int64_t* timestamps, size_t capacity,
+                                       int64_t since) const {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    if (capacity == 0) return 0;
+
+    // Decoding is cheap, so count first and skip to the newest `capacity` samples
+    size_t available = 0;
+    Sample sample;
+    for (Cursor cursor = makeCursor(mac, since); cursor.next(sample);) {
+        available++;
+    }
+    size_t skip = available > capacity ? available - capacity : 0;
+
+    size_t copied = 0;
+    for (Cursor cursor = makeCursor(mac, since); cursor.next(sample);) {
+        if (skip > 0) {
+            skip--;
+            continue;
+        }
+        if (rssi) rssi[copied] = sample.rssi;
+        if (timestamps) timestamps[copied] = sample.timestamp;
+        copied++;
+    }
+    return copied;
+}
+
+size_t SignalHistoryStore::deviceCount() const {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    return slotIndex.size();
+}
+
+size_t SignalHistoryStore::bytesUsed() const {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    if (!header) return 0;
+
+    size_t bytes = 0;
+    for (const auto& entry : slotIndex) {
+        for (uint32_t block = 0; block < header->blocksPerDevice; ++block) {
+            const BlockHeader* blockHeader = blockAt(entry.second, block);
+            if (blockHeader->sampleCount > 0) {
+                bytes += sizeof(BlockHeader) + blockHeader->usedBytes;
+            }
+        }
+    }
+    return bytes;
+}
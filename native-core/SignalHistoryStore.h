@@ -0,0 +1,127 @@
+#pragma once
+
+#include "MacAddress.h"
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Persistent per-device RSSI history in one memory-mapped file.
+//
+// Every device owns a fixed-size segment of blocks used as a ring: when the
+// newest block fills up, the oldest one is overwritten. Inside a block each
+// sample is stored relative to the previous one (time delta, RSSI delta,
+// flags) in one byte in the common case, and repeats of the previous
+// sample collapse into run bytes covering up to 127 samples, so a stable
+// device scanned every 5 seconds costs a few bytes per hour.
+//
+// Reopening the file maps it and rebuilds only the MAC-to-slot index, so
+// history is available immediately at startup. Readers decode straight from
+// the mapping into caller-provided buffers.
+class SignalHistoryStore {
+public:
+    struct Options {
+        uint32_t deviceSlots = 1024;    // devices tracked; the least recently seen is evicted when full
+        uint32_t blocksPerDevice = 16;  // ring length; 16 blocks of 256 bytes is 4 KiB per device
+    };
+
+    enum SampleFlags : uint8_t {
+        kSampleOnline = 1 << 0,
+    };
+
+    struct Sample {
+        int64_t timestamp; // seconds since the Unix epoch
+        int8_t rssi;       // dBm
+        uint8_t flags;     // SampleFlags
+    };
+
+    // Iterates one device's samples oldest first, decoding in place from the
+    // mapping. Invalidated by any append to the store.
+    class Cursor {
+    public:
+        bool next(Sample& sample);
+
+    private:
+        friend class SignalHistoryStore;
+
+        const SignalHistoryStore* store = nullptr;
+        uint32_t slot = 0;
+        uint32_t blocksLeft = 0;
+        uint32_t block = 0;
+        int64_t since = 0;
+
+        const uint8_t* cursor = nullptr;
+        const uint8_t* end = nullptr;
+        bool firstPending = false;
+        uint32_t runLeft = 0;
+        Sample current{};
+        uint32_t lastDelta = 0;
+
+        bool decodeNext();
+        bool enterBlock();
+    };
+
+    SignalHistoryStore();
+    ~SignalHistoryStore();
+
+    SignalHistoryStore(const SignalHistoryStore&) = delete;
+    SignalHistoryStore& operator=(const SignalHistoryStore&) = delete;
+
+    // Opens or creates the store. An existing valid file keeps its own layout
+    // and history; an unreadable one is reinitialised with the given options.
+    bool open(const std::string& path, const Options& options);
+    bool open(const std::string& path) { return open(path, Options()); }
+    void close();
+    bool flush();
+    bool isOpen() const { return header != nullptr; }
+
+    // Samples older than the device's newest one are stored with a zero time delta
+    bool append(MacAddress mac, int64_t timestamp, int rssi, uint8_t flags);
+
+    size_t sampleCount(MacAddress mac) const;
+
+    // Copies the most recent samples at or after since (oldest first) into
+    // the caller's buffers, which may be null. Returns the number copied.
+    size_t readSamples(MacAddress mac, float* rssi, int64_t* timestamps, size_t capacity,
+                       int64_t since = std::numeric_limits<int64_t>::min()) const;
+
+    // Visits samples oldest first without copying; f(const Sample&) must not
+    // call back into the store
+    template <typename F>
+    void forEachSample(MacAddress mac, int64_t since, F&& f) const {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        Cursor cursor = makeCursor(mac, since);
+        Sample sample;
+        while (cursor.next(sample)) {
+            f(sample);
+        }
+    }
+
+    size_t deviceCount() const;
+    size_t fileSize() const { return mapping.size(); }
+    size_t bytesUsed() const;
+
+private:
+    struct FileHeader;
+    struct SlotHeader;
+    struct BlockHeader;
+
+    mutable std::mutex storeMutex;
+    MappedFile mapping;
+    FileHeader* header;
+    SlotHeader* slots;
+    uint8_t* blocks;
+    std::unordered_map<uint64_t, uint32_t> slotIndex;
+
+    void closeMapping();
+    bool initialise(const std::string& path, const Options& options);
+    bool slotIsIntact(uint32_t slot) const;
+    uint32_t slotFor(MacAddress mac);
+    BlockHeader* blockAt(uint32_t slot, uint32_t block) const;
+    uint8_t* payloadOf(BlockHeader* block) const;
+    void startBlock(BlockHeader* block, uint32_t slot, int64_t timestamp, int8_t rssi, uint8_t flags);
+    Cursor makeCursor(MacAddress mac, int64_t since) const;
+};
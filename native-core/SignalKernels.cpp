@@ -0,0 +1,714 @@
+#include "SignalKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SB_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SB_TARGET_SSE2
+#define SB_TARGET_AVX2
+#else
+#define SB_TARGET_SSE2 __attribute__((target("sse2")))
+#define SB_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define SB_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace SignalKernels {
+
+namespace {
+
+// Lane accumulators are flushed into a double after this many samples so
+// long histories do not lose precision in float partial sums.
+constexpr size_t kFlushBlock = 1024;
+
+// One access point's path-loss constants, in the form the kernels use
+struct DistanceModel {
+    float txPower;
+    float exponent;        // pathLossExponent, for ratios of 1 and above
+    float inverseExponent; // for ratios below 1
+    float scale;           // 1.5 * exponent - 0.96
+};
+
+// Cephes single-precision log and exp, shared by every SIMD path
+constexpr float kLogSqrtHalf = 0.707106781186547524f;
+constexpr float kLogP[9] = {7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f,
+                             -1.2420140846e-1f, 1.4249322787e-1f, -1.6668057665e-1f,
+                             2.0000714765e-1f, -2.4999993993e-1f, 3.3333331174e-1f};
+constexpr float kLn2High = 0.693359375f;    // ln 2 split so e * kLn2High is exact
+constexpr float kLn2Low = -2.12194440e-4f;
+constexpr float kExpLimit = 88.3762626647949f;
+constexpr float kLog2e = 1.44269504088896341f;
+constexpr float kExpP[6] = {1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f,
+                             4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f};
+
+struct KernelTable {
+    const char* name;
+    double (*sum)(const float* data, size_t n);
+    double (*sumSquaredDeviation)(const float* data, size_t n, float mean);
+    void (*minMax)(const float* data, size_t n, float& minValue, float& maxValue);
+    void (*ewma)(const float* in, size_t n, float alpha, float previous, float* out);
+    void (*distances)(const float* rssi, size_t n, const DistanceModel& model, float* out);
+    void (*qualityLevels)(const float* rssi, size_t n, uint8_t* out);
+};
+
+// Scalar reference implementation
+double sumScalar(const float* data, size_t n) {
+    double total = 0.0;
+    for (size_t i = 0; i < n; ++i) total += data[i];
+    return total;
+}
+
+double sumSquaredDeviationScalar(const float* data, size_t n, float mean) {
+    double total = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double d = data[i] - mean;
+        total += d * d;
+    }
+    return total;
+}
+
+void minMaxScalar(const float* data, size_t n, float& minValue, float& maxValue) {
+    for (size_t i = 0; i < n; ++i) {
+        minValue = std::min(minValue, data[i]);
+        maxValue = std::max(maxValue, data[i]);
+    }
+}
+
+void ewmaScalar(const float* in, size_t n, float alpha, float previous, float* out) {
+    float decay = 1.0f - alpha;
+    for (size_t i = 0; i < n; ++i) {
+        previous = alpha * in[i] + decay * previous;
+        out[i] = previous;
+    }
+}
+
+// The reference the SIMD approximations are measured against
+float distanceScalar(float rssi, const DistanceModel& model) {
+    if (rssi == 0.0f) return -1.0f;
+
+    double ratio = static_cast<double>(rssi) / model.txPower;
+    if (ratio < 1.0) {
+        return static_cast<float>(std::pow(ratio, 1.0 / model.exponent));
+    }
+    return static_cast<float>((1.5 * model.exponent - 0.96) * std::pow(ratio, static_cast<double>(model.exponent)) + 0.62);
+}
+
+void distancesScalar(const float* rssi, size_t n, const DistanceModel& model, float* out) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = distanceScalar(rssi[i], model);
+    }
+}
+
+void qualityLevelsScalar(const float* rssi, size_t n, uint8_t* out) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = static_cast<uint8_t>(signalQualityLevel(rssi[i]));
+    }
+}
+
+#ifdef SB_KERNELS_X86
+SB_TARGET_SSE2 double horizontalSum(__m128 v) {
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, v);
+    return static_cast<double>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+}
+
+SB_TARGET_SSE2 double sumSse2(const float* data, size_t n) {
+    double total = 0.0;
+    size_t i = 0;
+    while (i + 8 <= n) {
+        size_t blockEnd = std::min(n, i + kFlushBlock);
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        for (; i + 8 <= blockEnd; i += 8) {
+            acc0 = _mm_add_ps(acc0, _mm_loadu_ps(data + i));
+            acc1 = _mm_add_ps(acc1, _mm_loadu_ps(data + i + 4));
+        }
+        total += horizontalSum(_mm_add_ps(acc0, acc1));
+    }
+    return total + sumScalar(data + i, n - i);
+}
+
+SB_TARGET_SSE2 double sumSquaredDeviationSse2(const float* data, size_t n, float mean) {
+    double total = 0.0;
+    __m128 m = _mm_set1_ps(mean);
+    size_t i = 0;
+    while (i + 8 <= n) {
+        size_t blockEnd = std::min(n, i + kFlushBlock);
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        for (; i + 8 <= blockEnd; i += 8) {
+            __m128 d0 = _mm_sub_ps(_mm_loadu_ps(data + i), m);
+            __m128 d1 = _mm_sub_ps(_mm_loadu_ps(data + i + 4), m);
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(d0, d0));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(d1, d1));
+        }
+        total += horizontalSum(_mm_add_ps(acc0, acc1));
+    }
+    return total + sumSquaredDeviationScalar(data + i, n - i, mean);
+}
+
+SB_TARGET_SSE2 void minMaxSse2(const float* data, size_t n, float& minValue, float& maxValue) {
+    size_t i = 0;
+    if (n >= 4) {
+        __m128 lo = _mm_set1_ps(minValue);
+        __m128 hi = _mm_set1_ps(maxValue);
+        for (; i + 4 <= n; i += 4) {
+            __m128 v = _mm_loadu_ps(data + i);
+            lo = _mm_min_ps(lo, v);
+            hi = _mm_max_ps(hi, v);
+        }
+        alignas(16) float loLanes[4], hiLanes[4];
+        _mm_store_ps(loLanes, lo);
+        _mm_store_ps(hiLanes, hi);
+        minMaxScalar(loLanes, 4, minValue, maxValue);
+        minMaxScalar(hiLanes, 4, minValue, maxValue);
+    }
+    minMaxScalar(data + i, n - i, minValue, maxValue);
+}
+
+SB_TARGET_SSE2 void ewmaSse2(const float* in, size_t n, float alpha, float previous, float* out) {
+    // Within a block of 4: y[k] = sum_j a*b^(k-j)*x[j] + b^(k+1)*y[-1]
+    float b = 1.0f - alpha;
+    __m128 a = _mm_set1_ps(alpha);
+    __m128 b1 = _mm_set1_ps(b);
+    __m128 b2 = _mm_set1_ps(b * b);
+    __m128 carryWeights = _mm_setr_ps(b, b * b, b * b * b, b * b * b * b);
+    __m128 carry = _mm_set1_ps(previous);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_mul_ps(a, _mm_loadu_ps(in + i));
+        v = _mm_add_ps(v, _mm_mul_ps(b1, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4))));
+        v = _mm_add_ps(v, _mm_mul_ps(b2, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 8))));
+        v = _mm_add_ps(v, _mm_mul_ps(carryWeights, carry));
+        _mm_storeu_ps(out + i, v);
+        carry = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+
+    if (i < n) {
+        ewmaScalar(in + i, n - i, alpha, _mm_cvtss_f32(carry), out + i);
+    }
+}
+
+SB_TARGET_AVX2 double horizontalSum(__m256 v) {
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, v);
+    double total = 0.0;
+    for (float lane : lanes) total += lane;
+    return total;
+}
+
+SB_TARGET_AVX2 double sumAvx2(const float* data, size_t n) {
+    double total = 0.0;
+    size_t i = 0;
+    while (i + 16 <= n) {
+        size_t blockEnd = std::min(n, i + kFlushBlock);
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        for (; i + 16 <= blockEnd; i += 16) {
+            acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(data + i));
+            acc1 = _mm256_add_ps(acc1, _mm256_loadu_ps(data + i + 8));
+        }
+        total += horizontalSum(_mm256_add_ps(acc0, acc1));
+    }
+    return total + sumScalar(data + i, n - i);
+}
+
+SB_TARGET_AVX2 double sumSquaredDeviationAvx2(const float* data, size_t n, float mean) {
+    double total = 0.0;
+    __m256 m = _mm256_set1_ps(mean);
+    size_t i = 0;
+    while (i + 16 <= n) {
+        size_t blockEnd = std::min(n, i + kFlushBlock);
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        for (; i + 16 <= blockEnd; i += 16) {
+            __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(data + i), m);
+            __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(data + i + 8), m);
+            acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(d0, d0));
+            acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(d1, d1));
+        }
+        total += horizontalSum(_mm256_add_ps(acc0, acc1));
+    }
+    return total + sumSquaredDeviationScalar(data + i, n - i, mean);
+}
+
+SB_TARGET_AVX2 void minMaxAvx2(const float* data, size_t n, float& minValue, float& maxValue) {
+    size_t i = 0;
+    if (n >= 8) {
+        __m256 lo = _mm256_set1_ps(minValue);
+        __m256 hi = _mm256_set1_ps(maxValue);
+        for (; i + 8 <= n; i += 8) {
+            __m256 v = _mm256_loadu_ps(data + i);
+            lo = _mm256_min_ps(lo, v);
+            hi = _mm256_max_ps(hi, v);
+        }
+        alignas(32) float loLanes[8], hiLanes[8];
+        _mm256_store_ps(loLanes, lo);
+        _mm256_store_ps(hiLanes, hi);
+        minMaxScalar(loLanes, 8, minValue, maxValue);
+        minMaxScalar(hiLanes, 8, minValue, maxValue);
+    }
+    minMaxScalar(data + i, n - i, minValue, maxValue);
+}
+
+SB_TARGET_SSE2 __m128 selectSse2(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Natural log of positive lanes; zero and denormals read as the smallest normal
+SB_TARGET_SSE2 __m128 logSse2(__m128 x) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    x = _mm_max_ps(x, _mm_castsi128_ps(_mm_set1_epi32(0x00800000)));
+
+    // x = m * 2^e with m in [0.5, 1), then m moved to [sqrt(1/2), sqrt(2))
+    __m128i bits = _mm_castps_si128(x);
+    __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126)));
+    x = _mm_or_ps(_mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(0x007fffff))), _mm_set1_ps(0.5f));
+    __m128 small = _mm_cmplt_ps(x, _mm_set1_ps(kLogSqrtHalf));
+    e = _mm_sub_ps(e, _mm_and_ps(one, small));
+    x = _mm_add_ps(_mm_sub_ps(x, one), _mm_and_ps(x, small));
+
+    __m128 z = _mm_mul_ps(x, x);
+    __m128 y = _mm_set1_ps(kLogP[0]);
+    for (size_t i = 1; i < 9; ++i) {
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kLogP[i]));
+    }
+    y = _mm_mul_ps(_mm_mul_ps(y, x), z);
+    y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(kLn2Low)));
+    y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    return _mm_add_ps(_mm_add_ps(x, y), _mm_mul_ps(e, _mm_set1_ps(kLn2High)));
+}
+
+SB_TARGET_SSE2 __m128 expSse2(__m128 x) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-kExpLimit)), _mm_set1_ps(kExpLimit));
+
+    // x = n ln2 + r with |r| <= ln2 / 2; floor by truncating and correcting
+    __m128 fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(kLog2e)), _mm_set1_ps(0.5f));
+    __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+    fx = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, fx), one));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(kLn2High)));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(kLn2Low)));
+
+    __m128 z = _mm_mul_ps(x, x);
+    __m128 y = _mm_set1_ps(kExpP[0]);
+    for (size_t i = 1; i < 6; ++i) {
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kExpP[i]));
+    }
+    y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, z), x), one);
+
+    __m128i exponent = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(fx), _mm_set1_epi32(0x7f)), 23);
+    return _mm_mul_ps(y, _mm_castsi128_ps(exponent));
+}
+
+SB_TARGET_SSE2 void distancesSse2(const float* rssi, size_t n, const DistanceModel& model, float* out) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 txPower = _mm_set1_ps(model.txPower);
+    const __m128 exponent = _mm_set1_ps(model.exponent);
+    const __m128 inverseExponent = _mm_set1_ps(model.inverseExponent);
+    const __m128 scale = _mm_set1_ps(model.scale);
+    const __m128 offset = _mm_set1_ps(0.62f);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 r = _mm_loadu_ps(rssi + i);
+        // Dividing (not multiplying by 1/txPower) keeps rssi == txPower at exactly 1
+        __m128 ratio = _mm_div_ps(r, txPower);
+        __m128 belowOne = _mm_cmplt_ps(ratio, one);
+        __m128 power = expSse2(_mm_mul_ps(selectSse2(belowOne, inverseExponent, exponent), logSse2(ratio)));
+        __m128 distance = selectSse2(belowOne, power, _mm_add_ps(_mm_mul_ps(scale, power), offset));
+        _mm_storeu_ps(out + i, selectSse2(_mm_cmpeq_ps(r, zero), _mm_set1_ps(-1.0f), distance));
+    }
+    distancesScalar(rssi + i, n - i, model, out + i);
+}
+
+SB_TARGET_SSE2 __m128i qualityLaneSse2(__m128 r) {
+    // Each passed threshold is an all-ones lane, i.e. -1
+    __m128i level = _mm_setzero_si128();
+    for (size_t i = 1; i < kSignalQualityLevelCount; ++i) {
+        __m128 passed = _mm_cmpge_ps(r, _mm_set1_ps(kSignalQualityLevels[i].minRssi));
+        level = _mm_sub_epi32(level, _mm_castps_si128(passed));
+    }
+    return level;
+}
+
+SB_TARGET_SSE2 void qualityLevelsSse2(const float* rssi, size_t n, uint8_t* out) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i low = _mm_packs_epi32(qualityLaneSse2(_mm_loadu_ps(rssi + i)),
+                                      qualityLaneSse2(_mm_loadu_ps(rssi + i + 4)));
+        __m128i high = _mm_packs_epi32(qualityLaneSse2(_mm_loadu_ps(rssi + i + 8)),
+                                       qualityLaneSse2(_mm_loadu_ps(rssi + i + 12)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(low, high));
+    }
+    qualityLevelsScalar(rssi + i, n - i, out + i);
+}
+
+SB_TARGET_AVX2 __m256 logAvx2(__m256 x) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    x = _mm256_max_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(0x00800000)));
+
+    __m256i bits = _mm256_castps_si256(x);
+    __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+    x = _mm256_or_ps(_mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(0x007fffff))), _mm256_set1_ps(0.5f));
+    __m256 small = _mm256_cmp_ps(x, _mm256_set1_ps(kLogSqrtHalf), _CMP_LT_OQ);
+    e = _mm256_sub_ps(e, _mm256_and_ps(one, small));
+    x = _mm256_add_ps(_mm256_sub_ps(x, one), _mm256_and_ps(x, small));
+
+    __m256 z = _mm256_mul_ps(x, x);
+    __m256 y = _mm256_set1_ps(kLogP[0]);
+    for (size_t i = 1; i < 9; ++i) {
+        y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(kLogP[i]));
+    }
+    y = _mm256_mul_ps(_mm256_mul_ps(y, x), z);
+    y = _mm256_add_ps(y, _mm256_mul_ps(e, _mm256_set1_ps(kLn2Low)));
+    y = _mm256_sub_ps(y, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+    return _mm256_add_ps(_mm256_add_ps(x, y), _mm256_mul_ps(e, _mm256_set1_ps(kLn2High)));
+}
+
+SB_TARGET_AVX2 __m256 expAvx2(__m256 x) {
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-kExpLimit)), _mm256_set1_ps(kExpLimit));
+
+    __m256 fx = _mm256_floor_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(kLog2e)), _mm256_set1_ps(0.5f)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(kLn2High)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(kLn2Low)));
+
+    __m256 z = _mm256_mul_ps(x, x);
+    __m256 y = _mm256_set1_ps(kExpP[0]);
+    for (size_t i = 1; i < 6; ++i) {
+        y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(kExpP[i]));
+    }
+    y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(y, z), x), _mm256_set1_ps(1.0f));
+
+    __m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(fx), _mm256_set1_epi32(0x7f)), 23);
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(exponent));
+}
+
+SB_TARGET_AVX2 void distancesAvx2(const float* rssi, size_t n, const DistanceModel& model, float* out) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 txPower = _mm256_set1_ps(model.txPower);
+    const __m256 exponent = _mm256_set1_ps(model.exponent);
+    const __m256 inverseExponent = _mm256_set1_ps(model.inverseExponent);
+    const __m256 scale = _mm256_set1_ps(model.scale);
+    const __m256 offset = _mm256_set1_ps(0.62f);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 r = _mm256_loadu_ps(rssi + i);
+        __m256 ratio = _mm256_div_ps(r, txPower);
+        __m256 belowOne = _mm256_cmp_ps(ratio, one, _CMP_LT_OQ);
+        __m256 power = expAvx2(_mm256_mul_ps(_mm256_blendv_ps(exponent, inverseExponent, belowOne), logAvx2(ratio)));
+        __m256 distance = _mm256_blendv_ps(_mm256_add_ps(_mm256_mul_ps(scale, power), offset), power, belowOne);
+        __m256 missing = _mm256_cmp_ps(r, zero, _CMP_EQ_OQ);
+        _mm256_storeu_ps(out + i, _mm256_blendv_ps(distance, _mm256_set1_ps(-1.0f), missing));
+    }
+    distancesSse2(rssi + i, n - i, model, out + i);
+}
+
+bool cpuSupportsSse2() {
+#if defined(_M_X64) || defined(__x86_64__)
+    return true;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+bool cpuSupportsAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 0x6) == 0x6);
+    if (!osSavesYmm) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif // SB_KERNELS_X86
+
+#ifdef SB_KERNELS_NEON
+double horizontalSum(float32x4_t v) {
+    float lanes[4];
+    vst1q_f32(lanes, v);
+    return static_cast<double>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+}
+
+double sumNeon(const float* data, size_t n) {
+    double total = 0.0;
+    size_t i = 0;
+    while (i + 8 <= n) {
+        size_t blockEnd = std::min(n, i + kFlushBlock);
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        for (; i + 8 <= blockEnd; i += 8) {
+            acc0 = vaddq_f32(acc0, vld1q_f32(data + i));
+            acc1 = vaddq_f32(acc1, vld1q_f32(data + i + 4));
+        }
+        total += horizontalSum(vaddq_f32(acc0, acc1));
+    }
+    return total + sumScalar(data + i, n - i);
+}
+
+double sumSquaredDeviationNeon(const float* data, size_t n, float mean) {
+    double total = 0.0;
+    float32x4_t m = vdupq_n_f32(mean);
+    size_t i = 0;
+    while (i + 8 <= n) {
+        size_t blockEnd = std::min(n, i + kFlushBlock);
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        for (; i + 8 <= blockEnd; i += 8) {
+            float32x4_t d0 = vsubq_f32(vld1q_f32(data + i), m);
+            float32x4_t d1 = vsubq_f32(vld1q_f32(data + i + 4), m);
+            acc0 = vmlaq_f32(acc0, d0, d0);
+            acc1 = vmlaq_f32(acc1, d1, d1);
+        }
+        total += horizontalSum(vaddq_f32(acc0, acc1));
+    }
+    return total + sumSquaredDeviationScalar(data + i, n - i, mean);
+}
+
+void minMaxNeon(const float* data, size_t n, float& minValue, float& maxValue) {
+    size_t i = 0;
+    if (n >= 4) {
+        float32x4_t lo = vdupq_n_f32(minValue);
+        float32x4_t hi = vdupq_n_f32(maxValue);
+        for (; i + 4 <= n; i += 4) {
+            float32x4_t v = vld1q_f32(data + i);
+            lo = vminq_f32(lo, v);
+            hi = vmaxq_f32(hi, v);
+        }
+        float loLanes[4], hiLanes[4];
+        vst1q_f32(loLanes, lo);
+        vst1q_f32(hiLanes, hi);
+        minMaxScalar(loLanes, 4, minValue, maxValue);
+        minMaxScalar(hiLanes, 4, minValue, maxValue);
+    }
+    minMaxScalar(data + i, n - i, minValue, maxValue);
+}
+
+void ewmaNeon(const float* in, size_t n, float alpha, float previous, float* out) {
+    float b = 1.0f - alpha;
+    float32x4_t zero = vdupq_n_f32(0.0f);
+    float32x4_t a = vdupq_n_f32(alpha);
+    float32x4_t b1 = vdupq_n_f32(b);
+    float32x4_t b2 = vdupq_n_f32(b * b);
+    const float weights[4] = {b, b * b, b * b * b, b * b * b * b};
+    float32x4_t carryWeights = vld1q_f32(weights);
+    float32x4_t carry = vdupq_n_f32(previous);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t v = vmulq_f32(a, vld1q_f32(in + i));
+        v = vmlaq_f32(v, b1, vextq_f32(zero, v, 3));
+        v = vmlaq_f32(v, b2, vextq_f32(zero, v, 2));
+        v = vmlaq_f32(v, carryWeights, carry);
+        vst1q_f32(out + i, v);
+        carry = vdupq_n_f32(vgetq_lane_f32(v, 3));
+    }
+
+    if (i < n) {
+        ewmaScalar(in + i, n - i, alpha, vgetq_lane_f32(carry, 0), out + i);
+    }
+}
+
+float32x4_t logNeon(float32x4_t x) {
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    x = vmaxq_f32(x, vreinterpretq_f32_u32(vdupq_n_u32(0x00800000)));
+
+    uint32x4_t bits = vreinterpretq_u32_f32(x);
+    float32x4_t e = vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vdupq_n_s32(126)));
+    x = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x007fffff)),
+                                        vreinterpretq_u32_f32(vdupq_n_f32(0.5f))));
+    uint32x4_t small = vcltq_f32(x, vdupq_n_f32(kLogSqrtHalf));
+    e = vsubq_f32(e, vbslq_f32(small, one, vdupq_n_f32(0.0f)));
+    x = vaddq_f32(vsubq_f32(x, one), vbslq_f32(small, x, vdupq_n_f32(0.0f)));
+
+    float32x4_t z = vmulq_f32(x, x);
+    float32x4_t y = vdupq_n_f32(kLogP[0]);
+    for (size_t i = 1; i < 9; ++i) {
+        y = vmlaq_f32(vdupq_n_f32(kLogP[i]), y, x);
+    }
+    y = vmulq_f32(vmulq_f32(y, x), z);
+    y = vmlaq_f32(y, e, vdupq_n_f32(kLn2Low));
+    y = vmlsq_f32(y, z, vdupq_n_f32(0.5f));
+    return vmlaq_f32(vaddq_f32(x, y), e, vdupq_n_f32(kLn2High));
+}
+
+float32x4_t expNeon(float32x4_t x) {
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(-kExpLimit)), vdupq_n_f32(kExpLimit));
+
+    float32x4_t fx = vmlaq_f32(vdupq_n_f32(0.5f), x, vdupq_n_f32(kLog2e));
+    float32x4_t truncated = vcvtq_f32_s32(vcvtq_s32_f32(fx));
+    fx = vsubq_f32(truncated, vbslq_f32(vcgtq_f32(truncated, fx), one, vdupq_n_f32(0.0f)));
+    x = vmlsq_f32(x, fx, vdupq_n_f32(kLn2High));
+    x = vmlsq_f32(x, fx, vdupq_n_f32(kLn2Low));
+
+    float32x4_t z = vmulq_f32(x, x);
+    float32x4_t y = vdupq_n_f32(kExpP[0]);
+    for (size_t i = 1; i < 6; ++i) {
+        y = vmlaq_f32(vdupq_n_f32(kExpP[i]), y, x);
+    }
+    y = vaddq_f32(vmlaq_f32(x, y, z), one);
+
+    int32x4_t exponent = vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(fx), vdupq_n_s32(0x7f)), 23);
+    return vmulq_f32(y, vreinterpretq_f32_s32(exponent));
+}
+
+void distancesNeon(const float* rssi, size_t n, const DistanceModel& model, float* out) {
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t exponent = vdupq_n_f32(model.exponent);
+    const float32x4_t inverseExponent = vdupq_n_f32(model.inverseExponent);
+    const float32x4_t scale = vdupq_n_f32(model.scale);
+    const float32x4_t offset = vdupq_n_f32(0.62f);
+    const float32x4_t txPower = vdupq_n_f32(model.txPower);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t r = vld1q_f32(rssi + i);
+        float32x4_t ratio = vdivq_f32(r, txPower);
+        uint32x4_t belowOne = vcltq_f32(ratio, one);
+        float32x4_t power = expNeon(vmulq_f32(vbslq_f32(belowOne, inverseExponent, exponent), logNeon(ratio)));
+        float32x4_t distance = vbslq_f32(belowOne, power, vmlaq_f32(offset, scale, power));
+        vst1q_f32(out + i, vbslq_f32(vceqq_f32(r, vdupq_n_f32(0.0f)), vdupq_n_f32(-1.0f), distance));
+    }
+    distancesScalar(rssi + i, n - i, model, out + i);
+}
+
+uint32x4_t qualityLaneNeon(float32x4_t r) {
+    // Each passed threshold is an all-ones lane, i.e. -1
+    uint32x4_t level = vdupq_n_u32(0);
+    for (size_t i = 1; i < kSignalQualityLevelCount; ++i) {
+        level = vsubq_u32(level, vcgeq_f32(r, vdupq_n_f32(kSignalQualityLevels[i].minRssi)));
+    }
+    return level;
+}
+
+void qualityLevelsNeon(const float* rssi, size_t n, uint8_t* out) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint16x8_t levels = vcombine_u16(vmovn_u32(qualityLaneNeon(vld1q_f32(rssi + i))),
+                                         vmovn_u32(qualityLaneNeon(vld1q_f32(rssi + i + 4))));
+        vst1_u8(out + i, vmovn_u16(levels));
+    }
+    qualityLevelsScalar(rssi + i, n - i, out + i);
+}
+#endif // SB_KERNELS_NEON
+
+KernelTable selectKernels() {
+#ifdef SB_KERNELS_X86
+    if (cpuSupportsAvx2()) {
+        // The EWMA scan is latency bound on the carry; 4 lanes are as fast as 8
+        // Quality bucketing is bound by memory, not lanes
+        return {"avx2", sumAvx2, sumSquaredDeviationAvx2, minMaxAvx2, ewmaSse2, distancesAvx2, qualityLevelsSse2};
+    }
+    if (cpuSupportsSse2()) {
+        return {"sse2", sumSse2, sumSquaredDeviationSse2, minMaxSse2, ewmaSse2, distancesSse2, qualityLevelsSse2};
+    }
+#elif defined(SB_KERNELS_NEON)
+    return {"neon", sumNeon, sumSquaredDeviationNeon, minMaxNeon, ewmaNeon, distancesNeon, qualityLevelsNeon};
+#endif
+    return {"scalar", sumScalar, sumSquaredDeviationScalar, minMaxScalar, ewmaScalar, distancesScalar,
+            qualityLevelsScalar};
+}
+
+const KernelTable& kernels() {
+    static const KernelTable table = selectKernels();
+    return table;
+}
+
+} // namespace
+
+const char* activeInstructionSet() {
+    return kernels().name;
+}
+
+double sum(const float* data, size_t n) {
+    return kernels().sum(data, n);
+}
+
+void meanVariance(const float* data, size_t n, double& mean, double& variance) {
+    if (n == 0) {
+        mean = 0.0;
+        variance = 0.0;
+        return;
+    }
+
+    const KernelTable& k = kernels();
+    mean = k.sum(data, n) / n;
+    variance = k.sumSquaredDeviation(data, n, static_cast<float>(mean)) / n;
+}
+
+void minMax(const float* data, size_t n, float& minValue, float& maxValue) {
+    minValue = std::numeric_limits<float>::max();
+    maxValue = std::numeric_limits<float>::lowest();
+    kernels().minMax(data, n, minValue, maxValue);
+}
+
+void percentiles(const float* data, size_t n, const float* quantiles, size_t count,
+                 float* out, std::vector<float>& scratch) {
+    if (n == 0) {
+        std::fill(out, out + count, 0.0f);
+        return;
+    }
+
+    scratch.assign(data, data + n);
+    for (size_t q = 0; q < count; ++q) {
+        double position = std::min(1.0f, std::max(0.0f, quantiles[q])) * (n - 1);
+        size_t lower = static_cast<size_t>(position);
+        double fraction = position - lower;
+
+        // Selection leaves everything above `lower` in the upper partition,
+        // so the next order statistic is the minimum of that range
+        std::nth_element(scratch.begin(), scratch.begin() + lower, scratch.end());
+        float lowerValue = scratch[lower];
+        float upperValue = lowerValue;
+        if (fraction > 0.0 && lower + 1 < n) {
+            upperValue = *std::min_element(scratch.begin() + lower + 1, scratch.end());
+        }
+
+        out[q] = static_cast<float>(lowerValue + fraction * (upperValue - lowerValue));
+    }
+}
+
+void ewma(const float* in, size_t n, float alpha, float* out) {
+    if (n == 0) return;
+
+    out[0] = in[0];
+    kernels().ewma(in + 1, n - 1, alpha, in[0], out + 1);
+}
+
+void estimateDistances(const float* rssi, size_t n, float txPower, float pathLossExponent, float* out) {
+    DistanceModel model = {txPower, pathLossExponent, 1.0f / pathLossExponent, 1.5f * pathLossExponent - 0.96f};
+    kernels().distances(rssi, n, model, out);
+}
+
+void estimateDistances(const float* rssi, size_t deviceCount, const float* txPower, const float* pathLossExponent,
+                       size_t apCount, float* distances) {
+    for (size_t ap = 0; ap < apCount; ++ap) {
+        estimateDistances(rssi + ap * deviceCount, deviceCount, txPower[ap], pathLossExponent[ap],
+                          distances + ap * deviceCount);
+    }
+}
+
+void classifySignalQuality(const float* rssi, size_t n, SignalQualityLevel* out) {
+    // SignalQualityLevel is a uint8_t enum, so the kernels write it as bytes
+    kernels().qualityLevels(rssi, n, reinterpret_cast<uint8_t*>(out));
+}
+
+} // namespace SignalKernels
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "SignalQuality.h"
+#include <cstddef>
+#include <vector>
+
+// Vectorized kernels over contiguous float spans of RSSI samples.
+// The implementation (AVX2, SSE2, NEON or scalar) is picked once at runtime
+// from the capabilities of the CPU the process is running on.
+namespace SignalKernels {
+
+// Name of the instruction set the dispatcher selected ("avx2", "sse2", "neon" or "scalar")
+const char* activeInstructionSet();
+
+double sum(const float* data, size_t n);
+
+// Population mean and variance of n samples (two-pass, double accumulation)
+void meanVariance(const float* data, size_t n, double& mean, double& variance);
+
+void minMax(const float* data, size_t n, float& minValue, float& maxValue);
+
+// Linearly interpolated quantiles (0..1) of n samples. `scratch` is reused
+// between calls so repeated use does not allocate once it has grown.
+void percentiles(const float* data, size_t n, const float* quantiles, size_t count,
+                 float* out, std::vector<float>& scratch);
+
+// out[0] = in[0], out[i] = alpha * in[i] + (1 - alpha) * out[i - 1].
+// Evaluated as a blocked prefix scan so each block of lanes is computed in parallel.
+void ewma(const float* in, size_t n, float alpha, float* out);
+
+// Upper bound on the relative error of estimateDistances() against the
+// double-precision SignalProcessor::estimateDistance(), for rssi/txPower
+// ratios up to 4 and path-loss exponents from 1 to 8
+constexpr double kDistanceRelativeError = 1e-5;
+
+// Log-distance estimates as SignalProcessor::estimateDistance computes them,
+// for readings taken by one access point: RSSI and txPower in (negative)
+// dBm; an RSSI of 0 gives -1. The SIMD paths evaluate pow as
+// exp(y * log(x)) with Cephes-style float polynomials (range reduction to
+// [sqrt(1/2), sqrt(2)) for log, to [-ln2/2, ln2/2] for exp).
+void estimateDistances(const float* rssi, size_t n, float txPower, float pathLossExponent, float* out);
+
+// Every device x access point pair at once. rssi holds one row of
+// deviceCount readings per access point (row a is what access point a
+// heard), txPower and pathLossExponent one value per access point, and
+// distances is laid out like rssi.
+void estimateDistances(const float* rssi, size_t deviceCount, const float* txPower, const float* pathLossExponent,
+                       size_t apCount, float* distances);
+
+// signalQualityLevel() of each reading
+void classifySignalQuality(const float* rssi, size_t n, SignalQualityLevel* out);
+
+} // namespace SignalKernels
@@ -1,4 +1,5 @@
 #include "SignalProcessor.h"
+#include "SignalKernels.h"
 #include <algorithm>
 #include <cmath>
 #include <numeric>
@@ -7,14 +8,31 @@ SignalProcessor::SignalProcessor() {
     // Initialize default parameters
 }
 
-double SignalProcessor::processRSSI(double rawRSSI, const std::string& deviceId) {
+double SignalProcessor::processRSSI(double rawRSSI, uint32_t deviceId) {
     // Apply Kalman filtering for signal smoothing
-    auto it = kalmanFilters.find(deviceId);
-    if (it == kalmanFilters.end()) {
-        kalmanFilters[deviceId] = KalmanFilter(1e-3, 0.1);
+    ensureFilter(deviceId);
+    return filterBank.update(deviceId, static_cast<float>(rawRSSI));
+}
+
+void SignalProcessor::processRSSIBatch(const uint32_t* deviceIds, const float* measurements, size_t count, float* filtered) {
+    for (size_t i = 0; i < count; ++i) {
+        ensureFilter(deviceIds[i]);
     }
     
-    return kalmanFilters[deviceId].update(rawRSSI);
+    // A cycle that changed a few devices costs a few updates, however many IDs exist
+    filterBank.updateIndexed(deviceIds, measurements, count, filtered);
+}
+
+void SignalProcessor::resetDevice(uint32_t deviceId) {
+    if (deviceId < filterBank.size()) {
+        filterBank.reset(deviceId);
+    }
+}
+
+void SignalProcessor::ensureFilter(uint32_t deviceId) {
+    while (filterBank.size() <= deviceId) {
+        filterBank.addFilter();
+    }
 }
 
 double SignalProcessor::estimateDistance(double rssi, double txPower, double pathLossExponent) {
@@ -30,34 +48,26 @@ double SignalProcessor::estimateDistance(double rssi, double txPower, double pat
 }
 
 SignalQuality SignalProcessor::analyzeSignalQuality(double rssi) {
+    const SignalQualityInfo& info = signalQualityInfo(signalQualityLevel(static_cast<float>(rssi)));
+
     SignalQuality quality;
     quality.rssi = rssi;
-    
-    if (rssi >= -50) {
-        quality.strength = "Excellent";
-        quality.percentage = 100;
-        quality.bars = 4;
-    } else if (rssi >= -60) {
-        quality.strength = "Good";
-        quality.percentage = 75;
-        quality.bars = 3;
-    } else if (rssi >= -70) {
-        quality.strength = "Fair";
-        quality.percentage = 50;
-        quality.bars = 2;
-    } else if (rssi >= -80) {
-        quality.strength = "Poor";
-        quality.percentage = 25;
-        quality.bars = 1;
-    } else {
-        quality.strength = "Very Poor";
-        quality.percentage = 0;
-        quality.bars = 0;
-    }
-    
+    quality.level = info.level;
+    quality.strength = info.label;
+    quality.percentage = info.percentage;
+    quality.bars = info.bars;
     return quality;
 }
 
+void SignalProcessor::estimateDistances(const float* rssi, size_t deviceCount, const float* txPower,
+                                        const float* pathLossExponent, size_t apCount, float* distances) {
+    SignalKernels::estimateDistances(rssi, deviceCount, txPower, pathLossExponent, apCount, distances);
+}
+
+void SignalProcessor::classifySignalQuality(const float* rssi, size_t count, SignalQualityLevel* levels) {
+    SignalKernels::classifySignalQuality(rssi, count, levels);
+}
+
 std::vector<double> SignalProcessor::smoothSignalHistory(const std::vector<double>& rawSignals) {
     if (rawSignals.empty()) return {};
     
@@ -85,12 +95,76 @@ double SignalProcessor::calculateSignalStability(const std::vector<double>& sign
     
     double variance = 0.0;
     for (double signal : signalHistory) {
-        variance += std::pow(signal - mean, 2);
+        double deviation = signal - mean;
+        variance += deviation * deviation;
     }
     variance /= signalHistory.size();
     
+    return stabilityFromStdDev(std::sqrt(variance));
+}
+
+void SignalProcessor::smoothSignalHistory(const float* rawSignals, size_t count, float* smoothed, float alpha) {
+    SignalKernels::ewma(rawSignals, count, alpha, smoothed);
+}
+
+double SignalProcessor::calculateSignalStability(const float* signalHistory, size_t count) {
+    if (count < 2) return 0.0;
+
+    double mean, variance;
+    SignalKernels::meanVariance(signalHistory, count, mean, variance);
+    return stabilityFromStdDev(std::sqrt(variance));
+}
+
+SignalHistoryStats SignalProcessor::analyzeSignalHistory(const float* signalHistory, size_t count) {
+    SignalHistoryStats stats = {};
+    if (count == 0) return stats;
+
+    double mean, variance;
+    SignalKernels::meanVariance(signalHistory, count, mean, variance);
+    SignalKernels::minMax(signalHistory, count, stats.min, stats.max);
+
+    static const float quantiles[3] = {0.1f, 0.5f, 0.9f};
+    float values[3];
+    SignalKernels::percentiles(signalHistory, count, quantiles, 3, values, percentileScratch);
+
     double stdDev = std::sqrt(variance);
-    
+    stats.mean = static_cast<float>(mean);
+    stats.stdDev = static_cast<float>(stdDev);
+    stats.stability = count < 2 ? 0.0f : static_cast<float>(stabilityFromStdDev(stdDev));
+    stats.p10 = values[0];
+    stats.p50 = values[1];
+    stats.p90 = values[2];
+    return stats;
+}
+
+double SignalProcessor::calculateSignalStability(const RunningMoments& moments) {
+    if (moments.count() < 2) return 0.0;
+    return stabilityFromStdDev(moments.stdDev());
+}
+
+SignalHistoryStats SignalProcessor::analyzeSignalSummary(const DeviceSummary& summary) {
+    SignalHistoryStats stats = {};
+    const RunningMoments& moments = summary.rssi;
+    if (moments.count() == 0) return stats;
+
+    stats.mean = static_cast<float>(moments.mean());
+    stats.stdDev = static_cast<float>(moments.stdDev());
+    stats.stability = static_cast<float>(calculateSignalStability(moments));
+    stats.min = static_cast<float>(moments.min());
+    stats.max = static_cast<float>(moments.max());
+    stats.p10 = summary.rssiQuantiles.quantile(0.1);
+    stats.p50 = summary.rssiQuantiles.quantile(0.5);
+    stats.p90 = summary.rssiQuantiles.quantile(0.9);
+    return stats;
+}
+
+void SignalProcessor::analyzeSignalHistories(const SignalHistorySpan* histories, size_t count, SignalHistoryStats* out) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = analyzeSignalHistory(histories[i].samples, histories[i].count);
+    }
+}
+
+double SignalProcessor::stabilityFromStdDev(double stdDev) {
     // Convert to stability score (0-1, higher is more stable)
     double stability = 1.0 / (1.0 + stdDev / 10.0);
     return std::max(0.0, std::min(1.0, stability));
@@ -120,6 +194,80 @@ double KalmanFilter::update(double measurement) {
     return estimatedValue;
 }
 
+// Kalman Filter Bank Implementation
+KalmanFilterBank::KalmanFilterBank(float processVariance, float measurementVariance)
+    : processVariance(processVariance), defaultMeasurementVariance(measurementVariance) {
+}
+
+uint32_t KalmanFilterBank::addFilter() {
+    return addFilter(defaultMeasurementVariance);
+}
+
+uint32_t KalmanFilterBank::addFilter(float measurementVariance) {
+    uint32_t index = static_cast<uint32_t>(estimates.size());
+    estimates.push_back(0.0f);
+    errors.push_back(1.0f);
+    measurementVariances.push_back(measurementVariance);
+    initialized.push_back(0.0f);
+    return index;
+}
+
+void KalmanFilterBank::reset(uint32_t index) {
+    estimates[index] = 0.0f;
+    errors[index] = 1.0f;
+    initialized[index] = 0.0f;
+}
+
+float KalmanFilterBank::update(uint32_t index, float measurement) {
+    if (initialized[index] == 0.0f) {
+        estimates[index] = measurement;
+        initialized[index] = 1.0f;
+        return measurement;
+    }
+
+    float predictedError = errors[index] + processVariance;
+    float kalmanGain = predictedError / (predictedError + measurementVariances[index]);
+    estimates[index] += kalmanGain * (measurement - estimates[index]);
+    errors[index] = (1.0f - kalmanGain) * predictedError;
+    return estimates[index];
+}
+
+void KalmanFilterBank::updateAll(const float* measurements, size_t n) {
+    n = std::min(n, estimates.size());
+    float* estimate = estimates.data();
+    float* error = errors.data();
+    float* init = initialized.data();
+    const float* variance = measurementVariances.data();
+    const float q = processVariance;
+
+    // Blend with 0/1 weights instead of branching so the loop stays in vector lanes:
+    // absent measurements contribute nothing, the first one seeds the estimate.
+    for (size_t i = 0; i < n; ++i) {
+        float measurement = measurements[i];
+        float present = measurement == measurement ? 1.0f : 0.0f;
+        float value = present != 0.0f ? measurement : estimate[i];
+        float active = init[i] * present;
+        float firstSample = present - active;
+
+        float predictedError = error[i] + q;
+        float kalmanGain = active * predictedError / (predictedError + variance[i]);
+
+        estimate[i] += (kalmanGain + firstSample) * (value - estimate[i]);
+        error[i] += active * ((1.0f - kalmanGain) * predictedError - error[i]);
+        init[i] += firstSample;
+    }
+}
+
+void KalmanFilterBank::updateIndexed(const uint32_t* indices, const float* measurements, size_t count,
+                                     float* filtered) {
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t index = indices[i];
+        float measurement = measurements[i];
+        float estimate = measurement == measurement ? update(index, measurement) : estimates[index];
+        if (filtered) filtered[i] = estimate;
+    }
+}
+
 // Exponential Weighted Moving Average Implementation
 EWMA::EWMA(double alpha) : alpha(alpha), isInitialized(false), currentValue(0.0) {
 }
@@ -1,12 +1,34 @@
 #pragma once
 
+#include "SignalQuality.h"
+#include "StreamingSummary.h"
 #include <vector>
 #include <string>
+#include <string_view>
 #include <map>
+#include <cstdint>
+#include <cstddef>
+
+struct SignalHistorySpan {
+    const float* samples;
+    size_t count;
+};
+
+struct SignalHistoryStats {
+    float mean;
+    float stdDev;
+    float stability;
+    float min;
+    float max;
+    float p10;
+    float p50;
+    float p90;
+};
 
 struct SignalQuality {
     double rssi;
-    std::string strength;
+    SignalQualityLevel level;
+    std::string_view strength; // label from kSignalQualityLevels
     int percentage;
     int bars;
 };
@@ -24,6 +46,42 @@ private:
     bool isInitialized;
 };
 
+// Structure-of-arrays bank of scalar Kalman filters addressed by a dense
+// index. State for all filters lives in contiguous arrays so a whole tick
+// of measurements is applied in one branch-free, vectorizable pass.
+class KalmanFilterBank {
+public:
+    KalmanFilterBank(float processVariance = 1e-3f, float measurementVariance = 0.1f);
+
+    uint32_t addFilter();
+    uint32_t addFilter(float measurementVariance);
+    size_t size() const { return estimates.size(); }
+
+    float update(uint32_t index, float measurement);
+
+    // Updates filters [0, n) with measurements[i]. A NaN measurement leaves
+    // the corresponding filter untouched.
+    void updateAll(const float* measurements, size_t n);
+    // Updates only filters indices[i] with measurements[i], in order, so the
+    // cost follows count rather than the bank size, and writes the new
+    // estimates to filtered unless it is null. NaN measurements are skipped
+    // as in updateAll().
+    void updateIndexed(const uint32_t* indices, const float* measurements, size_t count, float* filtered);
+
+    float estimate(uint32_t index) const { return estimates[index]; }
+    const float* estimateData() const { return estimates.data(); }
+    // Forgets the filter's state; its next measurement seeds it again
+    void reset(uint32_t index);
+
+private:
+    float processVariance;
+    float defaultMeasurementVariance;
+    std::vector<float> estimates;
+    std::vector<float> errors;
+    std::vector<float> measurementVariances;
+    std::vector<float> initialized;
+};
+
 class EWMA {
 public:
     EWMA(double alpha = 0.3);
@@ -39,12 +97,46 @@ class SignalProcessor {
 public:
     SignalProcessor();
     
-    double processRSSI(double rawRSSI, const std::string& deviceId);
+    // Filters one measurement for the device with the given interned ID
+    double processRSSI(double rawRSSI, uint32_t deviceId);
+
+    // Filters count measurements for the given device IDs and writes the new
+    // estimates into filtered. Only the listed devices' filters are touched.
+    void processRSSIBatch(const uint32_t* deviceIds, const float* measurements, size_t count, float* filtered);
+    // Drops a device's filter state, e.g. when it leaves the network; its ID
+    // starts over from the next measurement
+    void resetDevice(uint32_t deviceId);
     double estimateDistance(double rssi, double txPower = -59, double pathLossExponent = 2.0);
     SignalQuality analyzeSignalQuality(double rssi);
+
+    // estimateDistance() for every device x access point pair, for
+    // floor-plan mapping. rssi holds one row of deviceCount readings per
+    // access point and distances is laid out the same way; each access point
+    // has its own txPower and path-loss exponent. Vectorized, within
+    // SignalKernels::kDistanceRelativeError of the scalar formula.
+    void estimateDistances(const float* rssi, size_t deviceCount, const float* txPower,
+                           const float* pathLossExponent, size_t apCount, float* distances);
+    void classifySignalQuality(const float* rssi, size_t count, SignalQualityLevel* levels);
     std::vector<double> smoothSignalHistory(const std::vector<double>& rawSignals);
     double calculateSignalStability(const std::vector<double>& signalHistory);
+
+    // Vectorized variants over contiguous float histories
+    void smoothSignalHistory(const float* rawSignals, size_t count, float* smoothed, float alpha = 0.3f);
+    double calculateSignalStability(const float* signalHistory, size_t count);
+    SignalHistoryStats analyzeSignalHistory(const float* signalHistory, size_t count);
+
+    // The same figures from a device's bounded streaming summary instead of
+    // its sample history; percentiles carry the digest's approximation
+    double calculateSignalStability(const RunningMoments& moments);
+    SignalHistoryStats analyzeSignalSummary(const DeviceSummary& summary);
+
+    // Analyzes many devices' histories in one call, reusing scratch space
+    void analyzeSignalHistories(const SignalHistorySpan* histories, size_t count, SignalHistoryStats* out);
     
 private:
-    std::map<std::string, KalmanFilter> kalmanFilters;
+    KalmanFilterBank filterBank; // indexed by device ID
+    std::vector<float> percentileScratch;
+
+    void ensureFilter(uint32_t deviceId);
+    static double stabilityFromStdDev(double stdDev);
 };
\ No newline at end of file
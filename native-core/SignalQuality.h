@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+// Coarse signal quality buckets. SignalProcessor, the batch kernels and the
+// UI all bucket RSSI through kSignalQualityLevels, so the thresholds live in
+// one place.
+enum class SignalQualityLevel : uint8_t {
+    VeryPoor,
+    Poor,
+    Fair,
+    Good,
+    Excellent,
+    Count
+};
+
+struct SignalQualityInfo {
+    SignalQualityLevel level;
+    float minRssi; // dBm; the level applies from here up to the next one
+    std::string_view label;
+    int percentage;
+    int bars; // 0-4
+};
+
+inline constexpr SignalQualityInfo kSignalQualityLevels[] = {
+    {SignalQualityLevel::VeryPoor, std::numeric_limits<float>::lowest(), "Very Poor", 0, 0},
+    {SignalQualityLevel::Poor, -80.0f, "Poor", 25, 1},
+    {SignalQualityLevel::Fair, -70.0f, "Fair", 50, 2},
+    {SignalQualityLevel::Good, -60.0f, "Good", 75, 3},
+    {SignalQualityLevel::Excellent, -50.0f, "Excellent", 100, 4},
+};
+
+inline constexpr size_t kSignalQualityLevelCount = static_cast<size_t>(SignalQualityLevel::Count);
+
+static_assert(sizeof(kSignalQualityLevels) / sizeof(kSignalQualityLevels[0]) == kSignalQualityLevelCount,
+              "every SignalQualityLevel needs a row");
+
+// Number of thresholds at or below rssi, which is the level; branch-free so
+// loops over it vectorize
+constexpr SignalQualityLevel signalQualityLevel(float rssi) {
+    int level = 0;
+    for (size_t i = 1; i < kSignalQualityLevelCount; ++i) {
+        level += rssi >= kSignalQualityLevels[i].minRssi;
+    }
+    return static_cast<SignalQualityLevel>(level);
+}
+
+constexpr const SignalQualityInfo& signalQualityInfo(SignalQualityLevel level) {
+    size_t index = static_cast<size_t>(level);
+    return kSignalQualityLevels[index < kSignalQualityLevelCount ? index : 0];
+}
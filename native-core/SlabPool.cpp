@@ -0,0 +1,50 @@
+#include "SlabPool.h"
+#include <algorithm>
+
+SlabPool::SlabPool(size_t blockSize, size_t slabBlocks)
+    : blockBytes(std::max(blockSize, sizeof(FreeBlock))), blocksPerSlab(std::max<size_t>(slabBlocks, 1)),
+      freeList(nullptr), inUse(0) {
+    // Every block stays aligned for any object type
+    blockBytes = (blockBytes + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+}
+
+void* SlabPool::allocate(size_t size) {
+    if (size > blockBytes) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!freeList) {
+        // new[] of unsigned char is aligned for max_align_t, and so is every block in it
+        slabs.emplace_back(new unsigned char[blockBytes * blocksPerSlab]);
+        unsigned char* slab = slabs.back().get();
+        for (size_t i = blocksPerSlab; i-- > 0;) {
+            auto* block = reinterpret_cast<FreeBlock*>(slab + i * blockBytes);
+            block->next = freeList;
+            freeList = block;
+        }
+    }
+
+    FreeBlock* block = freeList;
+    freeList = block->next;
+    inUse++;
+    return block;
+}
+
+void SlabPool::deallocate(void* block, size_t) {
+    if (!block) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto* freed = static_cast<FreeBlock*>(block);
+    freed->next = freeList;
+    freeList = freed;
+    inUse--;
+}
+
+size_t SlabPool::blocksInUse() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return inUse;
+}
+
+size_t SlabPool::slabCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return slabs.size();
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Pool of equally sized blocks carved from larger slabs. Freed blocks go on
+// a free list and are handed out again, so objects that come and go (devices
+// joining and leaving the network) stop costing heap allocations once the
+// pool has grown to the working set. Thread-safe; slabs are released with
+// the pool.
+class SlabPool {
+public:
+    explicit SlabPool(size_t blockSize, size_t blocksPerSlab = 64);
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    // Returns nullptr when size doesn't fit a block
+    void* allocate(size_t size);
+    // Takes back a block from allocate() of the same size
+    void deallocate(void* block, size_t size);
+
+    size_t blockSize() const { return blockBytes; }
+    size_t blocksInUse() const;
+    size_t slabCount() const;
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    mutable std::mutex mutex;
+    size_t blockBytes;
+    size_t blocksPerSlab;
+    std::vector<std::unique_ptr<unsigned char[]>> slabs;
+    FreeBlock* freeList;
+    size_t inUse;
+};
+
+// Standard allocator over a shared SlabPool, for std::allocate_shared. The
+// control block keeps a copy, so the pool outlives every object from it.
+// Requests that don't fit a block fall back to operator new.
+template <typename T>
+class SlabAllocator {
+public:
+    using value_type = T;
+
+    explicit SlabAllocator(std::shared_ptr<SlabPool> slabPool) : pool(std::move(slabPool)) {}
+    template <typename U>
+    SlabAllocator(const SlabAllocator<U>& other) : pool(other.pool) {}
+
+    T* allocate(size_t n) {
+        if (n == 1 && alignof(T) <= alignof(std::max_align_t)) {
+            if (void* block = pool->allocate(sizeof(T))) return static_cast<T*>(block);
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t n) {
+        if (n == 1 && alignof(T) <= alignof(std::max_align_t) && sizeof(T) <= pool->blockSize()) {
+            pool->deallocate(pointer, sizeof(T));
+            return;
+        }
+        ::operator delete(pointer);
+    }
+
+    template <typename U>
+    bool operator==(const SlabAllocator<U>& other) const { return pool == other.pool; }
+    template <typename U>
+    bool operator!=(const SlabAllocator<U>& other) const { return pool != other.pool; }
+
+private:
+    template <typename U>
+    friend class SlabAllocator;
+
+    std::shared_ptr<SlabPool> pool;
+};
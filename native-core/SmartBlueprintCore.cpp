@@ -1,14 +1,44 @@
 #include "SmartBlueprintCore.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
 
-SmartBlueprintCore::SmartBlueprintCore() : monitoring(false) {
-    scanner = std::make_unique<NetworkScanner>();
+namespace {
+
+// Recycled snapshot buffers grow with some slack, so a device or anomaly
+// count creeping up (anomalies start from none) doesn't reallocate them
+// every few cycles
+constexpr size_t kMinSnapshotCapacity = 16;
+
+template <typename T>
+void reserveWithHeadroom(std::vector<T>& buffer, size_t size) {
+    if (buffer.capacity() < size) {
+        buffer.reserve(std::max({size + size / 4, 2 * buffer.capacity(), kMinSnapshotCapacity}));
+    }
+}
+
+} // namespace
+
+SmartBlueprintCore::SmartBlueprintCore() : SmartBlueprintCore(std::make_unique<NetworkScanner>()) {
+}
+
+SmartBlueprintCore::SmartBlueprintCore(std::unique_ptr<NetworkScanner> networkScanner)
+    : scanner(std::move(networkScanner)), monitoring(false), restoredState(false), cycleQueued(false), fullPassDue(false),
+      snapshot(std::make_shared<DeviceSnapshot>()), snapshotVersion(0) {
     mlEngine = std::make_unique<MLEngine>();
+    mlEngine->enableOnlineLearning();
     classifier = std::make_unique<DeviceClassifier>();
     signalProcessor = std::make_unique<SignalProcessor>();
+    
+    scanner->setChangeCallback([this](const std::vector<DeviceChange>& changes) {
+        onDeviceChanges(changes);
+    });
 }
 
 SmartBlueprintCore::~SmartBlueprintCore() {
+    ipcControl.stop();
     stopMonitoring();
+    scanner->setChangeCallback(nullptr);
 }
 
 void SmartBlueprintCore::startMonitoring() {
@@ -17,333 +47,488 @@ void SmartBlueprintCore::startMonitoring() {
     monitoring.store(true);
     scanner->startScanning();
     
-    monitoringThread = std::thread(&SmartBlueprintCore::monitoringLoop, this);
+    // Start with a full pass over whatever the scanner already knows
+    fullPassTask = TaskScheduler::shared().schedulePeriodic(
+        TaskPriority::Interactive, kFullPassInterval, [this] { requestFullPass(); });
 }
 
 void SmartBlueprintCore::stopMonitoring() {
     if (!monitoring.load()) return;
     
-    monitoring.store(false);
-    scanner->stopScanning();
-    
-    if (monitoringThread.joinable()) {
-        monitoringThread.join();
+    // Once monitoring is off under the lock no cycle requeues itself, so the
+    // last queued one is the only one left to wait for
+    TaskHandle lastCycle;
+    {
+        std::lock_guard<std::mutex> lock(changeMutex);
+        monitoring.store(false);
+        lastCycle = cycleTask;
     }
+    fullPassTask.cancel();
+    fullPassTask.wait();
+    scanner->stopScanning();
+    lastCycle.wait();
 }
 
-void SmartBlueprintCore::monitoringLoop() {
-    while (monitoring.load()) {
-        try {
-            // Get latest device data
-            auto devices = scanner->getCurrentDevices();
-            
-            // Process and classify devices
-            {
-                std::lock_guard<std::mutex> lock(dataMutex);
-                currentDevices = devices;
-                updateDeviceClassifications();
-                processSignalData();
-                
-                // Detect anomalies
-                currentAnomalies = mlEngine->detectAnomalies(currentDevices);
-            }
-            
-            // Wait before next iteration
-            std::this_thread::sleep_for(std::chrono::seconds(5));
-            
-        } catch (const std::exception& e) {
-            // Log error and continue
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-        }
-    }
-}
-
-std::vector<std::shared_ptr<NetworkDevice>> SmartBlueprintCore::getCurrentDevices() {
-    std::lock_guard<std::mutex> lock(dataMutex);
-    return currentDevices;
-}
-
-std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>> SmartBlueprintCore::detectAnomalies() {
-    std::lock_guard<std::mutex> lock(dataMutex);
-    return currentAnomalies;
+void SmartBlueprintCore::requestFullPass() {
+    std::lock_guard<std::mutex> lock(changeMutex);
+    fullPassDue = true;
+    queueCycleLocked();
 }
 
-void SmartBlueprintCore::performScan() {
-    scanner->performNetworkScan();
+void SmartBlueprintCore::queueCycleLocked() {
+    if (!monitoring.load() || cycleQueued) return;
+    
+    cycleQueued = true;
+    cycleTask = TaskScheduler::shared().submit(TaskPriority::Interactive, [this] { runCycle(); });
 }
 
-void SmartBlueprintCore::updateDeviceClassifications() {
-    for (auto& device : currentDevices) {
-        if (device->deviceType.empty()) {
-            device->deviceType = classifier->classifyDevice(device);
-            device->vendor = classifier->identifyVendor(device->macAddress);
+void SmartBlueprintCore::runCycle() {
+    bool fullPass = false;
+    {
+        std::lock_guard<std::mutex> lock(changeMutex);
+        if (monitoring.load()) {
+            processingChanges.swap(pendingChanges);
+            pendingChanges.clear();
+            fullPass = fullPassDue;
+            fullPassDue = false;
         }
     }
-}
-
-void SmartBlueprintCore::processSignalData() {
-    for (auto& device : currentDevices) {
-        // Process RSSI for signal smoothing
-        double processedRSSI = signalProcessor->processRSSI(device->rssi, device->macAddress);
-        device->rssi = static_cast<int>(processedRSSI);
+    
+    if (!processingChanges.empty() || fullPass) {
+        try {
+            processChanges(fullPass);
+        } catch (const std::exception& e) {
+            // Log and keep monitoring; the next cycle starts from fresh scanner state
+            SB_COUNT(CycleErrors, 1);
+            std::cerr << "Monitoring cycle failed: " << e.what() << std::endl;
+        }
+        processingChanges.clear();
+    }
+    
+    // Changes that arrived meanwhile get a fresh task, so other work can
+    // interleave with a busy network
+    std::lock_guard<std::mutex> lock(changeMutex);
+    cycleQueued = false;
+    if (!pendingChanges.empty() || fullPassDue) {
+        queueCycleLocked();
     }
 }
 
-class NetworkScanner {
-private:
-    std::vector<std::shared_ptr<Device>> devices;
-    std::mutex devicesMutex;
-    bool isScanning;
-    std::thread scanThread;
+void SmartBlueprintCore::onDeviceChanges(const std::vector<DeviceChange>& changes) {
+    std::lock_guard<std::mutex> lock(changeMutex);
+    pendingChanges.insert(pendingChanges.end(), changes.begin(), changes.end());
+    queueCycleLocked();
+}
 
-public:
-    NetworkScanner() : isScanning(false) {}
+void SmartBlueprintCore::processChanges(bool fullPass) {
+    SB_SCOPED_TIMER(Cycle);
+    uint64_t allocationsBefore = Metrics::threadAllocationCount();
+    
+    std::lock_guard<std::mutex> lock(dataMutex);
     
-    void startScanning() {
-        if (isScanning) return;
+    if (fullPass) {
+        // A removed device's ID can already belong to a new one
+        for (const auto& change : processingChanges) {
+            if (change.type == DeviceChangeType::Removed) {
+                dropDevice(change.deviceId);
+            }
+        }
+        scanner->currentDeviceIds(processIds);
         
-        isScanning = true;
-        scanThread = std::thread([this]() {
-            while (isScanning) {
-                performNetworkScan();
-                std::this_thread::sleep_for(std::chrono::seconds(30));
+        // Every device is reprocessed, but only those whose reading changed
+        // add a sample to their summary
+        for (const auto& change : processingChanges) {
+            if (change.type == DeviceChangeType::Removed) continue;
+            if (change.deviceId >= reportedMask.size()) {
+                reportedMask.resize(change.deviceId + 1, 0);
             }
-        });
+            reportedMask[change.deviceId] = 1;
+        }
+        
+        // Devices the scanner no longer has are dropped here too
+        for (uint32_t id : processIds) {
+            if (id >= changedMask.size()) {
+                changedMask.resize(id + 1, 0);
+            }
+            changedMask[id] = 1;
+        }
+        for (size_t id = 0; id < devicesById.size(); ++id) {
+            if (devicesById[id] && (id >= changedMask.size() || !changedMask[id])) {
+                dropDevice(static_cast<uint32_t>(id));
+            }
+        }
+        currentAnomalies.clear();
+    } else {
+        // Collapse the batch to one entry per device, the latest change
+        // winning. A removal drops everything we keep for the ID, which the
+        // scanner may hand to another device; removed devices only drop
+        // their anomaly.
+        processIds.clear();
+        for (auto change = processingChanges.rbegin(); change != processingChanges.rend(); ++change) {
+            uint32_t id = change->deviceId;
+            if (id >= changedMask.size()) {
+                changedMask.resize(id + 1, 0);
+            }
+            if (change->type == DeviceChangeType::Removed) {
+                dropDevice(id);
+            }
+            if (changedMask[id]) continue;
+            changedMask[id] = 1;
+            if (change->type != DeviceChangeType::Removed) {
+                processIds.push_back(id);
+            }
+        }
+        std::reverse(processIds.begin(), processIds.end());
+        for (uint32_t id : processIds) {
+            if (id >= reportedMask.size()) {
+                reportedMask.resize(id + 1, 0);
+            }
+            reportedMask[id] = 1;
+        }
+        
+        currentAnomalies.erase(std::remove_if(currentAnomalies.begin(), currentAnomalies.end(),
+            [this](const std::pair<std::shared_ptr<NetworkDevice>, double>& anomaly) {
+                uint32_t id = anomaly.first->deviceId;
+                return id < changedMask.size() && changedMask[id];
+            }), currentAnomalies.end());
     }
     
-    void stopScanning() {
-        isScanning = false;
-        if (scanThread.joinable()) {
-            scanThread.join();
+    // The scanner's records are only read under its lock; from here on
+    // everything works on our own copies
+    scanner->copyDevices(processIds.data(), processIds.size(), devicesById);
+    changedDevices.clear();
+    for (uint32_t id : processIds) {
+        if (id < devicesById.size() && devicesById[id]) {
+            changedDevices.push_back(devicesById[id]);
+        }
+    }
+    currentDevices.clear();
+    for (const auto& device : devicesById) {
+        if (device) {
+            currentDevices.push_back(device);
         }
     }
     
-    std::vector<std::shared_ptr<Device>> getDevices() {
-        std::lock_guard<std::mutex> lock(devicesMutex);
-        return devices;
+    if (!changedDevices.empty()) {
+        updateDeviceClassifications(changedDevices);
+        processSignalData(changedDevices);
+        
+        // Detect anomalies
+        SB_SCOPED_TIMER(AnomalyScoring);
+        mlEngine->detectAnomalies(changedDevices, currentAnomalies);
+    }
+    
+    // Tree replacement drifts towards recent data; a periodic full rebuild
+    // from the whole window, off the monitoring thread, re-balances the forest
+    if (fullPass) {
+        mlEngine->retrainFromWindowAsync();
     }
+    
+    publishSnapshot();
+    changedMask.assign(changedMask.size(), 0);
+    reportedMask.assign(reportedMask.size(), 0);
+    
+    SB_COUNT(Cycles, 1);
+    SB_COUNT(DevicesProcessed, changedDevices.size());
+    SB_COUNT(Allocations, Metrics::threadAllocationCount() - allocationsBefore);
+}
 
-private:
-    void performNetworkScan() {
-        std::vector<std::shared_ptr<Device>> newDevices;
-        
-#ifdef _WIN32
-        performWindowsNetworkScan(newDevices);
-#elif __APPLE__
-        performMacOSNetworkScan(newDevices);
-#elif __ANDROID__
-        performAndroidNetworkScan(newDevices);
-#elif __linux__
-        performLinuxNetworkScan(newDevices);
-#endif
-        
-        std::lock_guard<std::mutex> lock(devicesMutex);
-        devices = std::move(newDevices);
+void SmartBlueprintCore::publishSnapshot() {
+    // Recycling the older snapshot first releases the device copies that only it referenced
+    std::shared_ptr<DeviceSnapshot> next = recycleSnapshot();
+
+    // Copy-on-write: only devices processed this cycle get a fresh copy, the
+    // rest share the object already published in the previous snapshot
+    for (const auto& device : changedDevices) {
+        uint32_t id = device->deviceId;
+        if (id >= publishedById.size()) {
+            publishedById.resize(id + 1);
+            retiredById.resize(id + 1);
+        }
+        auto copy = copyForSnapshot(*device);
+        retiredById[id] = std::move(publishedById[id]);
+        publishedById[id] = std::move(copy);
     }
     
-#ifdef _WIN32
-    void performWindowsNetworkScan(std::vector<std::shared_ptr<Device>>& newDevices) {
-        // Windows-specific network scanning using WinAPI
-        PMIB_IPNETTABLE pIpNetTable = nullptr;
-        DWORD dwSize = 0;
-        DWORD dwRetVal = 0;
-        
-        // Get size needed for IP Net Table
-        if (GetIpNetTable(pIpNetTable, &dwSize, FALSE) == ERROR_INSUFFICIENT_BUFFER) {
-            pIpNetTable = (MIB_IPNETTABLE*)malloc(dwSize);
-            
-            if ((dwRetVal = GetIpNetTable(pIpNetTable, &dwSize, FALSE)) == NO_ERROR) {
-                for (DWORD i = 0; i < pIpNetTable->dwNumEntries; i++) {
-                    MIB_IPNETROW ipNetRow = pIpNetTable->table[i];
-                    
-                    // Convert MAC address to string
-                    char macStr[18];
-                    sprintf_s(macStr, 18, "%02X:%02X:%02X:%02X:%02X:%02X",
-                        ipNetRow.bPhysAddr[0], ipNetRow.bPhysAddr[1],
-                        ipNetRow.bPhysAddr[2], ipNetRow.bPhysAddr[3],
-                        ipNetRow.bPhysAddr[4], ipNetRow.bPhysAddr[5]);
-                    
-                    // Convert IP address to string
-                    struct in_addr addr;
-                    addr.S_un.S_addr = ipNetRow.dwAddr;
-                    std::string ipStr = inet_ntoa(addr);
-                    
-                    auto device = std::make_shared<Device>(macStr, ipStr);
-                    device->isOnline = (ipNetRow.dwType == MIB_IPNET_TYPE_DYNAMIC);
-                    
-                    newDevices.push_back(device);
-                }
-            }
-            
-            if (pIpNetTable) {
-                free(pIpNetTable);
-            }
+    next->version = snapshotVersion.load(std::memory_order_relaxed) + 1;
+    next->publishedAt = std::chrono::system_clock::now();
+    next->stale = restoredState && scanner->completedScanCount() == 0;
+    reserveWithHeadroom(next->devices, currentDevices.size());
+    for (const auto& device : currentDevices) {
+        uint32_t id = device->deviceId;
+        if (id >= publishedById.size()) {
+            publishedById.resize(id + 1);
+            retiredById.resize(id + 1);
         }
+        if (!publishedById[id]) {
+            publishedById[id] = allocateDevice(*device);
+        }
+        next->devices.push_back(publishedById[id]);
+    }
+    reserveWithHeadroom(next->anomalies, currentAnomalies.size());
+    for (const auto& anomaly : currentAnomalies) {
+        next->anomalies.push_back({publishedById[anomaly.first->deviceId], anomaly.second});
     }
-#endif
-
-#ifdef __APPLE__
-    void performMacOSNetworkScan(std::vector<std::shared_ptr<Device>>& newDevices) {
-        // macOS-specific network scanning using Core WLAN
-        @autoreleasepool {
-            CWWiFiClient* wifiClient = [CWWiFiClient sharedWiFiClient];
-            CWInterface* interface = [wifiClient interface];
-            
-            if (interface) {
-                NSSet<CWNetwork*>* networks = [interface scanForNetworksWithName:nil error:nil];
-                
-                for (CWNetwork* network in networks) {
-                    NSString* bssid = [network bssid];
-                    NSNumber* rssiValue = [NSNumber numberWithInteger:[network rssiValue]];
-                    
-                    if (bssid) {
-                        std::string macStr = [bssid UTF8String];
-                        auto device = std::make_shared<Device>(macStr, "");
-                        device->rssi = [rssiValue intValue];
-                        device->isOnline = true;
-                        
-                        newDevices.push_back(device);
-                    }
-                }
+    
+    uint64_t version = next->version;
+    std::atomic_store_explicit(&snapshot, std::shared_ptr<const DeviceSnapshot>(next), std::memory_order_release);
+    snapshotVersion.fetch_add(1, std::memory_order_release);
+    spareSnapshot = std::move(publishedSnapshot);
+    publishedSnapshot = std::move(next);
+    
+    if (ipcPublisher.isOpen()) {
+        removedIds.clear();
+        for (const auto& change : processingChanges) {
+            if (change.type == DeviceChangeType::Removed) {
+                removedIds.push_back(change.deviceId);
             }
         }
+        ipcPublisher.publish(changedDevices, removedIds, currentAnomalies, version);
     }
-#endif
+}
 
-#ifdef __ANDROID__
-    void performAndroidNetworkScan(std::vector<std::shared_ptr<Device>>& newDevices) {
-        // Android-specific network scanning via JNI
-        // This would require proper JNI setup and Android permissions
-        __android_log_print(ANDROID_LOG_INFO, "SmartBlueprint", "Performing Android network scan");
+void SmartBlueprintCore::dropDevice(uint32_t id) {
+    // Filter and rolling statistics too, or the ID's next device would
+    // start from the old one's converged estimate
+    signalProcessor->resetDevice(id);
+    mlEngine->resetDevice(id);
+    if (id < devicesById.size()) {
+        devicesById[id].reset();
     }
-#endif
+    if (id < publishedById.size()) {
+        publishedById[id].reset();
+        retiredById[id].reset();
+    }
+}
 
-#ifdef __linux__
-    void performLinuxNetworkScan(std::vector<std::shared_ptr<Device>>& newDevices) {
-        // Linux-specific network scanning using /proc/net/arp
-        std::ifstream arpFile("/proc/net/arp");
-        std::string line;
-        
-        // Skip header line
-        std::getline(arpFile, line);
-        
-        while (std::getline(arpFile, line)) {
-            std::istringstream iss(line);
-            std::string ip, hwType, flags, hwAddr, mask, device;
-            
-            if (iss >> ip >> hwType >> flags >> hwAddr >> mask >> device) {
-                if (hwAddr != "00:00:00:00:00:00") {
-                    auto devicePtr = std::make_shared<Device>(hwAddr, ip);
-                    devicePtr->isOnline = true;
-                    newDevices.push_back(devicePtr);
-                }
-            }
-        }
+std::shared_ptr<DeviceSnapshot> SmartBlueprintCore::recycleSnapshot() {
+    // Only we can still reach a spare nobody else holds, and the acquire
+    // fence orders our writes after the last reader's release of it
+    if (spareSnapshot && spareSnapshot.use_count() == 1) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        auto recycled = std::move(spareSnapshot);
+        recycled->devices.clear();
+        recycled->anomalies.clear();
+        return recycled;
+    }
+    spareSnapshot.reset();
+    return std::make_shared<DeviceSnapshot>();
+}
+
+std::shared_ptr<NetworkDevice> SmartBlueprintCore::copyForSnapshot(const NetworkDevice& device) {
+    // The copy retired last time is overwritten in place when no snapshot
+    // holds it any more; its strings keep their capacity
+    auto& retired = retiredById[device.deviceId];
+    if (retired && retired.use_count() == 1) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        *retired = device;
+        return std::move(retired);
     }
-#endif
-};
+    return allocateDevice(device);
+}
 
-class MLAnomalyDetector {
-private:
-    std::vector<std::vector<double>> trainingData;
-    std::vector<double> thresholds;
-    
-public:
-    void trainModel(const std::vector<std::shared_ptr<Device>>& devices) {
-        // Simple anomaly detection based on RSSI patterns
-        trainingData.clear();
-        
-        for (const auto& device : devices) {
-            std::vector<double> features;
-            features.push_back(static_cast<double>(device->rssi));
-            features.push_back(device->isOnline ? 1.0 : 0.0);
-            
-            trainingData.push_back(features);
-        }
-        
-        // Calculate thresholds (simplified)
-        if (!trainingData.empty()) {
-            thresholds.resize(trainingData[0].size());
-            for (size_t i = 0; i < thresholds.size(); ++i) {
-                double sum = 0.0;
-                for (const auto& sample : trainingData) {
-                    sum += sample[i];
-                }
-                thresholds[i] = sum / trainingData.size();
-            }
+std::shared_ptr<const DeviceSnapshot> SmartBlueprintCore::getSnapshot() const {
+    return std::atomic_load_explicit(&snapshot, std::memory_order_acquire);
+}
+
+MetricsSnapshot SmartBlueprintCore::getMetrics() const {
+    return Metrics::snapshot();
+}
+
+std::vector<std::shared_ptr<NetworkDevice>> SmartBlueprintCore::getCurrentDevices() {
+    return getSnapshot()->devices;
+}
+
+void SmartBlueprintCore::getCurrentDevices(std::vector<std::shared_ptr<NetworkDevice>>& devices) const {
+    auto current = getSnapshot();
+    devices.assign(current->devices.begin(), current->devices.end());
+}
+
+std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>> SmartBlueprintCore::detectAnomalies() {
+    return getSnapshot()->anomalies;
+}
+
+bool SmartBlueprintCore::enableSignalHistory(const std::string& path, const SignalHistoryStore::Options& options) {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    return signalHistory.open(path, options);
+}
+
+size_t SmartBlueprintCore::getSignalHistory(MacAddress mac, float* rssi, int64_t* timestamps, size_t capacity) const {
+    return signalHistory.readSamples(mac, rssi, timestamps, capacity);
+}
+
+bool SmartBlueprintCore::saveModel(const std::string& path) {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    return mlEngine->saveModel(path);
+}
+
+bool SmartBlueprintCore::loadModel(const std::string& path) {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    return mlEngine->loadModel(path);
+}
+
+bool SmartBlueprintCore::saveDeviceState(const std::string& path) const {
+    return DeviceStateFile::save(path, getSnapshot()->devices);
+}
+
+bool SmartBlueprintCore::loadDeviceState(const std::string& path) {
+    std::vector<NetworkDevice> restored;
+    if (!DeviceStateFile::load(path, restored)) return false;
+
+    scanner->restoreDevices(restored);
+
+    // Publish right away; the restored copies are reprocessed like any
+    // other device once scans report them
+    std::lock_guard<std::mutex> lock(dataMutex);
+    restoredState = true;
+    const DeviceIdTable& ids = scanner->getDeviceIds();
+    for (const auto& device : restored) {
+        uint32_t id = ids.find(device.mac);
+        if (id == DeviceIdTable::kInvalidId) continue;
+        if (id >= devicesById.size()) {
+            devicesById.resize(id + 1);
         }
+        if (devicesById[id]) continue;
+
+        // Unlike the scanner's copies ours keep the saved type, vendor and summary
+        devicesById[id] = allocateDevice(device);
+        devicesById[id]->deviceId = id;
+        devicesById[id]->isOnline = false;
     }
-    
-    double detectAnomaly(const std::shared_ptr<Device>& device) {
-        if (thresholds.empty()) return 0.0;
-        
-        std::vector<double> features;
-        features.push_back(static_cast<double>(device->rssi));
-        features.push_back(device->isOnline ? 1.0 : 0.0);
-        
-        double anomalyScore = 0.0;
-        for (size_t i = 0; i < features.size() && i < thresholds.size(); ++i) {
-            double deviation = std::abs(features[i] - thresholds[i]);
-            anomalyScore += deviation;
+    currentDevices.clear();
+    for (const auto& device : devicesById) {
+        if (device) {
+            currentDevices.push_back(device);
         }
-        
-        return anomalyScore / features.size();
     }
-};
+    changedDevices = currentDevices;
+    publishSnapshot();
+    changedDevices.clear();
+    return true;
+}
 
-class SmartBlueprintCore {
-private:
-    std::unique_ptr<NetworkScanner> scanner;
-    std::unique_ptr<MLAnomalyDetector> anomalyDetector;
-    bool isRunning;
+bool SmartBlueprintCore::loadVendorDatabase(const std::string& path, const std::string& indexPath) {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    if (!classifier->loadVendorDatabase(path)) return false;
+
+    const OuiDatabase& vendors = classifier->getVendorDatabase();
+    if (!indexPath.empty() && !vendors.isMapped() && !vendors.saveIndex(indexPath)) {
+        std::cerr << "Couldn't save vendor index to " << indexPath << std::endl;
+    }
+    return true;
+}
 
-public:
-    SmartBlueprintCore() : isRunning(false) {
-        scanner = std::make_unique<NetworkScanner>();
-        anomalyDetector = std::make_unique<MLAnomalyDetector>();
+bool SmartBlueprintCore::startExport(const std::string& path, ExportFormat format, bool includeHistory) {
+    // Snapshot devices are never modified, so the worker can read them freely
+    auto current = getSnapshot();
+    if (!includeHistory) {
+        return exporter.startDeviceExport(path, format, current->devices);
     }
+    if (!signalHistory.isOpen()) return false;
     
-    void start() {
-        if (isRunning) return;
-        
-        isRunning = true;
-        scanner->startScanning();
-        
-        // Start ML training thread
-        std::thread mlThread([this]() {
-            while (isRunning) {
-                auto devices = scanner->getDevices();
-                if (!devices.empty()) {
-                    anomalyDetector->trainModel(devices);
-                }
-                std::this_thread::sleep_for(std::chrono::minutes(5));
-            }
-        });
-        mlThread.detach();
+    std::vector<MacAddress> macs;
+    macs.reserve(current->devices.size());
+    for (const auto& device : current->devices) {
+        macs.push_back(device->mac);
+    }
+    return exporter.startHistoryExport(path, format, signalHistory, std::move(macs),
+                                       std::numeric_limits<int64_t>::min());
+}
+
+bool SmartBlueprintCore::enableIpc(const std::string& name, const std::string& controlPath) {
+    {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        if (!ipcPublisher.open(name)) return false;
+    }
+    if (controlPath.empty()) return true;
+    
+    return ipcControl.start(controlPath, [this](std::string_view request) {
+        return handleControlRequest(request);
+    });
+}
+
+std::string SmartBlueprintCore::handleControlRequest(std::string_view request) {
+    if (request == "PING") {
+        return "PONG";
+    }
+    if (request == "INFO") {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        return "OK shm=" + ipcPublisher.name() + " layout=" + std::to_string(kIpcLayoutVersion) +
+               " version=" + std::to_string(ipcPublisher.snapshotVersion()) +
+               " devices=" + std::to_string(ipcPublisher.deviceCount()) +
+               " anomalies=" + std::to_string(ipcPublisher.anomalyCount());
+    }
+    if (request == "SCAN") {
+        performScan();
+        return "OK";
+    }
+    if (request == "METRICS") {
+        return formatMetricsJson(getMetrics());
+    }
+    return "ERR unknown request";
+}
+
+void SmartBlueprintCore::performScan() {
+    scanner->performNetworkScan();
+}
+
+void SmartBlueprintCore::runMonitoringCycle(bool fullPass) {
+    scanner->performNetworkScan();
+    {
+        std::lock_guard<std::mutex> lock(changeMutex);
+        processingChanges.swap(pendingChanges);
+        pendingChanges.clear();
+    }
+    processChanges(fullPass);
+    processingChanges.clear();
+}
+
+void SmartBlueprintCore::updateDeviceClassifications(const std::vector<std::shared_ptr<NetworkDevice>>& devices) {
+    SB_SCOPED_TIMER(Classification);
+    // Every device goes through the classifier cache, so hostname changes are
+    // picked up while unchanged devices cost one hash lookup
+    for (auto& device : devices) {
+        device->deviceType = classifier->classifyDevice(device);
+        if (device->vendor.empty()) {
+            device->vendor = std::string(classifier->identifyVendor(device->mac));
+        }
     }
+}
+
+void SmartBlueprintCore::processSignalData(const std::vector<std::shared_ptr<NetworkDevice>>& devices) {
+    SB_SCOPED_TIMER(SignalProcessing);
+    size_t count = devices.size();
+    signalDeviceIds.resize(count);
+    signalMeasurements.resize(count);
+    filteredSignals.resize(count);
     
-    void stop() {
-        isRunning = false;
-        scanner->stopScanning();
+    // Filters are indexed by the scanner's interned device ID, so the tick is pure array work
+    for (size_t i = 0; i < count; ++i) {
+        signalDeviceIds[i] = devices[i]->deviceId;
+        signalMeasurements[i] = static_cast<float>(devices[i]->rssi);
     }
     
-    std::vector<std::shared_ptr<Device>> getCurrentDevices() {
-        return scanner->getDevices();
+    // Process RSSI for signal smoothing
+    signalProcessor->processRSSIBatch(signalDeviceIds.data(), signalMeasurements.data(), count, filteredSignals.data());
+    
+    for (size_t i = 0; i < count; ++i) {
+        NetworkDevice& device = *devices[i];
+        device.rssi = static_cast<int>(filteredSignals[i]);
+        // Offline devices repeat their last reading, restored ones included,
+        // and a full pass repeats unchanged ones
+        bool reported = device.deviceId < reportedMask.size() && reportedMask[device.deviceId];
+        if (device.isOnline && reported) {
+            device.summary.addSignal(filteredSignals[i]);
+            device.summary.addAddress(device.ipAddress);
+        }
     }
     
-    std::vector<std::pair<std::shared_ptr<Device>, double>> detectAnomalies() {
-        std::vector<std::pair<std::shared_ptr<Device>, double>> anomalies;
-        auto devices = scanner->getDevices();
-        
+    if (signalHistory.isOpen()) {
+        int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
         for (const auto& device : devices) {
-            double score = anomalyDetector->detectAnomaly(device);
-            if (score > 0.5) { // Threshold for anomaly detection
-                anomalies.push_back({device, score});
-            }
+            uint8_t flags = device->isOnline ? SignalHistoryStore::kSampleOnline : 0;
+            signalHistory.append(device->mac, now, device->rssi, flags);
         }
-        
-        return anomalies;
     }
-};
-
-} // namespace SmartBlueprint
\ No newline at end of file
+}
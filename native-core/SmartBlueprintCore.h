@@ -4,24 +4,101 @@
 #include "MLEngine.h"
 #include "DeviceClassifier.h"
 #include "SignalProcessor.h"
+#include "Metrics.h"
+#include "SignalHistoryStore.h"
+#include "DeviceExporter.h"
+#include "DeviceStateFile.h"
+#include "IpcBridge.h"
+#include "TaskScheduler.h"
 #include <vector>
 #include <memory>
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <chrono>
+
+// Immutable view of the core's state after one monitoring cycle. The device
+// objects are private copies that are never modified once published, so
+// readers can use them freely from any thread.
+struct DeviceSnapshot {
+    uint64_t version = 0; // increases with every publication
+    std::chrono::system_clock::time_point publishedAt;
+    bool stale = false; // devices restored from the last run that no scan has confirmed yet
+    std::vector<std::shared_ptr<NetworkDevice>> devices;
+    std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>> anomalies;
+};
 
 class SmartBlueprintCore {
 public:
     SmartBlueprintCore();
+    // Monitors devices from the given scanner, e.g. one driving a SyntheticBackend
+    explicit SmartBlueprintCore(std::unique_ptr<NetworkScanner> networkScanner);
     ~SmartBlueprintCore();
     
+    // Cycles run as tasks on the shared TaskScheduler whenever the scanner
+    // reports changes, plus a full pass every kFullPassInterval.
+    // stopMonitoring() waits for a cycle in progress; call it from outside
+    // the scheduler's tasks.
     void startMonitoring();
     void stopMonitoring();
     
+    // Latest published snapshot; never blocks on the monitoring thread.
+    // Compare version with a previously seen snapshot to skip unchanged data.
+    std::shared_ptr<const DeviceSnapshot> getSnapshot() const;
+    uint64_t getSnapshotVersion() const { return snapshotVersion.load(std::memory_order_acquire); }
+    
     std::vector<std::shared_ptr<NetworkDevice>> getCurrentDevices();
+    // Replaces the contents of devices with the latest snapshot's, reusing its capacity
+    void getCurrentDevices(std::vector<std::shared_ptr<NetworkDevice>>& devices) const;
     std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>> detectAnomalies();
     
+    // Stage latencies and counters for the whole process; see Metrics.h for
+    // formatMetricsPrometheus() and formatMetricsJson()
+    MetricsSnapshot getMetrics() const;
+    
+    // Persists every filtered RSSI sample to a memory-mapped history file,
+    // reopening any history already there. Call before startMonitoring().
+    bool enableSignalHistory(const std::string& path,
+                             const SignalHistoryStore::Options& options = SignalHistoryStore::Options());
+    // Most recent samples for one device, oldest first, for the float-span
+    // SignalProcessor APIs or model training. Safe from any thread.
+    size_t getSignalHistory(MacAddress mac, float* rssi, int64_t* timestamps, size_t capacity) const;
+    
+    // Anomaly model snapshots; a loaded model scores from the next cycle on,
+    // so detection works from the first scan after a restart. Safe while
+    // monitoring is running.
+    bool saveModel(const std::string& path);
+    bool loadModel(const std::string& path);
+    
+    // Last-known device table (DeviceStateFile.h). Loading seeds the scanner
+    // with the saved devices and publishes them at once as a stale snapshot,
+    // which the first completed scan replaces; call it before
+    // startMonitoring(). Saving writes the latest snapshot's devices.
+    bool saveDeviceState(const std::string& path) const;
+    bool loadDeviceState(const std::string& path);
+    
+    // Prebuilt OUI index (mapped) or IEEE registry file for vendor lookups.
+    // A registry is parsed, and then saved to indexPath if one is given, so
+    // the next start can map it instead.
+    bool loadVendorDatabase(const std::string& path, const std::string& indexPath = std::string());
+    
+    // Writes the devices of the latest snapshot, or the signal history of
+    // each of them, on a background worker so callers never block. Returns
+    // false while an export is running or when history is requested but not
+    // enabled; the outcome is collected with takeExportResult().
+    bool startExport(const std::string& path, ExportFormat format, bool signalHistory = false);
+    bool isExporting() const { return exporter.isRunning(); }
+    bool takeExportResult(ExportResult& result) { return exporter.takeResult(result); }
+    
+    // Publishes every cycle into a shared-memory region for other local
+    // processes (IpcBridge.h) and, unless controlPath is empty, answers PING,
+    // INFO, SCAN and METRICS on a control socket. Call before startMonitoring().
+    bool enableIpc(const std::string& name, const std::string& controlPath);
+    
     void performScan();
+    // One synchronous scan and processing cycle on the calling thread, as the
+    // monitoring thread would run it. Not for use while monitoring is running.
+    void runMonitoringCycle(bool fullPass = false);
     bool isMonitoring() const { return monitoring; }
     
 private:
@@ -29,15 +106,69 @@ private:
     std::unique_ptr<MLEngine> mlEngine;
     std::unique_ptr<DeviceClassifier> classifier;
     std::unique_ptr<SignalProcessor> signalProcessor;
+    SignalHistoryStore signalHistory;
+    DeviceExporter exporter; // declared after signalHistory so it stops first
+    IpcPublisher ipcPublisher;
+    std::vector<uint32_t> removedIds; // per-cycle scratch for ipcPublisher
     
     std::atomic<bool> monitoring;
-    std::thread monitoringThread;
+    bool restoredState; // published snapshots are stale until the scanner completes a scan
+    TaskHandle fullPassTask;
     std::mutex dataMutex;
     
+    // Scanner deltas waiting for the next cycle. At most one cycle task is
+    // queued or running at a time; it requeues itself while work remains.
+    std::mutex changeMutex;
+    std::vector<DeviceChange> pendingChanges;
+    std::vector<DeviceChange> processingChanges;
+    TaskHandle cycleTask;
+    bool cycleQueued;
+    bool fullPassDue;
+    
+    // Everything is reprocessed at least this often, since time-based features drift
+    static constexpr std::chrono::seconds kFullPassInterval{60};
+    
+    // Our own device records, indexed by deviceId and null when absent. The
+    // scanner's fields are copied in each cycle under its lock; type, vendor
+    // and the filtered signal are ours. Only the cycle writes them, holding
+    // dataMutex.
+    std::vector<std::shared_ptr<NetworkDevice>> devicesById;
     std::vector<std::shared_ptr<NetworkDevice>> currentDevices;
     std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>> currentAnomalies;
     
-    void monitoringLoop();
-    void updateDeviceClassifications();
-    void processSignalData();
+    // Per-tick scratch for batched signal filtering; like every per-cycle
+    // buffer here it keeps its capacity, so steady-state cycles don't allocate
+    std::vector<uint32_t> signalDeviceIds;
+    std::vector<float> signalMeasurements;
+    std::vector<float> filteredSignals;
+    std::vector<std::shared_ptr<NetworkDevice>> changedDevices;
+    std::vector<uint32_t> processIds;
+    std::vector<uint8_t> changedMask; // indexed by deviceId
+    std::vector<uint8_t> reportedMask; // deviceIds with a change this cycle, which feed the summaries
+    
+    // Published with atomic_store; only the cycle task writes
+    std::shared_ptr<const DeviceSnapshot> snapshot;
+    std::atomic<uint64_t> snapshotVersion;
+    std::vector<std::shared_ptr<NetworkDevice>> publishedById; // snapshot copies, indexed by deviceId
+    // The copies publishedById replaced, and the snapshot before the current
+    // one; each is reused in place once no reader holds it any more
+    std::vector<std::shared_ptr<NetworkDevice>> retiredById;
+    std::shared_ptr<DeviceSnapshot> publishedSnapshot;
+    std::shared_ptr<DeviceSnapshot> spareSnapshot;
+    
+    // Last member, so its thread stops before anything a request touches
+    IpcControlServer ipcControl;
+    
+    void runCycle();
+    void requestFullPass();
+    void queueCycleLocked();
+    void onDeviceChanges(const std::vector<DeviceChange>& changes);
+    void processChanges(bool fullPass);
+    void publishSnapshot();
+    void dropDevice(uint32_t id);
+    std::shared_ptr<DeviceSnapshot> recycleSnapshot();
+    std::shared_ptr<NetworkDevice> copyForSnapshot(const NetworkDevice& device);
+    std::string handleControlRequest(std::string_view request);
+    void updateDeviceClassifications(const std::vector<std::shared_ptr<NetworkDevice>>& devices);
+    void processSignalData(const std::vector<std::shared_ptr<NetworkDevice>>& devices);
 };
\ No newline at end of file
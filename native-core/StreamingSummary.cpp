@@ -0,0 +1,218 @@
+#include "StreamingSummary.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Arcsine scale: a centroid may cover at most one unit of k, so centroids
+// near the median hold many samples and those at the tails only a few
+double scale(double q) {
+    double x = std::max(-1.0, std::min(1.0, 2.0 * q - 1.0));
+    return TDigest::kCompression / (2.0 * kPi) * std::asin(x);
+}
+
+} // namespace
+
+void RunningMoments::add(double value) {
+    if (samples == 0) {
+        minValue = value;
+        maxValue = value;
+    } else {
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+    }
+
+    samples++;
+    double delta = value - meanValue;
+    meanValue += delta / static_cast<double>(samples);
+    m2 += delta * (value - meanValue);
+}
+
+void RunningMoments::merge(const RunningMoments& other) {
+    if (other.samples == 0) return;
+    if (samples == 0) {
+        *this = other;
+        return;
+    }
+
+    double n = static_cast<double>(samples + other.samples);
+    double delta = other.meanValue - meanValue;
+    meanValue += delta * static_cast<double>(other.samples) / n;
+    m2 += other.m2 + delta * delta * static_cast<double>(samples) * static_cast<double>(other.samples) / n;
+    samples += other.samples;
+    minValue = std::min(minValue, other.minValue);
+    maxValue = std::max(maxValue, other.maxValue);
+}
+
+double RunningMoments::stdDev() const {
+    return std::sqrt(variance());
+}
+
+void TDigest::add(float value) {
+    if (count() == 0) {
+        minValue = value;
+        maxValue = value;
+    } else {
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+    }
+
+    buffer[bufferedCount++] = value;
+    if (bufferedCount == kBufferSize) {
+        flush();
+    }
+}
+
+void TDigest::merge(const TDigest& other) {
+    if (other.count() == 0) return;
+    if (count() == 0) {
+        *this = other;
+        return;
+    }
+
+    TDigest incoming = other;
+    incoming.flush();
+    flush();
+
+    Centroid combined[2 * kMaxCentroids];
+    size_t used = 0;
+    for (size_t i = 0; i < centroids; ++i) combined[used++] = centroid[i];
+    for (size_t i = 0; i < incoming.centroids; ++i) combined[used++] = incoming.centroid[i];
+    std::sort(combined, combined + used, [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+
+    minValue = std::min(minValue, incoming.minValue);
+    maxValue = std::max(maxValue, incoming.maxValue);
+    compress(combined, used, totalWeight + incoming.totalWeight);
+}
+
+void TDigest::flush() {
+    if (bufferedCount == 0) return;
+
+    Centroid combined[kMaxCentroids + kBufferSize];
+    size_t used = 0;
+    for (size_t i = 0; i < centroids; ++i) combined[used++] = centroid[i];
+    for (size_t i = 0; i < bufferedCount; ++i) combined[used++] = {buffer[i], 1.0f};
+    std::sort(combined, combined + used, [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+
+    double weight = totalWeight + bufferedCount;
+    bufferedCount = 0;
+    compress(combined, used, weight);
+}
+
+void TDigest::compress(Centroid* sorted, size_t size, double weight) {
+    size_t out = 0;
+    double before = 0.0; // weight of the centroids already written
+    Centroid current = sorted[0];
+
+    for (size_t i = 1; i < size; ++i) {
+        double proposed = static_cast<double>(current.weight) + sorted[i].weight;
+        bool fits = scale((before + proposed) / weight) - scale(before / weight) <= 1.0;
+        // The scale bound keeps well under kMaxCentroids; the size check only guards rounding
+        if (fits || out + 2 > kMaxCentroids) {
+            current.mean += static_cast<float>((sorted[i].mean - current.mean) * sorted[i].weight / proposed);
+            current.weight = static_cast<float>(proposed);
+        } else {
+            before += current.weight;
+            centroid[out++] = current;
+            current = sorted[i];
+        }
+    }
+
+    centroid[out++] = current;
+    centroids = static_cast<uint8_t>(out);
+    totalWeight = weight;
+}
+
+float TDigest::quantile(double q) const {
+    if (count() == 0) return 0.0f;
+
+    const TDigest* digest = this;
+    TDigest flushed;
+    if (bufferedCount > 0) {
+        flushed = *this;
+        flushed.flush();
+        digest = &flushed;
+    }
+
+    const Centroid* c = digest->centroid;
+    size_t n = digest->centroids;
+    double target = std::max(0.0, std::min(1.0, q)) * digest->totalWeight;
+
+    // Each centroid sits at the middle of its weight; the tails interpolate
+    // towards the exact extremes
+    double firstCenter = c[0].weight / 2.0;
+    if (target <= firstCenter) {
+        return static_cast<float>(minValue + (c[0].mean - minValue) * (firstCenter > 0 ? target / firstCenter : 1.0));
+    }
+
+    double cumulative = 0.0;
+    for (size_t i = 0; i + 1 < n; ++i) {
+        double center = cumulative + c[i].weight / 2.0;
+        double nextCenter = cumulative + c[i].weight + c[i + 1].weight / 2.0;
+        if (target <= nextCenter) {
+            double t = (target - center) / (nextCenter - center);
+            return static_cast<float>(c[i].mean + (c[i + 1].mean - c[i].mean) * t);
+        }
+        cumulative += c[i].weight;
+    }
+
+    double lastCenter = digest->totalWeight - c[n - 1].weight / 2.0;
+    double tail = digest->totalWeight - lastCenter;
+    double t = tail > 0 ? (target - lastCenter) / tail : 1.0;
+    return static_cast<float>(c[n - 1].mean + (maxValue - c[n - 1].mean) * std::min(1.0, t));
+}
+
+void HyperLogLog::add(uint64_t hash) {
+    size_t index = static_cast<size_t>(hash >> (64 - kPrecision));
+    uint64_t rest = hash << kPrecision;
+
+    // Position of the first set bit after the index bits
+    uint8_t rank = 1;
+    while (rank <= 64 - kPrecision && !(rest & (uint64_t(1) << 63))) {
+        rest <<= 1;
+        rank++;
+    }
+    registers[index] = std::max(registers[index], rank);
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+    for (size_t i = 0; i < kRegisters; ++i) {
+        registers[i] = std::max(registers[i], other.registers[i]);
+    }
+}
+
+double HyperLogLog::estimate() const {
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (uint8_t value : registers) {
+        sum += std::ldexp(1.0, -static_cast<int>(value));
+        if (value == 0) zeros++;
+    }
+
+    const double m = static_cast<double>(kRegisters);
+    const double alpha = 0.709; // bias correction for 64 registers
+    double raw = alpha * m * m / sum;
+
+    // Linear counting is far more accurate while registers are still empty
+    if (raw <= 2.5 * m && zeros > 0) {
+        return m * std::log(m / static_cast<double>(zeros));
+    }
+    return raw;
+}
+
+uint64_t HyperLogLog::hashValue(std::string_view value) {
+    uint64_t hash = 1469598103934665603ull;
+    for (char c : value) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
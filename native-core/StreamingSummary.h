@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Fixed-size summaries of unbounded sample streams. Each one takes samples
+// one at a time, never allocates, and merges with another summary of the
+// same kind, so per-device state stays the same size however long a device
+// has been monitored, and windows or shards can be combined afterwards.
+
+// Count, mean, variance (Welford) and range
+class RunningMoments {
+public:
+    void add(double value);
+    // Chan et al. pairwise combination; same result as adding other's samples here
+    void merge(const RunningMoments& other);
+    void reset() { *this = RunningMoments(); }
+
+    uint64_t count() const { return samples; }
+    double mean() const { return samples ? meanValue : 0.0; }
+    double variance() const { return samples ? m2 / static_cast<double>(samples) : 0.0; } // population
+    double stdDev() const;
+    double min() const { return samples ? minValue : 0.0; }
+    double max() const { return samples ? maxValue : 0.0; }
+
+private:
+    uint64_t samples = 0;
+    double meanValue = 0.0;
+    double m2 = 0.0;
+    double minValue = 0.0;
+    double maxValue = 0.0;
+};
+
+// Merging t-digest with the arcsine scale function over fixed arrays. With
+// compression 20 a digest never holds more than 21 centroids; quantiles are
+// exact until samples need merging and are tightest towards the tails.
+class TDigest {
+public:
+    static constexpr size_t kMaxCentroids = 24;
+    static constexpr size_t kBufferSize = 8;
+    static constexpr double kCompression = 20.0;
+
+    void add(float value);
+    void merge(const TDigest& other);
+    void reset() { *this = TDigest(); }
+
+    double count() const { return totalWeight + bufferedCount; }
+    // q in [0, 1]; 0 when empty
+    float quantile(double q) const;
+    size_t centroidCount() const { return centroids; }
+
+private:
+    struct Centroid {
+        float mean;
+        float weight;
+    };
+
+    Centroid centroid[kMaxCentroids] = {};
+    float buffer[kBufferSize] = {};
+    uint8_t centroids = 0;
+    uint8_t bufferedCount = 0;
+    float minValue = 0.0f;
+    float maxValue = 0.0f;
+    double totalWeight = 0.0; // of the centroids, not the buffer
+
+    // Folds the buffered samples into the centroids
+    void flush();
+    // Replaces the centroids with the compressed form of sorted[0, size)
+    void compress(Centroid* sorted, size_t size, double weight);
+};
+
+// Distinct-count estimate over 64 registers (about 13% standard error,
+// near exact for the handful of values a single device usually shows)
+class HyperLogLog {
+public:
+    static constexpr size_t kPrecision = 6;
+    static constexpr size_t kRegisters = size_t(1) << kPrecision;
+
+    void add(uint64_t hash);
+    void add(std::string_view value) { add(hashValue(value)); }
+    void merge(const HyperLogLog& other);
+    void reset() { *this = HyperLogLog(); }
+
+    double estimate() const;
+
+    // FNV-1a with a final mix, so every bit of the hash depends on the value
+    static uint64_t hashValue(std::string_view value);
+
+private:
+    uint8_t registers[kRegisters] = {};
+};
+
+// Everything kept about one device's signal and addresses over its whole
+// lifetime on the network
+struct DeviceSummary {
+    RunningMoments rssi;
+    TDigest rssiQuantiles;
+    HyperLogLog addresses; // distinct IP addresses seen
+
+    void addSignal(float rssiValue) {
+        rssi.add(rssiValue);
+        rssiQuantiles.add(rssiValue);
+    }
+
+    void addAddress(std::string_view address) {
+        if (!address.empty()) addresses.add(address);
+    }
+
+    void merge(const DeviceSummary& other) {
+        rssi.merge(other.rssi);
+        rssiQuantiles.merge(other.rssiQuantiles);
+        addresses.merge(other.addresses);
+    }
+
+    void reset() { *this = DeviceSummary(); }
+};
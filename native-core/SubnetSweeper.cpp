@@ -0,0 +1,414 @@
+#include "SubnetSweeper.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <winternl.h>
+#include <iphlpapi.h>
+#include <icmpapi.h>
+#pragma comment(lib, "iphlpapi.lib")
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <poll.h>
+#else
+#include <sys/epoll.h>
+#endif
+#endif
+
+namespace {
+
+constexpr size_t kPayloadSize = 8;
+
+uint32_t prefixMask(uint32_t prefixLength) {
+    return prefixLength == 0 ? 0 : 0xFFFFFFFFu << (32 - prefixLength);
+}
+
+uint32_t maskToPrefix(uint32_t mask) {
+    uint32_t prefixLength = 0;
+    while (prefixLength < 32 && (mask & (0x80000000u >> prefixLength))) {
+        prefixLength++;
+    }
+    return prefixLength;
+}
+
+#ifdef _WIN32
+
+// Echo requests are issued with IcmpSendEcho2 and complete as APCs on the
+// sweeping thread whenever it waits alertably, so one thread keeps up to
+// maxInFlight probes outstanding.
+class ProbeEngine {
+public:
+    ~ProbeEngine() {
+        if (icmpHandle == INVALID_HANDLE_VALUE) return;
+
+        // Reply buffers must outlive every outstanding request
+        ULONGLONG deadline = GetTickCount64() + timeoutMs + 1000;
+        while (pending() && GetTickCount64() < deadline) {
+            SleepEx(50, TRUE);
+        }
+        IcmpCloseHandle(icmpHandle);
+    }
+
+    bool open(unsigned maxInFlight, DWORD replyTimeoutMs) {
+        icmpHandle = IcmpCreateFile();
+        if (icmpHandle == INVALID_HANDLE_VALUE) {
+            std::cerr << "IcmpCreateFile failed: " << GetLastError() << std::endl;
+            return false;
+        }
+
+        timeoutMs = replyTimeoutMs;
+        probes.resize(std::max(1u, maxInFlight));
+        for (size_t i = 0; i < probes.size(); ++i) {
+            probes[i].engine = this;
+            freeSlots.push_back(static_cast<uint32_t>(probes.size() - 1 - i));
+        }
+        return true;
+    }
+
+    // Returns false when every slot is busy and the caller should wait first
+    bool send(uint32_t address, uint16_t) {
+        if (freeSlots.empty()) return false;
+
+        Probe& probe = probes[freeSlots.back()];
+        freeSlots.pop_back();
+        probe.address = address;
+
+        char payload[kPayloadSize] = {};
+        DWORD result = IcmpSendEcho2(icmpHandle, nullptr, &ProbeEngine::onComplete, &probe,
+                                     htonl(address), payload, kPayloadSize, nullptr,
+                                     probe.reply, sizeof(probe.reply), timeoutMs);
+        if (result == 0 && GetLastError() != ERROR_IO_PENDING) {
+            release(probe); // Unreachable right away; move on to the next host
+        }
+        return true;
+    }
+
+    template <typename OnReply>
+    void poll(int waitMs, OnReply&& onReply) {
+        SleepEx(static_cast<DWORD>(waitMs), TRUE);
+        for (uint32_t address : replies) {
+            onReply(address);
+        }
+        replies.clear();
+    }
+
+    bool pending() const { return freeSlots.size() < probes.size(); }
+
+private:
+    struct Probe {
+        ProbeEngine* engine = nullptr;
+        uint32_t address = 0;
+        alignas(8) unsigned char reply[sizeof(ICMP_ECHO_REPLY) + kPayloadSize + 8 + sizeof(IO_STATUS_BLOCK)];
+    };
+
+    HANDLE icmpHandle = INVALID_HANDLE_VALUE;
+    DWORD timeoutMs = 1000;
+    std::vector<Probe> probes;
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> replies;
+
+    void release(Probe& probe) {
+        freeSlots.push_back(static_cast<uint32_t>(&probe - probes.data()));
+    }
+
+    static VOID NTAPI onComplete(PVOID context, PIO_STATUS_BLOCK, ULONG) {
+        Probe* probe = static_cast<Probe*>(context);
+        if (IcmpParseReplies(probe->reply, sizeof(probe->reply)) > 0) {
+            auto* echo = reinterpret_cast<ICMP_ECHO_REPLY*>(probe->reply);
+            if (echo->Status == IP_SUCCESS) {
+                probe->engine->replies.push_back(ntohl(echo->Address));
+            }
+        }
+        probe->engine->release(*probe);
+    }
+};
+
+#else
+
+uint16_t icmpChecksum(const uint8_t* data, size_t length) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < length; i += 2) {
+        sum += static_cast<uint32_t>(data[i] << 8 | data[i + 1]);
+    }
+    if (length & 1) {
+        sum += static_cast<uint32_t>(data[length - 1] << 8);
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return static_cast<uint16_t>(~sum);
+}
+
+// Unprivileged ICMP datagram socket where the OS allows it, raw socket otherwise.
+// All probes go out of, and all replies come back on, the same non-blocking socket.
+class ProbeEngine {
+public:
+    ~ProbeEngine() {
+        if (socketFd >= 0) close(socketFd);
+#ifndef __APPLE__
+        if (pollFd >= 0) close(pollFd);
+#endif
+    }
+
+    bool open(unsigned, unsigned) {
+        socketFd = socket(AF_INET, SOCK_DGRAM, IPPROTO_ICMP);
+        rawSocket = socketFd < 0;
+        if (rawSocket) {
+            socketFd = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+        }
+        if (socketFd < 0) {
+            std::cerr << "Failed to open ICMP socket: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        fcntl(socketFd, F_SETFL, fcntl(socketFd, F_GETFL) | O_NONBLOCK);
+        fcntl(socketFd, F_SETFD, FD_CLOEXEC);
+
+        // Replies can arrive faster than we drain them on a busy /22
+        int receiveBuffer = 1 << 20;
+        setsockopt(socketFd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+
+#ifndef __APPLE__
+        pollFd = epoll_create1(EPOLL_CLOEXEC);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = socketFd;
+        if (pollFd < 0 || epoll_ctl(pollFd, EPOLL_CTL_ADD, socketFd, &event) < 0) {
+            std::cerr << "Failed to set up epoll: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+#endif
+        identifier = static_cast<uint16_t>(getpid() & 0xFFFF);
+        return true;
+    }
+
+    // Returns false when the socket buffer is full and the caller should wait first
+    bool send(uint32_t address, uint16_t sequence) {
+        uint8_t packet[8 + kPayloadSize] = {};
+        packet[0] = 8; // Echo request
+        packet[4] = static_cast<uint8_t>(identifier >> 8);
+        packet[5] = static_cast<uint8_t>(identifier);
+        packet[6] = static_cast<uint8_t>(sequence >> 8);
+        packet[7] = static_cast<uint8_t>(sequence);
+        uint16_t checksum = icmpChecksum(packet, sizeof(packet));
+        packet[2] = static_cast<uint8_t>(checksum >> 8);
+        packet[3] = static_cast<uint8_t>(checksum);
+
+        sockaddr_in destination{};
+        destination.sin_family = AF_INET;
+        destination.sin_addr.s_addr = htonl(address);
+        if (sendto(socketFd, packet, sizeof(packet), 0,
+                   reinterpret_cast<sockaddr*>(&destination), sizeof(destination)) < 0) {
+            // Unreachable or refused hosts are simply skipped
+            return errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS;
+        }
+        return true;
+    }
+
+    template <typename OnReply>
+    void poll(int waitMs, OnReply&& onReply) {
+#ifdef __APPLE__
+        pollfd descriptor{socketFd, POLLIN, 0};
+        if (::poll(&descriptor, 1, waitMs) <= 0) return;
+#else
+        epoll_event event;
+        if (epoll_wait(pollFd, &event, 1, waitMs) <= 0) return;
+#endif
+
+        // Raw sockets (and datagram sockets on macOS) deliver the IP header too
+#ifdef __APPLE__
+        const bool includesIpHeader = true;
+#else
+        const bool includesIpHeader = rawSocket;
+#endif
+
+        uint8_t buffer[1500];
+        for (;;) {
+            sockaddr_in source{};
+            socklen_t sourceLength = sizeof(source);
+            ssize_t length = recvfrom(socketFd, buffer, sizeof(buffer), 0,
+                                      reinterpret_cast<sockaddr*>(&source), &sourceLength);
+            if (length < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+
+            // Raw sockets see every ICMP packet on the host; datagram sockets are demultiplexed by the kernel
+            if (!SubnetSweeper::isEchoReply(buffer, static_cast<size_t>(length), includesIpHeader,
+                                            rawSocket ? identifier : -1)) {
+                continue;
+            }
+
+            onReply(ntohl(source.sin_addr.s_addr));
+        }
+    }
+
+    bool pending() const { return true; }
+
+private:
+    int socketFd = -1;
+    int pollFd = -1;
+    bool rawSocket = false;
+    uint16_t identifier = 0;
+};
+
+#endif
+
+} // namespace
+
+std::vector<SubnetSweeper::Subnet> SubnetSweeper::enumerateSubnets() {
+    std::vector<Subnet> subnets;
+
+#ifdef _WIN32
+    ULONG size = 16 * 1024;
+    std::vector<unsigned char> buffer;
+    ULONG result = ERROR_BUFFER_OVERFLOW;
+    ULONG flags = GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST | GAA_FLAG_SKIP_DNS_SERVER;
+    for (int attempt = 0; attempt < 3 && result == ERROR_BUFFER_OVERFLOW; ++attempt) {
+        buffer.resize(size);
+        result = GetAdaptersAddresses(AF_INET, flags, nullptr,
+                                      reinterpret_cast<IP_ADAPTER_ADDRESSES*>(buffer.data()), &size);
+    }
+    if (result != NO_ERROR) {
+        std::cerr << "GetAdaptersAddresses failed: " << result << std::endl;
+        return subnets;
+    }
+
+    for (auto* adapter = reinterpret_cast<IP_ADAPTER_ADDRESSES*>(buffer.data()); adapter; adapter = adapter->Next) {
+        if (adapter->OperStatus != IfOperStatusUp || adapter->IfType == IF_TYPE_SOFTWARE_LOOPBACK) continue;
+
+        for (auto* unicast = adapter->FirstUnicastAddress; unicast; unicast = unicast->Next) {
+            if (unicast->Address.lpSockaddr->sa_family != AF_INET) continue;
+
+            auto* address = reinterpret_cast<sockaddr_in*>(unicast->Address.lpSockaddr);
+            uint32_t local = ntohl(address->sin_addr.s_addr);
+            uint32_t prefixLength = unicast->OnLinkPrefixLength;
+            subnets.push_back({local & prefixMask(prefixLength), prefixLength, local, adapter->AdapterName});
+        }
+    }
+#else
+    ifaddrs* interfaces = nullptr;
+    if (getifaddrs(&interfaces) != 0) {
+        std::cerr << "getifaddrs failed: " << std::strerror(errno) << std::endl;
+        return subnets;
+    }
+
+    for (ifaddrs* entry = interfaces; entry; entry = entry->ifa_next) {
+        if (!entry->ifa_addr || !entry->ifa_netmask || entry->ifa_addr->sa_family != AF_INET) continue;
+        if (!(entry->ifa_flags & IFF_UP) || (entry->ifa_flags & (IFF_LOOPBACK | IFF_POINTOPOINT))) continue;
+
+        uint32_t local = ntohl(reinterpret_cast<sockaddr_in*>(entry->ifa_addr)->sin_addr.s_addr);
+        uint32_t mask = ntohl(reinterpret_cast<sockaddr_in*>(entry->ifa_netmask)->sin_addr.s_addr);
+        subnets.push_back({local & mask, maskToPrefix(mask), local, entry->ifa_name});
+    }
+    freeifaddrs(interfaces);
+#endif
+
+    return subnets;
+}
+
+std::vector<uint32_t> SubnetSweeper::targetAddresses(const std::vector<Subnet>& subnets) const {
+    std::vector<uint32_t> targets;
+    std::vector<uint32_t> localAddresses;
+
+    for (const auto& subnet : subnets) {
+        localAddresses.push_back(subnet.localAddress);
+        if (subnet.prefixLength >= 31) continue; // No host range to sweep
+
+        // Clamp very large networks to the block around our own address
+        uint32_t prefixLength = std::max(subnet.prefixLength, options.minPrefixLength);
+        uint32_t mask = prefixMask(prefixLength);
+        uint32_t network = subnet.localAddress & mask;
+        uint32_t broadcast = network | ~mask;
+
+        for (uint32_t address = network + 1; address < broadcast; ++address) {
+            targets.push_back(address);
+        }
+    }
+
+    // Interfaces can share a subnet; probe each host once and never ourselves
+    std::sort(targets.begin(), targets.end());
+    targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+    std::sort(localAddresses.begin(), localAddresses.end());
+    targets.erase(std::remove_if(targets.begin(), targets.end(), [&](uint32_t address) {
+        return std::binary_search(localAddresses.begin(), localAddresses.end(), address);
+    }), targets.end());
+
+    return targets;
+}
+
+std::vector<uint32_t> SubnetSweeper::sweep(const std::vector<Subnet>& subnets) const {
+    std::vector<uint32_t> responders;
+    std::vector<uint32_t> targets = targetAddresses(subnets);
+    if (targets.empty()) return responders;
+
+    ProbeEngine engine;
+    if (!engine.open(options.maxInFlight, static_cast<unsigned>(options.replyTimeout.count()))) {
+        return responders;
+    }
+
+    std::vector<uint8_t> replied(targets.size(), 0);
+    auto onReply = [&](uint32_t address) {
+        auto it = std::lower_bound(targets.begin(), targets.end(), address);
+        if (it != targets.end() && *it == address) {
+            replied[it - targets.begin()] = 1;
+        }
+    };
+
+    // Pace probes with a token bucket: by time t, at most t * probesPerSecond have gone out
+    using Clock = std::chrono::steady_clock;
+    const double probesPerMicrosecond = std::max(1u, options.probesPerSecond) / 1e6;
+    auto start = Clock::now();
+    size_t next = 0;
+    while (next < targets.size()) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+        size_t due = std::min(targets.size(), static_cast<size_t>(elapsed * probesPerMicrosecond) + 1);
+        while (next < due && engine.send(targets[next], static_cast<uint16_t>(next))) {
+            next++;
+        }
+        engine.poll(1, onReply);
+    }
+
+    // Collect late replies
+    auto deadline = Clock::now() + options.replyTimeout;
+    while (engine.pending()) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        if (remaining <= 0) break;
+        engine.poll(static_cast<int>(std::min<long long>(remaining, 50)), onReply);
+    }
+
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (replied[i]) responders.push_back(targets[i]);
+    }
+    return responders;
+}
+
+bool SubnetSweeper::isEchoReply(const uint8_t* packet, size_t length, bool includesIpHeader, int expectedIdentifier) {
+    size_t offset = 0;
+    if (includesIpHeader) {
+        if (length < 20 || (packet[0] >> 4) != 4) return false;
+        offset = static_cast<size_t>(packet[0] & 0x0F) * 4;
+    }
+    if (length < offset + 8 || packet[offset] != 0) return false; // Echo replies are type 0
+
+    uint16_t identifier = static_cast<uint16_t>(packet[offset + 4] << 8 | packet[offset + 5]);
+    return expectedIdentifier < 0 || identifier == expectedIdentifier;
+}
+
+std::string SubnetSweeper::formatAddress(uint32_t address) {
+    char text[INET_ADDRSTRLEN];
+    in_addr raw;
+    raw.s_addr = htonl(address);
+    if (!inet_ntop(AF_INET, &raw, text, sizeof(text))) return std::string();
+    return text;
+}
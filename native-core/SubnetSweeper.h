@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Active IPv4 discovery: sends ICMP echo requests to every host of the local
+// subnets from one non-blocking socket (epoll on Linux, poll on macOS, APC
+// completions on Windows) and collects the hosts that answer. Probing an
+// on-link address also makes the OS resolve it, so hosts that drop ICMP but
+// answer ARP still show up in the neighbour table afterwards.
+class SubnetSweeper {
+public:
+    struct Options {
+        unsigned probesPerSecond = 2000;
+        unsigned maxInFlight = 512;                   // Windows only; sockets have no per-probe state
+        std::chrono::milliseconds replyTimeout{1000}; // wait after the last probe
+        unsigned minPrefixLength = 20;                // larger networks are clamped to the local /20
+    };
+
+    struct Subnet {
+        uint32_t network;      // host byte order
+        uint32_t prefixLength;
+        uint32_t localAddress; // host byte order, excluded from the sweep
+        std::string interfaceName;
+    };
+
+    SubnetSweeper() = default;
+    explicit SubnetSweeper(const Options& options) : options(options) {}
+
+    // IPv4 subnets of the interfaces that are up, excluding loopback and point-to-point links
+    static std::vector<Subnet> enumerateSubnets();
+
+    // Probes every host address of `subnets` and returns the ones that
+    // replied (host byte order, ascending). Returns an empty list if the
+    // ICMP socket can't be opened.
+    std::vector<uint32_t> sweep(const std::vector<Subnet>& subnets) const;
+
+    // The hosts sweep() probes, ascending: every host of each subnet except
+    // the network and broadcast addresses and our own, with subnets larger
+    // than minPrefixLength clamped to the block around the local address.
+    // /31 and /32 subnets have no hosts to probe.
+    std::vector<uint32_t> targetAddresses(const std::vector<Subnet>& subnets) const;
+
+    // True for a packet read from the ICMP socket that is an echo reply,
+    // behind an IPv4 header when includesIpHeader. A negative
+    // expectedIdentifier accepts any identifier, as for datagram sockets,
+    // which the kernel demultiplexes for us.
+    static bool isEchoReply(const uint8_t* packet, size_t length, bool includesIpHeader, int expectedIdentifier);
+
+    static std::string formatAddress(uint32_t address);
+
+private:
+    Options options;
+};
@@ -0,0 +1,161 @@
+#include "SyntheticNetwork.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+// OUIs from the built-in vendor table, plus a locally administered prefix for unknown vendors
+const uint32_t kVendorOuis[] = {
+    0x00000c, // Cisco
+    0x000393, // Apple
+    0x0012fb, // Samsung
+    0x0001e6, // HP
+    0x00055d, // D-Link
+    0x001d0f, // TP-Link
+    0x00095b, // Netgear
+    0x020000, // Unknown
+};
+
+const char* const kHostnamePrefixes[] = {
+    "", "iphone-", "android-", "desktop-", "laptop-", "printer-",
+    "roku-", "xbox-", "nest-thermostat-", "camera-", "echo-", "host-",
+};
+
+constexpr size_t kVendorCount = sizeof(kVendorOuis) / sizeof(kVendorOuis[0]);
+constexpr size_t kHostnameKinds = sizeof(kHostnamePrefixes) / sizeof(kHostnamePrefixes[0]);
+
+} // namespace
+
+SyntheticNetwork::SyntheticNetwork(const Options& options)
+    : options(options), rngState(options.seed), nextSerial(0), steps(0) {
+    devices.reserve(options.deviceCount);
+    for (size_t i = 0; i < options.deviceCount; ++i) {
+        devices.push_back(makeDevice());
+    }
+    rebuildRecords();
+}
+
+uint64_t SyntheticNetwork::nextRandom() {
+    // SplitMix64: tiny, fast and identical on every platform
+    uint64_t z = (rngState += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+double SyntheticNetwork::uniform() {
+    return static_cast<double>(nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double SyntheticNetwork::gaussian() {
+    // Box-Muller; one sample per call keeps the stream simple to reason about
+    double u1 = std::max(uniform(), 1e-300);
+    double u2 = uniform();
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+}
+
+SyntheticNetwork::Device SyntheticNetwork::makeDevice() {
+    Device device;
+    device.serial = nextSerial++;
+
+    uint32_t oui = kVendorOuis[nextRandom() % kVendorCount];
+    device.mac = MacAddress((static_cast<uint64_t>(oui) << 24) | (device.serial & 0xFFFFFF));
+    device.ipAddress = 0x0A000001u + static_cast<uint32_t>(device.serial); // 10.0.0.1 upwards
+    device.baseRssi = static_cast<float>(-85.0 + 50.0 * uniform());
+    device.rssi = device.baseRssi;
+    device.hostnameKind = static_cast<uint32_t>(nextRandom() % kHostnameKinds);
+    device.visible = true;
+    return device;
+}
+
+float SyntheticNetwork::sampleRssi(Device& device) {
+    float sigma = options.noiseStdDev;
+    switch (options.noise) {
+        case NoiseModel::None:
+            device.rssi = device.baseRssi;
+            break;
+        case NoiseModel::Gaussian:
+            device.rssi = device.baseRssi + sigma * static_cast<float>(gaussian());
+            break;
+        case NoiseModel::RandomWalk:
+            // Mean-reverting walk so long runs stay in a plausible range
+            device.rssi += sigma * static_cast<float>(gaussian()) + 0.05f * (device.baseRssi - device.rssi);
+            break;
+        case NoiseModel::Bursty:
+            device.rssi = device.baseRssi + sigma * static_cast<float>(gaussian());
+            if (uniform() < options.fadeProbability) {
+                device.rssi -= options.fadeDepth;
+            }
+            break;
+    }
+    device.rssi = std::min(-20.0f, std::max(-100.0f, device.rssi));
+    return device.rssi;
+}
+
+void SyntheticNetwork::step() {
+    steps++;
+
+    // Replace a fraction of the devices with brand-new ones
+    size_t churned = static_cast<size_t>(std::llround(options.churnRate * static_cast<double>(devices.size())));
+    for (size_t i = 0; i < churned && !devices.empty(); ++i) {
+        devices[nextRandom() % devices.size()] = makeDevice();
+    }
+
+    for (auto& device : devices) {
+        device.visible = uniform() >= options.dropoutRate;
+        sampleRssi(device);
+    }
+
+    rebuildRecords();
+}
+
+void SyntheticNetwork::rebuildRecords() {
+    visibleRecords.clear();
+    visibleRecords.reserve(devices.size());
+
+    for (const auto& device : devices) {
+        if (!device.visible) continue;
+
+        ScanRecord record;
+        record.mac = device.mac;
+        std::snprintf(record.ipAddress, sizeof(record.ipAddress), "%u.%u.%u.%u",
+                      device.ipAddress >> 24, (device.ipAddress >> 16) & 0xFF,
+                      (device.ipAddress >> 8) & 0xFF, device.ipAddress & 0xFF);
+        record.rssi = static_cast<int>(std::lround(device.rssi));
+        visibleRecords.push_back(record);
+    }
+}
+
+void SyntheticNetwork::applyTo(SyntheticBackend& backend) const {
+    backend.setRecords(visibleRecords);
+}
+
+std::string SyntheticNetwork::hostnameFor(const Device& device) const {
+    const char* prefix = kHostnamePrefixes[device.hostnameKind];
+    if (prefix[0] == '\0') return std::string();
+    return prefix + std::to_string(device.serial);
+}
+
+std::vector<std::shared_ptr<NetworkDevice>> SyntheticNetwork::makeDevices() const {
+    std::vector<std::shared_ptr<NetworkDevice>> result;
+    result.reserve(visibleRecords.size());
+
+    uint32_t id = 0;
+    for (const auto& device : devices) {
+        if (!device.visible) continue;
+
+        const ScanRecord& record = visibleRecords[id];
+        auto networkDevice = std::make_shared<NetworkDevice>();
+        networkDevice->mac = device.mac;
+        networkDevice->deviceId = id++;
+        networkDevice->macAddress = device.mac.toString();
+        networkDevice->ipAddress = record.ipAddress;
+        networkDevice->hostname = hostnameFor(device);
+        networkDevice->rssi = record.rssi;
+        networkDevice->isOnline = true;
+        result.push_back(networkDevice);
+    }
+
+    return result;
+}
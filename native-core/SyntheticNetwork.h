@@ -0,0 +1,74 @@
+#pragma once
+
+#include "NetworkScanner.h"
+#include "ScanBackend.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Deterministic generator of large simulated networks for benchmarks and
+// tests. The same options and seed produce the same devices, RSSI traces
+// and churn on every platform (no std:: distributions are involved).
+class SyntheticNetwork {
+public:
+    enum class NoiseModel {
+        None,
+        Gaussian,   // independent noise around each device's base level
+        RandomWalk, // slow drift, e.g. people moving around
+        Bursty      // Gaussian with occasional deep fades
+    };
+
+    struct Options {
+        size_t deviceCount = 100;       // 10 .. 100k
+        double churnRate = 0.01;        // fraction of devices replaced by new ones per step
+        double dropoutRate = 0.02;      // fraction of devices missing from each step
+        NoiseModel noise = NoiseModel::Gaussian;
+        float noiseStdDev = 3.0f;       // dB
+        float fadeProbability = 0.02f;  // Bursty only
+        float fadeDepth = 25.0f;        // dB, Bursty only
+        uint64_t seed = 1;
+    };
+
+    explicit SyntheticNetwork(const Options& options);
+
+    // Advances one scan interval: churn, dropouts and a new RSSI sample per device
+    void step();
+
+    // Devices visible in the current step
+    const std::vector<ScanRecord>& records() const { return visibleRecords; }
+    void applyTo(SyntheticBackend& backend) const;
+
+    // Materialises the current step as NetworkDevice objects (with hostnames,
+    // dense IDs in generation order) for exercising the processing stages directly
+    std::vector<std::shared_ptr<NetworkDevice>> makeDevices() const;
+
+    size_t stepCount() const { return steps; }
+    size_t totalDevicesCreated() const { return nextSerial; }
+
+private:
+    struct Device {
+        uint64_t serial;
+        MacAddress mac;
+        uint32_t ipAddress;
+        float baseRssi;
+        float rssi;
+        uint32_t hostnameKind;
+        bool visible;
+    };
+
+    Options options;
+    uint64_t rngState;
+    uint64_t nextSerial;
+    size_t steps;
+    std::vector<Device> devices;
+    std::vector<ScanRecord> visibleRecords;
+
+    uint64_t nextRandom();
+    double uniform();
+    double gaussian();
+    Device makeDevice();
+    float sampleRssi(Device& device);
+    void rebuildRecords();
+    std::string hostnameFor(const Device& device) const;
+};
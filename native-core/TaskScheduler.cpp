@@ -0,0 +1,350 @@
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <limits>
+
+struct TaskState {
+    std::function<void()> function;
+    TaskPriority priority;
+    std::chrono::milliseconds interval; // 0 for one-shot tasks
+    std::atomic<bool> cancelled{false};
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool running = false;
+    bool done = false;
+
+    // Claims the task for a run; false once it is cancelled or done
+    bool begin() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (done || cancelled.load()) return false;
+        running = true;
+        return true;
+    }
+
+    // Ends a run; returns true if the task should run again
+    bool end(bool again) {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+        if (again && !cancelled.load()) return true;
+        done = true;
+        condition.notify_all();
+        return false;
+    }
+
+    void cancel() {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelled.store(true);
+        if (!running && !done) {
+            done = true;
+            condition.notify_all();
+        }
+    }
+};
+
+namespace {
+
+thread_local const TaskScheduler* currentScheduler = nullptr;
+thread_local size_t currentWorker = 0;
+
+// Bounded waits re-check their condition, so a lost wake-up costs at most this
+constexpr std::chrono::seconds kWaitRecheck{1};
+
+std::atomic<unsigned> sharedWorkers(0);
+std::atomic<bool> sharedCreated(false);
+
+unsigned claimSharedWorkers() {
+    sharedCreated.store(true);
+    return sharedWorkers.load();
+}
+
+// Indices handed out to the caller and helpers of one parallelFor()
+struct ParallelGroup {
+    const std::function<void(size_t)>* body;
+    size_t count;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> completed{0};
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::exception_ptr error;
+
+    void drain() {
+        // body is only touched for unclaimed indices, which the caller is
+        // still waiting for, so late helpers never see a dangling pointer
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                (*body)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) error = std::current_exception();
+            }
+            if (++completed == count) {
+                std::lock_guard<std::mutex> lock(mutex);
+                condition.notify_all();
+            }
+        }
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (completed.load() != count) {
+            condition.wait_for(lock, kWaitRecheck);
+        }
+    }
+};
+
+} // namespace
+
+void TaskHandle::cancel() {
+    if (state) state->cancel();
+}
+
+bool TaskHandle::isCancelled() const {
+    return state && state->cancelled.load();
+}
+
+bool TaskHandle::isDone() const {
+    if (!state) return true;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->done;
+}
+
+void TaskHandle::wait() const {
+    if (!state) return;
+    std::unique_lock<std::mutex> lock(state->mutex);
+    while (!state->done) {
+        state->condition.wait_for(lock, kWaitRecheck);
+    }
+}
+
+TaskScheduler::TaskScheduler(unsigned workerCount)
+    : nextWorker(0), queuedTasks(0), stopping(false), timerOrder(0),
+      nextTimerDue(std::numeric_limits<int64_t>::max()) {
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers.reserve(workerCount);
+    for (unsigned i = 0; i < workerCount; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (unsigned i = 0; i < workerCount; ++i) {
+        workers[i]->thread = std::thread(&TaskScheduler::workerLoop, this, static_cast<size_t>(i));
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        stopping = true;
+    }
+    idleCondition.notify_all();
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+
+    // Release anyone waiting on tasks that will never run
+    for (auto& worker : workers) {
+        for (auto& queue : worker->queues) {
+            for (auto& task : queue) task->cancel();
+        }
+    }
+    while (!timers.empty()) {
+        timers.top().task->cancel();
+        timers.pop();
+    }
+}
+
+TaskScheduler& TaskScheduler::shared() {
+    static TaskScheduler scheduler(claimSharedWorkers());
+    return scheduler;
+}
+
+bool TaskScheduler::configureShared(unsigned workerCount) {
+    if (sharedCreated.load()) return false;
+    sharedWorkers.store(workerCount);
+    return true;
+}
+
+bool TaskScheduler::onWorkerThread() const {
+    return currentScheduler == this;
+}
+
+TaskHandle TaskScheduler::create(TaskPriority priority, std::chrono::milliseconds interval,
+                                 std::function<void()> task) {
+    auto state = std::make_shared<TaskState>();
+    state->function = std::move(task);
+    state->priority = priority;
+    state->interval = interval;
+    return TaskHandle(std::move(state));
+}
+
+TaskHandle TaskScheduler::submit(TaskPriority priority, std::function<void()> task) {
+    TaskHandle handle = create(priority, std::chrono::milliseconds(0), std::move(task));
+    enqueue(handle.state);
+    return handle;
+}
+
+TaskHandle TaskScheduler::schedule(TaskPriority priority, std::chrono::milliseconds delay,
+                                   std::function<void()> task) {
+    TaskHandle handle = create(priority, std::chrono::milliseconds(0), std::move(task));
+    addTimer(std::chrono::steady_clock::now() + delay, handle.state);
+    return handle;
+}
+
+TaskHandle TaskScheduler::schedulePeriodic(TaskPriority priority, std::chrono::milliseconds interval,
+                                           std::function<void()> task, std::chrono::milliseconds initialDelay) {
+    TaskHandle handle = create(priority, std::max(interval, std::chrono::milliseconds(1)), std::move(task));
+    if (initialDelay.count() <= 0) {
+        enqueue(handle.state);
+    } else {
+        addTimer(std::chrono::steady_clock::now() + initialDelay, handle.state);
+    }
+    return handle;
+}
+
+void TaskScheduler::parallelFor(TaskPriority priority, size_t count, const std::function<void(size_t)>& body,
+                                unsigned maxParallelism) {
+    if (count == 0) return;
+
+    size_t threads = maxParallelism ? std::min(maxParallelism, workerCount()) : workerCount();
+    threads = std::min(threads, count);
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) body(i);
+        return;
+    }
+
+    auto group = std::make_shared<ParallelGroup>();
+    group->body = &body;
+    group->count = count;
+    for (size_t i = 1; i < threads; ++i) {
+        submit(priority, [group] { group->drain(); });
+    }
+    group->drain();
+    group->wait();
+
+    if (group->error) {
+        std::rethrow_exception(group->error);
+    }
+}
+
+void TaskScheduler::enqueue(std::shared_ptr<TaskState> task) {
+    size_t target = currentScheduler == this ? currentWorker : nextWorker++ % workers.size();
+    Worker& worker = *workers[target];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queues[static_cast<size_t>(task->priority)].push_back(std::move(task));
+        worker.queued++;
+    }
+    queuedTasks++;
+
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+    }
+    idleCondition.notify_one();
+}
+
+void TaskScheduler::addTimer(std::chrono::steady_clock::time_point due, std::shared_ptr<TaskState> task) {
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        if (stopping) {
+            task->cancel();
+            return;
+        }
+        timers.push({due, timerOrder++, std::move(task)});
+        nextTimerDue.store(timers.top().due.time_since_epoch().count());
+    }
+    // A sleeping worker may need to wake earlier than it planned
+    idleCondition.notify_one();
+}
+
+void TaskScheduler::promoteDueTimers() {
+    auto now = std::chrono::steady_clock::now();
+    if (now.time_since_epoch().count() < nextTimerDue.load(std::memory_order_relaxed)) return;
+
+    std::vector<std::shared_ptr<TaskState>> due;
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        while (!timers.empty() && timers.top().due <= now) {
+            due.push_back(timers.top().task);
+            timers.pop();
+        }
+        nextTimerDue.store(timers.empty() ? std::numeric_limits<int64_t>::max()
+                                          : timers.top().due.time_since_epoch().count());
+    }
+
+    for (auto& task : due) {
+        if (task->cancelled.load()) continue; // cancel() has already released its waiters
+        enqueue(std::move(task));
+    }
+}
+
+std::shared_ptr<TaskState> TaskScheduler::takeTask(size_t self) {
+    size_t count = workers.size();
+    for (size_t priority = 0; priority < kPriorityCount; ++priority) {
+        // Newest first from our own deque, oldest first from everyone else's
+        for (size_t k = 0; k < count; ++k) {
+            Worker& worker = *workers[(self + k) % count];
+            if (worker.queued.load(std::memory_order_relaxed) == 0) continue;
+
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            auto& queue = worker.queues[priority];
+            if (queue.empty()) continue;
+
+            std::shared_ptr<TaskState> task;
+            if (k == 0) {
+                task = std::move(queue.back());
+                queue.pop_back();
+            } else {
+                task = std::move(queue.front());
+                queue.pop_front();
+            }
+            worker.queued--;
+            queuedTasks--;
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void TaskScheduler::run(const std::shared_ptr<TaskState>& task) {
+    if (!task->begin()) return;
+
+    try {
+        task->function();
+    } catch (const std::exception& e) {
+        std::cerr << "Task failed: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "Task failed with an unknown exception" << std::endl;
+    }
+
+    bool periodic = task->interval.count() > 0;
+    if (task->end(periodic)) {
+        addTimer(std::chrono::steady_clock::now() + task->interval, task);
+    }
+}
+
+void TaskScheduler::workerLoop(size_t index) {
+    currentScheduler = this;
+    currentWorker = index;
+
+    for (;;) {
+        promoteDueTimers();
+        if (auto task = takeTask(index)) {
+            run(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(idleMutex);
+        if (stopping) return;
+        if (queuedTasks.load() != 0) continue;
+
+        if (timers.empty()) {
+            idleCondition.wait_for(lock, kWaitRecheck);
+        } else {
+            idleCondition.wait_until(lock, timers.top().due);
+        }
+        if (stopping) return;
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Higher priorities run first whenever a worker picks its next task
+enum class TaskPriority : uint8_t {
+    Interactive, // monitoring cycles, which publish the snapshot the UI shows
+    Pipeline,    // scanning and anomaly scoring
+    Training,    // forest rebuilds
+    Background   // exports
+};
+
+struct TaskState;
+
+// Refers to a submitted task. Copies share the task; an empty handle is
+// already done.
+class TaskHandle {
+public:
+    TaskHandle() = default;
+
+    // Skips the task if it hasn't started and stops a periodic task from
+    // being rescheduled; a run in progress completes
+    void cancel();
+    bool isCancelled() const;
+    // Finished, cancelled or dropped by a stopping scheduler
+    bool isDone() const;
+    // Blocks until isDone(); periodic tasks are only done once cancelled.
+    // Never wait on a task from inside itself.
+    void wait() const;
+
+private:
+    friend class TaskScheduler;
+    explicit TaskHandle(std::shared_ptr<TaskState> task) : state(std::move(task)) {}
+
+    std::shared_ptr<TaskState> state;
+};
+
+// Fixed pool of workers shared by the whole core, so the process never runs
+// more busy threads than it has cores and a one-core box runs everything on
+// one worker.
+//
+// Each worker has a deque per priority. Tasks submitted from a worker go to
+// its own deque, where it takes the newest first; idle workers steal the
+// oldest from the others. Tasks from other threads are spread round-robin.
+// Delayed and periodic tasks wait in a timer heap and are moved into the
+// deques when due. Tasks should not block for long: waiting belongs in
+// timers, and I/O loops that must block keep their own thread.
+class TaskScheduler {
+public:
+    // 0 uses one worker per hardware thread
+    explicit TaskScheduler(unsigned workers = 0);
+    // Waits for running tasks; queued and timed tasks are dropped
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // The process-wide scheduler, created on first use
+    static TaskScheduler& shared();
+    // Sets the shared scheduler's worker count; false once it exists
+    static bool configureShared(unsigned workers);
+
+    TaskHandle submit(TaskPriority priority, std::function<void()> task);
+    TaskHandle schedule(TaskPriority priority, std::chrono::milliseconds delay, std::function<void()> task);
+    // Runs after initialDelay, then interval after each run finishes
+    TaskHandle schedulePeriodic(TaskPriority priority, std::chrono::milliseconds interval,
+                                std::function<void()> task,
+                                std::chrono::milliseconds initialDelay = std::chrono::milliseconds(0));
+
+    // Calls body(i) for every i below count, on up to maxParallelism threads
+    // (0 for all workers) including the caller, and returns when all are
+    // done. The caller works through indices itself instead of waiting for
+    // helpers to start, so this is safe from inside a task on a single
+    // worker. The first exception thrown by body is rethrown.
+    void parallelFor(TaskPriority priority, size_t count, const std::function<void(size_t)>& body,
+                     unsigned maxParallelism = 0);
+
+    unsigned workerCount() const { return static_cast<unsigned>(workers.size()); }
+    // True on one of this scheduler's workers
+    bool onWorkerThread() const;
+
+private:
+    static constexpr size_t kPriorityCount = 4;
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<TaskState>> queues[kPriorityCount];
+        std::atomic<size_t> queued{0};
+        std::thread thread;
+    };
+
+    struct Timer {
+        std::chrono::steady_clock::time_point due;
+        uint64_t order; // FIFO among timers due at the same time
+        std::shared_ptr<TaskState> task;
+
+        bool operator>(const Timer& other) const {
+            return due != other.due ? due > other.due : order > other.order;
+        }
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<size_t> nextWorker;
+    std::atomic<size_t> queuedTasks;
+
+    // Guards sleeping, stopping and the timers
+    std::mutex idleMutex;
+    std::condition_variable idleCondition;
+    bool stopping;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    uint64_t timerOrder;
+    std::atomic<int64_t> nextTimerDue; // steady_clock ticks of timers.top(), max when empty
+
+    TaskHandle create(TaskPriority priority, std::chrono::milliseconds interval, std::function<void()> task);
+    void enqueue(std::shared_ptr<TaskState> task);
+    void addTimer(std::chrono::steady_clock::time_point due, std::shared_ptr<TaskState> task);
+    void promoteDueTimers();
+    std::shared_ptr<TaskState> takeTask(size_t self);
+    void run(const std::shared_ptr<TaskState>& task);
+    void workerLoop(size_t index);
+};
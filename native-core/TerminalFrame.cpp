@@ -0,0 +1,330 @@
+#include "TerminalFrame.h"
+#include <algorithm>
+
+namespace {
+
+// Unchanged cells shorter than a cursor move are rewritten rather than skipped
+constexpr size_t kMergeGap = 6;
+
+constexpr uint32_t kBlank = ' ';
+
+bool decodeUtf8(std::string_view text, size_t& index, uint32_t& codepoint) {
+    unsigned char lead = static_cast<unsigned char>(text[index]);
+    size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+    if (length == 0 || index + length > text.size()) {
+        index++;
+        return false; // Stray or truncated byte
+    }
+
+    codepoint = length == 1 ? lead : lead & (0x7F >> length);
+    for (size_t i = 1; i < length; ++i) {
+        unsigned char next = static_cast<unsigned char>(text[index + i]);
+        if ((next & 0xC0) != 0x80) {
+            index += i;
+            return false;
+        }
+        codepoint = (codepoint << 6) | (next & 0x3F);
+    }
+    index += length;
+    return true;
+}
+
+} // namespace
+
+TerminalFrame::TerminalFrame()
+    : height(0), width(0), fullRedraw(true), row(0), column(0), overflow(0), style(0), outputStyle(0) {
+    styles.emplace_back();
+}
+
+void TerminalFrame::resize(size_t rows, size_t columns) {
+    if (rows == height && columns == width) return;
+
+    height = rows;
+    width = columns;
+    Cell blank = {kBlank, 0, 1, 0};
+    cells.assign(height * width, blank);
+    previous.assign(height * width, blank);
+    rowUncertain.assign(height, 0);
+    previousUncertain.assign(height, 0);
+    fullRedraw = true;
+}
+
+void TerminalFrame::begin() {
+    Cell blank = {kBlank, 0, 1, 0};
+    std::fill(cells.begin(), cells.end(), blank);
+    std::fill(rowUncertain.begin(), rowUncertain.end(), 0);
+    row = 0;
+    column = 0;
+    overflow = 0;
+    style = 0;
+}
+
+void TerminalFrame::write(std::string_view text) {
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (c == '\n') {
+            row++;
+            column = 0;
+            i++;
+            continue;
+        }
+        if (c == '\r') {
+            column = 0;
+            i++;
+            continue;
+        }
+        if (c == '\t') {
+            size_t next = (column / 8 + 1) * 8;
+            while (column < next) putGlyph(kBlank);
+            i++;
+            continue;
+        }
+        if (c == '\033') {
+            // CSI sequences: only SGR (colours) affects the grid, the rest is dropped
+            if (i + 1 < text.size() && text[i + 1] == '[') {
+                size_t end = i + 2;
+                while (end < text.size() && (text[end] < 0x40 || text[end] > 0x7E)) end++;
+                if (end < text.size() && text[end] == 'm') {
+                    applySgr(text.substr(i + 2, end - i - 2));
+                }
+                i = end + 1;
+            } else {
+                i += 2;
+            }
+            continue;
+        }
+
+        uint32_t codepoint;
+        if (!decodeUtf8(text, i, codepoint) || codepoint < 0x20 || codepoint == 0x7F) continue;
+
+        if (codepoint == 0xFE0F) {
+            // Emoji presentation selector: widens the glyph before it
+            if (row < height && column > 0 && column <= width) {
+                Cell& last = cells[row * width + column - 1];
+                if (last.glyph == 0 || (last.flags & kEmojiPresentation)) continue;
+                last.flags |= kEmojiPresentation;
+                if (last.width == 1) {
+                    if (column < width) {
+                        last.width = 2;
+                        cells[row * width + column] = {0, last.style, 0, last.flags};
+                    }
+                    column++;
+                }
+                rowUncertain[row] = 1;
+            }
+            continue;
+        }
+        if (codepoint == 0x200D || (codepoint >= 0xFE00 && codepoint <= 0xFE0E) ||
+            (codepoint >= 0x0300 && codepoint <= 0x036F)) {
+            continue; // Zero-width joiners, selectors and combining marks
+        }
+
+        putGlyph(codepoint);
+    }
+}
+
+void TerminalFrame::putGlyph(uint32_t codepoint) {
+    bool uncertain = false;
+    uint8_t glyphColumns = glyphWidth(codepoint, uncertain);
+
+    if (row >= height) {
+        overflow = std::max(overflow, row - height + 1);
+        column += glyphColumns;
+        return;
+    }
+    if (column + glyphColumns > width) {
+        column += glyphColumns; // Clipped at the right edge
+        return;
+    }
+
+    Cell* cell = &cells[row * width + column];
+    cell[0] = {codepoint, style, glyphColumns, 0};
+    if (glyphColumns == 2) {
+        cell[1] = {0, style, 0, 0};
+    }
+    if (uncertain) {
+        rowUncertain[row] = 1;
+    }
+    column += glyphColumns;
+}
+
+void TerminalFrame::applySgr(std::string_view parameters) {
+    if (parameters.empty() || parameters == "0") {
+        style = 0;
+        return;
+    }
+
+    // Attributes accumulate until a reset, as on a real terminal
+    std::string combined;
+    if (style != 0 && parameters.substr(0, 2) != "0;") {
+        combined = styles[style] + ";";
+    }
+    combined.append(parameters.data(), parameters.size());
+    style = internStyle(combined);
+}
+
+uint16_t TerminalFrame::internStyle(const std::string& parameters) {
+    auto it = std::find(styles.begin(), styles.end(), parameters);
+    if (it != styles.end()) {
+        return static_cast<uint16_t>(it - styles.begin());
+    }
+    if (styles.size() > 0xFFFF) return 0; // Out of styles; fall back to plain text
+
+    styles.push_back(parameters);
+    return static_cast<uint16_t>(styles.size() - 1);
+}
+
+size_t TerminalFrame::contentEnd(const Cell* line) const {
+    size_t end = width;
+    while (end > 0 && line[end - 1].glyph == kBlank && line[end - 1].style == 0) end--;
+    return end;
+}
+
+void TerminalFrame::moveTo(std::string& out, size_t targetRow, size_t targetColumn) const {
+    out += "\033[";
+    out += std::to_string(targetRow + 1);
+    out += ';';
+    out += std::to_string(targetColumn + 1);
+    out += 'H';
+}
+
+void TerminalFrame::writeCells(std::string& out, const Cell* line, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        const Cell& cell = line[i];
+        if (cell.glyph == 0) continue; // Covered by the wide glyph before it
+
+        if (cell.style != outputStyle) {
+            out += cell.style == 0 ? "\033[0m" : "\033[0;" + styles[cell.style] + "m";
+            outputStyle = cell.style;
+        }
+        appendUtf8(out, cell.glyph);
+        if (cell.flags & kEmojiPresentation) {
+            appendUtf8(out, 0xFE0F);
+        }
+    }
+}
+
+void TerminalFrame::present(std::string& out) {
+    // Every present() ends in the default style, and anything else written
+    // to the terminal invalidates the frame
+    size_t startSize = out.size();
+    outputStyle = 0;
+
+    if (fullRedraw) {
+        out += "\033[0m\033[H\033[2J";
+    }
+
+    for (size_t r = 0; r < height; ++r) {
+        const Cell* line = &cells[r * width];
+        const Cell* old = &previous[r * width];
+        size_t end = contentEnd(line);
+
+        if (fullRedraw) {
+            if (end == 0) continue;
+            moveTo(out, r, 0);
+            writeCells(out, line, 0, end);
+            continue;
+        }
+        if (std::equal(line, line + width, old)) continue;
+
+        size_t oldEnd = contentEnd(old);
+        if (rowUncertain[r] || previousUncertain[r]) {
+            moveTo(out, r, 0);
+            writeCells(out, line, 0, end);
+            if (outputStyle != 0) {
+                out += "\033[0m";
+                outputStyle = 0;
+            }
+            out += "\033[K";
+            continue;
+        }
+
+        // Rewrite each run of changed cells; blanks past the new content are
+        // erased in one go
+        size_t limit = std::max(end, oldEnd);
+        size_t c = 0;
+        while (c < limit) {
+            if (line[c] == old[c]) {
+                c++;
+                continue;
+            }
+
+            size_t runBegin = c;
+            while (runBegin > 0 && (line[runBegin].glyph == 0 || old[runBegin].glyph == 0)) runBegin--;
+            size_t runEnd = c + 1;
+            size_t same = 0;
+            for (size_t next = runEnd; next < limit && same <= kMergeGap; ++next) {
+                if (line[next] != old[next]) {
+                    runEnd = next + 1;
+                    same = 0;
+                } else {
+                    same++;
+                }
+            }
+            while (runEnd < width && line[runEnd].glyph == 0) runEnd++;
+
+            moveTo(out, r, runBegin);
+            if (runEnd >= end && oldEnd > end) {
+                writeCells(out, line, runBegin, std::max(runBegin, end));
+                if (outputStyle != 0) {
+                    out += "\033[0m";
+                    outputStyle = 0;
+                }
+                out += "\033[K";
+                break;
+            }
+            writeCells(out, line, runBegin, runEnd);
+            c = runEnd;
+        }
+    }
+
+    if (out.size() != startSize && outputStyle != 0) {
+        out += "\033[0m";
+    }
+
+    previous.swap(cells);
+    previousUncertain.swap(rowUncertain);
+    fullRedraw = false;
+}
+
+uint8_t TerminalFrame::glyphWidth(uint32_t codepoint, bool& uncertain) {
+    if (codepoint < 0x2600) {
+        // Latin, punctuation, arrows and box drawing; CJK jamo is wide
+        return (codepoint >= 0x1100 && codepoint <= 0x115F) ? 2 : 1;
+    }
+    if (codepoint < 0x2800 || codepoint >= 0x1F000) {
+        // Symbols, dingbats and emoji: widths vary between terminals
+        uncertain = true;
+        bool wide = codepoint >= 0x1F300 || codepoint == 0x2705 || codepoint == 0x270A ||
+                    codepoint == 0x270B || codepoint == 0x2728 || codepoint == 0x274C || codepoint == 0x274E ||
+                    (codepoint >= 0x2753 && codepoint <= 0x2755) || codepoint == 0x2757 ||
+                    (codepoint >= 0x2795 && codepoint <= 0x2797) || codepoint == 0x27B0 || codepoint == 0x27BF;
+        return wide ? 2 : 1;
+    }
+    if ((codepoint >= 0x2E80 && codepoint <= 0xA4CF) || (codepoint >= 0xAC00 && codepoint <= 0xD7A3) ||
+        (codepoint >= 0xF900 && codepoint <= 0xFAFF) || (codepoint >= 0xFE30 && codepoint <= 0xFE4F) ||
+        (codepoint >= 0xFF00 && codepoint <= 0xFF60) || (codepoint >= 0xFFE0 && codepoint <= 0xFFE6) ||
+        (codepoint >= 0x20000 && codepoint <= 0x3FFFD)) {
+        return 2; // East Asian wide
+    }
+    return 1;
+}
+
+void TerminalFrame::appendUtf8(std::string& out, uint32_t codepoint) {
+    if (codepoint < 0x80) {
+        out += static_cast<char>(codepoint);
+    } else if (codepoint < 0x800) {
+        out += static_cast<char>(0xC0 | (codepoint >> 6));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+        out += static_cast<char>(0xE0 | (codepoint >> 12));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (codepoint >> 18));
+        out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Double-buffered character grid for full-screen terminal views.
+//
+// A frame is composed by writing text to it exactly as it would be printed
+// (UTF-8 with SGR colour sequences and newlines); the text is laid out into
+// cells and clipped to the viewport. present() compares the grid with the
+// previous frame and appends only what changed: one cursor move per run of
+// changed cells, so an unchanged screen costs nothing and a ticking clock
+// costs a few bytes.
+//
+// Terminals disagree on the width of emoji and some symbols. Rows holding
+// such glyphs are redrawn from their first cell whenever they change, so a
+// width mismatch can never leave the rest of the screen misaligned.
+class TerminalFrame {
+public:
+    TerminalFrame();
+
+    // Sets the viewport; a new size forces a full redraw
+    void resize(size_t rows, size_t columns);
+    size_t rows() const { return height; }
+    size_t columns() const { return width; }
+
+    // Starts composing the next frame on a blank grid
+    void begin();
+    void write(std::string_view text);
+    // Rows written below the viewport in the frame being composed
+    size_t overflowRows() const { return overflow; }
+
+    // Appends the escape sequences that turn the previous frame into this one
+    void present(std::string& out);
+    // Makes the next present() redraw everything, e.g. after other output
+    void invalidate() { fullRedraw = true; }
+
+private:
+    struct Cell {
+        uint32_t glyph;  // code point; 0 continues the wide glyph to its left
+        uint16_t style;  // index into styles
+        uint8_t width;
+        uint8_t flags;
+
+        bool operator==(const Cell& other) const {
+            return glyph == other.glyph && style == other.style && flags == other.flags;
+        }
+        bool operator!=(const Cell& other) const { return !(*this == other); }
+    };
+
+    enum CellFlags : uint8_t {
+        kEmojiPresentation = 1 << 0, // followed by U+FE0F
+    };
+
+    size_t height;
+    size_t width;
+    std::vector<Cell> cells;          // frame being composed, row-major
+    std::vector<Cell> previous;       // frame on screen
+    std::vector<uint8_t> rowUncertain;
+    std::vector<uint8_t> previousUncertain;
+    bool fullRedraw;
+
+    // Composition state
+    size_t row;
+    size_t column;
+    size_t overflow;
+    uint16_t style;
+    std::vector<std::string> styles; // SGR parameters; 0 is the default style
+
+    // Output state within one present()
+    uint16_t outputStyle;
+
+    void putGlyph(uint32_t codepoint);
+    void applySgr(std::string_view parameters);
+    uint16_t internStyle(const std::string& parameters);
+    size_t contentEnd(const Cell* line) const;
+    void moveTo(std::string& out, size_t targetRow, size_t targetColumn) const;
+    void writeCells(std::string& out, const Cell* line, size_t begin, size_t end);
+
+    static uint8_t glyphWidth(uint32_t codepoint, bool& uncertain);
+    static void appendUtf8(std::string& out, uint32_t codepoint);
+};
@@ -1,5 +1,4 @@
 #include "SmartBlueprintCore.h"
-#include "DesktopUI.h"
 #include <iostream>
 #include <chrono>
 #include <thread>
@@ -29,7 +28,7 @@ enum class ViewMode {
 
 class NativeConsoleUI {
 private:
-    SmartBlueprint::SmartBlueprintCore core;
+    SmartBlueprintCore core;
     bool isRunning;
     ViewMode currentView;
     int selectedDevice;
@@ -40,12 +39,12 @@ private:
 public:
     NativeConsoleUI() : isRunning(false), currentView(ViewMode::DASHBOARD), 
                        selectedDevice(0), showDetails(false), autoRefresh(true) {}
-
+    
     void start() {
         clearScreen();
         showWelcomeScreen();
         
-        core.start();
+        core.startMonitoring();
         isRunning = true;
         
         // Main UI loop
@@ -62,7 +61,7 @@ public:
         handleUserInput();
         
         uiThread.join();
-        core.stop();
+        core.stopMonitoring();
     }
 
 private:
@@ -516,33 +515,12 @@ private:
     }
     
     void exportDeviceData() {
-        auto devices = core.getCurrentDevices();
-        
-        std::cout << "\n📤 Exporting device data...\n";
-        
-        // Create CSV export
-        std::ofstream csvFile("smartblueprint_devices.csv");
-        csvFile << "Device Name,MAC Address,IP Address,Signal Strength,Status,Last Seen\n";
-        
-        for (const auto& device : devices) {
-            std::string deviceName = generateDeviceName(device->macAddress);
-            std::string ipAddr = device->ipAddress.empty() ? "Unknown" : device->ipAddress;
-            std::string status = device->isOnline ? "Online" : "Offline";
-            
-            csvFile << deviceName << ","
-                   << device->macAddress << ","
-                   << ipAddr << ","
-                   << device->rssi << " dBm,"
-                   << status << ","
-                   << "Now" << "\n";
+        // Written on the core's export worker so the console keeps updating
+        if (core.startExport("smartblueprint_devices.csv", ExportFormat::Csv)) {
+            std::cout << "\n📤 Exporting device data to 'smartblueprint_devices.csv' in the background...\n";
+        } else {
+            std::cout << "\n⏳ An export is already running\n";
         }
-        
-        csvFile.close();
-        
-        std::cout << "✅ Device data exported to 'smartblueprint_devices.csv'\n";
-        std::cout << "   " << devices.size() << " devices exported\n";
-        std::this_thread::sleep_for(std::chrono::seconds(2));
-        updateDisplay();
     }
 };
 
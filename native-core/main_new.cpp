@@ -1,43 +1,102 @@
 #include "SmartBlueprintCore.h"
 #include "DesktopUI.h"
+#include "MappedFile.h"
 #include <iostream>
+#include <fstream>
 #include <chrono>
 #include <thread>
 #include <csignal>
 #include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+// Set by SIGINT and SIGTERM. The main loop notices it and shuts down the
+// normal way, so the model and device state are saved on exit.
+volatile std::sig_atomic_t stopRequested = 0;
+
+void requestStop(int) {
+    stopRequested = 1;
+}
+
+} // namespace
 
 class SmartBlueprintApp {
 private:
     SmartBlueprintCore core;
     DesktopUI ui;
     std::atomic<bool> isRunning;
+    
+    // Optional metrics dump for external scrapers (e.g. the Node server)
+    std::string metricsPath;
+    bool metricsAsJson;
+    std::chrono::steady_clock::time_point nextMetricsDump;
+    
+    // Optional anomaly model snapshot, loaded at startup and saved periodically
+    std::string modelPath;
+    std::chrono::steady_clock::time_point nextModelSave;
+    
+    // Optional shared-memory region and control socket for local consumers
+    std::string ipcName;
+
+    // Optional directory for the warm start: last device table, vendor index
+    // and (unless --model names one) the model snapshot
+    std::string stateDir;
+    std::string vendorsPath;
+    bool showingStale;
 
 public:
-    SmartBlueprintApp() : isRunning(true) {
-        // Set up signal handler for graceful shutdown
-        std::signal(SIGINT, [](int) {
-            std::cout << "\n\nReceived interrupt signal. Shutting down...\n";
-            std::exit(0);
-        });
+    SmartBlueprintApp(std::string metricsPath = std::string(), bool metricsAsJson = false,
+                      std::string modelPath = std::string(), std::string ipcName = std::string(),
+                      std::string stateDir = std::string(), std::string vendorsPath = std::string())
+        : isRunning(true), metricsPath(std::move(metricsPath)), metricsAsJson(metricsAsJson),
+          modelPath(std::move(modelPath)), nextModelSave(std::chrono::steady_clock::now() + kModelSaveInterval),
+          ipcName(std::move(ipcName)), stateDir(std::move(stateDir)), vendorsPath(std::move(vendorsPath)),
+          showingStale(false) {
+        // Graceful shutdown on Ctrl+C and on termination requests
+        std::signal(SIGINT, requestStop);
+        std::signal(SIGTERM, requestStop);
     }
-
+    
     void run() {
         showWelcomeScreen();
         
+        // Everything here maps files; the first scan starts in the background
+        // and the UI shows the restored devices until it completes
+        loadVendors();
+        if (!modelPath.empty() && !core.loadModel(modelPath)) {
+            std::cerr << "No usable model snapshot at " << modelPath << "; training from scratch" << std::endl;
+        }
+        if (!stateDir.empty()) {
+            core.loadDeviceState(statePath("devices.state")); // Missing on the first run
+        }
+        if (!ipcName.empty() && !core.enableIpc(ipcName, IpcControlServer::defaultPath(ipcName))) {
+            std::cerr << "IPC bridge " << ipcName << " unavailable; continuing without it" << std::endl;
+        }
+        
         // Start core monitoring
         core.startMonitoring();
         
         // Main application loop
-        while (isRunning.load()) {
-            // Update UI with latest data
-            auto devices = core.getCurrentDevices();
-            auto anomalies = core.detectAnomalies();
-            
-            ui.updateDevices(devices);
-            ui.updateAnomalies(anomalies);
+        uint64_t shownVersion = 0;
+        while (isRunning.load() && !stopRequested) {
+            // Update UI with latest data, skipping the copy when nothing new was published
+            if (core.getSnapshotVersion() != shownVersion) {
+                auto snapshot = core.getSnapshot();
+                ui.updateDevices(snapshot->devices);
+                ui.updateAnomalies(snapshot->anomalies);
+                shownVersion = snapshot->version;
+                showStaleState(snapshot->stale && !snapshot->devices.empty());
+            }
             
             // Render the interface
             ui.render();
+            dumpMetrics();
+            saveState(false);
+            pollExport();
             
             // Handle user input
             handleInput();
@@ -52,10 +111,63 @@ public:
         
         // Cleanup
         core.stopMonitoring();
+        saveState(true);
         showExitScreen();
     }
 
 private:
+    void dumpMetrics() {
+        if (metricsPath.empty() || std::chrono::steady_clock::now() < nextMetricsDump) return;
+        nextMetricsDump = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        
+        auto metrics = core.getMetrics();
+        std::string text = metricsAsJson ? formatMetricsJson(metrics) : formatMetricsPrometheus(metrics);
+        
+        // Write then rename so a scraper never reads a half-written file
+        std::string temporaryPath = metricsPath + ".tmp";
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            if (!file) return;
+            file << text;
+        }
+        if (!replaceFile(temporaryPath, metricsPath)) {
+            std::remove(temporaryPath.c_str());
+        }
+    }
+    
+    static constexpr std::chrono::minutes kModelSaveInterval{5};
+    
+    std::string statePath(const char* name) const {
+        return stateDir + "/" + name;
+    }
+    
+    void loadVendors() {
+        std::string indexPath = stateDir.empty() ? std::string() : statePath("oui.idx");
+        
+        // The index saved from the registry on an earlier run maps instantly
+        if (!indexPath.empty() && core.loadVendorDatabase(indexPath)) return;
+        if (!vendorsPath.empty() && !core.loadVendorDatabase(vendorsPath, indexPath)) {
+            std::cerr << "Couldn't load vendor database " << vendorsPath << "; using built-in vendors" << std::endl;
+        }
+    }
+    
+    void showStaleState(bool stale) {
+        if (stale == showingStale) return;
+        showingStale = stale;
+        ui.setStatusMessage(stale ? "Showing devices from the last run; first scan in progress..." : "");
+    }
+    
+    void saveState(bool force) {
+        if (!force && std::chrono::steady_clock::now() < nextModelSave) return;
+        nextModelSave = std::chrono::steady_clock::now() + kModelSaveInterval;
+        if (!modelPath.empty()) {
+            core.saveModel(modelPath); // Fails harmlessly while the model is untrained
+        }
+        if (!stateDir.empty() && !core.saveDeviceState(statePath("devices.state"))) {
+            std::cerr << "Couldn't save device state to " << stateDir << std::endl;
+        }
+    }
+    
     void showWelcomeScreen() {
         ui.clearScreen();
         std::cout << "╔══════════════════════════════════════════════════════════════╗\n";
@@ -66,19 +178,11 @@ private:
         std::cout << "║  ML-powered anomaly detection and signal analysis           ║\n";
         std::cout << "╚══════════════════════════════════════════════════════════════╝\n\n";
         
-        std::cout << "🔍 Initializing network scanner...\n";
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
-        
-        std::cout << "🤖 Loading ML anomaly detection models...\n";
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
-        
-        std::cout << "📡 Starting device discovery...\n";
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-        
-        std::cout << "\n✅ System ready! Switching to dashboard...\n";
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        // No pauses: the dashboard replaces this as soon as state is loaded
+        std::cout << "🔍 Loading last known state and starting device discovery...\n";
+        std::cout.flush();
     }
-
+    
     void showExitScreen() {
         ui.clearScreen();
         std::cout << "╔══════════════════════════════════════════════════════════════╗\n";
@@ -88,7 +192,7 @@ private:
         std::cout << "Thank you for using SmartBlueprint Pro!\n";
         std::cout << "Network monitoring stopped safely.\n\n";
     }
-
+    
     void handleInput() {
         char key = ui.getKeyPress();
         if (key == 0) return; // No key pressed
@@ -132,6 +236,14 @@ private:
                 ui.setView(ViewMode::HELP);
                 break;
                 
+            case 'n':
+                ui.nextPage();
+                break;
+                
+            case 'p':
+                ui.previousPage();
+                break;
+                
             case 'a':
                 if (ui.getCurrentView() == ViewMode::SETTINGS) {
                     ui.toggleAutoRefresh();
@@ -152,52 +264,83 @@ private:
                 
             case 'e':
                 if (ui.getCurrentView() == ViewMode::SETTINGS) {
-                    exportDeviceData();
+                    exportDeviceData(ExportFormat::Csv);
+                }
+                break;
+                
+            case 'j':
+                if (ui.getCurrentView() == ViewMode::SETTINGS) {
+                    exportDeviceData(ExportFormat::NdJson);
+                }
+                break;
+                
+            case 'b':
+                if (ui.getCurrentView() == ViewMode::SETTINGS) {
+                    exportDeviceData(ExportFormat::Binary);
                 }
                 break;
         }
     }
-
-    void exportDeviceData() {
-        auto devices = core.getCurrentDevices();
-        
-        std::cout << "\n📤 Exporting device data...\n";
-        
-        try {
-            std::ofstream csvFile("smartblueprint_devices.csv");
-            csvFile << "Device Name,MAC Address,IP Address,Signal Strength,Status,Device Type,Vendor\n";
-            
-            for (const auto& device : devices) {
-                std::string deviceName = device->hostname.empty() ? 
-                    ("Device-" + device->macAddress.substr(15, 2)) : device->hostname;
-                std::string ipAddr = device->ipAddress.empty() ? "Unknown" : device->ipAddress;
-                std::string status = device->isOnline ? "Online" : "Offline";
-                
-                csvFile << deviceName << ","
-                       << device->macAddress << ","
-                       << ipAddr << ","
-                       << device->rssi << " dBm,"
-                       << status << ","
-                       << device->deviceType << ","
-                       << device->vendor << "\n";
-            }
-            
-            csvFile.close();
-            
-            std::cout << "✅ Device data exported to 'smartblueprint_devices.csv'\n";
-            std::cout << "   " << devices.size() << " devices exported\n";
-            
-        } catch (const std::exception& e) {
-            std::cout << "❌ Export failed: " << e.what() << "\n";
+    
+    void exportDeviceData(ExportFormat format) {
+        // Runs on the core's export worker; the result shows up in the command bar
+        std::string path = std::string("smartblueprint_devices") + DeviceExporter::extension(format);
+        if (core.startExport(path, format)) {
+            ui.setStatusMessage("Exporting devices to " + path + "...");
+        } else {
+            ui.setStatusMessage("An export is already running");
         }
+    }
+    
+    void pollExport() {
+        ExportResult result;
+        if (!core.takeExportResult(result)) return;
         
-        std::this_thread::sleep_for(std::chrono::seconds(2));
+        if (result.ok) {
+            ui.setStatusMessage("Exported " + std::to_string(result.rows) + " rows to " + result.path);
+        } else {
+            ui.setStatusMessage("Export failed: " + result.error);
+        }
     }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
+    std::string metricsPath;
+    bool metricsAsJson = false;
+    std::string modelPath;
+    std::string ipcName;
+    std::string stateDir;
+    std::string vendorsPath;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--metrics-file") == 0 && i + 1 < argc) {
+            metricsPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--metrics-json") == 0) {
+            metricsAsJson = true;
+        } else if (std::strcmp(argv[i], "--model") == 0 && i + 1 < argc) {
+            modelPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--ipc") == 0 && i + 1 < argc) {
+            ipcName = argv[++i];
+        } else if (std::strcmp(argv[i], "--state-dir") == 0 && i + 1 < argc) {
+            stateDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--vendors") == 0 && i + 1 < argc) {
+            vendorsPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc && std::atoi(argv[i + 1]) > 0) {
+            // Worker threads for all background work; defaults to one per core
+            TaskScheduler::configureShared(static_cast<unsigned>(std::atoi(argv[++i])));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--metrics-file <path> [--metrics-json]] [--model <path>]"
+                      << " [--ipc <name>] [--threads <n>] [--state-dir <dir>] [--vendors <oui file>]" << std::endl;
+            return 2;
+        }
+    }
+    
+    // The state directory holds the model snapshot unless one is named
+    if (modelPath.empty() && !stateDir.empty()) {
+        modelPath = stateDir + "/model.bin";
+    }
+    
     try {
-        SmartBlueprintApp app;
+        SmartBlueprintApp app(metricsPath, metricsAsJson, modelPath, ipcName, stateDir, vendorsPath);
         app.run();
         return 0;
         
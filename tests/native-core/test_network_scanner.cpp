@@ -1,149 +1,2097 @@
 #include <gtest/gtest.h>
-#include "../../native-core/SmartBlueprintCore.cpp"
+#include "../../native-core/SmartBlueprintCore.h"
+#include "../../native-core/ScanBackend.h"
+#include "../../native-core/SignalHistoryStore.h"
+#include "../../native-core/FeatureStore.h"
+#include "../../native-core/TerminalFrame.h"
+#include "../../native-core/DeviceExporter.h"
+#include "../../native-core/Checksum.h"
+#include "../../native-core/IpcBridge.h"
+#include "../../native-core/TaskScheduler.h"
+#include "../../native-core/ShardedMonitor.h"
+#include "../../native-core/SlabPool.h"
+#include "../../native-core/SignalKernels.h"
+#include "../../native-core/OuiDatabase.h"
+#include "../../native-core/Localizer.h"
+#include "../../native-core/SyntheticNetwork.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
 #include <thread>
 #include <chrono>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include "../../native-core/NetlinkNeighbors.h"
+#include <arpa/inet.h>
+#include <linux/neighbour.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#endif
+
+namespace {
+
+ScanRecord makeRecord(uint64_t mac, const std::string& ip, int rssi) {
+    ScanRecord record;
+    record.mac = MacAddress(mac);
+    record.setAddress(ip);
+    record.rssi = rssi;
+    return record;
+}
+
+std::shared_ptr<NetworkDevice> makeDevice(uint32_t id, int rssi, bool online) {
+    auto device = std::make_shared<NetworkDevice>();
+    device->mac = MacAddress(0x020000000000ull + id);
+    device->deviceId = id;
+    device->macAddress = device->mac.toString();
+    device->rssi = rssi;
+    device->isOnline = online;
+    return device;
+}
+
+// Hands out queued records as events, like the netlink backend does
+class SyntheticEventBackend : public SyntheticBackend {
+public:
+    bool supportsEvents() const override { return true; }
+    
+    bool waitForEvents(int, std::vector<ScanRecord>& records) override {
+        std::lock_guard<std::mutex> lock(eventsMutex);
+        records.insert(records.end(), events.begin(), events.end());
+        events.clear();
+        return true;
+    }
+    
+    void pushEvents(const std::vector<ScanRecord>& batch) {
+        std::lock_guard<std::mutex> lock(eventsMutex);
+        events.insert(events.end(), batch.begin(), batch.end());
+    }
+    
+private:
+    std::mutex eventsMutex;
+    std::vector<ScanRecord> events;
+};
+
+// Counts full scans and whether any ran on a scheduler worker; loses
+// events once when asked to
+class ScanThreadProbe : public ScanBackend {
+public:
+    const char* name() const override { return "probe"; }
+    
+    bool scan(std::vector<ScanRecord>&) override {
+        if (TaskScheduler::shared().onWorkerThread()) scannedOnWorker = true;
+        scans++;
+        return true;
+    }
+    
+    bool supportsEvents() const override { return true; }
+    bool waitForEvents(int, std::vector<ScanRecord>&) override { return !loseEvents.exchange(false); }
+    
+    std::atomic<int> scans{0};
+    std::atomic<bool> scannedOnWorker{false};
+    std::atomic<bool> loseEvents{false};
+};
+
+} // namespace
+
 class NetworkScannerTest : public ::testing::Test {
 protected:
     void SetUp() override {
-        scanner = std::make_unique<SmartBlueprint::NetworkScanner>();
+        auto synthetic = std::make_unique<SyntheticBackend>();
+        backend = synthetic.get();
+        scanner = std::make_unique<NetworkScanner>(std::move(synthetic));
+        scanner->setChangeCallback([this](const std::vector<DeviceChange>& batch) {
+            changes.insert(changes.end(), batch.begin(), batch.end());
+        });
     }
-
+    
     void TearDown() override {
         if (scanner) {
             scanner->stopScanning();
         }
     }
-
-    std::unique_ptr<SmartBlueprint::NetworkScanner> scanner;
+    
+    size_t countChanges(DeviceChangeType type) const {
+        size_t count = 0;
+        for (const auto& change : changes) {
+            if (change.type == type) count++;
+        }
+        return count;
+    }
+    
+    SyntheticBackend* backend;
+    std::unique_ptr<NetworkScanner> scanner;
+    std::vector<DeviceChange> changes;
 };
 
 TEST_F(NetworkScannerTest, InitialState) {
-    auto devices = scanner->getDevices();
+    auto devices = scanner->getCurrentDevices();
     EXPECT_TRUE(devices.empty());
 }
 
 TEST_F(NetworkScannerTest, StartStopScanning) {
+    auto start = std::chrono::steady_clock::now();
     scanner->startScanning();
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
     
     scanner->stopScanning();
-    // Test should complete without hanging
-    SUCCEED();
+    // Stopping must not wait out the scan interval
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
 }
 
-TEST_F(NetworkScannerTest, DeviceDetection) {
-    scanner->startScanning();
+TEST(NetworkScannerThreadTest, ScansRunOffSchedulerWorkers) {
+    auto probe = std::make_unique<ScanThreadProbe>();
+    ScanThreadProbe* backend = probe.get();
+    NetworkScanner scanner(std::move(probe));
+    scanner.startScanning();
     
-    // Wait for potential device discovery
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+    auto waitForScans = [&](int count) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (backend->scans < count && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return backend->scans >= count;
+    };
+    EXPECT_TRUE(waitForScans(1));
     
-    auto devices = scanner->getDevices();
-    // Devices may or may not be found depending on network environment
-    EXPECT_GE(devices.size(), 0);
+    // Lost events wake the scan thread long before the scan interval is up
+    backend->loseEvents = true;
+    EXPECT_TRUE(waitForScans(2));
+    scanner.stopScanning();
+    EXPECT_FALSE(backend->scannedOnWorker);
+}
+
+TEST(NetworkScannerThreadTest, PollsEveryEventBackend) {
+    auto first = std::make_unique<SyntheticEventBackend>();
+    auto second = std::make_unique<SyntheticEventBackend>();
+    SyntheticEventBackend* firstEvents = first.get();
+    SyntheticEventBackend* secondEvents = second.get();
+    NetworkScanner scanner(std::move(first));
+    scanner.addBackend(std::move(second));
+    scanner.startScanning();
     
-    scanner->stopScanning();
+    firstEvents->pushEvents({makeRecord(0xaabbccddee01ull, "192.168.1.101", -40)});
+    secondEvents->pushEvents({makeRecord(0xaabbccddee02ull, "192.168.1.102", -50)});
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (scanner.getCurrentDevices().size() < 2 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    scanner.stopScanning();
+    EXPECT_EQ(scanner.getCurrentDevices().size(), 2u);
 }
 
-class MLAnomalyDetectorTest : public ::testing::Test {
-protected:
-    void SetUp() override {
-        detector = std::make_unique<SmartBlueprint::MLAnomalyDetector>();
+TEST_F(NetworkScannerTest, DeviceDetection) {
+    backend->setRecords({
+        makeRecord(0xaabbccddee01ull, "192.168.1.101", -40),
+        makeRecord(0xaabbccddee02ull, "192.168.1.102", -60),
+        makeRecord(0xaabbccddee03ull, "192.168.1.103", -80),
+    });
+    scanner->performNetworkScan();
+    
+    auto devices = scanner->getCurrentDevices();
+    ASSERT_EQ(devices.size(), 3u);
+    EXPECT_EQ(devices[0]->macAddress, "aa:bb:cc:dd:ee:01");
+    EXPECT_EQ(devices[0]->ipAddress, "192.168.1.101");
+    EXPECT_EQ(devices[2]->rssi, -80);
+    for (const auto& device : devices) {
+        EXPECT_TRUE(device->isOnline);
+        EXPECT_EQ(scanner->getDeviceIds().find(device->mac), device->deviceId);
     }
+}
+
+TEST_F(NetworkScannerTest, ChangeStreamReportsOnlyDeltas) {
+    backend->setRecords({
+        makeRecord(0xaabbccddee01ull, "192.168.1.101", -40),
+        makeRecord(0xaabbccddee02ull, "192.168.1.102", -60),
+    });
+    scanner->performNetworkScan();
+    EXPECT_EQ(countChanges(DeviceChangeType::Added), 2u);
+    
+    // An identical scan produces no changes
+    changes.clear();
+    scanner->performNetworkScan();
+    EXPECT_TRUE(changes.empty());
+    
+    // One device moves, the other disappears
+    backend->setRecords({makeRecord(0xaabbccddee01ull, "192.168.1.101", -45)});
+    scanner->performNetworkScan();
+    ASSERT_EQ(changes.size(), 2u);
+    EXPECT_EQ(countChanges(DeviceChangeType::Updated), 2u);
+    
+    auto devices = scanner->getCurrentDevices();
+    ASSERT_EQ(devices.size(), 2u);
+    EXPECT_EQ(devices[0]->rssi, -45);
+    EXPECT_FALSE(devices[1]->isOnline);
+}
 
-    std::unique_ptr<SmartBlueprint::MLAnomalyDetector> detector;
+TEST_F(NetworkScannerTest, MultipleBackendsMergeByMac) {
+    auto second = std::make_unique<SyntheticBackend>();
+    second->setRecords({
+        makeRecord(0xaabbccddee01ull, "", -35), // Same device, no address
+        makeRecord(0xaabbccddee09ull, "192.168.1.109", -70),
+    });
+    scanner->addBackend(std::move(second));
+    backend->setRecords({makeRecord(0xaabbccddee01ull, "192.168.1.101", -40)});
+    
+    scanner->performNetworkScan();
+    
+    auto devices = scanner->getCurrentDevices();
+    ASSERT_EQ(devices.size(), 2u);
+    EXPECT_EQ(devices[0]->ipAddress, "192.168.1.101");
+    EXPECT_EQ(devices[0]->rssi, -35);
+}
+
+TEST_F(NetworkScannerTest, RemovedDevicesFreeTheirIds) {
+    // A device last seen long ago ages out on the first scan that misses it
+    NetworkDevice gone;
+    gone.mac = MacAddress(0xaabbccddee01ull);
+    gone.macAddress = gone.mac.toString();
+    gone.lastSeen = std::chrono::system_clock::now() - std::chrono::minutes(20);
+    scanner->restoreDevices({gone});
+    uint32_t goneId = scanner->getDeviceIds().find(gone.mac);
+    
+    backend->setRecords({makeRecord(0xaabbccddee02ull, "192.168.1.102", -50)});
+    scanner->performNetworkScan();
+    EXPECT_EQ(countChanges(DeviceChangeType::Removed), 1u);
+    EXPECT_EQ(scanner->getDeviceIds().find(gone.mac), DeviceIdTable::kInvalidId);
+    
+    // The next scan hands the freed ID to a new device
+    backend->setRecords({makeRecord(0xaabbccddee02ull, "192.168.1.102", -50),
+                         makeRecord(0xaabbccddee03ull, "192.168.1.103", -60)});
+    scanner->performNetworkScan();
+    EXPECT_EQ(scanner->getDeviceIds().find(MacAddress(0xaabbccddee03ull)), goneId);
+    EXPECT_EQ(scanner->getDeviceIds().macAddress(goneId), MacAddress(0xaabbccddee03ull));
+    EXPECT_EQ(scanner->getDeviceIds().size(), 2u);
+    
+    auto devices = scanner->getCurrentDevices();
+    ASSERT_EQ(devices.size(), 2u);
+    EXPECT_EQ(devices[goneId]->ipAddress, "192.168.1.103");
+}
+
+TEST(DeviceIdTableTest, ReleasedIdsAreReusedAfterReclaim) {
+    DeviceIdTable table;
+    uint32_t a = table.intern(MacAddress(1));
+    uint32_t b = table.intern(MacAddress(2));
+    table.release(a);
+    table.release(a); // already released
+    EXPECT_EQ(table.find(MacAddress(1)), DeviceIdTable::kInvalidId);
+    EXPECT_TRUE(table.macAddress(a).isZero());
+    EXPECT_EQ(table.intern(MacAddress(3)), 2u);
+    
+    table.reclaimReleased();
+    EXPECT_EQ(table.intern(MacAddress(1)), a); // a returning MAC is a new device
+    EXPECT_EQ(table.intern(MacAddress(4)), 3u);
+    EXPECT_EQ(table.find(MacAddress(2)), b);
+    EXPECT_EQ(table.size(), 4u);
+}
+
+TEST(SubnetSweeperTest, TargetsFormattingAndReplyMatching) {
+    auto ip = [](uint32_t a, uint32_t b, uint32_t c, uint32_t d) { return a << 24 | b << 16 | c << 8 | d; };
+    SubnetSweeper sweeper;
+    
+    // Every host but the network, broadcast and our own addresses; a second
+    // interface on the same subnet adds nothing
+    auto targets = sweeper.targetAddresses({{ip(192, 168, 1, 0), 24, ip(192, 168, 1, 10), "eth0"},
+                                            {ip(192, 168, 1, 0), 24, ip(192, 168, 1, 11), "wlan0"}});
+    ASSERT_EQ(targets.size(), 252u);
+    EXPECT_TRUE(std::is_sorted(targets.begin(), targets.end()));
+    EXPECT_EQ(targets.front(), ip(192, 168, 1, 1));
+    EXPECT_EQ(targets.back(), ip(192, 168, 1, 254));
+    EXPECT_FALSE(std::binary_search(targets.begin(), targets.end(), ip(192, 168, 1, 10)));
+    EXPECT_FALSE(std::binary_search(targets.begin(), targets.end(), ip(192, 168, 1, 11)));
+    
+    // /31 and /32 links have no host range; a /30 has two hosts, one of them us
+    EXPECT_TRUE(sweeper.targetAddresses({{ip(10, 0, 0, 0), 31, ip(10, 0, 0, 1), "p2p"},
+                                         {ip(10, 0, 0, 9), 32, ip(10, 0, 0, 9), "tun0"}}).empty());
+    auto link = sweeper.targetAddresses({{ip(10, 0, 0, 4), 30, ip(10, 0, 0, 5), "link"}});
+    ASSERT_EQ(link.size(), 1u);
+    EXPECT_EQ(link[0], ip(10, 0, 0, 6));
+    
+    // Large networks are clamped to the block around our own address
+    auto corporate = sweeper.targetAddresses({{ip(10, 1, 0, 0), 16, ip(10, 1, 37, 5), "corp"}});
+    ASSERT_EQ(corporate.size(), 4093u);
+    EXPECT_EQ(corporate.front(), ip(10, 1, 32, 1));
+    EXPECT_EQ(corporate.back(), ip(10, 1, 47, 254));
+    SubnetSweeper::Options narrow;
+    narrow.minPrefixLength = 22;
+    EXPECT_EQ(SubnetSweeper(narrow).targetAddresses({{ip(10, 1, 0, 0), 16, ip(10, 1, 37, 5), "corp"}}).size(), 1021u);
+    
+    EXPECT_EQ(SubnetSweeper::formatAddress(ip(192, 168, 1, 254)), "192.168.1.254");
+    EXPECT_EQ(SubnetSweeper::formatAddress(0), "0.0.0.0");
+    
+    // Echo replies (type 0) with our identifier; our own echo requests looping back don't count
+    uint8_t reply[16] = {0, 0, 0, 0, 0x12, 0x34, 0, 1};
+    EXPECT_TRUE(SubnetSweeper::isEchoReply(reply, sizeof(reply), false, -1));
+    EXPECT_TRUE(SubnetSweeper::isEchoReply(reply, sizeof(reply), false, 0x1234));
+    EXPECT_FALSE(SubnetSweeper::isEchoReply(reply, sizeof(reply), false, 0x4321));
+    EXPECT_FALSE(SubnetSweeper::isEchoReply(reply, 7, false, -1));
+    reply[0] = 8;
+    EXPECT_FALSE(SubnetSweeper::isEchoReply(reply, sizeof(reply), false, -1));
+    reply[0] = 0;
+    
+    // Behind an IPv4 header, here with options (IHL 6)
+    uint8_t packet[24 + sizeof(reply)] = {0x46};
+    std::memcpy(packet + 24, reply, sizeof(reply));
+    EXPECT_TRUE(SubnetSweeper::isEchoReply(packet, sizeof(packet), true, 0x1234));
+    EXPECT_FALSE(SubnetSweeper::isEchoReply(packet, 30, true, 0x1234));
+    EXPECT_FALSE(SubnetSweeper::isEchoReply(packet, 19, true, -1));
+    packet[0] = 0x66;
+    EXPECT_FALSE(SubnetSweeper::isEchoReply(packet, sizeof(packet), true, -1));
+}
+
+class MLEngineTest : public ::testing::Test {
+protected:
+    MLEngine engine;
 };
 
-TEST_F(MLAnomalyDetectorTest, TrainingWithEmptyData) {
-    std::vector<std::shared_ptr<SmartBlueprint::Device>> emptyDevices;
-    detector->trainModel(emptyDevices);
+TEST_F(MLEngineTest, TrainingWithEmptyData) {
+    engine.trainModel({});
     SUCCEED(); // Should not crash
 }
 
-TEST_F(MLAnomalyDetectorTest, AnomalyDetectionWithoutTraining) {
-    auto device = std::make_shared<SmartBlueprint::Device>("aa:bb:cc:dd:ee:ff", "192.168.1.100");
-    device->rssi = -50;
-    device->isOnline = true;
+TEST_F(MLEngineTest, AnomalyDetectionWithoutTraining) {
+    auto anomalies = engine.detectAnomalies({makeDevice(0, -50, true)});
+    EXPECT_TRUE(anomalies.empty()); // Untrained forest scores everything 0.5
+}
+
+TEST_F(MLEngineTest, TrainingAndDetection) {
+    IsolationForest forest(100, 64);
+    std::vector<std::vector<double>> training;
+    for (int i = 0; i < 200; ++i) {
+        training.push_back({-50.0 + (i % 10), 1.0});
+    }
+    forest.train(training);
     
-    double score = detector->detectAnomaly(device);
-    EXPECT_EQ(score, 0.0); // Should return 0 when not trained
+    double normalScore = forest.anomalyScore({-45.0, 1.0});
+    double anomalyScore = forest.anomalyScore({-95.0, 0.0});
+    
+    EXPECT_GT(anomalyScore, normalScore);
 }
 
-TEST_F(MLAnomalyDetectorTest, TrainingAndDetection) {
-    // Create training data
-    std::vector<std::shared_ptr<SmartBlueprint::Device>> devices;
-    for (int i = 0; i < 5; ++i) {
-        auto device = std::make_shared<SmartBlueprint::Device>(
-            "aa:bb:cc:dd:ee:0" + std::to_string(i), 
-            "192.168.1.10" + std::to_string(i)
-        );
-        device->rssi = -50 + i * 5; // Normal range
-        device->isOnline = true;
-        devices.push_back(device);
+TEST_F(MLEngineTest, BatchScoresMatchPerPointScores) {
+    IsolationForest forest(60, 64);
+    std::vector<float> training;
+    for (int i = 0; i < 300; ++i) {
+        training.insert(training.end(), {-50.0f + (i % 10), static_cast<float>(i % 3), 0.25f * (i % 7)});
     }
+    forest.train(training.data(), 300, 3);
     
-    detector->trainModel(devices);
+    // Rows padded to a stride of 4, an odd count, normal and outlying points
+    const size_t count = 37, stride = 4;
+    std::vector<float> rows(count * stride, 99.0f);
+    for (size_t i = 0; i < count; ++i) {
+        rows[i * stride] = -100.0f + 2.5f * static_cast<float>(i);
+        rows[i * stride + 1] = static_cast<float>(i % 4);
+        rows[i * stride + 2] = 0.1f * static_cast<float>(i);
+    }
+    std::vector<double> scores(count);
+    forest.anomalyScoreBatch(rows.data(), count, stride, scores.data());
     
-    // Test normal device
-    auto normalDevice = std::make_shared<SmartBlueprint::Device>("normal", "192.168.1.200");
-    normalDevice->rssi = -52;
-    normalDevice->isOnline = true;
+    for (size_t i = 0; i < count; ++i) {
+        std::vector<double> point(rows.begin() + i * stride, rows.begin() + i * stride + 3);
+        EXPECT_DOUBLE_EQ(scores[i], forest.anomalyScore(point)) << "row " << i;
+    }
+}
+
+TEST_F(MLEngineTest, ParallelTrainingIsDeterministic) {
+    std::vector<float> rows;
+    for (int i = 0; i < 512; ++i) {
+        rows.insert(rows.end(), {-60.0f + (i % 17), static_cast<float>(i % 5)});
+    }
     
-    double normalScore = detector->detectAnomaly(normalDevice);
+    // Same seed, one thread against every worker, including sliding-window updates
+    IsolationForest serial(64, 128, 7), parallel(64, 128, 7);
+    serial.setTrainingThreads(1);
+    parallel.setTrainingThreads(0);
+    serial.train(rows.data(), 512, 2);
+    parallel.train(rows.data(), 512, 2);
+    for (int update = 0; update < 3; ++update) {
+        serial.replaceTrees(rows.data() + 200, 256, 2, 16);
+        parallel.replaceTrees(rows.data() + 200, 256, 2, 16);
+    }
     
-    // Test anomalous device
-    auto anomalousDevice = std::make_shared<SmartBlueprint::Device>("anomaly", "192.168.1.201");
-    anomalousDevice->rssi = -90; // Much weaker signal
-    anomalousDevice->isOnline = false;
+    for (int i = 0; i < 50; ++i) {
+        std::vector<double> point = {-90.0 + i, static_cast<double>(i % 6)};
+        EXPECT_EQ(serial.anomalyScore(point), parallel.anomalyScore(point)) << "point " << i;
+    }
+}
+
+TEST_F(MLEngineTest, SlidingWindowForestFollowsDrift) {
+    IsolationForest forest(50, 64);
+    std::vector<float> before, after;
+    for (int i = 0; i < 256; ++i) {
+        before.insert(before.end(), {-50.0f + (i % 10), 1.0f});
+        after.insert(after.end(), {-80.0f + (i % 10), 1.0f});
+    }
+    forest.train(before.data(), 256, 2);
+    double driftedBefore = forest.anomalyScore({-75.0, 1.0});
     
-    double anomalyScore = detector->detectAnomaly(anomalousDevice);
+    // Replacing every tree from the new window moves the model to the new regime
+    for (int cycle = 0; cycle < 5; ++cycle) {
+        forest.replaceTrees(after.data(), 256, 2, 10);
+    }
+    EXPECT_EQ(forest.treeCount(), 50u);
+    EXPECT_LT(forest.anomalyScore({-75.0, 1.0}), driftedBefore);
+    EXPECT_GT(forest.anomalyScore({-45.0, 1.0}), forest.anomalyScore({-75.0, 1.0}));
+}
+
+TEST_F(MLEngineTest, OnlineLearningTrainsFromObservedDevices) {
+    MLEngine::OnlineOptions options;
+    options.minRowsToTrain = 32;
+    engine.enableOnlineLearning(options);
     
-    EXPECT_GT(anomalyScore, normalScore);
+    std::vector<std::shared_ptr<NetworkDevice>> devices;
+    for (uint32_t id = 0; id < 16; ++id) {
+        devices.push_back(makeDevice(id, -50 - static_cast<int>(id % 4), true));
+    }
+    engine.detectAnomalies(devices);
+    EXPECT_FALSE(engine.isTrained());
+    engine.detectAnomalies(devices);
+    EXPECT_TRUE(engine.isTrained());
+    
+    // A background retrain is swapped in by a later detection call
+    ASSERT_TRUE(engine.retrainFromWindowAsync());
+    while (engine.isRetraining()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    engine.detectAnomalies(devices);
+    EXPECT_TRUE(engine.isTrained());
+}
+
+TEST_F(MLEngineTest, SnapshotLoadsMappedAndRejectsCorruption) {
+    IsolationForest forest(50, 64);
+    std::vector<float> rows;
+    for (int i = 0; i < 256; ++i) {
+        rows.insert(rows.end(), {-50.0f + (i % 10), 1.0f});
+    }
+    forest.train(rows.data(), 256, 2);
+    forest.replaceTrees(rows.data(), 256, 2, 5); // leaves dead nodes behind
+    
+    std::string path = ::testing::TempDir() + "sb_forest_snapshot.bin";
+    ASSERT_TRUE(forest.saveSnapshot(path, 7));
+    
+    IsolationForest loaded;
+    EXPECT_FALSE(loaded.loadSnapshot(path, 8)); // another feature layout
+    ASSERT_TRUE(loaded.loadSnapshot(path, 7));
+    EXPECT_TRUE(loaded.isMapped());
+    EXPECT_EQ(loaded.treeCount(), 50u);
+    EXPECT_EQ(loaded.numFeatures(), 2u);
+    EXPECT_DOUBLE_EQ(loaded.anomalyScore({-95.0, 0.0}), forest.anomalyScore({-95.0, 0.0}));
+    EXPECT_DOUBLE_EQ(loaded.anomalyScore({-45.0, 1.0}), forest.anomalyScore({-45.0, 1.0}));
+    
+    // Online updates copy the mapped trees into memory first
+    loaded.replaceTrees(rows.data(), 256, 2, 1);
+    EXPECT_FALSE(loaded.isMapped());
+    EXPECT_EQ(loaded.treeCount(), 50u);
+    
+    // A flipped byte fails the checksum and leaves the current model in place
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-3, std::ios::end);
+        file.put('\x5a');
+    }
+    IsolationForest corrupted(50, 64);
+    EXPECT_FALSE(corrupted.loadSnapshot(path, 7));
+    EXPECT_FALSE(corrupted.isTrained());
+    
+    // The engine rejects snapshots whose features don't match its own
+    ASSERT_TRUE(forest.saveSnapshot(path, FeatureStore::kLayoutVersion));
+    EXPECT_FALSE(engine.loadModel(path));
+    EXPECT_FALSE(engine.isTrained());
+    
+    std::vector<std::shared_ptr<NetworkDevice>> devices;
+    for (uint32_t id = 0; id < 64; ++id) {
+        devices.push_back(makeDevice(id, -50 - static_cast<int>(id % 8), true));
+    }
+    engine.trainModel(devices);
+    ASSERT_TRUE(engine.saveModel(path));
+    MLEngine restarted;
+    ASSERT_TRUE(restarted.loadModel(path));
+    EXPECT_TRUE(restarted.isTrained());
+    std::remove(path.c_str());
+}
+
+TEST(FeatureStoreTest, RollingStatisticsTrackBehaviour) {
+    FeatureStore store;
+    auto steady = makeDevice(0, -50, true);
+    auto flaky = makeDevice(1, -50, true);
+    steady->ipAddress = "10.0.0.1";
+    flaky->ipAddress = "10.0.0.2";
+    std::vector<std::shared_ptr<NetworkDevice>> devices = {steady, flaky};
+    std::vector<float> rows(devices.size() * FeatureStore::kNumFeatures);
+    
+    auto now = std::chrono::system_clock::now();
+    for (int i = 0; i < 40; ++i) {
+        flaky->rssi = (i % 2) ? -40 : -80;
+        flaky->isOnline = (i % 4) != 3;
+        flaky->ipAddress = "10.0.0." + std::to_string(2 + i % 3);
+        store.observe(devices.data(), devices.size(), now + std::chrono::seconds(5 * i), rows.data());
+    }
+    
+    const float* steadyRow = &rows[0];
+    const float* flakyRow = &rows[FeatureStore::kNumFeatures];
+    EXPECT_FLOAT_EQ(steadyRow[FeatureStore::kRssiStdDev], 0.0f);
+    EXPECT_NEAR(flakyRow[FeatureStore::kRssiStdDev], 20.0f, 1.0f);
+    EXPECT_FLOAT_EQ(steadyRow[FeatureStore::kFlapRate], 0.0f);
+    EXPECT_GT(flakyRow[FeatureStore::kFlapRate], 15.0f);
+    EXPECT_FLOAT_EQ(steadyRow[FeatureStore::kIpChurnRate], 0.0f);
+    EXPECT_GT(flakyRow[FeatureStore::kIpChurnRate], 30.0f);
+    
+    // Rates decay with the half-life once the device settles down
+    float settled[FeatureStore::kNumFeatures];
+    store.extract(*flaky, now + std::chrono::seconds(200 + 3600), settled);
+    EXPECT_NEAR(settled[FeatureStore::kFlapRate], flakyRow[FeatureStore::kFlapRate] / 2.0f, 0.1f);
+    EXPECT_EQ(store.size(), 2u);
 }
 
 class SmartBlueprintCoreTest : public ::testing::Test {
 protected:
     void SetUp() override {
-        core = std::make_unique<SmartBlueprint::SmartBlueprintCore>();
+        auto synthetic = std::make_unique<SyntheticBackend>();
+        backend = synthetic.get();
+        core = std::make_unique<SmartBlueprintCore>(std::make_unique<NetworkScanner>(std::move(synthetic)));
     }
-
+    
     void TearDown() override {
         if (core) {
-            core->stop();
+            core->stopMonitoring();
         }
     }
-
-    std::unique_ptr<SmartBlueprint::SmartBlueprintCore> core;
+    
+    SyntheticBackend* backend;
+    std::unique_ptr<SmartBlueprintCore> core;
 };
 
 TEST_F(SmartBlueprintCoreTest, StartStop) {
-    core->start();
+    core->startMonitoring();
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
     
-    core->stop();
-    SUCCEED();
+    core->stopMonitoring();
+    EXPECT_FALSE(core->isMonitoring());
 }
 
 TEST_F(SmartBlueprintCoreTest, DeviceRetrieval) {
-    core->start();
+    backend->setRecords({
+        makeRecord(0x00000c000001ull, "192.168.1.1", -40),
+        makeRecord(0x000393000002ull, "192.168.1.2", -55),
+    });
+    core->startMonitoring();
     
-    auto devices = core->getCurrentDevices();
-    EXPECT_GE(devices.size(), 0);
+    // Changes are processed as events, so the snapshot updates quickly
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (core->getCurrentDevices().size() < 2 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    
+    auto snapshot = core->getSnapshot();
+    ASSERT_EQ(snapshot->devices.size(), 2u);
+    EXPECT_GT(snapshot->version, 0u);
+    EXPECT_EQ(snapshot->devices[0]->vendor, "Cisco");
+    EXPECT_EQ(snapshot->devices[0]->deviceType, DeviceType::Router);
     
-    core->stop();
+    core->stopMonitoring();
 }
 
 TEST_F(SmartBlueprintCoreTest, AnomalyDetection) {
-    core->start();
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    core->startMonitoring();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
     
     auto anomalies = core->detectAnomalies();
-    EXPECT_GE(anomalies.size(), 0);
+    EXPECT_TRUE(anomalies.empty());
+    
+    core->stopMonitoring();
+}
+
+TEST(MetricsTest, HistogramPercentilesWithinBucketError) {
+    LatencyHistogram histogram;
+    for (uint64_t value = 1; value <= 10000; ++value) {
+        histogram.record(value * 1000);
+    }
+    
+    EXPECT_EQ(histogram.count(), 10000u);
+    EXPECT_EQ(histogram.min(), 1000u);
+    EXPECT_EQ(histogram.max(), 10000000u);
+    EXPECT_NEAR(static_cast<double>(histogram.percentile(0.5)), 5000000.0, 5000000.0 / 16);
+    EXPECT_NEAR(static_cast<double>(histogram.percentile(0.99)), 9900000.0, 9900000.0 / 16);
+    EXPECT_EQ(histogram.percentile(1.0), histogram.max());
+    
+    for (size_t i = 0; i + 1 < LatencyHistogram::kBucketCount; ++i) {
+        EXPECT_EQ(LatencyHistogram::bucketIndex(LatencyHistogram::bucketLowerBound(i)), i);
+        EXPECT_EQ(LatencyHistogram::bucketIndex(LatencyHistogram::bucketUpperBound(i)), i);
+    }
+}
+
+TEST_F(SmartBlueprintCoreTest, MetricsCoverMonitoringCycle) {
+    Metrics::reset();
+    backend->setRecords({
+        makeRecord(0x00000c000001ull, "192.168.1.1", -40),
+        makeRecord(0x000393000002ull, "192.168.1.2", -55),
+    });
+    core->runMonitoringCycle(true);
+    core->runMonitoringCycle(true);
+    
+    auto metrics = core->getMetrics();
+    if (!SB_ENABLE_METRICS) {
+        EXPECT_EQ(metrics.counter(MetricCounter::Cycles), 0u);
+        return;
+    }
+    EXPECT_EQ(metrics.counter(MetricCounter::Cycles), 2u);
+    EXPECT_EQ(metrics.counter(MetricCounter::DevicesProcessed), 4u);
+    EXPECT_EQ(metrics.counter(MetricCounter::CacheHits), 2u); // second pass hits the classifier cache
+    EXPECT_EQ(metrics.stage(MetricStage::Scan).count, 2u);
+    EXPECT_EQ(metrics.stage(MetricStage::Classification).count, 2u);
+    EXPECT_GE(metrics.stage(MetricStage::Cycle).maxNs, metrics.stage(MetricStage::AnomalyScoring).maxNs);
+    
+    std::string text = formatMetricsPrometheus(metrics);
+    EXPECT_NE(text.find("smartblueprint_cycles_total 2"), std::string::npos);
+    EXPECT_NE(text.find("stage=\"classification\",quantile=\"0.99\""), std::string::npos);
+    EXPECT_NE(formatMetricsJson(metrics).find("\"devices_processed\":4"), std::string::npos);
+}
+
+TEST(SlabPoolTest, FreedBlocksAreReused) {
+    // allocate_shared puts the control block in the same block as the device
+    auto pool = std::make_shared<SlabPool>(sizeof(NetworkDevice) + 64, 4);
+    void* first = pool->allocate(sizeof(NetworkDevice));
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(pool->allocate(pool->blockSize() + 1), nullptr);
+    pool->deallocate(first, sizeof(NetworkDevice));
+    EXPECT_EQ(pool->allocate(sizeof(NetworkDevice)), first);
+    pool->deallocate(first, sizeof(NetworkDevice));
+    
+    std::vector<std::shared_ptr<NetworkDevice>> devices;
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 10; ++i) {
+            devices.push_back(std::allocate_shared<NetworkDevice>(SlabAllocator<NetworkDevice>(pool)));
+        }
+        EXPECT_EQ(pool->blocksInUse(), 10u);
+        devices.clear();
+    }
+    EXPECT_EQ(pool->blocksInUse(), 0u);
+    EXPECT_LE(pool->slabCount(), 3u); // later rounds only reuse the first round's blocks
+}
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+namespace {
+
+void appendAttribute(std::string& payload, uint16_t type, const void* data, size_t size) {
+    rtattr attribute{};
+    attribute.rta_len = static_cast<unsigned short>(RTA_LENGTH(size));
+    attribute.rta_type = type;
+    payload.append(reinterpret_cast<const char*>(&attribute), sizeof(attribute));
+    payload.append(static_cast<const char*>(data), size);
+    payload.resize(RTA_ALIGN(payload.size()), '\0');
+}
+
+// ndmsg plus NDA_DST and, unless mac is null, NDA_LLADDR
+std::string neighborPayload(uint8_t family, uint16_t state, const char* address, const uint8_t* mac) {
+    ndmsg message{};
+    message.ndm_family = family;
+    message.ndm_ifindex = 3;
+    message.ndm_state = state;
+    std::string payload(reinterpret_cast<const char*>(&message), sizeof(message));
+    payload.resize(NLMSG_ALIGN(payload.size()), '\0');
     
-    core->stop();
+    uint8_t destination[16];
+    inet_pton(family, address, destination);
+    appendAttribute(payload, NDA_DST, destination, family == AF_INET ? 4 : 16);
+    if (mac) appendAttribute(payload, NDA_LLADDR, mac, 6);
+    return payload;
+}
+
+void appendMessage(std::string& datagram, uint16_t type, uint32_t sequence, const std::string& payload) {
+    nlmsghdr header{};
+    header.nlmsg_len = static_cast<uint32_t>(NLMSG_LENGTH(payload.size()));
+    header.nlmsg_type = type;
+    header.nlmsg_seq = sequence;
+    datagram.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    datagram += payload;
+    datagram.resize(NLMSG_ALIGN(datagram.size()), '\0');
+}
+
+std::string errorPayload(int error) {
+    nlmsgerr message{};
+    message.error = error;
+    return std::string(reinterpret_cast<const char*>(&message), sizeof(message));
+}
+
+// Parses from 4-byte aligned storage, as the receive buffer is
+bool parseDatagram(const std::string& datagram, uint32_t sequence, std::vector<NeighborEntry>& out, bool& done) {
+    std::vector<uint32_t> aligned((datagram.size() + 3) / 4);
+    std::memcpy(aligned.data(), datagram.data(), datagram.size());
+    return NetlinkNeighbors::parseMessages(reinterpret_cast<const char*>(aligned.data()), datagram.size(),
+                                           sequence, out, done);
+}
+
+} // namespace
+
+TEST(NetlinkNeighborsTest, ParsesNeighborMessages) {
+    const uint8_t mac[6] = {0x3c, 0x22, 0xfb, 0x01, 0x02, 0x03};
+    const uint8_t zeroMac[6] = {};
+    
+    std::string dump;
+    appendMessage(dump, RTM_NEWNEIGH, 7, neighborPayload(AF_INET, NUD_REACHABLE, "192.168.1.20", mac));
+    appendMessage(dump, RTM_NEWNEIGH, 7, neighborPayload(AF_INET, NUD_FAILED, "192.168.1.21", mac));
+    appendMessage(dump, RTM_NEWNEIGH, 7, neighborPayload(AF_INET, NUD_INCOMPLETE, "192.168.1.22", nullptr));
+    appendMessage(dump, RTM_NEWNEIGH, 7, neighborPayload(AF_INET, NUD_NOARP, "192.168.1.23", zeroMac));
+    appendMessage(dump, RTM_NEWNEIGH, 6, neighborPayload(AF_INET, NUD_REACHABLE, "192.168.1.24", mac));
+    appendMessage(dump, RTM_NEWNEIGH, 7, neighborPayload(AF_BRIDGE, NUD_REACHABLE, "192.168.1.25", mac));
+    appendMessage(dump, RTM_NEWNEIGH, 7, std::string(2, '\0')); // shorter than ndmsg
+    appendMessage(dump, RTM_NEWNEIGH, 7, neighborPayload(AF_INET6, NUD_STALE, "fe80::1", mac));
+    appendMessage(dump, RTM_DELNEIGH, 7, neighborPayload(AF_INET, NUD_REACHABLE, "192.168.1.26", mac));
+    appendMessage(dump, NLMSG_DONE, 7, std::string(4, '\0'));
+    appendMessage(dump, RTM_NEWNEIGH, 7, neighborPayload(AF_INET, NUD_REACHABLE, "192.168.1.27", mac));
+    
+    std::vector<NeighborEntry> entries;
+    bool done = false;
+    EXPECT_TRUE(parseDatagram(dump, 7, entries, done));
+    EXPECT_TRUE(done);
+    ASSERT_EQ(entries.size(), 4u);
+    
+    char address[INET6_ADDRSTRLEN];
+    entries[0].formatAddress(address);
+    EXPECT_STREQ(address, "192.168.1.20");
+    EXPECT_EQ(entries[0].mac, MacAddress::fromBytes(mac));
+    EXPECT_EQ(entries[0].interfaceIndex, 3);
+    EXPECT_TRUE(entries[0].isReachable());
+    
+    // The kernel gave up resolving it
+    entries[1].formatAddress(address);
+    EXPECT_STREQ(address, "192.168.1.21");
+    EXPECT_TRUE(entries[1].removed);
+    EXPECT_FALSE(entries[1].isReachable());
+    
+    entries[2].formatAddress(address);
+    EXPECT_STREQ(address, "fe80::1");
+    EXPECT_EQ(entries[2].family, AF_INET6);
+    EXPECT_TRUE(entries[2].isReachable());
+    
+    entries[3].formatAddress(address);
+    EXPECT_STREQ(address, "192.168.1.26");
+    EXPECT_TRUE(entries[3].removed);
+    
+    // Notifications carry no sequence number and never end a dump
+    std::string events;
+    appendMessage(events, RTM_NEWNEIGH, 0, neighborPayload(AF_INET, NUD_DELAY, "10.0.0.5", mac));
+    entries.clear();
+    done = false;
+    EXPECT_TRUE(parseDatagram(events, 0, entries, done));
+    EXPECT_FALSE(done);
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_TRUE(entries[0].isReachable());
+    
+    // An acknowledgement ends a request successfully, an error fails it
+    std::string ack;
+    appendMessage(ack, NLMSG_ERROR, 9, errorPayload(0));
+    done = false;
+    EXPECT_TRUE(parseDatagram(ack, 9, entries, done));
+    EXPECT_TRUE(done);
+    
+    std::string failure;
+    appendMessage(failure, NLMSG_ERROR, 9, errorPayload(-EPERM));
+    done = false;
+    EXPECT_FALSE(parseDatagram(failure, 9, entries, done));
+    EXPECT_TRUE(done);
+    EXPECT_EQ(entries.size(), 1u);
+}
+#endif
+
+TEST(PatternMatcherTest, PriorityDecidesBetweenOverlappingMatches) {
+    PatternMatcher matcher;
+    EXPECT_EQ(matcher.match("anything"), PatternMatcher::kNoMatch); // nothing compiled yet
+    
+    int he = matcher.addPattern("he", "he", 3);
+    int she = matcher.addPattern("she", "she", 1);
+    int hers = matcher.addPattern("hers", "hers", 0);
+    int his = matcher.addPattern("His", "his", 2);
+    int tv = matcher.addPattern("tv", "tv", 5);
+    int tvFirst = matcher.addPattern("tv", "tv again", 5);
+    matcher.compile();
+    
+    // Suffix patterns reached through failure links
+    EXPECT_EQ(matcher.match("ushe"), she);
+    EXPECT_EQ(matcher.match("xhex"), he);
+    // Overlapping matches: the lowest priority value wins wherever it occurs
+    EXPECT_EQ(matcher.match("ushers"), hers);
+    EXPECT_EQ(matcher.match("she-his"), she);
+    EXPECT_EQ(matcher.match("this"), his);
+    // Case folding applies to both the patterns and the text
+    EXPECT_EQ(matcher.match("THIS"), his);
+    EXPECT_EQ(matcher.match("SHE"), she);
+    EXPECT_EQ(matcher.result(matcher.match("Living-Room-TV")), "tv");
+    // Equal priorities fall back to the order rules were added in
+    EXPECT_EQ(matcher.match("smart tv"), tv);
+    EXPECT_NE(tvFirst, tv);
+    
+    EXPECT_EQ(matcher.match(""), PatternMatcher::kNoMatch);
+    EXPECT_EQ(matcher.match("xyz-123"), PatternMatcher::kNoMatch);
+    EXPECT_EQ(matcher.match("h e"), PatternMatcher::kNoMatch);
+    
+    matcher.clear();
+    matcher.compile();
+    EXPECT_EQ(matcher.match("she"), PatternMatcher::kNoMatch);
+}
+
+TEST(DeviceClassifierTest, MatcherAgreesWithLinearScan) {
+    DeviceClassifier classifier(0);
+    const std::map<std::string, DeviceType> hostnameRules = classifier.getHostnamePatterns();
+    const std::map<std::string, DeviceType> vendorRules = classifier.getVendorPatterns();
+    ASSERT_FALSE(hostnameRules.empty());
+    ASSERT_FALSE(vendorRules.empty());
+    
+    // The scan the matcher replaced: first rule in map order found in the lowercased text
+    auto linearScan = [](const std::map<std::string, DeviceType>& rules, std::string text, DeviceType& type) {
+        std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+        for (const auto& rule : rules) {
+            if (text.find(rule.first) != std::string::npos) {
+                type = rule.second;
+                return true;
+            }
+        }
+        return false;
+    };
+    auto pairsOf = [](const std::map<std::string, DeviceType>& rules) {
+        std::vector<std::string> texts = {"", "xyz-123"};
+        for (const auto& a : rules) {
+            texts.push_back(a.first);
+            for (const auto& b : rules) texts.push_back(a.first + "-" + b.first);
+        }
+        return texts;
+    };
+    
+    // Vendor names built from every pair of vendor patterns, one OUI each
+    std::vector<std::string> vendors = pairsOf(vendorRules);
+    std::string registryPath = ::testing::TempDir() + "sb_vendor_pairs.csv";
+    {
+        std::ofstream registry(registryPath);
+        for (size_t i = 0; i < vendors.size(); ++i) {
+            if (vendors[i].empty()) continue;
+            std::string name = vendors[i];
+            name[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(name[0])));
+            char prefix[8];
+            std::snprintf(prefix, sizeof(prefix), "%06X", static_cast<unsigned>(0x100000 + i));
+            registry << "MA-L," << prefix << "," << name << " Ltd,Somewhere\n";
+        }
+    }
+    ASSERT_TRUE(classifier.loadVendorDatabase(registryPath));
+    std::remove(registryPath.c_str());
+    
+    uint32_t id = 0;
+    auto check = [&](const std::shared_ptr<NetworkDevice>& device) {
+        DeviceType expected = DeviceType::Unknown;
+        if (!linearScan(hostnameRules, device->hostname, expected)) {
+            linearScan(vendorRules, std::string(classifier.identifyVendor(device->mac)), expected);
+        }
+        EXPECT_EQ(classifier.classifyDevice(device), expected)
+            << "hostname '" << device->hostname << "', vendor '" << classifier.identifyVendor(device->mac) << "'";
+    };
+    for (const std::string& hostname : pairsOf(hostnameRules)) {
+        auto device = makeDevice(id++, -50, true);
+        device->hostname = hostname;
+        check(device);
+        std::transform(device->hostname.begin(), device->hostname.end(), device->hostname.begin(), ::toupper);
+        check(device);
+    }
+    for (size_t i = 0; i < vendors.size(); ++i) {
+        auto device = makeDevice(id++, -50, true);
+        device->mac = MacAddress((static_cast<uint64_t>(0x100000 + i) << 24) | 1);
+        check(device);
+    }
+}
+
+TEST(DeviceClassifierTest, FullCacheEvictsLeastRecentlyUsed) {
+    DeviceClassifier classifier(2);
+    auto a = makeDevice(1, -40, true);
+    auto b = makeDevice(2, -40, true);
+    auto c = makeDevice(3, -40, true);
+    b->hostname = "living-room-tv";
+    
+    classifier.classifyDevice(a);
+    DeviceType type = classifier.classifyDevice(b);
+    classifier.classifyDevice(a);
+    classifier.classifyDevice(c); // evicts b
+    EXPECT_EQ(classifier.classifyDevice(b), type); // evicts a
+    classifier.classifyDevice(c);
+    
+    auto stats = classifier.getCacheStats();
+    EXPECT_EQ(stats.hits, 2u);
+    EXPECT_EQ(stats.misses, 4u);
+    EXPECT_EQ(stats.evictions, 2u);
+    EXPECT_EQ(stats.entries, 2u);
+}
+
+TEST(DeviceClassifierTest, RuleFilesNameDeviceTypes) {
+    for (const auto& info : kDeviceTypes) {
+        DeviceType parsed;
+        EXPECT_TRUE(parseDeviceType(info.name, parsed));
+        EXPECT_EQ(parsed, info.type);
+    }
+    EXPECT_FLOAT_EQ(FeatureStore::typeScore(DeviceType::Router), 0.9f);
+    
+    std::string path = ::testing::TempDir() + "sb_rules.txt";
+    {
+        std::ofstream rules(path);
+        rules << "hostname, fridge, smart_plug\n";
+        rules << "hostname, toaster, kitchen_robot # not a type\n";
+    }
+    DeviceClassifier classifier;
+    EXPECT_EQ(classifier.loadPatternRules(path), 1);
+    std::remove(path.c_str());
+    
+    auto fridge = makeDevice(1, -50, true);
+    fridge->hostname = "Kitchen-Fridge";
+    auto toaster = makeDevice(2, -50, true);
+    toaster->hostname = "toaster";
+    EXPECT_EQ(classifier.classifyDevice(fridge), DeviceType::SmartPlug);
+    EXPECT_EQ(classifier.classifyDevice(toaster), DeviceType::Unknown);
+    
+    // Reloading rules invalidates cached results
+    {
+        std::ofstream rules(path);
+        rules << "hostname, fridge, smart_home\n";
+    }
+    EXPECT_EQ(classifier.loadPatternRules(path), 1);
+    std::remove(path.c_str());
+    EXPECT_EQ(classifier.classifyDevice(fridge), DeviceType::SmartHome);
+}
+
+TEST_F(SmartBlueprintCoreTest, SteadyStateCycleDoesNotAllocate) {
+    SyntheticNetwork::Options options;
+    options.deviceCount = 200;
+    options.churnRate = 0.0; // no new MACs, only dropouts and RSSI noise
+    SyntheticNetwork network(options);
+    network.applyTo(*backend);
+    core->runMonitoringCycle(true);
+    // Warm up until the online-learning window is full and every buffer has
+    // reached its working size
+    for (int i = 0; i < 40; ++i) {
+        network.step();
+        network.applyTo(*backend);
+        core->runMonitoringCycle();
+    }
+    
+    uint64_t allocations = 0;
+    for (int i = 0; i < 5; ++i) {
+        network.step();
+        network.applyTo(*backend);
+        uint64_t before = Metrics::threadAllocationCount();
+        core->runMonitoringCycle();
+        allocations += Metrics::threadAllocationCount() - before;
+    }
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_FALSE(core->getCurrentDevices().empty());
+}
+
+TEST(SmartBlueprintCoreConcurrencyTest, CyclesRunAlongsideScansAndEvents) {
+    auto synthetic = std::make_unique<SyntheticEventBackend>();
+    SyntheticEventBackend* events = synthetic.get();
+    SmartBlueprintCore core(std::make_unique<NetworkScanner>(std::move(synthetic)));
+    
+    // Addresses change length every round, so racing copies would see
+    // strings reallocated under them
+    constexpr int kDevices = 64;
+    auto address = [](int device, int round) {
+        std::string octet = std::to_string(round % 2 ? 100 + round % 100 : round % 10);
+        return "10." + octet + "." + std::to_string(device) + "." + octet;
+    };
+    std::set<std::string> issued;
+    auto records = [&](int round) {
+        std::vector<ScanRecord> batch;
+        for (int i = 0; i < kDevices; ++i) {
+            batch.push_back(makeRecord(0x020000000000ull + i, address(i, round), -40 - (round + i) % 40));
+            issued.insert(address(i, round));
+        }
+        return batch;
+    };
+    
+    events->setRecords(records(0));
+    core.startMonitoring();
+    
+    // Full scans run here and on the scan thread, event polls and cycles on
+    // the scheduler, while we keep reading snapshots
+    int round = 1;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(600);
+    while (std::chrono::steady_clock::now() < deadline) {
+        events->pushEvents(records(round++));
+        events->setRecords(records(round++));
+        core.performScan();
+        
+        auto snapshot = core.getSnapshot();
+        for (const auto& device : snapshot->devices) {
+            ASSERT_TRUE(issued.count(device->ipAddress)) << device->ipAddress;
+            ASSERT_EQ(device->mac.toString(), device->macAddress);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    core.stopMonitoring();
+    
+    // Once things settle the snapshot matches the last scan
+    int last = round - 1;
+    core.runMonitoringCycle(true);
+    auto snapshot = core.getSnapshot();
+    ASSERT_EQ(snapshot->devices.size(), static_cast<size_t>(kDevices));
+    for (int i = 0; i < kDevices; ++i) {
+        EXPECT_EQ(snapshot->devices[i]->mac, MacAddress(0x020000000000ull + i));
+        EXPECT_EQ(snapshot->devices[i]->ipAddress, address(i, last));
+        EXPECT_TRUE(snapshot->devices[i]->isOnline);
+        EXPECT_GT(snapshot->devices[i]->summary.rssi.count(), 0u);
+    }
+}
+
+TEST_F(SmartBlueprintCoreTest, RemovedDevicesLeaveNoStateBehind) {
+    // Just short of the ten-minute limit, so it goes offline at once and
+    // ages out a moment later
+    NetworkDevice leaving;
+    leaving.mac = MacAddress(0xaabbccddee01ull);
+    leaving.macAddress = leaving.mac.toString();
+    leaving.rssi = -90;
+    leaving.lastSeen = std::chrono::system_clock::now() - std::chrono::minutes(11) + std::chrono::milliseconds(300);
+    auto synthetic = std::make_unique<SyntheticBackend>();
+    SyntheticBackend* source = synthetic.get();
+    auto scanner = std::make_unique<NetworkScanner>(std::move(synthetic));
+    scanner->restoreDevices({leaving});
+    uint32_t leavingId = scanner->getDeviceIds().find(leaving.mac);
+    SmartBlueprintCore monitor(std::move(scanner));
+    
+    source->setRecords({makeRecord(0xaabbccddee02ull, "192.168.1.102", -50)});
+    monitor.runMonitoringCycle(true); // its filter starts from -90
+    ASSERT_EQ(monitor.getSnapshot()->devices.size(), 2u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    monitor.runMonitoringCycle();
+    ASSERT_EQ(monitor.getSnapshot()->devices.size(), 1u);
+    
+    // A new device takes over the ID and the old one returns under a new
+    // ID; neither inherits the old filter or summary
+    source->setRecords({makeRecord(0xaabbccddee03ull, "192.168.1.103", -60),
+                        makeRecord(0xaabbccddee01ull, "192.168.1.101", -45),
+                        makeRecord(0xaabbccddee02ull, "192.168.1.102", -50)});
+    monitor.runMonitoringCycle();
+    auto snapshot = monitor.getSnapshot();
+    ASSERT_EQ(snapshot->devices.size(), 3u);
+    for (const auto& device : snapshot->devices) {
+        if (device->mac == MacAddress(0xaabbccddee03ull)) {
+            EXPECT_EQ(device->deviceId, leavingId);
+            EXPECT_EQ(device->rssi, -60);
+            EXPECT_EQ(device->summary.rssi.count(), 1u);
+        } else if (device->mac == leaving.mac) {
+            EXPECT_NE(device->deviceId, leavingId);
+            EXPECT_EQ(device->rssi, -45);
+            EXPECT_EQ(device->summary.rssi.count(), 1u);
+        }
+    }
+}
+
+TEST_F(SmartBlueprintCoreTest, SummariesCountReadingsNotPasses) {
+    backend->setRecords({makeRecord(0xaabbccddee01ull, "192.168.1.101", -40),
+                         makeRecord(0xaabbccddee02ull, "192.168.1.102", -60)});
+    for (int i = 0; i < 4; ++i) {
+        core->runMonitoringCycle(true);
+    }
+    
+    // Only the second device's reading changes; full passes repeat the other
+    backend->setRecords({makeRecord(0xaabbccddee01ull, "192.168.1.101", -40),
+                         makeRecord(0xaabbccddee02ull, "192.168.1.102", -65)});
+    core->runMonitoringCycle(true);
+    core->runMonitoringCycle(true);
+    
+    auto snapshot = core->getSnapshot();
+    ASSERT_EQ(snapshot->devices.size(), 2u);
+    EXPECT_EQ(snapshot->devices[0]->summary.rssi.count(), 1u);
+    EXPECT_EQ(snapshot->devices[1]->summary.rssi.count(), 2u);
+}
+
+TEST_F(SmartBlueprintCoreTest, WarmStartShowsLastKnownDevices) {
+    std::string path = ::testing::TempDir() + "sb_device_state_test.state";
+    std::remove(path.c_str());
+    
+    backend->setRecords({
+        makeRecord(0x00000c000001ull, "192.168.1.1", -40),
+        makeRecord(0x000393000002ull, "192.168.1.20", -55),
+        makeRecord(0xaabbccddee03ull, "192.168.1.30", -70),
+    });
+    for (int i = 0; i < 3; ++i) {
+        core->runMonitoringCycle(true);
+    }
+    ASSERT_TRUE(core->saveDeviceState(path));
+    auto saved = core->getSnapshot();
+    
+    // A fresh core shows the saved devices before it has scanned at all
+    auto synthetic = std::make_unique<SyntheticBackend>();
+    SyntheticBackend* restartedBackend = synthetic.get();
+    SmartBlueprintCore restarted(std::make_unique<NetworkScanner>(std::move(synthetic)));
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(restarted.loadDeviceState(path));
+    auto restored = restarted.getSnapshot();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(100));
+    
+    EXPECT_TRUE(restored->stale);
+    ASSERT_EQ(restored->devices.size(), saved->devices.size());
+    for (size_t i = 0; i < restored->devices.size(); ++i) {
+        const NetworkDevice& before = *saved->devices[i];
+        const NetworkDevice& after = *restored->devices[i];
+        EXPECT_EQ(after.mac, before.mac);
+        EXPECT_EQ(after.ipAddress, before.ipAddress);
+        EXPECT_EQ(after.deviceType, before.deviceType);
+        EXPECT_EQ(after.rssi, before.rssi);
+        EXPECT_EQ(after.summary.rssi.count(), before.summary.rssi.count());
+        EXPECT_FALSE(after.isOnline);
+    }
+    
+    // The first scan confirms the devices still present and clears the flag
+    restartedBackend->setRecords({
+        makeRecord(0x00000c000001ull, "192.168.1.1", -40),
+        makeRecord(0x000393000002ull, "192.168.1.20", -55),
+    });
+    restarted.runMonitoringCycle();
+    auto scanned = restarted.getSnapshot();
+    EXPECT_FALSE(scanned->stale);
+    ASSERT_EQ(scanned->devices.size(), 3u);
+    EXPECT_TRUE(scanned->devices[0]->isOnline);
+    EXPECT_EQ(scanned->devices[0]->summary.rssi.count(), saved->devices[0]->summary.rssi.count() + 1);
+    EXPECT_FALSE(scanned->devices[2]->isOnline);
+    
+    // Damaged files are ignored
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-1, std::ios::end);
+        file.put('\x7f');
+    }
+    SmartBlueprintCore other(std::make_unique<NetworkScanner>(std::make_unique<SyntheticBackend>()));
+    EXPECT_FALSE(other.loadDeviceState(path));
+    EXPECT_TRUE(other.getSnapshot()->devices.empty());
+    std::remove(path.c_str());
+}
+
+TEST(ShardedMonitorTest, ShardsSplitSubnetsAndMergeSnapshots) {
+    std::vector<ScanRecord> records = {
+        makeRecord(0x00000c000001ull, "10.0.0.1", -40),
+        makeRecord(0x000393000002ull, "10.0.0.2", -55),
+        makeRecord(0x000393000003ull, "10.1.0.7", -60),
+        makeRecord(0x000393000004ull, "fe80::1", -60),
+    };
+    ShardedMonitor monitor;
+    std::vector<SyntheticBackend*> backends;
+    const char* names[] = {"management", "guest"};
+    uint32_t networks[] = {0x0a000000u, 0x0a010000u}; // 10.0.0.0/16, 10.1.0.0/16
+    for (int i = 0; i < 2; ++i) {
+        auto synthetic = std::make_unique<SyntheticBackend>();
+        synthetic->setRecords(records);
+        backends.push_back(synthetic.get());
+        auto filtered = std::make_unique<SubnetFilterBackend>(std::move(synthetic), networks[i], 16);
+        EXPECT_EQ(monitor.addShard(names[i], std::make_unique<NetworkScanner>(std::move(filtered))), static_cast<size_t>(i));
+    }
+    monitor.runMonitoringCycle(true);
+    
+    auto snapshot = monitor.getSnapshot();
+    ASSERT_EQ(snapshot->devices.size(), 3u);
+    EXPECT_EQ(monitor.shard(0).getCurrentDevices().size(), 2u);
+    EXPECT_EQ(monitor.shard(1).getCurrentDevices().size(), 1u);
+    EXPECT_EQ(snapshot->deviceShards, (std::vector<uint32_t>{0, 0, 1}));
+    EXPECT_EQ(snapshot->devices[2]->ipAddress, "10.1.0.7");
+    EXPECT_EQ(monitor.shardName(1), "guest");
+    EXPECT_EQ(snapshot->version, monitor.getSnapshotVersion());
+    
+    // Unchanged shards are not merged again; a change in one shard leaves the other alone
+    EXPECT_EQ(monitor.getSnapshot(), snapshot);
+    uint64_t managementVersion = monitor.shard(0).getSnapshotVersion();
+    records.push_back(makeRecord(0x000393000005ull, "10.1.3.3", -50));
+    backends[1]->setRecords(records);
+    monitor.shard(1).runMonitoringCycle();
+    
+    auto updated = monitor.getSnapshot();
+    EXPECT_NE(updated, snapshot);
+    EXPECT_EQ(updated->devices.size(), 4u);
+    EXPECT_EQ(monitor.shard(0).getSnapshotVersion(), managementVersion);
+    EXPECT_GT(updated->shardVersions[1], snapshot->shardVersions[1]);
+}
+
+TEST(IpcBridgeTest, ReaderSeesSnapshotsAndDeltas) {
+    IpcPublisher::Options options;
+    options.deviceSlots = 8;
+    options.ringSlots = 4;
+    IpcPublisher publisher;
+    ASSERT_TRUE(publisher.open("sb_ipc_test", options));
+    
+    std::vector<std::shared_ptr<NetworkDevice>> devices = {
+        makeDevice(0, -40, true), makeDevice(1, -60, true), makeDevice(2, -70, false), makeDevice(9, -50, true)};
+    devices[1]->hostname = "a-hostname-much-longer-than-the-forty-bytes-of-its-field";
+    std::vector<std::pair<std::shared_ptr<NetworkDevice>, double>> anomalies = {{devices[2], 0.8}};
+    publisher.publish(devices, {}, anomalies, 1);
+    
+    IpcReader reader;
+    ASSERT_TRUE(reader.open("sb_ipc_test"));
+    EXPECT_EQ(reader.layout()->ringSlots, 4u);
+    EXPECT_EQ(reader.layout()->droppedDevices, 1u); // ID 9 doesn't fit the table
+    
+    std::vector<IpcDeviceRecord> records;
+    uint64_t version = 0;
+    uint64_t cursor = 0;
+    ASSERT_TRUE(reader.readSnapshot(records, version, cursor));
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(version, 1u);
+    EXPECT_EQ(cursor, 3u);
+    EXPECT_EQ(MacAddress(records[1].mac), devices[1]->mac);
+    EXPECT_EQ(std::strlen(records[1].hostname), sizeof(records[1].hostname) - 1);
+    EXPECT_EQ(records[0].flags, kIpcPresent | kIpcOnline);
+    EXPECT_EQ(records[2].flags, kIpcPresent | kIpcAnomalous);
+    EXPECT_FLOAT_EQ(records[2].anomalyScore, 0.8f);
+    
+    // Only what changed since the cursor, removals first
+    devices[1]->rssi = -55;
+    publisher.publish({devices[1]}, {2}, {}, 2);
+    std::vector<std::pair<IpcChangeType, IpcDeviceRecord>> changes;
+    ASSERT_TRUE(reader.readDeltas(cursor, changes));
+    ASSERT_EQ(changes.size(), 2u);
+    EXPECT_EQ(changes[0].first, kIpcRemoved);
+    EXPECT_EQ(changes[0].second.deviceId, 2u);
+    EXPECT_EQ(changes[1].first, kIpcUpdated);
+    EXPECT_EQ(changes[1].second.rssi, -55);
+    EXPECT_EQ(reader.layout()->deviceCount, 2u);
+    EXPECT_EQ(reader.layout()->anomalyCount, 0u);
+    
+    // A reader that falls behind the ring is told to start over
+    for (int i = 0; i < 5; ++i) {
+        publisher.publish({devices[0]}, {}, {}, 3 + i);
+    }
+    changes.clear();
+    EXPECT_FALSE(reader.readDeltas(cursor, changes));
+    EXPECT_EQ(cursor, reader.layout()->deltaCount.load());
+    EXPECT_TRUE(reader.readDeltas(cursor, changes));
+    EXPECT_TRUE(changes.empty());
+    
+    // The region stays ours while we are running
+    IpcPublisher second;
+    EXPECT_FALSE(second.open("sb_ipc_test", options));
+    
+    publisher.close();
+    IpcReader closed;
+    EXPECT_FALSE(closed.open("sb_ipc_test"));
+    
+#ifndef _WIN32
+    // A region left behind by a writer that has exited is taken over
+    pid_t exited = fork();
+    if (exited == 0) _exit(0);
+    ASSERT_GT(exited, 0);
+    waitpid(exited, nullptr, 0);
+    int fd = shm_open("/sb_ipc_test", O_CREAT | O_EXCL | O_RDWR, 0644);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(ftruncate(fd, sizeof(IpcHeader)), 0);
+    void* view = mmap(nullptr, sizeof(IpcHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    ASSERT_NE(view, MAP_FAILED);
+    auto* stale = static_cast<IpcHeader*>(view);
+    std::memcpy(stale->magic, "SBIPC\0\0\0", sizeof(stale->magic));
+    stale->writerPid = static_cast<uint32_t>(exited);
+    munmap(view, sizeof(IpcHeader));
+    
+    IpcPublisher successor;
+    EXPECT_TRUE(successor.open("sb_ipc_test", options));
+    successor.close();
+#endif
+}
+
+#ifndef _WIN32
+TEST_F(SmartBlueprintCoreTest, IpcBridgeServesControlRequests) {
+    std::string socketPath = ::testing::TempDir() + "sb_ipc_core.sock";
+    ASSERT_TRUE(core->enableIpc("sb_ipc_core", socketPath));
+    backend->setRecords({
+        makeRecord(0x00000c000001ull, "192.168.1.1", -40),
+        makeRecord(0x000393000002ull, "192.168.1.2", -55),
+    });
+    core->runMonitoringCycle(true);
+    
+    IpcReader reader;
+    ASSERT_TRUE(reader.open("sb_ipc_core"));
+    std::vector<IpcDeviceRecord> records;
+    uint64_t version = 0;
+    uint64_t cursor = 0;
+    ASSERT_TRUE(reader.readSnapshot(records, version, cursor));
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(version, core->getSnapshotVersion());
+    EXPECT_STREQ(records[0].vendor, "Cisco");
+    EXPECT_STREQ(records[0].ipAddress, "192.168.1.1");
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    ASSERT_EQ(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    
+    std::string request = "PING\nINFO\nBOGUS\n";
+    ASSERT_EQ(send(fd, request.data(), request.size(), 0), static_cast<ssize_t>(request.size()));
+    std::string response;
+    char buffer[256];
+    while (std::count(response.begin(), response.end(), '\n') < 3) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        ASSERT_GT(n, 0);
+        response.append(buffer, static_cast<size_t>(n));
+    }
+    close(fd);
+    
+    EXPECT_EQ(response.substr(0, 5), "PONG\n");
+    EXPECT_NE(response.find("OK shm=sb_ipc_core layout=1"), std::string::npos);
+    EXPECT_NE(response.find("devices=2"), std::string::npos);
+    EXPECT_NE(response.find("ERR"), std::string::npos);
+}
+#endif
+
+namespace {
+
+MacAddress macFrom(const char* text) {
+    MacAddress mac;
+    EXPECT_TRUE(MacAddress::parse(text, mac)) << text;
+    return mac;
+}
+
+} // namespace
+
+TEST(OuiDatabaseTest, ParsesRegistriesAndRoundTripsIndex) {
+    std::string textPath = ::testing::TempDir() + "sb_oui.txt";
+    std::string csvPath = ::testing::TempDir() + "sb_oui.csv";
+    {
+        std::ofstream text(textPath);
+        text << "OUI/MA-L\t\t\tOrganization\n"
+             << "00-00-0C   (hex)\t\tCisco Systems, Inc\r\n"
+             << "00000C     (base 16)\t\tCisco Systems, Inc\n"
+             << "ZZ-00-0C   (hex)\t\tNot Hex\n"
+             << "3C-22-FB   (hex)\t\tApple, Inc.\n";
+        std::ofstream csv(csvPath);
+        csv << "Registry,Assignment,Organization Name,Organization Address\n"
+            << "MA-L,F4F5D8,Google, Inc.,1600 Amphitheatre\n"
+            << "MA-M,3C22FB1,\"Block \"\"M\"\", Ltd\",Somewhere\n"
+            << "MA-S,3C22FB1AB,Tiny Maker,Elsewhere\n"
+            << "CID,0A1B2C,Company ID,Nowhere\n"
+            << "MA-L,12345,Too Short,Nowhere\n";
+    }
+    
+    OuiDatabase database;
+    EXPECT_EQ(database.loadIeeeRegistry(textPath), 2);
+    EXPECT_EQ(database.loadIeeeRegistry(csvPath), 3);
+    EXPECT_EQ(database.loadIeeeRegistry(textPath + ".missing"), -1);
+    EXPECT_EQ(database.size(), 5u);
+    
+    // Longest prefix wins: MA-S inside MA-M inside MA-L
+    EXPECT_EQ(database.lookup(macFrom("00:00:0c:12:34:56")), "Cisco Systems, Inc");
+    EXPECT_EQ(database.lookup(macFrom("f4:f5:d8:00:00:01")), "Google");
+    EXPECT_EQ(database.lookup(macFrom("3c:22:fb:00:00:01")), "Apple, Inc.");
+    EXPECT_EQ(database.lookup(macFrom("3c:22:fb:1f:00:01")), "Block \"M\", Ltd");
+    EXPECT_EQ(database.lookup(macFrom("3c:22:fb:1a:b0:01")), "Tiny Maker");
+    EXPECT_EQ(database.lookup(macFrom("aa:bb:cc:dd:ee:ff")), "");
+    
+    std::string indexPath = ::testing::TempDir() + "sb_oui.idx";
+    ASSERT_TRUE(database.saveIndex(indexPath));
+    OuiDatabase mapped;
+    ASSERT_TRUE(mapped.loadIndex(indexPath));
+    EXPECT_TRUE(mapped.isMapped());
+    EXPECT_EQ(mapped.size(), database.size());
+    for (const char* text : {"00:00:0c:12:34:56", "3c:22:fb:1f:00:01", "3c:22:fb:1a:b0:01", "aa:bb:cc:dd:ee:ff"}) {
+        EXPECT_EQ(mapped.lookup(macFrom(text)), database.lookup(macFrom(text))) << text;
+    }
+    
+    // Adding to a mapped table copies it into memory first
+    mapped.addEntry(OuiDatabase::MA_L, 0xaabbcc, "Added Later");
+    mapped.finalize();
+    EXPECT_FALSE(mapped.isMapped());
+    EXPECT_EQ(mapped.lookup(macFrom("aa:bb:cc:dd:ee:ff")), "Added Later");
+    EXPECT_EQ(mapped.lookup(macFrom("00:00:0c:12:34:56")), "Cisco Systems, Inc");
+    
+    std::remove(textPath.c_str());
+    std::remove(csvPath.c_str());
+    std::remove(indexPath.c_str());
+}
+
+TEST(OuiDatabaseTest, RejectsCorruptIndex) {
+    OuiDatabase database;
+    database.addEntry(OuiDatabase::MA_L, 0x00000c, "Cisco Systems, Inc");
+    database.addEntry(OuiDatabase::MA_L, 0x3c22fb, "Apple, Inc.");
+    database.finalize();
+    std::string path = ::testing::TempDir() + "sb_oui_corrupt.idx";
+    ASSERT_TRUE(database.saveIndex(path));
+    
+    std::string original;
+    {
+        std::ifstream file(path, std::ios::binary);
+        original.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    // Header: magic, version, byte order, three counts, pool size, checksum, reserved
+    const size_t headerSize = 40, checksumOffset = 32;
+    const size_t entrySize = sizeof(OuiDatabase::Entry);
+    ASSERT_EQ(original.size(), headerSize + 2 * entrySize + std::strlen("Cisco Systems, IncApple, Inc."));
+    
+    OuiDatabase current;
+    current.addEntry(OuiDatabase::MA_L, 0xf4f5d8, "Google");
+    current.finalize();
+    
+    // Each edit keeps the checksum valid, so only the structural checks catch it
+    auto rejects = [&](const std::function<void(std::string&)>& corrupt) {
+        std::string bytes = original;
+        corrupt(bytes);
+        uint32_t checksum = crc32(bytes.data() + headerSize, bytes.size() - headerSize);
+        std::memcpy(&bytes[checksumOffset], &checksum, sizeof(checksum));
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        }
+        bool loaded = current.loadIndex(path);
+        // A rejected file leaves the previous table in place
+        EXPECT_EQ(current.lookup(macFrom("f4:f5:d8:00:00:01")), "Google");
+        return !loaded;
+    };
+    
+    auto editEntry = [&](std::string& bytes, size_t index, const std::function<void(OuiDatabase::Entry&)>& edit) {
+        OuiDatabase::Entry entry;
+        size_t offset = headerSize + index * entrySize;
+        std::memcpy(&entry, &bytes[offset], entrySize);
+        edit(entry);
+        std::memcpy(&bytes[offset], &entry, entrySize);
+    };
+    EXPECT_TRUE(rejects([&](std::string& bytes) {
+        editEntry(bytes, 1, [](OuiDatabase::Entry& entry) { entry.nameOffset = 1000; }); // name past the pool
+    }));
+    EXPECT_TRUE(rejects([&](std::string& bytes) {
+        editEntry(bytes, 1, [](OuiDatabase::Entry& entry) { entry.nameLength = 0xffffffffu; }); // wraps in 32 bits
+    }));
+    EXPECT_TRUE(rejects([&](std::string& bytes) {
+        editEntry(bytes, 0, [](OuiDatabase::Entry& entry) { entry.prefix = 0x3c22fb; }); // duplicate prefix
+    }));
+    EXPECT_TRUE(rejects([&](std::string& bytes) {
+        editEntry(bytes, 1, [](OuiDatabase::Entry& entry) { entry.prefix = 0x1000000; }); // wider than 24 bits
+    }));
+    
+    // A flipped byte without a matching checksum
+    {
+        std::string bytes = original;
+        bytes.back() ^= 0x20;
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+    EXPECT_FALSE(current.loadIndex(path));
+    
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(original.data(), static_cast<std::streamsize>(original.size()));
+    }
+    ASSERT_TRUE(current.loadIndex(path));
+    EXPECT_EQ(current.lookup(macFrom("3c:22:fb:00:00:01")), "Apple, Inc.");
+    std::remove(path.c_str());
+}
+
+TEST(SignalHistoryStoreTest, SamplesSurviveReopenAndCompress) {
+    std::string path = ::testing::TempDir() + "sb_signal_history_test.bin";
+    std::remove(path.c_str());
+    
+    MacAddress steady(0x00000c000001ull);
+    MacAddress noisy(0x000393000002ull);
+    SignalHistoryStore::Options options;
+    options.deviceSlots = 4;
+    options.blocksPerDevice = 4;
+    {
+        SignalHistoryStore store;
+        ASSERT_TRUE(store.open(path, options));
+        for (int i = 0; i < 2000; ++i) {
+            int64_t time = 1700000000 + i * 5;
+            store.append(steady, time, -50, SignalHistoryStore::kSampleOnline);
+            store.append(noisy, time, -60 + (i % 7) - (i % 3) * 20, SignalHistoryStore::kSampleOnline);
+        }
+        // Runs of identical samples take a few bytes for thousands of samples
+        EXPECT_EQ(store.sampleCount(steady), 2000u);
+        EXPECT_LT(store.bytesUsed(), 2 * options.blocksPerDevice * 256u);
+    }
+    
+    SignalHistoryStore store;
+    ASSERT_TRUE(store.open(path));
+    EXPECT_EQ(store.deviceCount(), 2u);
+    
+    std::vector<float> rssi(16);
+    std::vector<int64_t> times(16);
+    ASSERT_EQ(store.readSamples(steady, rssi.data(), times.data(), rssi.size()), 16u);
+    EXPECT_EQ(rssi.back(), -50.0f);
+    EXPECT_EQ(times.back(), 1700000000 + 1999 * 5);
+    EXPECT_EQ(times.back() - times.front(), 15 * 5);
+    
+    // The noisy device wrapped around its ring: only the newest samples remain, decoded exactly
+    size_t kept = store.sampleCount(noisy);
+    EXPECT_GT(kept, 0u);
+    EXPECT_LT(kept, 2000u);
+    int i = 2000 - static_cast<int>(kept);
+    store.forEachSample(noisy, INT64_MIN, [&](const SignalHistoryStore::Sample& sample) {
+        EXPECT_EQ(sample.timestamp, 1700000000 + i * 5);
+        EXPECT_EQ(sample.rssi, -60 + (i % 7) - (i % 3) * 20);
+        i++;
+    });
+    EXPECT_EQ(i, 2000);
+    
+    store.close();
+    std::remove(path.c_str());
+}
+
+TEST(SignalHistoryStoreTest, DamagedSlotsAreDiscardedOnReopen) {
+    std::string path = ::testing::TempDir() + "sb_signal_history_damaged.bin";
+    std::remove(path.c_str());
+    
+    MacAddress badHead(0x00000c000001ull);
+    MacAddress badBlock(0x00000c000002ull);
+    MacAddress intact(0x00000c000003ull);
+    SignalHistoryStore::Options options;
+    options.deviceSlots = 4;
+    options.blocksPerDevice = 4;
+    {
+        SignalHistoryStore store;
+        ASSERT_TRUE(store.open(path, options));
+        for (int i = 0; i < 50; ++i) {
+            for (MacAddress mac : {badHead, badBlock, intact}) {
+                store.append(mac, 1700000000 + i, -50 - i % 9, SignalHistoryStore::kSampleOnline);
+            }
+        }
+    }
+    
+    // 32-byte file header, then 32-byte slot headers, then 256-byte blocks;
+    // devices took the slots in the order they first appeared
+    auto patch = [&](size_t offset, uint32_t value, size_t width) {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.write(reinterpret_cast<const char*>(&value), static_cast<std::streamsize>(width));
+    };
+    const size_t blocksStart = 32 + 4 * 32;
+    patch(32 + 0 * 32 + 24, 99, 4);                      // badHead: headBlock past the ring
+    patch(blocksStart + (1 * 4 + 0) * 256 + 26, 1000, 2); // badBlock: usedBytes past the payload
+    
+    SignalHistoryStore store;
+    ASSERT_TRUE(store.open(path));
+    EXPECT_EQ(store.deviceCount(), 1u);
+    EXPECT_EQ(store.sampleCount(badHead), 0u);
+    EXPECT_EQ(store.sampleCount(badBlock), 0u);
+    EXPECT_EQ(store.sampleCount(intact), 50u);
+    
+    // The discarded slots are free for new history
+    EXPECT_TRUE(store.append(badHead, 1700000100, -40, SignalHistoryStore::kSampleOnline));
+    EXPECT_EQ(store.sampleCount(badHead), 1u);
+    EXPECT_EQ(store.deviceCount(), 2u);
+    
+    store.close();
+    std::remove(path.c_str());
+}
+
+TEST(KalmanFilterBankTest, BankUpdatesMatchScalarFilters) {
+    constexpr uint32_t kFilters = 37;
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    KalmanFilterBank whole, single, indexed;
+    std::vector<KalmanFilter> reference(kFilters);
+    for (uint32_t i = 0; i < kFilters; ++i) {
+        whole.addFilter();
+        single.addFilter();
+        indexed.addFilter();
+    }
+    
+    std::vector<float> measurements(kFilters);
+    std::vector<uint32_t> ids;
+    std::vector<float> readings, filtered;
+    uint32_t state = 12345;
+    for (int step = 0; step < 200; ++step) {
+        // Every filter misses some ticks; the first reading each gets seeds it
+        ids.clear();
+        readings.clear();
+        for (uint32_t i = 0; i < kFilters; ++i) {
+            state = state * 1664525u + 1013904223u;
+            bool present = (state >> 28) % 3 != 0 && step >= static_cast<int>(i % 5);
+            measurements[i] = present ? -90.0f + static_cast<float>((state >> 8) % 600) / 10.0f : nan;
+            if (present) {
+                ids.push_back(i);
+                readings.push_back(measurements[i]);
+            }
+        }
+        
+        whole.updateAll(measurements.data(), measurements.size());
+        filtered.assign(ids.size(), 0.0f);
+        indexed.updateIndexed(ids.data(), readings.data(), ids.size(), filtered.data());
+        for (size_t k = 0; k < ids.size(); ++k) {
+            uint32_t i = ids[k];
+            float estimate = single.update(i, readings[k]);
+            double expected = reference[i].update(readings[k]);
+            ASSERT_FLOAT_EQ(filtered[k], estimate);
+            ASSERT_NEAR(whole.estimate(i), estimate, 1e-4f);
+            ASSERT_NEAR(estimate, expected, 1e-3);
+        }
+    }
+    for (uint32_t i = 0; i < kFilters; ++i) {
+        EXPECT_FLOAT_EQ(indexed.estimate(i), single.estimate(i));
+    }
+    
+    // A NaN leaves the filter alone; after reset() the next reading seeds it again
+    float before = indexed.estimate(3);
+    uint32_t id = 3;
+    indexed.updateIndexed(&id, &nan, 1, filtered.data());
+    EXPECT_FLOAT_EQ(indexed.estimate(3), before);
+    EXPECT_FLOAT_EQ(filtered[0], before);
+    indexed.reset(3);
+    float fresh = -42.0f;
+    indexed.updateIndexed(&id, &fresh, 1, nullptr);
+    EXPECT_FLOAT_EQ(indexed.estimate(3), -42.0f);
+}
+
+TEST(SignalKernelsTest, DispatchedKernelsMatchScalarReference) {
+    // Odd lengths and every tail size of the 4-, 8- and 16-lane loops, read
+    // from an unaligned start
+    std::vector<size_t> lengths;
+    for (size_t n = 0; n <= 40; ++n) lengths.push_back(n);
+    for (size_t n : {63, 64, 65, 127, 128, 129, 1000, 1001, 4099}) lengths.push_back(n);
+    
+    uint32_t state = 12345;
+    std::vector<float> buffer(4100 + 1);
+    for (float& value : buffer) {
+        state = state * 1664525u + 1013904223u;
+        value = -95.0f + static_cast<float>(state >> 8) / static_cast<float>(1u << 24) * 75.0f;
+    }
+    const float* data = buffer.data() + 1;
+    const float quantiles[] = {0.0f, 0.1f, 0.5f, 0.9f, 1.0f};
+    std::vector<float> scratch, smoothed(4100);
+    
+    for (size_t n : lengths) {
+        SCOPED_TRACE("n = " + std::to_string(n) + " on " + SignalKernels::activeInstructionSet());
+        double total = 0.0;
+        float low = std::numeric_limits<float>::max(), high = std::numeric_limits<float>::lowest();
+        for (size_t i = 0; i < n; ++i) {
+            total += data[i];
+            low = std::min(low, data[i]);
+            high = std::max(high, data[i]);
+        }
+        double mean = n ? total / static_cast<double>(n) : 0.0;
+        double squares = 0.0;
+        for (size_t i = 0; i < n; ++i) squares += (data[i] - mean) * (data[i] - mean);
+        double variance = n ? squares / static_cast<double>(n) : 0.0;
+        
+        EXPECT_NEAR(SignalKernels::sum(data, n), total, 1e-5 * std::fabs(total) + 1e-6);
+        double kernelMean, kernelVariance;
+        SignalKernels::meanVariance(data, n, kernelMean, kernelVariance);
+        EXPECT_NEAR(kernelMean, mean, 1e-5 * std::fabs(mean) + 1e-6);
+        EXPECT_NEAR(kernelVariance, variance, 1e-4 * variance + 1e-6);
+        
+        float kernelLow, kernelHigh;
+        SignalKernels::minMax(data, n, kernelLow, kernelHigh);
+        if (n > 0) {
+            EXPECT_EQ(kernelLow, low);
+            EXPECT_EQ(kernelHigh, high);
+        }
+        
+        std::vector<float> sorted(data, data + n);
+        std::sort(sorted.begin(), sorted.end());
+        float kernelQuantiles[5];
+        SignalKernels::percentiles(data, n, quantiles, 5, kernelQuantiles, scratch);
+        for (size_t q = 0; q < 5 && n > 0; ++q) {
+            double position = quantiles[q] * (n - 1);
+            size_t lower = static_cast<size_t>(position);
+            size_t upper = std::min(lower + 1, n - 1);
+            double expected = sorted[lower] + (position - lower) * (sorted[upper] - sorted[lower]);
+            EXPECT_NEAR(kernelQuantiles[q], expected, 1e-4) << "quantile " << quantiles[q];
+        }
+        
+        SignalKernels::ewma(data, n, 0.3f, smoothed.data());
+        double previous = n ? data[0] : 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            double expected = i == 0 ? data[0] : 0.3 * data[i] + 0.7 * previous;
+            EXPECT_NEAR(smoothed[i], expected, 1e-3) << "sample " << i;
+            previous = expected;
+        }
+    }
+}
+
+TEST(SignalKernelsTest, DistanceBatchStaysWithinErrorBound) {
+    // Every access point hears every device; rows are per access point
+    const std::vector<float> txPower = {-25.0f, -40.0f, -59.0f, -75.0f, -90.0f};
+    const std::vector<float> exponents = {1.0f, 1.6f, 2.0f, 2.7f, 3.5f, 5.0f, 8.0f};
+    std::vector<float> apTxPower, apExponent;
+    for (float tx : txPower) {
+        for (float n : exponents) {
+            apTxPower.push_back(tx);
+            apExponent.push_back(n);
+        }
+    }
+    std::vector<float> readings;
+    for (float rssi = -100.0f; rssi < 0.0f; rssi += 0.25f) readings.push_back(rssi);
+    readings.push_back(0.0f);
+    
+    size_t deviceCount = readings.size();
+    size_t apCount = apTxPower.size();
+    std::vector<float> rssi;
+    for (size_t ap = 0; ap < apCount; ++ap) rssi.insert(rssi.end(), readings.begin(), readings.end());
+    std::vector<float> distances(rssi.size());
+    
+    SignalProcessor processor;
+    processor.estimateDistances(rssi.data(), deviceCount, apTxPower.data(), apExponent.data(), apCount,
+                                distances.data());
+    
+    double worst = 0.0;
+    for (size_t ap = 0; ap < apCount; ++ap) {
+        for (size_t d = 0; d < deviceCount; ++d) {
+            double expected = processor.estimateDistance(readings[d], apTxPower[ap], apExponent[ap]);
+            double actual = distances[ap * deviceCount + d];
+            if (readings[d] == 0.0f) {
+                EXPECT_EQ(actual, -1.0);
+                continue;
+            }
+            worst = std::max(worst, std::fabs(actual - expected) / expected);
+        }
+    }
+    EXPECT_LE(worst, SignalKernels::kDistanceRelativeError) << SignalKernels::activeInstructionSet();
+    
+    // Quality buckets agree with the scalar thresholds and labels
+    std::vector<SignalQualityLevel> levels(readings.size());
+    processor.classifySignalQuality(readings.data(), readings.size(), levels.data());
+    for (size_t i = 0; i < readings.size(); ++i) {
+        EXPECT_EQ(levels[i], signalQualityLevel(readings[i])) << readings[i];
+    }
+    EXPECT_EQ(processor.analyzeSignalQuality(-50).level, SignalQualityLevel::Excellent);
+    EXPECT_EQ(processor.analyzeSignalQuality(-55).strength, "Good");
+    EXPECT_EQ(processor.analyzeSignalQuality(-80).bars, 1);
+    EXPECT_EQ(processor.analyzeSignalQuality(-80.5).level, SignalQualityLevel::VeryPoor);
+}
+
+TEST(LocalizerTest, TrilateratesDevicesFromSeveralObservers) {
+    // Access points just outside the corners of a 20 x 15 m floor
+    std::vector<Observer> observers(4);
+    const float corners[4][2] = {{-3, -3}, {23, -3}, {23, 18}, {-3, 18}};
+    for (size_t a = 0; a < 4; ++a) {
+        observers[a].x = corners[a][0];
+        observers[a].y = corners[a][1];
+        observers[a].pathLossExponent = a % 2 ? 2.5f : 2.0f;
+    }
+    
+    // Readings that SignalProcessor::estimateDistance() maps back to the true range
+    auto rssiAt = [](const Observer& observer, float x, float y) {
+        double range = std::hypot(x - observer.x, y - observer.y);
+        double n = observer.pathLossExponent;
+        return static_cast<float>(observer.txPower * std::pow((range - 0.62) / (1.5 * n - 0.96), 1.0 / n));
+    };
+    
+    const uint32_t deviceCount = 300; // several blocks, so the solve runs on the scheduler
+    std::vector<float> trueX(deviceCount), trueY(deviceCount);
+    std::vector<uint32_t> deviceIds, observerIds;
+    std::vector<float> rssi;
+    for (uint32_t d = 0; d < deviceCount; ++d) {
+        trueX[d] = static_cast<float>(d % 20) + 0.5f;
+        trueY[d] = static_cast<float>(d % 15) + 0.25f;
+        // The last device is heard by two observers only
+        for (uint32_t a = 0; a < (d + 1 == deviceCount ? 2u : 4u); ++a) {
+            deviceIds.push_back(d);
+            observerIds.push_back(a);
+            rssi.push_back(rssiAt(observers[a], trueX[d], trueY[d]));
+        }
+    }
+    
+    Localizer localizer;
+    localizer.setObservers(observers);
+    for (int cycle = 0; cycle < 3; ++cycle) {
+        localizer.observe(deviceIds.data(), observerIds.data(), rssi.data(), rssi.size());
+        EXPECT_EQ(localizer.solve(), deviceCount - 1);
+    }
+    
+    float worst = 0.0f;
+    for (uint32_t d = 0; d + 1 < deviceCount; ++d) {
+        DevicePosition position;
+        ASSERT_TRUE(localizer.position(d, position));
+        worst = std::max(worst, std::hypot(position.x - trueX[d], position.y - trueY[d]));
+        EXPECT_EQ(position.observers, 4);
+        EXPECT_LT(position.residual, 0.05f);
+    }
+    EXPECT_LT(worst, 0.05f);
+    
+    DevicePosition ambiguous;
+    EXPECT_FALSE(localizer.position(deviceCount - 1, ambiguous));
+    
+    // Readings expire after maxObservationAge solves; positions are kept
+    EXPECT_EQ(localizer.solve(), deviceCount - 1);
+    EXPECT_EQ(localizer.solve(), deviceCount - 1);
+    EXPECT_EQ(localizer.solve(), 0u);
+    DevicePosition kept;
+    EXPECT_TRUE(localizer.position(0, kept));
+    
+    // A forgotten device, e.g. one whose ID the scanner reuses, starts over
+    localizer.forgetDevice(0);
+    EXPECT_FALSE(localizer.position(0, kept));
+    EXPECT_TRUE(localizer.position(1, kept));
+}
+
+TEST(StreamingSummaryTest, SketchesStayBoundedAndMerge) {
+    // A long noisy stream split into two windows, as from two time ranges or shards
+    std::vector<float> samples;
+    uint32_t state = 12345;
+    for (int i = 0; i < 20000; ++i) {
+        int noise = 0;
+        for (int k = 0; k < 3; ++k) {
+            state = state * 1664525u + 1013904223u;
+            noise += static_cast<int>((state >> 16) % 21);
+        }
+        samples.push_back(static_cast<float>(-90 + noise));
+    }
+    
+    DeviceSummary all, first, second;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        all.addSignal(samples[i]);
+        (i < samples.size() / 2 ? first : second).addSignal(samples[i]);
+    }
+    first.merge(second);
+    
+    std::vector<double> history(samples.begin(), samples.end());
+    SignalProcessor processor;
+    EXPECT_EQ(first.rssi.count(), 20000u);
+    EXPECT_NEAR(first.rssi.mean(), all.rssi.mean(), 1e-9);
+    EXPECT_NEAR(first.rssi.variance(), all.rssi.variance(), 1e-6);
+    EXPECT_NEAR(processor.calculateSignalStability(first.rssi), processor.calculateSignalStability(history), 1e-9);
+    EXPECT_EQ(first.rssi.min(), *std::min_element(samples.begin(), samples.end()));
+    
+    std::vector<float> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    for (double q : {0.1, 0.5, 0.9}) {
+        float exact = sorted[static_cast<size_t>(q * (sorted.size() - 1))];
+        EXPECT_NEAR(all.rssiQuantiles.quantile(q), exact, 1.0f) << q;
+        EXPECT_NEAR(first.rssiQuantiles.quantile(q), exact, 1.0f) << q;
+    }
+    EXPECT_LE(first.rssiQuantiles.centroidCount(), TDigest::kMaxCentroids);
+    
+    // Short streams are answered exactly
+    TDigest few;
+    for (float value : {-40.0f, -80.0f, -60.0f, -50.0f, -70.0f}) few.add(value);
+    EXPECT_EQ(few.quantile(0.5), -60.0f);
+    EXPECT_EQ(few.quantile(0.0), -80.0f);
+    EXPECT_EQ(few.quantile(1.0), -40.0f);
+    
+    // A device seen at a few addresses counts them exactly however often it is seen
+    HyperLogLog addresses;
+    for (int i = 0; i < 300; ++i) {
+        addresses.add("192.168.1." + std::to_string(10 + i % 3));
+    }
+    EXPECT_EQ(std::lround(addresses.estimate()), 3);
+    
+    HyperLogLog low, high, both;
+    for (int i = 0; i < 1000; ++i) {
+        std::string address = "10.0." + std::to_string(i / 256) + "." + std::to_string(i % 256);
+        (i < 600 ? low : high).add(address);
+        if (i >= 400 && i < 600) high.add(address);
+        both.add(address);
+    }
+    low.merge(high);
+    EXPECT_EQ(low.estimate(), both.estimate());
+    EXPECT_NEAR(both.estimate(), 1000.0, 250.0);
+    
+    // Fixed per-device cost no matter how long the device has been monitored
+    EXPECT_LT(sizeof(DeviceSummary), 512u);
+}
+
+TEST(DeviceExporterTest, WritesDevicesAndHistoryInEveryFormat) {
+    std::vector<std::shared_ptr<NetworkDevice>> devices;
+    for (uint32_t id = 0; id < 3; ++id) {
+        devices.push_back(makeDevice(id, -40 - static_cast<int>(id), id != 1));
+        devices.back()->ipAddress = "10.0.0." + std::to_string(id + 1);
+    }
+    devices[0]->hostname = "lab, \"printer\"";
+    
+    auto readFile = [](const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+    
+    DeviceExporter exporter;
+    std::string path = ::testing::TempDir() + "sb_export";
+    ExportResult csv = exporter.exportDevices(path + ".csv", ExportFormat::Csv, devices);
+    ASSERT_TRUE(csv.ok) << csv.error;
+    EXPECT_EQ(csv.rows, 3u);
+    std::string text = readFile(path + ".csv");
+    EXPECT_NE(text.find("\"lab, \"\"printer\"\"\",02:00:00:00:00:00,10.0.0.1,-40 dBm,Online,"), std::string::npos);
+    EXPECT_NE(text.find("Device-01,02:00:00:00:00:01,10.0.0.2,-41 dBm,Offline,"), std::string::npos);
+    
+    // Background export; the result is handed out exactly once
+    ASSERT_TRUE(exporter.startDeviceExport(path + ".ndjson", ExportFormat::NdJson, devices));
+    while (exporter.isRunning()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ExportResult ndjson;
+    ASSERT_TRUE(exporter.takeResult(ndjson));
+    EXPECT_FALSE(exporter.takeResult(ndjson));
+    text = readFile(path + ".ndjson");
+    EXPECT_EQ(std::count(text.begin(), text.end(), '\n'), 3);
+    EXPECT_NE(text.find("{\"mac\":\"02:00:00:00:00:00\",\"ip\":\"10.0.0.1\",\"hostname\":\"lab, \\\"printer\\\"\""),
+              std::string::npos);
+    
+    // History streams from the store; binary files end in a checksummed trailer
+    SignalHistoryStore store;
+    std::string storePath = ::testing::TempDir() + "sb_export_history.bin";
+    std::remove(storePath.c_str());
+    ASSERT_TRUE(store.open(storePath));
+    for (int i = 0; i < 500; ++i) {
+        store.append(devices[0]->mac, 1700000000 + i, -50 - i % 5, SignalHistoryStore::kSampleOnline);
+        store.append(devices[2]->mac, 1700000000 + i, -70, 0);
+    }
+    std::vector<MacAddress> macs = {devices[0]->mac, devices[1]->mac, devices[2]->mac};
+    ExportResult history = exporter.exportHistory(path + ".history.csv", ExportFormat::Csv, store, macs, 1700000100);
+    ASSERT_TRUE(history.ok);
+    EXPECT_EQ(history.rows, 800u);
+    text = readFile(path + ".history.csv");
+    EXPECT_NE(text.find("02:00:00:00:00:00,1700000100,-50,1\n"), std::string::npos);
+    
+    ExportResult binary = exporter.exportHistory(path + ".sbx", ExportFormat::Binary, store, macs, 0);
+    ASSERT_TRUE(binary.ok);
+    EXPECT_EQ(binary.rows, 1000u);
+    text = readFile(path + ".sbx");
+    ASSERT_EQ(text.size(), binary.bytes);
+    EXPECT_EQ(text.compare(0, 8, std::string("SBEXPRT\0", 8)), 0);
+    const size_t trailerSize = 24;
+    EXPECT_EQ(text.compare(text.size() - trailerSize, 4, "SBEN"), 0);
+    uint32_t groups, checksum;
+    uint64_t rows;
+    std::memcpy(&groups, &text[text.size() - trailerSize + 4], sizeof(groups));
+    std::memcpy(&rows, &text[text.size() - trailerSize + 8], sizeof(rows));
+    std::memcpy(&checksum, &text[text.size() - trailerSize + 16], sizeof(checksum));
+    EXPECT_EQ(groups, 2u); // the device without history gets no group
+    EXPECT_EQ(rows, 1000u);
+    EXPECT_EQ(checksum, crc32(text.data(), text.size() - trailerSize));
+    
+    store.close();
+    for (const char* suffix : {".csv", ".ndjson", ".history.csv", ".sbx"}) {
+        std::remove((path + suffix).c_str());
+    }
+    std::remove(storePath.c_str());
+}
+
+TEST(TerminalFrameTest, PresentsOnlyChangedCells) {
+    TerminalFrame frame;
+    frame.resize(5, 40);
+    
+    std::string out;
+    frame.begin();
+    frame.write("Devices: 12\nStatus: \033[32mOnline\033[0m\n");
+    frame.present(out);
+    EXPECT_NE(out.find("\033[2J"), std::string::npos); // first frame is drawn in full
+    EXPECT_NE(out.find("\033[0;32mOnline"), std::string::npos);
+    
+    // Same content: nothing to send
+    out.clear();
+    frame.begin();
+    frame.write("Devices: 12\nStatus: \033[32mOnline\033[0m\n");
+    frame.present(out);
+    EXPECT_TRUE(out.empty());
+    
+    // One digit changed: a cursor move to it and the digit
+    out.clear();
+    frame.begin();
+    frame.write("Devices: 13\nStatus: \033[32mOnline\033[0m\n");
+    frame.present(out);
+    EXPECT_EQ(out, "\033[1;11H3");
+    
+    // A shorter line erases the leftover cells
+    out.clear();
+    frame.begin();
+    frame.write("Devices: 13\nStatus: \033[31mOff\033[0m\n");
+    frame.present(out);
+    EXPECT_EQ(out, "\033[2;9H\033[0;31mOff\033[0m\033[K");
+    
+    // Rows past the viewport are clipped and counted
+    frame.begin();
+    frame.write("1\n2\n3\n4\n5\n6\n7\n");
+    EXPECT_EQ(frame.overflowRows(), 2u);
+}
+
+TEST(TaskSchedulerTest, PrioritiesTimersAndCancellation) {
+    TaskScheduler scheduler(1);
+    std::mutex orderMutex;
+    std::vector<int> order;
+    auto record = [&](int value) {
+        return [&, value] {
+            std::lock_guard<std::mutex> lock(orderMutex);
+            order.push_back(value);
+        };
+    };
+    
+    // Hold the only worker while tasks of every priority queue up
+    std::atomic<bool> release(false);
+    TaskHandle blocker = scheduler.submit(TaskPriority::Interactive, [&] {
+        while (!release.load()) std::this_thread::yield();
+    });
+    TaskHandle background = scheduler.submit(TaskPriority::Background, record(4));
+    TaskHandle training = scheduler.submit(TaskPriority::Training, record(3));
+    TaskHandle cancelled = scheduler.submit(TaskPriority::Interactive, record(99));
+    TaskHandle pipeline = scheduler.submit(TaskPriority::Pipeline, record(2));
+    TaskHandle interactive = scheduler.submit(TaskPriority::Interactive, record(1));
+    cancelled.cancel();
+    EXPECT_TRUE(cancelled.isDone());
+    release = true;
+    background.wait();
+    EXPECT_EQ(order, (std::vector<int>{1, 2, 3, 4}));
+    
+    auto start = std::chrono::steady_clock::now();
+    TaskHandle delayed = scheduler.schedule(TaskPriority::Pipeline, std::chrono::milliseconds(30), [] {});
+    delayed.wait();
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(30));
+    
+    std::atomic<int> runs(0);
+    TaskHandle periodic = scheduler.schedulePeriodic(TaskPriority::Pipeline, std::chrono::milliseconds(5), [&] {
+        runs++;
+    });
+    while (runs.load() < 3) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_FALSE(periodic.isDone());
+    periodic.cancel();
+    periodic.wait();
+    int finalRuns = runs.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(runs.load(), finalRuns);
+    
+    // A task fanning out on a single worker does the work itself
+    std::atomic<size_t> sum(0);
+    scheduler.submit(TaskPriority::Training, [&] {
+        scheduler.parallelFor(TaskPriority::Training, 100, [&](size_t i) { sum += i; });
+    }).wait();
+    EXPECT_EQ(sum.load(), 4950u);
+}
+
+TEST(TaskSchedulerTest, IdleWorkersStealQueuedTasks) {
+    TaskScheduler scheduler(4);
+    std::mutex threadsMutex;
+    std::set<std::thread::id> threads;
+    std::vector<TaskHandle> handles;
+    std::mutex handlesMutex;
+    
+    // Everything lands in one worker's deque; the others have to steal it
+    scheduler.submit(TaskPriority::Pipeline, [&] {
+        for (int i = 0; i < 16; ++i) {
+            TaskHandle handle = scheduler.submit(TaskPriority::Pipeline, [&] {
+                {
+                    std::lock_guard<std::mutex> lock(threadsMutex);
+                    threads.insert(std::this_thread::get_id());
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            });
+            std::lock_guard<std::mutex> lock(handlesMutex);
+            handles.push_back(handle);
+        }
+    }).wait();
+    for (const auto& handle : handles) handle.wait();
+    EXPECT_GT(threads.size(), 1u);
+    
+    std::vector<int> hits(10000, 0);
+    scheduler.parallelFor(TaskPriority::Pipeline, hits.size(), [&](size_t i) { hits[i]++; });
+    EXPECT_EQ(std::count(hits.begin(), hits.end(), 1), 10000);
+    EXPECT_THROW(scheduler.parallelFor(TaskPriority::Pipeline, 8, [](size_t i) {
+        if (i == 5) throw std::runtime_error("chunk failed");
+    }), std::runtime_error);
 }
 
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
-}
\ No newline at end of file
+}